@@ -0,0 +1,44 @@
+option(USE_BUNDLED_BENCHMARK "Enable building of the bundled google benchmark" ${USE_BUNDLED_DEPS})
+
+if(BENCHMARK_INCLUDE_DIR)
+	# we already have google benchmark
+elseif(NOT USE_BUNDLED_BENCHMARK)
+	find_path(BENCHMARK_INCLUDE_DIR NAMES benchmark/benchmark.h)
+	find_library(BENCHMARK_LIB NAMES benchmark)
+	find_library(BENCHMARK_MAIN_LIB NAMES benchmark_main)
+	if(BENCHMARK_INCLUDE_DIR AND BENCHMARK_LIB AND BENCHMARK_MAIN_LIB)
+		message(STATUS "Found google benchmark: include: ${BENCHMARK_INCLUDE_DIR}, lib: ${BENCHMARK_LIB}, main lib: ${BENCHMARK_MAIN_LIB}")
+	else()
+		message(FATAL_ERROR "Couldn't find system google benchmark")
+	endif()
+else()
+	# Download and unpack google benchmark at configure time, the same
+	# way as googletest
+	configure_file(CMakeListsBenchmarkInclude.cmake ${PROJECT_BINARY_DIR}/benchmark-download/CMakeLists.txt)
+	execute_process(COMMAND ${CMAKE_COMMAND} -G "${CMAKE_GENERATOR}" .
+		RESULT_VARIABLE result
+		WORKING_DIRECTORY ${PROJECT_BINARY_DIR}/benchmark-download )
+	if(result)
+		message(FATAL_ERROR "CMake step for google benchmark failed: ${result}")
+	endif()
+	execute_process(COMMAND ${CMAKE_COMMAND} --build .
+		RESULT_VARIABLE result
+		WORKING_DIRECTORY ${PROJECT_BINARY_DIR}/benchmark-download )
+	if(result)
+		message(FATAL_ERROR "Build step for google benchmark failed: ${result}")
+	endif()
+
+	# Add google benchmark directly to our build. This defines
+	# the benchmark and benchmark_main targets.
+	set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+	set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+	add_subdirectory(${PROJECT_BINARY_DIR}/benchmark-src
+					 ${PROJECT_BINARY_DIR}/benchmark-build
+					 EXCLUDE_FROM_ALL)
+
+	set(BENCHMARK_INCLUDE_DIR "${benchmark_SOURCE_DIR}/include")
+	set(BENCHMARK_LIB "benchmark")
+	set(BENCHMARK_MAIN_LIB "benchmark_main")
+endif()
+
+include_directories("${BENCHMARK_INCLUDE_DIR}")
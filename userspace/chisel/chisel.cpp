@@ -15,6 +15,7 @@ limitations under the License.
 
 */
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <cctype>
@@ -141,6 +142,7 @@ const static struct luaL_Reg ll_chisel [] =
 	{"set_interval_s", &lua_cbacks::set_interval_s},
 	{"set_precise_interval_ns", &lua_cbacks::set_precise_interval_ns},
 	{"exec", &lua_cbacks::exec},
+	{"set_ffi_batches", &lua_cbacks::set_ffi_batches},
 	{NULL,NULL}
 };
 
@@ -251,8 +253,12 @@ sinsp_chisel::sinsp_chisel(sinsp* inspector, string filename)
 	m_inspector = inspector;
 	m_ls = NULL;
 	m_lua_has_handle_evt = false;
+	m_lua_has_handle_evt_batch = false;
 	m_lua_is_first_evt = true;
 	m_lua_cinfo = NULL;
+	m_batch_prev_size = 0;
+	m_batch_ref = LUA_NOREF;
+	m_batch_ffi = false;
 	m_lua_last_interval_sample_time = 0;
 	m_lua_last_interval_ts = 0;
 	m_udp_socket = 0;
@@ -280,6 +286,15 @@ void sinsp_chisel::free_lua_chisel()
 	}
 	m_allocated_fltchecks.clear();
 
+	m_lua_has_handle_evt = false;
+	m_lua_has_handle_evt_batch = false;
+	m_batch_columns.clear();
+	m_batch_nums.clear();
+	m_batch_ts.clear();
+	m_batch_prev_size = 0;
+	m_batch_ref = LUA_NOREF;
+	m_batch_ffi = false;
+
 	if(m_lua_cinfo != NULL)
 	{
 		delete m_lua_cinfo;
@@ -408,6 +423,26 @@ sinsp_field_aggregation sinsp_chisel::string_to_aggregation(string ag)
 	{
 		res = A_MAX;
 	}
+	else if(ag == "DISTINCT")
+	{
+		res = A_DISTINCT;
+	}
+	else if(ag == "P50")
+	{
+		res = A_P50;
+	}
+	else if(ag == "P90")
+	{
+		res = A_P90;
+	}
+	else if(ag == "P95")
+	{
+		res = A_P95;
+	}
+	else if(ag == "P99")
+	{
+		res = A_P99;
+	}
 	else
 	{
 		throw sinsp_exception("unknown view column aggregation " + ag);
@@ -1213,6 +1248,23 @@ void sinsp_chisel::load(string cmdstr)
 	luaL_openlib(m_ls, "chisel", ll_chisel, 0);
 	luaL_openlib(m_ls, "evt", ll_evt, 0);
 
+	//
+	// With LuaJIT, chisel.ffi gives the field values without converting
+	// them to Lua objects: the functions are cast with
+	// ffi.cast("sinsp_ffi_field_fn", chisel.ffi.field) after declaring
+	// them with ffi.cdef(chisel.ffi.cdef)
+	//
+	lua_getglobal(m_ls, "chisel");
+	lua_newtable(m_ls);
+	lua_pushstring(m_ls, lua_cbacks::ffi_cdef);
+	lua_setfield(m_ls, -2, "cdef");
+	lua_pushlightuserdata(m_ls, (void*)&lua_cbacks::ffi_field);
+	lua_setfield(m_ls, -2, "field");
+	lua_pushlightuserdata(m_ls, (void*)&lua_cbacks::ffi_column);
+	lua_setfield(m_ls, -2, "column");
+	lua_setfield(m_ls, -2, "ffi");
+	lua_pop(m_ls, 1);
+
 	//
 	// Add our chisel paths to package.path
 	//
@@ -1262,8 +1314,25 @@ void sinsp_chisel::load(string cmdstr)
 	if(lua_isfunction(m_ls, -1))
 	{
 		m_lua_has_handle_evt = true;
-		lua_pop(m_ls, 1);
 	}
+	lua_pop(m_ls, 1);
+
+	//
+	// Check if the script has an on_event_batch, which takes precedence.
+	// The batch table is created once and refilled for every batch.
+	//
+	lua_getglobal(m_ls, "on_event_batch");
+	if(lua_isfunction(m_ls, -1))
+	{
+		m_lua_has_handle_evt_batch = true;
+
+		lua_newtable(m_ls);
+		m_batch_ref = luaL_ref(m_ls, LUA_REGISTRYINDEX);
+
+		m_batch_nums.reserve(CHISEL_EVENT_BATCH_SIZE);
+		m_batch_ts.reserve(CHISEL_EVENT_BATCH_SIZE);
+	}
+	lua_pop(m_ls, 1);
 #endif
 
 	is.close();
@@ -1580,10 +1649,23 @@ bool sinsp_chisel::run(sinsp_evt* evt)
 		}
 	}
 
+	//
+	// If the script processes batches, queue the event. The formatter
+	// output can't depend on the callback result in this case.
+	//
+	if(m_lua_has_handle_evt_batch)
+	{
+		add_to_event_batch(evt);
+
+		if(m_lua_cinfo->m_end_capture == true)
+		{
+			throw sinsp_capture_interrupt_exception();
+		}
+	}
 	//
 	// If the script has the on_event callback, call it
 	//
-	if(m_lua_has_handle_evt)
+	else if(m_lua_has_handle_evt)
 	{
 		lua_getglobal(m_ls, "on_event");
 
@@ -1621,6 +1703,203 @@ bool sinsp_chisel::run(sinsp_evt* evt)
 #endif
 }
 
+void sinsp_chisel::add_to_event_batch(sinsp_evt* evt)
+{
+	uint32_t nevts = (uint32_t)m_batch_ts.size();
+	uint64_t ts = evt->get_ts();
+
+	if(nevts != 0 && ts - m_batch_ts[0] >= CHISEL_EVENT_BATCH_MAX_DELAY_NS)
+	{
+		flush_event_batch();
+		nevts = 0;
+	}
+
+	//
+	// Fields requested after the batch started are missing from the
+	// events that came before
+	//
+	while(m_batch_columns.size() < m_allocated_fltchecks.size())
+	{
+		sinsp_filter_check* chk = m_allocated_fltchecks[m_batch_columns.size()];
+
+		m_batch_columns.push_back(chisel_field_column());
+		chisel_field_column& col = m_batch_columns.back();
+		col.m_check = chk;
+		col.m_type = chk->get_field_info()->m_type;
+		col.m_offsets.reserve(CHISEL_EVENT_BATCH_SIZE);
+		col.m_lens.reserve(CHISEL_EVENT_BATCH_SIZE);
+		col.m_offsets.assign(nevts, 0);
+		col.m_lens.assign(nevts, CHISEL_FIELD_NULL);
+	}
+
+	for(auto& col : m_batch_columns)
+	{
+		uint32_t vlen;
+		uint8_t* rawval = col.m_check->extract(evt, &vlen);
+
+		col.m_offsets.push_back((uint32_t)col.m_data.size());
+
+		if(rawval == NULL)
+		{
+			col.m_lens.push_back(CHISEL_FIELD_NULL);
+			continue;
+		}
+
+		col.m_lens.push_back(vlen);
+		col.m_data.insert(col.m_data.end(), rawval, rawval + vlen);
+		col.m_data.push_back(0);
+	}
+
+	m_batch_nums.push_back(evt->get_num());
+	m_batch_ts.push_back(ts);
+
+	if(m_batch_ts.size() >= CHISEL_EVENT_BATCH_SIZE)
+	{
+		flush_event_batch();
+	}
+}
+
+//
+// Calls on_event_batch(batch, n). For every requested field, batch has an
+// array of n values (nil for the events that don't have the field) keyed
+// by the field handle, unless the chisel called chisel.set_ffi_batches();
+// batch.num, batch.ts_s and batch.ts_ns are the event numbers and
+// timestamps.
+//
+void sinsp_chisel::flush_event_batch()
+{
+#ifdef HAS_LUA_CHISELS
+	uint32_t nevts = (uint32_t)m_batch_ts.size();
+	if(nevts == 0)
+	{
+		return;
+	}
+
+	//
+	// The arrays are reused, so the tail of a longer previous batch must
+	// be cleared
+	//
+	uint32_t nslots = std::max(nevts, m_batch_prev_size);
+	uint32_t j;
+
+	lua_rawgeti(m_ls, LUA_REGISTRYINDEX, m_batch_ref);
+
+	//
+	// With FFI batches, the chisel reads the columns in place
+	//
+	uint32_t ncols = m_batch_ffi ? 0 : (uint32_t)m_batch_columns.size();
+
+	for(uint32_t c = 0; c < ncols; c++)
+	{
+		chisel_field_column& col = m_batch_columns[c];
+
+		lua_pushlightuserdata(m_ls, col.m_check);
+		lua_rawget(m_ls, -2);
+		if(!lua_istable(m_ls, -1))
+		{
+			lua_pop(m_ls, 1);
+			lua_createtable(m_ls, CHISEL_EVENT_BATCH_SIZE, 0);
+			lua_pushlightuserdata(m_ls, col.m_check);
+			lua_pushvalue(m_ls, -2);
+			lua_rawset(m_ls, -4);
+		}
+
+		for(j = 0; j < nslots; j++)
+		{
+			if(j >= nevts || col.m_lens[j] == CHISEL_FIELD_NULL ||
+				lua_cbacks::rawval_to_lua_stack(m_ls, &col.m_data[col.m_offsets[j]], col.m_type, col.m_lens[j]) == 0)
+			{
+				lua_pushnil(m_ls);
+			}
+
+			lua_rawseti(m_ls, -2, j + 1);
+		}
+
+		lua_pop(m_ls, 1);
+	}
+
+	const char* meta_names[] = {"num", "ts_s", "ts_ns"};
+	for(uint32_t k = 0; k < sizeof(meta_names) / sizeof(meta_names[0]); k++)
+	{
+		lua_getfield(m_ls, -1, meta_names[k]);
+		if(!lua_istable(m_ls, -1))
+		{
+			lua_pop(m_ls, 1);
+			lua_createtable(m_ls, CHISEL_EVENT_BATCH_SIZE, 0);
+			lua_pushvalue(m_ls, -1);
+			lua_setfield(m_ls, -3, meta_names[k]);
+		}
+
+		for(j = 0; j < nslots; j++)
+		{
+			if(j >= nevts)
+			{
+				lua_pushnil(m_ls);
+			}
+			else if(k == 0)
+			{
+				lua_pushnumber(m_ls, (double)m_batch_nums[j]);
+			}
+			else if(k == 1)
+			{
+				lua_pushinteger(m_ls, (uint32_t)(m_batch_ts[j] / 1000000000));
+			}
+			else
+			{
+				lua_pushinteger(m_ls, (uint32_t)(m_batch_ts[j] % 1000000000));
+			}
+
+			lua_rawseti(m_ls, -2, j + 1);
+		}
+
+		lua_pop(m_ls, 1);
+	}
+
+	m_batch_nums.clear();
+	m_batch_ts.clear();
+	m_batch_prev_size = nevts;
+
+	//
+	// evt.* refer to a single event and are not available to the batch
+	// callback. The current event is restored after the call.
+	//
+	lua_getglobal(m_ls, "sievt");
+	lua_pushlightuserdata(m_ls, NULL);
+	lua_setglobal(m_ls, "sievt");
+
+	lua_getglobal(m_ls, "on_event_batch");
+	lua_pushvalue(m_ls, -3);
+	lua_pushnumber(m_ls, nevts);
+
+	bool failed = (lua_pcall(m_ls, 2, 0, 0) != 0);
+	string err;
+	if(failed)
+	{
+		const char* msg = lua_tostring(m_ls, -1);
+		err = (msg != NULL)? msg : "";
+		lua_pop(m_ls, 1);
+	}
+
+	//
+	// Leave the state ready for the next batch even if the call failed
+	//
+	lua_setglobal(m_ls, "sievt");
+	lua_pop(m_ls, 1);
+
+	for(auto& col : m_batch_columns)
+	{
+		col.m_data.clear();
+		col.m_offsets.clear();
+		col.m_lens.clear();
+	}
+
+	if(failed)
+	{
+		throw sinsp_exception(m_filename + " chisel error: calling on_event_batch() failed:" + err);
+	}
+#endif // HAS_LUA_CHISELS
+}
+
 void sinsp_chisel::do_timeout(sinsp_evt* evt)
 {
 	if(m_lua_is_first_evt)
@@ -1646,6 +1925,8 @@ void sinsp_chisel::do_timeout(sinsp_evt* evt)
 		{
 			int64_t delta = 0;
 
+			flush_event_batch();
+
 			if(m_lua_last_interval_ts != 0)
 			{
 				delta = ts - m_lua_last_interval_ts;
@@ -1687,6 +1968,8 @@ void sinsp_chisel::do_timeout(sinsp_evt* evt)
 		{
 			uint64_t t;
 
+			flush_event_batch();
+
 			for(t = m_lua_last_interval_sample_time; t <= ts - interval; t += interval)
 			{
 				lua_getglobal(m_ls, "on_interval");
@@ -1717,6 +2000,8 @@ void sinsp_chisel::do_timeout(sinsp_evt* evt)
 void sinsp_chisel::do_end_of_sample()
 {
 #ifdef HAS_LUA_CHISELS
+	flush_event_batch();
+
 	lua_getglobal(m_ls, "on_end_of_sample");
 
 	if(lua_pcall(m_ls, 0, 1, 0) != 0)
@@ -1764,6 +2049,8 @@ void sinsp_chisel::on_capture_start()
 void sinsp_chisel::on_capture_end()
 {
 #ifdef HAS_LUA_CHISELS
+	flush_event_batch();
+
 	lua_getglobal(m_ls, "on_capture_end");
 
 	if(lua_isfunction(m_ls, -1))
@@ -107,6 +107,33 @@ private:
 	sinsp* m_inspector;
 };
 
+//
+// Chisels that define on_event_batch() get the values of the fields they
+// requested for up to CHISEL_EVENT_BATCH_SIZE events at a time, instead
+// of calling evt.field() for every event. A batch is also delivered when
+// its oldest event is CHISEL_EVENT_BATCH_MAX_DELAY_NS older than the
+// newest one, before every on_interval() and at the end of the capture.
+//
+#define CHISEL_EVENT_BATCH_SIZE 1024
+#define CHISEL_EVENT_BATCH_MAX_DELAY_NS 100000000
+
+//
+// The values of one requested field for the events of the current batch.
+// Every value is stored followed by a zero byte, like the extracted ones.
+//
+class chisel_field_column
+{
+public:
+	sinsp_filter_check* m_check;
+	ppm_param_type m_type;
+	vector<uint8_t> m_data;
+	vector<uint32_t> m_offsets;
+	// CHISEL_FIELD_NULL when the field is missing from the event
+	vector<uint32_t> m_lens;
+};
+
+#define CHISEL_FIELD_NULL 0xffffffff
+
 class SINSP_PUBLIC sinsp_chisel
 {
 public:
@@ -147,6 +174,8 @@ private:
 	static bool parse_view_info(lua_State *ls, OUT chisel_desc* cd);
 	static bool init_lua_chisel(chisel_desc &cd, string const &path);
 	void first_event_inits(sinsp_evt* evt);
+	void add_to_event_batch(sinsp_evt* evt);
+	void flush_event_batch();
 
 	sinsp* m_inspector;
 	string m_description;
@@ -155,12 +184,20 @@ private:
 	lua_State* m_ls;
 	chisel_desc m_lua_script_info;
 	bool m_lua_has_handle_evt;
+	bool m_lua_has_handle_evt_batch;
 	bool m_lua_is_first_evt;
 	uint64_t m_lua_last_interval_sample_time;
 	uint64_t m_lua_last_interval_ts;
 	vector<sinsp_filter_check*> m_allocated_fltchecks;
 	char m_lua_fld_storage[PPM_MAX_ARG_SIZE];
 	chiselinfo* m_lua_cinfo;
+	vector<chisel_field_column> m_batch_columns;
+	vector<uint64_t> m_batch_nums;
+	vector<uint64_t> m_batch_ts;
+	// The fields are only available through the FFI in the batches
+	bool m_batch_ffi;
+	uint32_t m_batch_prev_size;
+	int m_batch_ref;
 	string m_new_chisel_to_exec;
 	int m_udp_socket;
 	struct sockaddr_in m_serveraddr;
@@ -369,6 +369,77 @@ int lua_cbacks::field(lua_State *ls)
 	}
 }
 
+//
+// A chisel that only compares or hashes values can read them in place
+// through these, without creating Lua strings. The values point into the
+// event or into sinsp buffers and are only valid until the callback
+// returns.
+//
+const char* lua_cbacks::ffi_cdef =
+	"typedef const uint8_t* (*sinsp_ffi_field_fn)(void* evt, void* fld, uint32_t* len);\n"
+	"typedef uint32_t (*sinsp_ffi_column_fn)(void* chisel, void* fld, "
+		"const uint8_t** data, const uint32_t** offsets, const uint32_t** lens);\n";
+
+//
+// Same as evt.field(), for ffi_field(sievt, handle, len). Returns NULL if
+// the event doesn't have the field.
+//
+const uint8_t* lua_cbacks::ffi_field(sinsp_evt* evt, sinsp_filter_check* chk, uint32_t* len)
+{
+	if(evt == NULL || chk == NULL)
+	{
+		return NULL;
+	}
+
+	return chk->extract(evt, len);
+}
+
+//
+// From on_event_batch(), ffi_column(sichisel, handle, data, offsets, lens)
+// gives the values of a field for the events of the batch: the value of
+// the i-th event is at data + offsets[i], with length lens[i], or missing
+// if lens[i] is 0xffffffff. Returns the number of events.
+//
+uint32_t lua_cbacks::ffi_column(sinsp_chisel* ch, sinsp_filter_check* chk,
+	const uint8_t** data, const uint32_t** offsets, const uint32_t** lens)
+{
+	*data = NULL;
+	*offsets = NULL;
+	*lens = NULL;
+
+	if(ch == NULL)
+	{
+		return 0;
+	}
+
+	for(auto& col : ch->m_batch_columns)
+	{
+		if(col.m_check == chk && !col.m_lens.empty())
+		{
+			*data = col.m_data.data();
+			*offsets = col.m_offsets.data();
+			*lens = col.m_lens.data();
+			return (uint32_t)col.m_lens.size();
+		}
+	}
+
+	return 0;
+}
+
+int lua_cbacks::set_ffi_batches(lua_State *ls)
+{
+	lua_getglobal(ls, "sichisel");
+
+	sinsp_chisel* ch = (sinsp_chisel*)lua_touserdata(ls, -1);
+	lua_pop(ls, 1);
+
+	ASSERT(ch);
+
+	ch->m_batch_ffi = (lua_toboolean(ls, 1) != 0);
+
+	return 0;
+}
+
 int lua_cbacks::set_global_filter(lua_State *ls)
 {
 	lua_getglobal(ls, "sichisel");
@@ -62,6 +62,15 @@ public:
 	static int udp_setpeername(lua_State *ls);
 	static int udp_send(lua_State *ls);
 	static int get_read_progress(lua_State *ls);
+	static int set_ffi_batches(lua_State *ls);
+
+	//
+	// Called from LuaJIT through the FFI, see chisel.ffi
+	//
+	static const uint8_t* ffi_field(sinsp_evt* evt, sinsp_filter_check* chk, uint32_t* len);
+	static uint32_t ffi_column(sinsp_chisel* ch, sinsp_filter_check* chk,
+		const uint8_t** data, const uint32_t** offsets, const uint32_t** lens);
+	static const char* ffi_cdef;
 #ifdef HAS_ANALYZER
 	static int push_metric(lua_State *ls);
 #endif
@@ -0,0 +1,545 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <string.h>
+#include <unistd.h>
+
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bench_capture.h"
+
+namespace bench
+{
+
+namespace
+{
+
+const uint64_t FIRST_TS = 1600000000000000000ULL;
+const uint64_t TS_STEP = 1000;
+
+//
+// The process tree: init, a chain of shells and NPROCS worker processes
+// with NTHREADS threads each, children of the last shell
+//
+const uint64_t INIT_PID = 1;
+const uint64_t SHELL_PID = 100;
+const uint64_t WORKER_PID = 1000;
+const uint64_t CHILD_PID = 100000;
+const uint32_t NPROCS = 16;
+const uint32_t NTHREADS = 4;
+const uint32_t NFILES = 4;
+const int64_t FIRST_FD = 3;
+
+const uint32_t IO_SYSCALLS = 100000;
+const uint32_t FD_CHURN_OPENS = 30000;
+const uint32_t THREAD_CHURN_CLONES = 5000;
+const uint32_t NET_CONNECTIONS = 4000;
+const uint32_t NET_REQUESTS = 8;
+
+const uint32_t SNAPLEN = 80;
+
+//
+// A parameter value: integers are stored with the size of the parameter
+// type, strings as they are, so C strings must carry their terminator
+//
+struct param_value
+{
+	template<typename T>
+	param_value(T num, typename std::enable_if<std::is_integral<T>::value>::type* = 0):
+		m_is_num(true),
+		m_num((uint64_t)num)
+	{
+	}
+
+	param_value(const char* str):
+		m_is_num(false),
+		m_num(0),
+		m_buf(str, strlen(str) + 1)
+	{
+	}
+
+	param_value(const std::string& buf):
+		m_is_num(false),
+		m_num(0),
+		m_buf(buf)
+	{
+	}
+
+	bool m_is_num;
+	uint64_t m_num;
+	std::string m_buf;
+};
+
+typedef std::initializer_list<std::pair<const char*, param_value>> param_list;
+
+uint32_t num_param_size(ppm_param_type type)
+{
+	switch(type)
+	{
+	case PT_INT8:
+	case PT_UINT8:
+	case PT_FLAGS8:
+	case PT_SIGTYPE:
+	case PT_L4PROTO:
+	case PT_SOCKFAMILY:
+		return 1;
+	case PT_INT16:
+	case PT_UINT16:
+	case PT_FLAGS16:
+	case PT_SYSCALLID:
+	case PT_PORT:
+		return 2;
+	case PT_INT32:
+	case PT_UINT32:
+	case PT_FLAGS32:
+	case PT_UID:
+	case PT_GID:
+	case PT_BOOL:
+	case PT_IPV4ADDR:
+	case PT_SIGSET:
+	case PT_MODE:
+		return 4;
+	case PT_INT64:
+	case PT_UINT64:
+	case PT_ERRNO:
+	case PT_FD:
+	case PT_PID:
+	case PT_RELTIME:
+	case PT_ABSTIME:
+	case PT_DOUBLE:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+//
+// Writes a capture with a synthetic process table and synthetic events,
+// through a libscap handle that does not capture anything
+//
+class capture_writer
+{
+public:
+	capture_writer():
+		m_h(NULL),
+		m_dumper(NULL),
+		m_ts(FIRST_TS),
+		m_info(scap_get_event_info_table())
+	{
+		char error[SCAP_LASTERR_SIZE];
+		int32_t rc;
+		scap_open_args oargs = {};
+		oargs.mode = SCAP_MODE_NODRIVER;
+		oargs.import_users = true;
+
+		m_h = scap_open(oargs, error, &rc);
+		if(m_h == NULL)
+		{
+			throw sinsp_exception(string("cannot create the benchmark capture: ") + error);
+		}
+
+		// start from an empty process table instead of the one of this host
+		scap_proc_free_table(m_h);
+	}
+
+	~capture_writer()
+	{
+		if(m_dumper != NULL)
+		{
+			scap_dump_close(m_dumper);
+		}
+		scap_close(m_h);
+	}
+
+	void add_process(uint64_t tid, uint64_t pid, uint64_t ptid, const char* comm, const char* exepath, const std::string& args)
+	{
+		scap_threadinfo* tinfo = scap_proc_alloc(m_h);
+		tinfo->tid = tid;
+		tinfo->pid = pid;
+		tinfo->ptid = ptid;
+		tinfo->sid = INIT_PID;
+		tinfo->vpgid = pid;
+		snprintf(tinfo->comm, sizeof(tinfo->comm), "%s", comm);
+		snprintf(tinfo->exe, sizeof(tinfo->exe), "%s", exepath);
+		snprintf(tinfo->exepath, sizeof(tinfo->exepath), "%s", exepath);
+		tinfo->args_len = (uint16_t)std::min(args.size(), sizeof(tinfo->args) - 1);
+		memcpy(tinfo->args, args.data(), tinfo->args_len);
+		snprintf(tinfo->cwd, sizeof(tinfo->cwd), "/srv/");
+		snprintf(tinfo->root, sizeof(tinfo->root), "/");
+		tinfo->fdlimit = 1024;
+		tinfo->vtid = tid;
+		tinfo->vpid = pid;
+		tinfo->clone_ts = FIRST_TS;
+		tinfo->loginuid = -1;
+
+		if(scap_proc_add(m_h, tid, tinfo) != SCAP_SUCCESS)
+		{
+			throw sinsp_exception(scap_getlasterr(m_h));
+		}
+	}
+
+	//
+	// Writes the process table, after which only events can be added
+	//
+	void start(const std::string& path)
+	{
+		m_dumper = scap_dump_open(m_h, path.c_str(), SCAP_COMPRESSION_NONE, true);
+		if(m_dumper == NULL)
+		{
+			throw sinsp_exception(scap_getlasterr(m_h));
+		}
+	}
+
+	//
+	// Writes an event of the given type; the parameters that are not
+	// listed are zero or empty
+	//
+	void event(uint16_t type, uint64_t tid, param_list params)
+	{
+		const ppm_event_info& info = m_info[type];
+		std::vector<uint16_t> lens(info.nparams);
+		std::string data;
+
+		for(uint32_t j = 0; j < info.nparams; j++)
+		{
+			const ppm_param_info& pinfo = info.params[j];
+			uint32_t size = num_param_size(pinfo.type);
+			const param_value* value = NULL;
+
+			for(const auto& p : params)
+			{
+				if(strcmp(p.first, pinfo.name) == 0)
+				{
+					value = &p.second;
+					break;
+				}
+			}
+
+			size_t start = data.size();
+			if(value != NULL && !value->m_is_num)
+			{
+				data += value->m_buf;
+			}
+			else if(size != 0)
+			{
+				uint64_t num = value != NULL ? value->m_num : 0;
+				data.append((const char*)&num, size);
+			}
+			else if(pinfo.type == PT_CHARBUF || pinfo.type == PT_FSPATH || pinfo.type == PT_FSRELPATH)
+			{
+				data += '\0';
+			}
+			lens[j] = (uint16_t)(data.size() - start);
+		}
+
+		std::string evt(sizeof(scap_evt), '\0');
+		scap_evt* hdr = (scap_evt*)&evt[0];
+		hdr->ts = m_ts;
+		hdr->tid = tid;
+		hdr->type = type;
+		hdr->nparams = info.nparams;
+		hdr->len = (uint32_t)(sizeof(scap_evt) + lens.size() * sizeof(uint16_t) + data.size());
+		evt.append((const char*)lens.data(), lens.size() * sizeof(uint16_t));
+		evt += data;
+
+		if(scap_dump(m_h, m_dumper, (scap_evt*)&evt[0], 0, 0) != SCAP_SUCCESS)
+		{
+			throw sinsp_exception(scap_getlasterr(m_h));
+		}
+
+		m_ts += TS_STEP;
+	}
+
+	void open(uint64_t tid, int64_t fd, const std::string& name)
+	{
+		event(PPME_SYSCALL_OPEN_E, tid, {});
+		event(PPME_SYSCALL_OPEN_X, tid, {{"fd", fd}, {"name", name.c_str()}, {"flags", PPM_O_RDWR}, {"mode", 0644}});
+	}
+
+	void io(uint64_t tid, int64_t fd, bool read, uint32_t size)
+	{
+		io(tid, fd, read, size, std::string(std::min(size, SNAPLEN), 'x'));
+	}
+
+	//
+	// A read or write of size bytes that start with data, of which only
+	// the first SNAPLEN bytes are captured
+	//
+	void io(uint64_t tid, int64_t fd, bool read, uint32_t size, const std::string& data)
+	{
+		std::string payload = data.substr(0, SNAPLEN);
+		event(read ? PPME_SYSCALL_READ_E : PPME_SYSCALL_WRITE_E, tid, {{"fd", fd}, {"size", size}});
+		event(read ? PPME_SYSCALL_READ_X : PPME_SYSCALL_WRITE_X, tid, {{"res", size}, {"data", payload}});
+	}
+
+	//
+	// An accepted IPv4 TCP connection from client:cport to server:sport
+	//
+	void accept(uint64_t tid, int64_t fd, uint32_t client, uint16_t cport, uint32_t server, uint16_t sport)
+	{
+		std::string tuple(1, (char)PPM_AF_INET);
+		tuple.append((const char*)&client, sizeof(client));
+		tuple.append((const char*)&cport, sizeof(cport));
+		tuple.append((const char*)&server, sizeof(server));
+		tuple.append((const char*)&sport, sizeof(sport));
+
+		event(PPME_SOCKET_ACCEPT_5_E, tid, {});
+		event(PPME_SOCKET_ACCEPT_5_X, tid, {{"fd", fd}, {"tuple", tuple}});
+	}
+
+	void close(uint64_t tid, int64_t fd)
+	{
+		event(PPME_SYSCALL_CLOSE_E, tid, {{"fd", fd}});
+		event(PPME_SYSCALL_CLOSE_X, tid, {{"res", 0}});
+	}
+
+private:
+	scap_t* m_h;
+	scap_dumper_t* m_dumper;
+	uint64_t m_ts;
+	const ppm_event_info* m_info;
+};
+
+std::string args(const std::string& arg0, uint64_t id)
+{
+	std::string res = arg0;
+	res += '\0';
+	res += std::to_string(id);
+	res += '\0';
+	return res;
+}
+
+uint64_t worker_tid(uint32_t proc, uint32_t thread)
+{
+	return WORKER_PID + proc * NTHREADS + thread;
+}
+
+std::string data_file(uint32_t proc, uint32_t file)
+{
+	return "/srv/data/" + std::to_string(proc) + "/table" + std::to_string(file) + ".db";
+}
+
+void add_process_tree(capture_writer& w)
+{
+	w.add_process(INIT_PID, INIT_PID, 0, "init", "/sbin/init", args("/sbin/init", 0));
+
+	uint64_t parent = INIT_PID;
+	for(uint32_t j = 0; j < ANCESTOR_DEPTH; j++)
+	{
+		uint64_t pid = SHELL_PID + j;
+		w.add_process(pid, pid, parent, "sh", "/bin/sh", args("-c", j));
+		parent = pid;
+	}
+
+	for(uint32_t p = 0; p < NPROCS; p++)
+	{
+		uint64_t pid = worker_tid(p, 0);
+		for(uint32_t t = 0; t < NTHREADS; t++)
+		{
+			w.add_process(worker_tid(p, t), pid, t == 0 ? parent : pid,
+				      "worker", "/usr/bin/worker", args("--id", p));
+		}
+	}
+}
+
+void write_io(capture_writer& w)
+{
+	for(uint32_t p = 0; p < NPROCS; p++)
+	{
+		for(uint32_t f = 0; f < NFILES; f++)
+		{
+			w.open(worker_tid(p, f % NTHREADS), FIRST_FD + f, data_file(p, f));
+		}
+	}
+
+	for(uint32_t j = 0; j < IO_SYSCALLS; j++)
+	{
+		uint32_t thread = (j * 7) % (NPROCS * NTHREADS);
+		w.io(WORKER_PID + thread, FIRST_FD + j % NFILES, j % 3 != 0, 64 << (j % 6));
+	}
+}
+
+void write_fd_churn(capture_writer& w)
+{
+	for(uint32_t j = 0; j < FD_CHURN_OPENS; j++)
+	{
+		uint32_t thread = (j * 7) % (NPROCS * NTHREADS);
+		uint64_t tid = WORKER_PID + thread;
+
+		// every thread uses its own fd, so threads of the same process
+		// never close each other's files
+		int64_t fd = FIRST_FD + thread % NTHREADS;
+		w.open(tid, fd, "/var/cache/worker/" + std::to_string(thread) + "/entry" + std::to_string(j) + ".tmp");
+		w.io(tid, fd, true, 512);
+		w.close(tid, fd);
+	}
+}
+
+void write_thread_churn(capture_writer& w)
+{
+	for(uint32_t j = 0; j < THREAD_CHURN_CLONES; j++)
+	{
+		uint32_t proc = j % NPROCS;
+		uint64_t parent = worker_tid(proc, 0);
+		uint64_t child = CHILD_PID + j;
+
+		// one clone in four creates a thread instead of a process
+		bool thread = (j % 4) == 0;
+		uint64_t pid = thread ? parent : child;
+		uint32_t flags = thread ? (PPM_CL_CLONE_THREAD | PPM_CL_CLONE_FILES | PPM_CL_CLONE_VM) : 0;
+
+		w.event(PPME_SYSCALL_CLONE_20_E, parent, {});
+		w.event(PPME_SYSCALL_CLONE_20_X, parent, {{"res", child}, {"exe", "/usr/bin/worker"}, {"args", args("--id", proc)},
+			{"tid", parent}, {"pid", parent}, {"ptid", parent}, {"cwd", "/srv/"}, {"fdlimit", 1024},
+			{"comm", "worker"}, {"flags", flags}, {"vtid", parent}, {"vpid", parent}});
+		w.event(PPME_SYSCALL_CLONE_20_X, child, {{"res", 0}, {"exe", "/usr/bin/worker"}, {"args", args("--id", proc)},
+			{"tid", child}, {"pid", pid}, {"ptid", parent}, {"cwd", "/srv/"}, {"fdlimit", 1024},
+			{"comm", "worker"}, {"flags", flags}, {"vtid", child}, {"vpid", pid}});
+
+		if(!thread)
+		{
+			w.event(PPME_SYSCALL_EXECVE_19_E, child, {{"filename", "/usr/bin/job"}});
+			w.event(PPME_SYSCALL_EXECVE_19_X, child, {{"res", 0}, {"exe", "/usr/bin/job"}, {"args", args("--job", j)},
+				{"tid", child}, {"pid", child}, {"ptid", parent}, {"cwd", "/srv/"}, {"fdlimit", 1024},
+				{"comm", "job"}, {"vpid", child}, {"pgid", child}, {"loginuid", -1}});
+		}
+
+		int64_t fd = thread ? FIRST_FD + NFILES + j % 64 : FIRST_FD;
+		w.open(child, fd, "/etc/ld.so.cache");
+		w.io(child, fd, true, 4096);
+		w.close(child, fd);
+		w.event(PPME_PROCEXIT_1_E, child, {{"status", 0}});
+	}
+}
+
+void write_net(capture_writer& w)
+{
+	const std::string tls_record("\x17\x03\x03\x01\x00", 5);
+
+	for(uint32_t j = 0; j < NET_CONNECTIONS; j++)
+	{
+		uint32_t thread = (j * 7) % (NPROCS * NTHREADS);
+		uint64_t tid = WORKER_PID + thread;
+		int64_t fd = FIRST_FD + thread % NTHREADS;
+
+		// one connection in four is TLS, half of them on the HTTP port
+		bool tls = (j % 4) == 3;
+		uint16_t port = (tls && (j % 8) == 3) ? 443 : 8080;
+
+		w.accept(tid, fd, 0x0a000100 + j % 200, (uint16_t)(32768 + j % 16384), 0x0a000001, port);
+		for(uint32_t r = 0; r < NET_REQUESTS; r++)
+		{
+			if(tls)
+			{
+				w.io(tid, fd, true, 256, tls_record + std::string(251, 'x'));
+				w.io(tid, fd, false, 4096, tls_record + std::string(4091, 'x'));
+			}
+			else
+			{
+				std::string request = "GET /api/v1/items/" + std::to_string(j * NET_REQUESTS + r) +
+					" HTTP/1.1\r\nHost: backend\r\nUser-Agent: bench\r\nAccept: */*\r\n\r\n";
+				w.io(tid, fd, true, (uint32_t)request.size(), request);
+				w.io(tid, fd, false, 4096, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 4020\r\n\r\n{");
+			}
+		}
+		w.close(tid, fd);
+	}
+}
+
+struct capture_files
+{
+	std::string m_paths[CAPTURE_MAX];
+
+	~capture_files()
+	{
+		for(const auto& path : m_paths)
+		{
+			if(!path.empty())
+			{
+				unlink(path.c_str());
+			}
+		}
+	}
+};
+
+capture_files s_captures;
+
+}
+
+const char* capture_name(capture_kind kind)
+{
+	switch(kind)
+	{
+	case CAPTURE_IO:
+		return "io";
+	case CAPTURE_FD_CHURN:
+		return "fd_churn";
+	case CAPTURE_THREAD_CHURN:
+		return "thread_churn";
+	case CAPTURE_NET:
+		return "net";
+	default:
+		return "unknown";
+	}
+}
+
+std::string temp_path(const std::string& name)
+{
+	const char* tmpdir = getenv("TMPDIR");
+	return std::string(tmpdir != NULL ? tmpdir : "/tmp") +
+		"/bench-libsinsp-" + std::to_string(getpid()) + "-" + name;
+}
+
+const std::string& capture_path(capture_kind kind)
+{
+	std::string& path = s_captures.m_paths[kind];
+	if(!path.empty())
+	{
+		return path;
+	}
+
+	std::string res = temp_path(std::string(capture_name(kind)) + ".scap");
+
+	capture_writer w;
+	add_process_tree(w);
+	w.start(res);
+	switch(kind)
+	{
+	case CAPTURE_IO:
+		write_io(w);
+		break;
+	case CAPTURE_FD_CHURN:
+		write_fd_churn(w);
+		break;
+	case CAPTURE_THREAD_CHURN:
+		write_thread_churn(w);
+		break;
+	case CAPTURE_NET:
+		write_net(w);
+		break;
+	default:
+		throw sinsp_exception("unknown benchmark capture");
+	}
+
+	path = res;
+	return path;
+}
+
+}
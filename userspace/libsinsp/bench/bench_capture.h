@@ -0,0 +1,123 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <sinsp.h>
+
+namespace bench
+{
+
+//
+// The synthetic captures the benchmarks run on. They are generated the
+// first time they are used, from a fixed process tree and a fixed
+// sequence of events, so every run and every version reads the same
+// events:
+//
+//  - CAPTURE_IO: 64 threads in 16 processes reading and writing files
+//    they opened at the beginning, the common case of a busy host
+//  - CAPTURE_FD_CHURN: the same threads opening, reading and closing a
+//    different file every time
+//  - CAPTURE_THREAD_CHURN: short lived processes that are cloned,
+//    exec a program, open a file and exit
+//  - CAPTURE_NET: the same threads accepting keep-alive connections
+//    and answering requests, mostly HTTP and some TLS
+//
+// Every process descends from a chain of ANCESTOR_DEPTH shells, so that
+// the proc.aname/proc.apid walks go through a realistic number of
+// parents.
+//
+enum capture_kind
+{
+	CAPTURE_IO = 0,
+	CAPTURE_FD_CHURN,
+	CAPTURE_THREAD_CHURN,
+	CAPTURE_NET,
+	CAPTURE_MAX,
+};
+
+const uint32_t ANCESTOR_DEPTH = 24;
+
+const char* capture_name(capture_kind kind);
+
+//
+// Path of the capture file, generated in $TMPDIR (or /tmp) on first use
+// and deleted when the program exits
+//
+const std::string& capture_path(capture_kind kind);
+
+//
+// Path of a scratch file in $TMPDIR (or /tmp), unique to this process
+//
+std::string temp_path(const std::string& name);
+
+//
+// Runs an operation on every event of a capture and reports the time
+// spent in the operation only, as manual time, along with the number of
+// events per second. Op is constructed for every pass over the capture
+// with (sinsp*, benchmark::State&, args...), before the capture is
+// opened, and called with every event; the benchmark must be registered
+// with UseManualTime().
+//
+// The harness itself costs two clock reads per event, measured by the
+// BM_events_noop benchmark.
+//
+template<typename Op, typename... Args>
+void run_on_events(benchmark::State& state, capture_kind kind, Args... args)
+{
+	typedef std::chrono::steady_clock clock;
+	uint64_t nevts = 0;
+
+	for(auto _ : state)
+	{
+		std::unique_ptr<sinsp> inspector(new sinsp());
+		Op op(inspector.get(), state, args...);
+		inspector->open(capture_path(kind));
+
+		clock::duration elapsed(0);
+		sinsp_evt* evt;
+		while(true)
+		{
+			int32_t res = inspector->next(&evt);
+			if(res == SCAP_EOF)
+			{
+				break;
+			}
+			else if(res != SCAP_SUCCESS)
+			{
+				continue;
+			}
+
+			clock::time_point start = clock::now();
+			op(evt);
+			elapsed += clock::now() - start;
+			nevts++;
+		}
+
+		inspector->close();
+		state.SetIterationTime(std::chrono::duration<double>(elapsed).count());
+	}
+
+	state.SetItemsProcessed(nevts);
+}
+
+}
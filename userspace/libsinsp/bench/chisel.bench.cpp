@@ -0,0 +1,254 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <cstdio>
+#include <fstream>
+
+#include "bench_capture.h"
+#include <chisel.h>
+
+using namespace bench;
+
+//
+// A chisel in the spirit of topfiles and topprocs_file: it requests the
+// usual handful of fields and sums the bytes per file and per process,
+// keyed by a hash of the names. All the versions do the same work; the
+// FFI ones read the values in place instead of getting Lua strings, and
+// need LuaJIT.
+//
+enum chisel_mode
+{
+	CHISEL_EVENT = 0,
+	CHISEL_BATCH,
+	CHISEL_EVENT_FFI,
+	CHISEL_BATCH_FFI,
+	CHISEL_MODE_MAX,
+};
+
+static const char* CHISEL_PROLOGUE =
+	"args = {}\n"
+	"local fields = {\"fd.name\", \"fd.type\", \"proc.name\", \"proc.pid\",\n"
+	"\t\"evt.type\", \"evt.is_io\", \"evt.buflen\", \"evt.latency\", \"thread.tid\", \"evt.dir\"}\n"
+	"local h = {}\n"
+	"local files = {}\n"
+	"local procs = {}\n"
+	"function on_init()\n"
+	"\tfor i, f in ipairs(fields) do h[i] = chisel.request_field(f) end\n"
+	"\tif ffi_batches then chisel.set_ffi_batches(true) end\n"
+	"\treturn true\n"
+	"end\n"
+	"local function hash(s)\n"
+	"\tif s == nil then return nil end\n"
+	"\tlocal x = 0\n"
+	"\tfor i = 1, #s do x = (x * 31 + s:byte(i)) % 4294967296 end\n"
+	"\treturn x\n"
+	"end\n"
+	"local function account(name, isfile, pname, isio, buflen)\n"
+	"\tif isio and buflen ~= nil and isfile and name ~= nil and pname ~= nil then\n"
+	"\t\tfiles[name] = (files[name] or 0) + buflen\n"
+	"\t\tprocs[pname] = (procs[pname] or 0) + buflen\n"
+	"\tend\n"
+	"end\n";
+
+static const char* CHISEL_FFI_PROLOGUE =
+	"local ffi = require(\"ffi\")\n"
+	"ffi.cdef(chisel.ffi.cdef)\n"
+	"ffi.cdef(\"int memcmp(const void* a, const void* b, size_t n);\")\n"
+	"local field = ffi.cast(\"sinsp_ffi_field_fn\", chisel.ffi.field)\n"
+	"local column = ffi.cast(\"sinsp_ffi_column_fn\", chisel.ffi.column)\n"
+	"local NULL_LEN = 0xffffffff\n"
+	"local function hashp(p, n)\n"
+	"\tlocal x = 0\n"
+	"\tfor i = 0, n - 1 do x = (x * 31 + p[i]) % 4294967296 end\n"
+	"\treturn x\n"
+	"end\n"
+	"local function isfilep(p, n)\n"
+	"\treturn n == 4 and ffi.C.memcmp(p, \"file\", 4) == 0\n"
+	"end\n";
+
+static const char* CHISEL_ON_EVENT =
+	"function on_event()\n"
+	"\tlocal name, ftype, pname = evt.field(h[1]), evt.field(h[2]), evt.field(h[3])\n"
+	"\tevt.field(h[4]) evt.field(h[5])\n"
+	"\tlocal isio, buflen = evt.field(h[6]), evt.field(h[7])\n"
+	"\tevt.field(h[8]) evt.field(h[9]) evt.field(h[10])\n"
+	"\taccount(hash(name), ftype == \"file\", hash(pname), isio, buflen)\n"
+	"\treturn true\n"
+	"end\n";
+
+static const char* CHISEL_ON_EVENT_BATCH =
+	"function on_event_batch(batch, n)\n"
+	"\tlocal c1, c2, c3, c6, c7 = batch[h[1]], batch[h[2]], batch[h[3]], batch[h[6]], batch[h[7]]\n"
+	"\tfor i = 1, n do\n"
+	"\t\taccount(hash(c1[i]), c2[i] == \"file\", hash(c3[i]), c6[i], c7[i])\n"
+	"\tend\n"
+	"end\n";
+
+static const char* CHISEL_ON_EVENT_FFI =
+	"local len = ffi.new(\"uint32_t[1]\")\n"
+	"function on_event()\n"
+	"\tlocal ev = sievt\n"
+	"\tlocal p = field(ev, h[1], len)\n"
+	"\tlocal name = p ~= nil and hashp(p, len[0]) or nil\n"
+	"\tp = field(ev, h[2], len)\n"
+	"\tlocal isfile = p ~= nil and isfilep(p, len[0])\n"
+	"\tp = field(ev, h[3], len)\n"
+	"\tlocal pname = p ~= nil and hashp(p, len[0]) or nil\n"
+	"\tfield(ev, h[4], len) field(ev, h[5], len)\n"
+	"\tp = field(ev, h[6], len)\n"
+	"\tlocal isio = p ~= nil and ffi.cast(\"const uint32_t*\", p)[0] ~= 0\n"
+	"\tp = field(ev, h[7], len)\n"
+	"\tlocal buflen = p ~= nil and tonumber(ffi.cast(\"const uint64_t*\", p)[0]) or nil\n"
+	"\tfield(ev, h[8], len) field(ev, h[9], len) field(ev, h[10], len)\n"
+	"\taccount(name, isfile, pname, isio, buflen)\n"
+	"\treturn true\n"
+	"end\n";
+
+static const char* CHISEL_ON_EVENT_BATCH_FFI =
+	"ffi_batches = true\n"
+	"local data = ffi.new(\"const uint8_t*[1]\")\n"
+	"local offs = ffi.new(\"const uint32_t*[1]\")\n"
+	"local lens = ffi.new(\"const uint32_t*[1]\")\n"
+	"local function col(k)\n"
+	"\tcolumn(sichisel, h[k], data, offs, lens)\n"
+	"\treturn data[0], offs[0], lens[0]\n"
+	"end\n"
+	"function on_event_batch(batch, n)\n"
+	"\tlocal d1, o1, l1 = col(1)\n"
+	"\tlocal d2, o2, l2 = col(2)\n"
+	"\tlocal d3, o3, l3 = col(3)\n"
+	"\tlocal d6, o6, l6 = col(6)\n"
+	"\tlocal d7, o7, l7 = col(7)\n"
+	"\tfor i = 0, n - 1 do\n"
+	"\t\tlocal name = l1[i] ~= NULL_LEN and hashp(d1 + o1[i], l1[i]) or nil\n"
+	"\t\tlocal isfile = l2[i] ~= NULL_LEN and isfilep(d2 + o2[i], l2[i])\n"
+	"\t\tlocal pname = l3[i] ~= NULL_LEN and hashp(d3 + o3[i], l3[i]) or nil\n"
+	"\t\tlocal isio = l6[i] ~= NULL_LEN and ffi.cast(\"const uint32_t*\", d6 + o6[i])[0] ~= 0\n"
+	"\t\tlocal buflen = l7[i] ~= NULL_LEN and tonumber(ffi.cast(\"const uint64_t*\", d7 + o7[i])[0]) or nil\n"
+	"\t\taccount(name, isfile, pname, isio, buflen)\n"
+	"\tend\n"
+	"end\n";
+
+class chisel_files
+{
+public:
+	~chisel_files()
+	{
+		for(auto& path : m_paths)
+		{
+			if(!path.empty())
+			{
+				remove(path.c_str());
+			}
+		}
+	}
+
+	const std::string& get(chisel_mode mode)
+	{
+		static const char* names[CHISEL_MODE_MAX] = {
+			"chisel_evt.lua", "chisel_batch.lua", "chisel_evt_ffi.lua", "chisel_batch_ffi.lua"};
+
+		std::string& path = m_paths[mode];
+		if(path.empty())
+		{
+			std::string res = temp_path(names[mode]);
+			std::ofstream os(res);
+			os << CHISEL_PROLOGUE;
+			switch(mode)
+			{
+			case CHISEL_EVENT:
+				os << CHISEL_ON_EVENT;
+				break;
+			case CHISEL_BATCH:
+				os << CHISEL_ON_EVENT_BATCH;
+				break;
+			case CHISEL_EVENT_FFI:
+				os << CHISEL_FFI_PROLOGUE << CHISEL_ON_EVENT_FFI;
+				break;
+			default:
+				os << CHISEL_FFI_PROLOGUE << CHISEL_ON_EVENT_BATCH_FFI;
+				break;
+			}
+
+			if(!os.good())
+			{
+				throw sinsp_exception("can't write " + res);
+			}
+
+			path = res;
+		}
+
+		return path;
+	}
+
+private:
+	std::string m_paths[CHISEL_MODE_MAX];
+};
+
+static chisel_files s_chisels;
+
+struct chisel_op
+{
+	chisel_op(sinsp* inspector, benchmark::State&, chisel_mode mode)
+	{
+		m_chisel.reset(new sinsp_chisel(inspector, s_chisels.get(mode)));
+		m_chisel->on_init();
+	}
+
+	~chisel_op()
+	{
+		m_chisel->on_capture_end();
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		m_chisel->run(evt);
+	}
+
+	std::unique_ptr<sinsp_chisel> m_chisel;
+};
+
+//
+// Every event of a capture going through a chisel that requests ten
+// fields, calling on_event() for every event or on_event_batch() for
+// blocks of events. The last partial batch is delivered outside of the
+// measured time, at the end of the capture. The FFI versions are skipped
+// when the chisels can't load the ffi module.
+//
+static void BM_chisel(benchmark::State& state, capture_kind kind, chisel_mode mode)
+{
+	try
+	{
+		sinsp inspector;
+		sinsp_chisel chisel(&inspector, s_chisels.get(mode));
+	}
+	catch(const sinsp_exception& e)
+	{
+		state.SkipWithError(e.what());
+		return;
+	}
+
+	run_on_events<chisel_op>(state, kind, mode);
+}
+BENCHMARK_CAPTURE(BM_chisel, on_event, CAPTURE_IO, CHISEL_EVENT)->UseManualTime();
+BENCHMARK_CAPTURE(BM_chisel, on_event_batch, CAPTURE_IO, CHISEL_BATCH)->UseManualTime();
+BENCHMARK_CAPTURE(BM_chisel, on_event_ffi, CAPTURE_IO, CHISEL_EVENT_FFI)->UseManualTime();
+BENCHMARK_CAPTURE(BM_chisel, on_event_batch_ffi, CAPTURE_IO, CHISEL_BATCH_FFI)->UseManualTime();
+BENCHMARK_CAPTURE(BM_chisel, on_event_fd_churn, CAPTURE_FD_CHURN, CHISEL_EVENT)->UseManualTime();
+BENCHMARK_CAPTURE(BM_chisel, on_event_batch_fd_churn, CAPTURE_FD_CHURN, CHISEL_BATCH)->UseManualTime();
+BENCHMARK_CAPTURE(BM_chisel, on_event_ffi_fd_churn, CAPTURE_FD_CHURN, CHISEL_EVENT_FFI)->UseManualTime();
+BENCHMARK_CAPTURE(BM_chisel, on_event_batch_ffi_fd_churn, CAPTURE_FD_CHURN, CHISEL_BATCH_FFI)->UseManualTime();
@@ -0,0 +1,68 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <unistd.h>
+
+#include "bench_capture.h"
+#include <dumper.h>
+
+using namespace bench;
+
+struct dumper_op
+{
+	dumper_op(sinsp* inspector, benchmark::State&, bool compress):
+		m_dumper(inspector),
+		m_path(temp_path("dump.scap")),
+		m_compress(compress),
+		m_opened(false)
+	{
+	}
+
+	~dumper_op()
+	{
+		m_dumper.close();
+		unlink(m_path.c_str());
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		//
+		// The dump file takes the thread table from the capture, which
+		// is only available once it's open
+		//
+		if(!m_opened)
+		{
+			m_dumper.open(m_path, m_compress);
+			m_opened = true;
+		}
+
+		m_dumper.dump(evt);
+	}
+
+	sinsp_dumper m_dumper;
+	std::string m_path;
+	bool m_compress;
+	bool m_opened;
+};
+
+static void BM_dump(benchmark::State& state, capture_kind kind, bool compress)
+{
+	run_on_events<dumper_op>(state, kind, compress);
+}
+BENCHMARK_CAPTURE(BM_dump, io, CAPTURE_IO, false)->UseManualTime();
+BENCHMARK_CAPTURE(BM_dump, io_gzip, CAPTURE_IO, true)->UseManualTime();
+BENCHMARK_CAPTURE(BM_dump, thread_churn, CAPTURE_THREAD_CHURN, false)->UseManualTime();
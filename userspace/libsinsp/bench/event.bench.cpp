@@ -0,0 +1,90 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "bench_capture.h"
+
+using namespace bench;
+
+//
+// Reading the first parameter of every event, the fd or the result for
+// all the events of the io capture, the way the parsers read them
+//
+struct param_as_op
+{
+	param_as_op(sinsp*, benchmark::State&)
+	{
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		if(evt->get_num_params() > 0)
+		{
+			benchmark::DoNotOptimize(evt->get_param_as<int64_t>(0));
+		}
+	}
+};
+
+struct param_cast_op
+{
+	param_cast_op(sinsp*, benchmark::State&)
+	{
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		if(evt->get_num_params() > 0)
+		{
+			sinsp_evt_param* parinfo = evt->get_param(0);
+			ASSERT(parinfo->m_len == sizeof(int64_t));
+			benchmark::DoNotOptimize(*(int64_t*)parinfo->m_val);
+		}
+	}
+};
+
+//
+// Parameter lookup by name, as done by the evt.arg.NAME fields
+//
+struct param_by_name_op
+{
+	param_by_name_op(sinsp*, benchmark::State&)
+	{
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		benchmark::DoNotOptimize(evt->get_param_value_raw("fd"));
+		benchmark::DoNotOptimize(evt->get_param_value_raw("res"));
+	}
+};
+
+static void BM_evt_get_param_as(benchmark::State& state)
+{
+	run_on_events<param_as_op>(state, CAPTURE_IO);
+}
+BENCHMARK(BM_evt_get_param_as)->UseManualTime();
+
+static void BM_evt_get_param_cast(benchmark::State& state)
+{
+	run_on_events<param_cast_op>(state, CAPTURE_IO);
+}
+BENCHMARK(BM_evt_get_param_cast)->UseManualTime();
+
+static void BM_evt_get_param_by_name(benchmark::State& state)
+{
+	run_on_events<param_by_name_op>(state, CAPTURE_IO);
+}
+BENCHMARK(BM_evt_get_param_by_name)->UseManualTime();
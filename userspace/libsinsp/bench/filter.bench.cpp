@@ -0,0 +1,106 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <vector>
+
+#include "bench_capture.h"
+#include <filter.h>
+
+using namespace bench;
+
+//
+// A rule set shaped like the default falco rules: every rule is a
+// separate filter and runs on every event, and almost none of them
+// match. The rules cycle through the common comparison operators.
+//
+static std::string make_rule(uint32_t j)
+{
+	std::string id = std::to_string(j);
+
+	switch(j % 6)
+	{
+	case 0:
+		return "evt.type=open and fd.name startswith /etc/app" + id + "/ and proc.name in (sshd, sudo, job" + id + ")";
+	case 1:
+		return "evt.type in (read, write) and fd.name contains /secret" + id + "/";
+	case 2:
+		return "evt.type=execve and proc.cmdline icontains miner" + id;
+	case 3:
+		return "fd.name glob /var/lib/*/keys" + id + "/*";
+	case 4:
+		return "fd.name pmatch (/usr/lib/pkg" + id + ", /opt/pkg" + id + ")";
+	default:
+		return "evt.type=execve and proc.pname=sh and proc.exepath endswith /nc" + id;
+	}
+}
+
+struct filter_op
+{
+	filter_op(sinsp* inspector, benchmark::State&, std::vector<std::string> rules)
+	{
+		for(const auto& rule : rules)
+		{
+			sinsp_filter_compiler compiler(inspector, rule);
+			m_filters.push_back(std::unique_ptr<sinsp_filter>(compiler.compile()));
+		}
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		for(const auto& filter : m_filters)
+		{
+			benchmark::DoNotOptimize(filter->run(evt));
+		}
+	}
+
+	std::vector<std::unique_ptr<sinsp_filter>> m_filters;
+};
+
+static void BM_filter_ruleset(benchmark::State& state, capture_kind kind)
+{
+	std::vector<std::string> rules;
+	for(int64_t j = 0; j < state.range(0); j++)
+	{
+		rules.push_back(make_rule(j));
+	}
+
+	run_on_events<filter_op>(state, kind, rules);
+}
+BENCHMARK_CAPTURE(BM_filter_ruleset, io, CAPTURE_IO)->Arg(10)->Arg(100)->Arg(400)->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter_ruleset, fd_churn, CAPTURE_FD_CHURN)->Arg(100)->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter_ruleset, thread_churn, CAPTURE_THREAD_CHURN)->Arg(100)->UseManualTime();
+
+//
+// Single expressions, for the fields and operators that have a
+// dedicated fast path
+//
+static void BM_filter(benchmark::State& state, const char* expr)
+{
+	run_on_events<filter_op>(state, CAPTURE_IO, std::vector<std::string>{expr});
+}
+// proc.aname without an index walks all the ANCESTOR_DEPTH parents
+BENCHMARK_CAPTURE(BM_filter, aname_walk, "proc.aname=nomatch")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, aname_index, "proc.aname[8]=sh")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, apid_walk, "proc.apid=999999")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, contains, "fd.name contains /secret/")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, icontains, "proc.cmdline icontains MINER")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, startswith, "fd.name startswith /srv/data/15/")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, endswith, "fd.name endswith .key")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, glob, "fd.name glob /srv/*/keys/*")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, evt_arg_name, "evt.arg.fd=100")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, evt_arg_index, "evt.arg[0]=100")->UseManualTime();
+BENCHMARK_CAPTURE(BM_filter, evt_rawarg, "evt.rawarg.size>100000")->UseManualTime();
@@ -0,0 +1,109 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <vector>
+
+#include "bench_capture.h"
+#include <eventformatter.h>
+
+using namespace bench;
+
+//
+// Rule outputs sharing most of their fields, as in the default falco
+// rules
+//
+static const char* const formats[] =
+{
+	"%evt.time %evt.type user=%user.name command=%proc.cmdline file=%fd.name",
+	"%evt.time %proc.name (%proc.pid) %evt.type fd=%fd.num %fd.name",
+	"%evt.time parent=%proc.pname command=%proc.cmdline pcmdline=%proc.pcmdline",
+	"%evt.time %container.id %container.name %proc.name %fd.name",
+	"%evt.time user=%user.name %proc.exepath %evt.args",
+	"%evt.time %evt.type %evt.dir %evt.res %fd.name",
+	"%evt.time gparent=%proc.aname[2] ggparent=%proc.aname[3] %proc.cmdline",
+	"%evt.time %proc.name %thread.tid %fd.typechar %fd.directory",
+	"%evt.time %user.name %proc.name %proc.cwd %fd.filename",
+	"%evt.time %evt.num %evt.cpu %proc.name %evt.info",
+};
+
+struct formatter_op
+{
+	formatter_op(sinsp* inspector, benchmark::State& state, sinsp_evt::param_fmt fmt)
+	{
+		inspector->set_buffer_format(fmt);
+		for(int64_t j = 0; j < state.range(0); j++)
+		{
+			m_formatters.push_back(std::unique_ptr<sinsp_evt_formatter>(new sinsp_evt_formatter(inspector, formats[j])));
+		}
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		for(const auto& f : m_formatters)
+		{
+			f->tostring(evt, &m_res);
+			benchmark::DoNotOptimize(m_res.data());
+		}
+	}
+
+	std::vector<std::unique_ptr<sinsp_evt_formatter>> m_formatters;
+	std::string m_res;
+};
+
+struct formatter_group_op
+{
+	formatter_group_op(sinsp* inspector, benchmark::State& state, sinsp_evt::param_fmt fmt):
+		m_group(inspector)
+	{
+		inspector->set_buffer_format(fmt);
+		for(int64_t j = 0; j < state.range(0); j++)
+		{
+			m_group.add_format(formats[j]);
+		}
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		m_group.tostring(evt, &m_res, &m_show);
+		benchmark::DoNotOptimize(m_res.data());
+	}
+
+	sinsp_evt_formatter_group m_group;
+	std::vector<std::string> m_res;
+	std::vector<bool> m_show;
+};
+
+//
+// Every event rendered with the first range(0) formats, one formatter
+// per format
+//
+static void BM_format(benchmark::State& state, sinsp_evt::param_fmt fmt)
+{
+	run_on_events<formatter_op>(state, CAPTURE_IO, fmt);
+}
+BENCHMARK_CAPTURE(BM_format, text, sinsp_evt::PF_NORMAL)->Arg(1)->Arg(3)->Arg(10)->UseManualTime();
+BENCHMARK_CAPTURE(BM_format, json, sinsp_evt::PF_JSON)->Arg(1)->Arg(3)->Arg(10)->UseManualTime();
+
+//
+// The same, through a sinsp_evt_formatter_group
+//
+static void BM_format_group(benchmark::State& state, sinsp_evt::param_fmt fmt)
+{
+	run_on_events<formatter_group_op>(state, CAPTURE_IO, fmt);
+}
+BENCHMARK_CAPTURE(BM_format_group, text, sinsp_evt::PF_NORMAL)->Arg(1)->Arg(3)->Arg(10)->UseManualTime();
+BENCHMARK_CAPTURE(BM_format_group, json, sinsp_evt::PF_JSON)->Arg(1)->Arg(3)->Arg(10)->UseManualTime();
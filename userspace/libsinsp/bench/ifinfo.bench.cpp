@@ -0,0 +1,66 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <arpa/inet.h>
+
+#include <benchmark/benchmark.h>
+#include <sinsp.h>
+
+//
+// Address classification of new sockets on a host with range(0)
+// interfaces, eg. a node running many containers with a veth each
+//
+static void BM_ifinfo_update_fd(benchmark::State& state)
+{
+	sinsp_network_interfaces interfaces(nullptr);
+	interfaces.import_ipv4_interface(sinsp_ipv4_ifinfo(inet_addr("127.0.0.1"), inet_addr("255.0.0.0"),
+							   inet_addr("127.255.255.255"), "lo"));
+	for(int64_t i = 0; i < state.range(0); ++i)
+	{
+		std::string addr = "100." + std::to_string(64 + i / 256) + '.' + std::to_string(i % 256) + ".1";
+		interfaces.import_ipv4_interface(sinsp_ipv4_ifinfo(inet_addr(addr.c_str()), inet_addr("255.255.255.0"),
+								   0, ("veth" + std::to_string(i)).c_str()));
+	}
+
+	// half of the destinations are on the local subnets, half are not
+	std::vector<uint32_t> dips;
+	for(uint32_t i = 0; i < 1024; ++i)
+	{
+		std::string addr = (i % 2) ?
+			"100." + std::to_string(64 + (i / 2) % 16) + '.' + std::to_string(i % 256) + ".7" :
+			"8.8." + std::to_string(i % 256) + ".8";
+		dips.push_back(inet_addr(addr.c_str()));
+	}
+
+	sinsp_fdinfo_t fd;
+	fd.m_type = SCAP_FD_IPV4_SOCK;
+	for(auto _ : state)
+	{
+		for(uint32_t dip : dips)
+		{
+			fd.m_sockinfo.m_ipv4info.m_fields.m_sip = 0;
+			fd.m_sockinfo.m_ipv4info.m_fields.m_dip = dip;
+			fd.m_sockinfo.m_ipv4info.m_fields.m_sport = 1;
+			fd.m_sockinfo.m_ipv4info.m_fields.m_dport = 2;
+			interfaces.update_fd(&fd);
+			benchmark::DoNotOptimize(fd.m_sockinfo.m_ipv4info.m_fields.m_sip);
+			benchmark::DoNotOptimize(interfaces.is_ipv4addr_in_subnet(dip));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * dips.size());
+}
+BENCHMARK(BM_ifinfo_update_fd)->Arg(4)->Arg(256)->Arg(4000);
@@ -0,0 +1,134 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <algorithm>
+
+#include <benchmark/benchmark.h>
+#include <json/json.h>
+#include <json_list_splitter.h>
+#include <k8s_state.h>
+
+//
+// A pod list as returned by the API server, with npods items
+//
+static std::string make_pod_list(uint32_t npods)
+{
+	std::string res = "{\"kind\":\"PodList\",\"apiVersion\":\"v1\",\"metadata\":{\"resourceVersion\":\"42\"},\"items\":[";
+	for(uint32_t j = 0; j < npods; j++)
+	{
+		std::string id = std::to_string(j);
+		if(j > 0)
+		{
+			res += ',';
+		}
+		res += "{\"metadata\":{\"name\":\"web-" + id + "\",\"namespace\":\"default\",\"uid\":\"uid-" + id + "\","
+			"\"labels\":{\"app\":\"web\",\"pod-template-hash\":\"5d8f" + id + "\"}},"
+			"\"spec\":{\"nodeName\":\"node-" + std::to_string(j % 100) + "\",\"containers\":[{\"name\":\"web\",\"image\":\"nginx:1.21\"}]},"
+			"\"status\":{\"phase\":\"Running\",\"podIP\":\"10.0." + std::to_string(j / 256 % 256) + '.' + std::to_string(j % 256) + "\","
+			"\"containerStatuses\":[{\"name\":\"web\",\"containerID\":\"docker://0123456789ab" + id + "\"}]}}";
+	}
+	res += "]}";
+	return res;
+}
+
+//
+// Splitting the list into per item documents as it's received, in 16KB
+// chunks, and parsing each of them
+//
+static void BM_k8s_list_stream(benchmark::State& state)
+{
+	std::string list = make_pod_list(state.range(0));
+	const size_t chunk = 16 * 1024;
+	size_t max_buffered = 0;
+
+	for(auto _ : state)
+	{
+		json_list_splitter splitter;
+		json_list_splitter::json_list_t docs;
+		Json::Reader reader;
+		Json::Value root;
+		for(size_t pos = 0; pos < list.size(); pos += chunk)
+		{
+			splitter.feed(list.data() + pos, std::min(chunk, list.size() - pos), docs);
+			max_buffered = std::max(max_buffered, splitter.buffered());
+			for(const auto& doc : docs)
+			{
+				reader.parse(doc, root, false);
+			}
+			docs.clear();
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.SetBytesProcessed(state.iterations() * list.size());
+	state.counters["max_buffered"] = max_buffered;
+}
+BENCHMARK(BM_k8s_list_stream)->Arg(5000);
+
+//
+// Buffering the whole list and parsing it at once
+//
+static void BM_k8s_list_whole(benchmark::State& state)
+{
+	std::string list = make_pod_list(state.range(0));
+
+	for(auto _ : state)
+	{
+		Json::Reader reader;
+		Json::Value root;
+		reader.parse(list, root, false);
+		benchmark::DoNotOptimize(root.size());
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.SetBytesProcessed(state.iterations() * list.size());
+	state.counters["max_buffered"] = list.size();
+}
+BENCHMARK(BM_k8s_list_whole)->Arg(5000);
+
+//
+// Lookups of a pod by uid and by container id in a state with range(0)
+// pods
+//
+static void BM_k8s_state_lookup(benchmark::State& state)
+{
+	k8s_state_t k8s;
+	std::vector<std::string> uids;
+	std::vector<std::string> containers;
+	for(int64_t j = 0; j < state.range(0); j++)
+	{
+		std::string name = "web-" + std::to_string(j);
+		std::string container = "0123456789ab" + std::to_string(j);
+		k8s_pod_t& pod = k8s.get_component<k8s_pods, k8s_pod_t>(k8s.get_pods(), name, name + "-uid", "default");
+		pod.set_labels({{"app", "web"}});
+		pod.set_container_ids({"docker://" + container});
+		k8s.update_cache(k8s_component::K8S_PODS, pod.get_uid());
+		uids.push_back(pod.get_uid());
+		containers.push_back(container);
+	}
+
+	size_t j = 0;
+	for(auto _ : state)
+	{
+		j = (j + 7919) % uids.size();
+		benchmark::DoNotOptimize(k8s.has(k8s.get_pods(), uids[j]));
+		benchmark::DoNotOptimize(k8s.get_pod(containers[j]));
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_k8s_state_lookup)->Arg(100)->Arg(10000);
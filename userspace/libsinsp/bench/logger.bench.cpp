@@ -0,0 +1,100 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "bench_capture.h"
+#include <logger.h>
+
+using namespace bench;
+
+//
+// A debug message for every event, written to a file, the way a capture
+// loop with debug logging enabled does. Only the time spent in the
+// logging thread is measured: in async mode the formatting and the
+// writes happen in the background, and the messages that don't fit in
+// the ring are reported as dropped.
+//
+struct log_op
+{
+	log_op(sinsp*, benchmark::State&, bool async, uint64_t* dropped):
+		m_dropped(dropped)
+	{
+		std::string path = temp_path("logger.log");
+		m_logger.add_file_log(path);
+		remove(path.c_str());
+		m_logger.set_severity(sinsp_logger::SEV_DEBUG);
+		if(async)
+		{
+			m_logger.enable_async();
+		}
+	}
+
+	~log_op()
+	{
+		m_logger.flush();
+		*m_dropped += m_logger.get_dropped();
+		m_logger.disable_async();
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		m_logger.format(sinsp_logger::SEV_DEBUG, "event %" PRIu64 " %s tid=%" PRId64,
+				evt->get_num(), evt->get_name(), evt->get_tid());
+	}
+
+	sinsp_logger m_logger;
+	uint64_t* m_dropped;
+};
+
+//
+// The cost of a disabled debug message, which the hot paths pay all the
+// time
+//
+struct log_disabled_op
+{
+	log_disabled_op(sinsp*, benchmark::State&)
+	{
+		m_logger.set_severity(sinsp_logger::SEV_INFO);
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		m_logger.log_lazy(sinsp_logger::SEV_DEBUG, [evt]()
+		{
+			return std::string("event ") + std::to_string(evt->get_num());
+		});
+	}
+
+	sinsp_logger m_logger;
+};
+
+static void BM_logger(benchmark::State& state, capture_kind kind, bool async)
+{
+	uint64_t dropped = 0;
+	run_on_events<log_op>(state, kind, async, &dropped);
+	state.counters["dropped"] = benchmark::Counter((double)dropped, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_logger, sync, CAPTURE_IO, false)->UseManualTime();
+BENCHMARK_CAPTURE(BM_logger, async, CAPTURE_IO, true)->UseManualTime();
+
+static void BM_logger_disabled(benchmark::State& state, capture_kind kind)
+{
+	run_on_events<log_disabled_op>(state, kind);
+}
+BENCHMARK_CAPTURE(BM_logger_disabled, io, CAPTURE_IO)->UseManualTime();
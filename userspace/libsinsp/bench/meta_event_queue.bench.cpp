@@ -0,0 +1,127 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <tbb/concurrent_queue.h>
+#include <sinsp.h>
+#include <meta_event_queue.h>
+
+//
+// What sinsp::next() pays for every event when no meta event is
+// pending: the pending flag, against the empty concurrent queue and
+// local event pointer it replaces.
+//
+static void BM_meta_event_idle(benchmark::State& state)
+{
+	sinsp_meta_event_queue queue;
+
+	for(auto _ : state)
+	{
+		sinsp_evt* evt = queue.pending() ? queue.pop() : NULL;
+		benchmark::DoNotOptimize(evt);
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_meta_event_idle);
+
+static void BM_meta_event_idle_tbb(benchmark::State& state)
+{
+	tbb::concurrent_queue<std::shared_ptr<sinsp_evt>> queue;
+	std::shared_ptr<sinsp_evt> cur;
+	sinsp_evt* local = NULL;
+
+	for(auto _ : state)
+	{
+		sinsp_evt* evt = NULL;
+		if(local != NULL)
+		{
+			evt = local;
+			local = NULL;
+		}
+		else if(queue.try_pop(cur))
+		{
+			evt = cur.get();
+		}
+		benchmark::DoNotOptimize(evt);
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_meta_event_idle_tbb);
+
+//
+// Events pushed in batches of range(0) and taken one by one, as when a
+// k8s watch or a burst of new containers produces them. The items are
+// the events.
+//
+static void BM_meta_event_batch(benchmark::State& state)
+{
+	const size_t nevts = state.range(0);
+	std::vector<std::shared_ptr<sinsp_evt>> evts;
+	for(size_t j = 0; j < nevts; j++)
+	{
+		evts.push_back(std::make_shared<sinsp_evt>());
+	}
+
+	sinsp_meta_event_queue queue;
+	std::vector<std::shared_ptr<sinsp_evt>> batch;
+
+	for(auto _ : state)
+	{
+		batch = evts;
+		queue.push(batch);
+		while(queue.pending() && queue.pop() != NULL)
+		{
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * nevts);
+}
+BENCHMARK(BM_meta_event_batch)->Arg(1)->Arg(64);
+
+static void BM_meta_event_batch_tbb(benchmark::State& state)
+{
+	const size_t nevts = state.range(0);
+	std::vector<std::shared_ptr<sinsp_evt>> evts;
+	for(size_t j = 0; j < nevts; j++)
+	{
+		evts.push_back(std::make_shared<sinsp_evt>());
+	}
+
+	tbb::concurrent_queue<std::shared_ptr<sinsp_evt>> queue;
+	std::shared_ptr<sinsp_evt> cur;
+
+	for(auto _ : state)
+	{
+		for(auto& evt : evts)
+		{
+			queue.push(evt);
+		}
+		while(queue.try_pop(cur))
+		{
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * nevts);
+}
+BENCHMARK(BM_meta_event_batch_tbb)->Arg(1)->Arg(64);
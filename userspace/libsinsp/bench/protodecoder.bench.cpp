@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "bench_capture.h"
+
+using namespace bench;
+
+//
+// sinsp::next() with and without the socket protocol decoders. The items
+// are the reads and writes, so the difference between the versions is
+// the cost of decoding a read or write. On the io capture no FD is a
+// socket, so the decoders should cost nothing there.
+//
+static void BM_protodecoder(benchmark::State& state, capture_kind kind, bool http, bool dns)
+{
+	const std::string& path = capture_path(kind);
+	uint64_t nrw = 0;
+
+	for(auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<sinsp> inspector(new sinsp());
+		if(http)
+		{
+			inspector->require_protodecoder("http");
+		}
+		if(dns)
+		{
+			inspector->require_protodecoder("dns");
+		}
+		inspector->open(path);
+		state.ResumeTiming();
+
+		sinsp_evt* evt;
+		int32_t res;
+		while((res = inspector->next(&evt)) != SCAP_EOF)
+		{
+			if(res == SCAP_SUCCESS &&
+				(evt->get_type() == PPME_SYSCALL_READ_X || evt->get_type() == PPME_SYSCALL_WRITE_X))
+			{
+				nrw++;
+			}
+		}
+
+		state.PauseTiming();
+		inspector->close();
+		inspector.reset();
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(nrw);
+}
+BENCHMARK_CAPTURE(BM_protodecoder, net_off, CAPTURE_NET, false, false);
+BENCHMARK_CAPTURE(BM_protodecoder, net_http, CAPTURE_NET, true, false);
+BENCHMARK_CAPTURE(BM_protodecoder, net_http_dns, CAPTURE_NET, true, true);
+BENCHMARK_CAPTURE(BM_protodecoder, io_off, CAPTURE_IO, false, false);
+BENCHMARK_CAPTURE(BM_protodecoder, io_http_dns, CAPTURE_IO, true, true);
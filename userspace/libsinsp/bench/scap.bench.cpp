@@ -0,0 +1,62 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "bench_capture.h"
+
+using namespace bench;
+
+//
+// Raw reading of a capture with scap_next(), no parsing
+//
+static void BM_scap_next_offline(benchmark::State& state, capture_kind kind)
+{
+	const std::string& path = capture_path(kind);
+	uint64_t nevts = 0;
+	uint64_t nbytes = 0;
+
+	for(auto _ : state)
+	{
+		state.PauseTiming();
+		char error[SCAP_LASTERR_SIZE];
+		int32_t rc;
+		scap_t* h = scap_open_offline(path.c_str(), error, &rc);
+		if(h == NULL)
+		{
+			state.SkipWithError(error);
+			break;
+		}
+		state.ResumeTiming();
+
+		scap_evt* evt;
+		uint16_t cpuid;
+		while(scap_next(h, &evt, &cpuid) == SCAP_SUCCESS)
+		{
+			nevts++;
+			nbytes += evt->len;
+		}
+
+		state.PauseTiming();
+		scap_close(h);
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(nevts);
+	state.SetBytesProcessed(nbytes);
+}
+BENCHMARK_CAPTURE(BM_scap_next_offline, io, CAPTURE_IO);
+BENCHMARK_CAPTURE(BM_scap_next_offline, fd_churn, CAPTURE_FD_CHURN);
+BENCHMARK_CAPTURE(BM_scap_next_offline, thread_churn, CAPTURE_THREAD_CHURN);
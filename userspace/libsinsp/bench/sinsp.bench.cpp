@@ -0,0 +1,94 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "bench_capture.h"
+
+using namespace bench;
+
+//
+// Full sinsp::next() throughput: reading, parsing and the thread and fd
+// table updates. The thread_churn and fd_churn captures stress the
+// thread and fd tables.
+//
+static void BM_sinsp_next(benchmark::State& state, capture_kind kind)
+{
+	const std::string& path = capture_path(kind);
+	uint64_t nevts = 0;
+#ifdef GATHER_INTERNAL_STATS
+	uint64_t nstored = 0;
+	uint64_t nstored_bytes = 0;
+#endif
+
+	for(auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<sinsp> inspector(new sinsp());
+		inspector->open(path);
+		state.ResumeTiming();
+
+		sinsp_evt* evt;
+		int32_t res;
+		while((res = inspector->next(&evt)) != SCAP_EOF)
+		{
+			if(res == SCAP_SUCCESS)
+			{
+				nevts++;
+			}
+		}
+
+		state.PauseTiming();
+#ifdef GATHER_INTERNAL_STATS
+		sinsp_stats stats = inspector->get_stats();
+		nstored += stats.m_n_stored_evts;
+		nstored_bytes += stats.m_n_stored_bytes;
+#endif
+		inspector->close();
+		inspector.reset();
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(nevts);
+#ifdef GATHER_INTERNAL_STATS
+	state.counters["stored_evts"] = benchmark::Counter(nstored, benchmark::Counter::kIsRate);
+	state.counters["stored_bytes"] = benchmark::Counter(nstored_bytes, benchmark::Counter::kIsRate);
+#endif
+}
+BENCHMARK_CAPTURE(BM_sinsp_next, io, CAPTURE_IO);
+BENCHMARK_CAPTURE(BM_sinsp_next, fd_churn, CAPTURE_FD_CHURN);
+BENCHMARK_CAPTURE(BM_sinsp_next, thread_churn, CAPTURE_THREAD_CHURN);
+
+//
+// The cost of the run_on_events() harness itself, to be subtracted from
+// the benchmarks of cheap per-event operations
+//
+struct noop_op
+{
+	noop_op(sinsp*, benchmark::State&)
+	{
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		benchmark::DoNotOptimize(evt);
+	}
+};
+
+static void BM_events_noop(benchmark::State& state)
+{
+	run_on_events<noop_op>(state, CAPTURE_IO);
+}
+BENCHMARK(BM_events_noop)->UseManualTime();
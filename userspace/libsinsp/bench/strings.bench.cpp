@@ -0,0 +1,191 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <fnmatch.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <glob_matcher.h>
+#include <string_search.h>
+
+//
+// The string comparisons of the filter operators, against the libc
+// functions they replaced, on fd.name and proc.cmdline like values that
+// mostly do not match
+//
+static const std::vector<std::string>& haystacks()
+{
+	static std::vector<std::string> res;
+	if(res.empty())
+	{
+		for(uint32_t j = 0; j < 64; j++)
+		{
+			std::string id = std::to_string(j);
+			res.push_back("/var/lib/docker/overlay2/" + id + "0123456789abcdef/merged/usr/lib/x86_64-linux-gnu/lib" + id + ".so");
+			res.push_back("/usr/bin/python3 -m http.server --bind 0.0.0.0 80" + id + " --directory /srv/www/" + id);
+		}
+	}
+	return res;
+}
+
+static void BM_string_search_contains(benchmark::State& state)
+{
+	string_search search;
+	search.set("/secret/", sizeof("/secret/") - 1);
+	for(auto _ : state)
+	{
+		for(const auto& h : haystacks())
+		{
+			benchmark::DoNotOptimize(search.find(h.c_str(), h.size()));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * haystacks().size());
+}
+BENCHMARK(BM_string_search_contains);
+
+static void BM_strstr(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		for(const auto& h : haystacks())
+		{
+			benchmark::DoNotOptimize(strstr(h.c_str(), "/secret/"));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * haystacks().size());
+}
+BENCHMARK(BM_strstr);
+
+static void BM_string_search_icontains(benchmark::State& state)
+{
+	string_search search;
+	search.set("MINER", sizeof("MINER") - 1);
+	for(auto _ : state)
+	{
+		for(const auto& h : haystacks())
+		{
+			benchmark::DoNotOptimize(search.find_nocase(h.c_str(), h.size()));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * haystacks().size());
+}
+BENCHMARK(BM_string_search_icontains);
+
+static void BM_strcasestr(benchmark::State& state)
+{
+	for(auto _ : state)
+	{
+		for(const auto& h : haystacks())
+		{
+			benchmark::DoNotOptimize(strcasestr(h.c_str(), "MINER"));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * haystacks().size());
+}
+BENCHMARK(BM_strcasestr);
+
+static void BM_string_search_startswith_endswith(benchmark::State& state)
+{
+	string_search prefix;
+	prefix.set("/var/lib/docker/overlay2/9", sizeof("/var/lib/docker/overlay2/9") - 1);
+	string_search suffix;
+	suffix.set(".key", sizeof(".key") - 1);
+	for(auto _ : state)
+	{
+		for(const auto& h : haystacks())
+		{
+			benchmark::DoNotOptimize(prefix.is_prefix_of(h.c_str()));
+			benchmark::DoNotOptimize(suffix.is_suffix_of(h.c_str(), h.size()));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * haystacks().size());
+}
+BENCHMARK(BM_string_search_startswith_endswith);
+
+static void BM_strncmp_startswith_endswith(benchmark::State& state)
+{
+	const char* prefix = "/var/lib/docker/overlay2/9";
+	const char* suffix = ".key";
+	for(auto _ : state)
+	{
+		for(const auto& h : haystacks())
+		{
+			size_t plen = strlen(prefix);
+			size_t slen = strlen(suffix);
+			size_t len = strlen(h.c_str());
+			benchmark::DoNotOptimize(strncmp(h.c_str(), prefix, plen) == 0);
+			benchmark::DoNotOptimize(len >= slen && strcmp(h.c_str() + len - slen, suffix) == 0);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * haystacks().size());
+}
+BENCHMARK(BM_strncmp_startswith_endswith);
+
+//
+// Glob patterns as found in rules, compiled once vs fnmatch()
+//
+static const char* const glob_patterns[] =
+{
+	"/etc/*",
+	"*.sh",
+	"/proc/*/environ",
+	"*/.ssh/*",
+	"/var/lib/docker/overlay2/*/merged/usr/lib/*/libc.so.?",
+	"/dev/tty[0-9]",
+};
+
+static void BM_glob_matcher(benchmark::State& state)
+{
+	std::vector<glob_matcher> matchers(sizeof(glob_patterns) / sizeof(glob_patterns[0]));
+	for(size_t j = 0; j < matchers.size(); j++)
+	{
+		matchers[j].compile(glob_patterns[j], strlen(glob_patterns[j]));
+	}
+
+	for(auto _ : state)
+	{
+		for(const auto& h : haystacks())
+		{
+			for(const auto& m : matchers)
+			{
+				benchmark::DoNotOptimize(m.match(h.c_str(), h.size()));
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * haystacks().size() * matchers.size());
+}
+BENCHMARK(BM_glob_matcher);
+
+static void BM_fnmatch(benchmark::State& state)
+{
+	size_t npatterns = sizeof(glob_patterns) / sizeof(glob_patterns[0]);
+	for(auto _ : state)
+	{
+		for(const auto& h : haystacks())
+		{
+			for(size_t j = 0; j < npatterns; j++)
+			{
+				benchmark::DoNotOptimize(fnmatch(glob_patterns[j], h.c_str(), 0));
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * haystacks().size() * npatterns);
+}
+BENCHMARK(BM_fnmatch);
@@ -0,0 +1,154 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <vector>
+
+#include "bench_capture.h"
+#include <table.h>
+
+using namespace bench;
+
+//
+// The captures are a fraction of a second long, so the tables refresh
+// every 10ms to emit a number of samples
+//
+static const uint64_t REFRESH_INTERVAL_NS = 10000000;
+
+//
+// Column layouts of the standard csysdig views
+//
+enum view_kind
+{
+	VIEW_PROCS = 0,
+	VIEW_FILES,
+	VIEW_FILES_BY_PROC,
+	VIEW_SPY,
+	// procs, with the distinct files and the latency percentiles
+	VIEW_PROCS_SKETCHES,
+};
+
+static sinsp_view_column_info column(const char* field, uint32_t flags,
+	sinsp_field_aggregation aggregation, sinsp_field_aggregation groupby_aggregation = A_NONE)
+{
+	return sinsp_view_column_info(field, field, "", 10, flags,
+		aggregation, groupby_aggregation, vector<string>(), "");
+}
+
+struct table_op
+{
+	table_op(sinsp* inspector, benchmark::State&, view_kind kind, uint32_t max_rows)
+	{
+		vector<sinsp_view_column_info> columns;
+		sinsp_table::tabletype type = sinsp_table::TT_TABLE;
+		string filter;
+
+		switch(kind)
+		{
+		case VIEW_PROCS:
+			columns.push_back(column("proc.pid", TEF_IS_KEY, A_NONE));
+			columns.push_back(column("evt.count", TEF_NONE, A_SUM));
+			columns.push_back(column("evt.buflen.in", TEF_NONE, A_TIME_AVG));
+			columns.push_back(column("evt.buflen.out", TEF_NONE, A_TIME_AVG));
+			columns.push_back(column("evt.latency", TEF_NONE, A_AVG));
+			columns.push_back(column("proc.name", TEF_NONE, A_NONE));
+			columns.push_back(column("proc.cmdline", TEF_NONE, A_NONE));
+			break;
+		case VIEW_FILES:
+			columns.push_back(column("fd.name", TEF_IS_KEY, A_NONE));
+			columns.push_back(column("evt.buflen.file.in", TEF_NONE, A_TIME_AVG));
+			columns.push_back(column("evt.buflen.file.out", TEF_NONE, A_TIME_AVG));
+			columns.push_back(column("evt.count", TEF_NONE, A_SUM));
+			columns.push_back(column("proc.name", TEF_NONE, A_NONE));
+			filter = "fd.type=file";
+			break;
+		case VIEW_FILES_BY_PROC:
+			columns.push_back(column("fd.name", TEF_IS_KEY, A_NONE));
+			columns.push_back(column("proc.pid", TEF_IS_GROUPBY_KEY, A_NONE));
+			columns.push_back(column("evt.buflen", TEF_NONE, A_SUM, A_SUM));
+			columns.push_back(column("evt.count", TEF_NONE, A_SUM, A_SUM));
+			columns.push_back(column("evt.latency", TEF_NONE, A_MAX, A_MAX));
+			columns.push_back(column("proc.name", TEF_NONE, A_NONE, A_NONE));
+			filter = "fd.type=file";
+			break;
+		case VIEW_SPY:
+			type = sinsp_table::TT_LIST;
+			columns.push_back(column("evt.type", TEF_NONE, A_NONE));
+			columns.push_back(column("proc.name", TEF_NONE, A_NONE));
+			columns.push_back(column("fd.name", TEF_NONE, A_NONE));
+			columns.push_back(column("evt.buflen", TEF_NONE, A_NONE));
+			filter = "evt.dir=<";
+			break;
+		case VIEW_PROCS_SKETCHES:
+			columns.push_back(column("proc.pid", TEF_IS_KEY, A_NONE));
+			columns.push_back(column("evt.count", TEF_NONE, A_SUM));
+			columns.push_back(column("fd.name", TEF_NONE, A_DISTINCT));
+			columns.push_back(column("evt.latency", TEF_NONE, A_P50));
+			columns.push_back(column("evt.latency", TEF_NONE, A_P99));
+			columns.push_back(column("proc.name", TEF_NONE, A_NONE));
+			break;
+		}
+
+		m_table.reset(new sinsp_table(inspector, type, REFRESH_INTERVAL_NS,
+			sinsp_table::OT_CURSES, 0, 0));
+		m_table->configure(&columns, filter, false, 0);
+		if(type == sinsp_table::TT_TABLE)
+		{
+			m_table->set_sorting_col(1);
+			m_table->set_max_rows(max_rows);
+		}
+	}
+
+	void operator()(sinsp_evt* evt)
+	{
+		if(evt->get_ts() >= m_table->m_next_flush_time_ns)
+		{
+			bool emit = (m_table->m_next_flush_time_ns != 0);
+
+			m_table->flush(evt);
+			if(emit)
+			{
+				benchmark::DoNotOptimize(m_table->get_sample(REFRESH_INTERVAL_NS));
+				if(m_table->get_type() == sinsp_table::TT_LIST)
+				{
+					m_table->clear();
+				}
+			}
+		}
+
+		m_table->process_event(evt);
+	}
+
+	std::unique_ptr<sinsp_table> m_table;
+};
+
+//
+// Every event of a capture going through a view, including the samples
+// emitted at every refresh. A max_rows other than 0 bounds the table to
+// its top rows.
+//
+static void BM_table(benchmark::State& state, capture_kind kind, view_kind view, uint32_t max_rows)
+{
+	run_on_events<table_op>(state, kind, view, max_rows);
+}
+BENCHMARK_CAPTURE(BM_table, procs, CAPTURE_IO, VIEW_PROCS, 0)->UseManualTime();
+BENCHMARK_CAPTURE(BM_table, files, CAPTURE_IO, VIEW_FILES, 0)->UseManualTime();
+BENCHMARK_CAPTURE(BM_table, files_fd_churn, CAPTURE_FD_CHURN, VIEW_FILES, 0)->UseManualTime();
+BENCHMARK_CAPTURE(BM_table, files_fd_churn_top20, CAPTURE_FD_CHURN, VIEW_FILES, 20)->UseManualTime();
+BENCHMARK_CAPTURE(BM_table, files_by_proc, CAPTURE_IO, VIEW_FILES_BY_PROC, 0)->UseManualTime();
+BENCHMARK_CAPTURE(BM_table, procs_thread_churn, CAPTURE_THREAD_CHURN, VIEW_PROCS, 0)->UseManualTime();
+BENCHMARK_CAPTURE(BM_table, procs_sketches, CAPTURE_FD_CHURN, VIEW_PROCS_SKETCHES, 0)->UseManualTime();
+BENCHMARK_CAPTURE(BM_table, spy, CAPTURE_IO, VIEW_SPY, 0)->UseManualTime();
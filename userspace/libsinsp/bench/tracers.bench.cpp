@@ -0,0 +1,114 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <sinsp.h>
+#include <tracers.h>
+
+//
+// Synthetic tracer traffic: every thread opens nested spans, the way an
+// instrumented request handler does, and closes them in reverse order.
+// All the threads open their spans before any is closed, so the exits
+// look up a span among nthreads * DEPTH open ones. The pool of partial
+// tracers holds 128, so nthreads * DEPTH must stay below that.
+//
+static const uint32_t DEPTH = 3;
+
+enum tracer_format
+{
+	FORMAT_JSON = 0,
+	FORMAT_SIMPLE,
+};
+
+static std::string tracer_message(tracer_format format, bool enter, uint32_t id, uint32_t depth)
+{
+	static const char* tags[DEPTH] = {"http", "handler", "db"};
+	std::string res;
+
+	if(format == FORMAT_JSON)
+	{
+		res = std::string("[\"") + (enter ? ">" : "<") + "\", " + std::to_string(id) + ", [\"app\"";
+		for(uint32_t j = 0; j <= depth; j++)
+		{
+			res += std::string(", \"") + tags[j] + "\"";
+		}
+		res += "], [{\"method\":\"GET\"}, {\"url\":\"/api/v1/items?page=" + std::to_string(id) + "\"}]]";
+	}
+	else
+	{
+		res = std::string(enter ? ">" : "<") + ":" + std::to_string(id) + ":app";
+		for(uint32_t j = 0; j <= depth; j++)
+		{
+			res += std::string(".") + tags[j];
+		}
+		res += ":method=GET,url=/api/v1/items?page\\=" + std::to_string(id) + ":";
+	}
+
+	return res;
+}
+
+static void BM_tracer_parse(benchmark::State& state, tracer_format format, uint32_t nthreads)
+{
+	std::vector<std::vector<char>> msgs;
+	for(uint32_t d = 0; d < DEPTH; d++)
+	{
+		for(uint32_t t = 0; t < nthreads; t++)
+		{
+			std::string m = tracer_message(format, true, 1000 + t, d);
+			msgs.push_back(std::vector<char>(m.begin(), m.end()));
+		}
+	}
+	for(uint32_t d = DEPTH; d-- > 0; )
+	{
+		for(uint32_t t = 0; t < nthreads; t++)
+		{
+			std::string m = tracer_message(format, false, 1000 + t, d);
+			msgs.push_back(std::vector<char>(m.begin(), m.end()));
+		}
+	}
+
+	std::unique_ptr<sinsp> inspector(new sinsp());
+	inspector->request_tracer_state_tracking();
+	sinsp_threadinfo tinfo(inspector.get());
+	tinfo.m_tid = tinfo.m_pid = tinfo.m_ptid = 1;
+
+	sinsp_tracerparser parser(inspector.get());
+	parser.m_tinfo = &tinfo;
+
+	for(auto _ : state)
+	{
+		for(auto& m : msgs)
+		{
+			parser.process_event_data(m.data(), (uint32_t)m.size(), 0);
+			if(parser.m_enter_pae == NULL)
+			{
+				state.SkipWithError("unmatched tracer exit");
+				return;
+			}
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * msgs.size());
+}
+BENCHMARK_CAPTURE(BM_tracer_parse, json_1_thread, FORMAT_JSON, 1);
+BENCHMARK_CAPTURE(BM_tracer_parse, json_32_threads, FORMAT_JSON, 32);
+BENCHMARK_CAPTURE(BM_tracer_parse, simple_1_thread, FORMAT_SIMPLE, 1);
+BENCHMARK_CAPTURE(BM_tracer_parse, simple_32_threads, FORMAT_SIMPLE, 32);
@@ -37,6 +37,7 @@ limitations under the License.
 #include "sinsp_int.h"
 #include "container.h"
 #include "utils.h"
+#include "stage_timers.h"
 
 using namespace libsinsp;
 
@@ -120,6 +121,8 @@ sinsp_container_info::ptr_t sinsp_container_manager::get_container(const string&
 
 bool sinsp_container_manager::resolve_container(sinsp_threadinfo* tinfo, bool query_os_for_missing_info)
 {
+	internal_metrics::scoped_stage_timer stage_timer(internal_metrics::STAGE_CONTAINER);
+
 	ASSERT(tinfo);
 	bool matches = false;
 
@@ -329,10 +332,8 @@ void sinsp_container_manager::notify_new_container(const sinsp_container_info& c
 
 		std::shared_ptr<sinsp_evt> cevt(evt);
 
-		// Enqueue it onto the queue of pending container events for the inspector
-#ifndef _WIN32
-		m_inspector->m_pending_container_evts.push(cevt);
-#endif
+		// Enqueue it onto the queue of pending meta events for the inspector
+		m_inspector->queue_meta_event(cevt);
 	}
 	else
 	{
@@ -15,63 +15,61 @@ limitations under the License.
 
 */
 
+#include <algorithm>
 #include "dns_manager.h"
 
+void sinsp_getaddrinfo_lookup::resolve(const std::string& name, std::set<uint32_t>& v4_addrs, std::set<ipv6addr>& v6_addrs)
+{
+#if defined(HAS_CAPTURE) && !defined(CYGWING_AGENT) && !defined(_WIN32)
+	struct addrinfo hints, *result, *rp;
+	memset(&hints, 0, sizeof(struct addrinfo));
+
+	// Allow IPv4 or IPv6, all socket types, all protocols
+	hints.ai_family = AF_UNSPEC;
+
+	int s = getaddrinfo(name.c_str(), NULL, &hints, &result);
+	if (!s && result)
+	{
+		for (rp = result; rp != NULL; rp = rp->ai_next)
+		{
+			if(rp->ai_family == AF_INET)
+			{
+				v4_addrs.insert(((struct sockaddr_in*)rp->ai_addr)->sin_addr.s_addr);
+			}
+			else // AF_INET6
+			{
+				ipv6addr v6;
+				memcpy(v6.m_b, ((struct sockaddr_in6*)rp->ai_addr)->sin6_addr.s6_addr, sizeof(ipv6addr));
+				v6_addrs.insert(v6);
+			}
+		}
+		freeaddrinfo(result);
+	}
+#endif
+}
+
 void sinsp_dns_resolver::refresh(uint64_t erase_timeout, uint64_t base_refresh_timeout, uint64_t max_refresh_timeout, std::future<void> f_exit)
 {
 #if defined(HAS_CAPTURE) && !defined(CYGWING_AGENT) && !defined(_WIN32)
 	sinsp_dns_manager &manager = sinsp_dns_manager::get();
+	std::vector<std::string> due;
 	while(true)
 	{
-		if(!manager.m_cache.empty())
+		if(manager.m_size)
 		{
-			std::list<std::string> to_delete;
-
 			uint64_t ts = sinsp_utils::get_current_time_ns();
 
-			for(auto &it: manager.m_cache)
+			due.clear();
+			manager.collect(ts, erase_timeout, due);
+			if(!due.empty())
 			{
-				const std::string &name = it.first;
-				sinsp_dns_manager::dns_info &info = it.second;
-
-				if((ts > info.m_last_used_ts) &&
-				   (ts - info.m_last_used_ts) > erase_timeout)
-				{
-					// remove the entry if it's hasn't been used for a whole hour
-					to_delete.push_back(name);
-				}
-				else if(ts > (info.m_last_resolve_ts + info.m_timeout))
-				{
-					sinsp_dns_manager::dns_info refreshed_info = manager.resolve(name, ts);
-					refreshed_info.m_timeout = base_refresh_timeout;
-					refreshed_info.m_last_resolve_ts = info.m_last_resolve_ts = ts;
-
-					// dns_info::operator!= will check if some
-					// v4 or v6 addresses are changed from the
-					// last resolution
-					if(refreshed_info != info)
-					{
-						info = refreshed_info;
-					}
-					else if(info.m_timeout < max_refresh_timeout)
-					{
-						// double the timeout until 320 secs
-						info.m_timeout <<= 1;
-					}
-				}
-			}
-			if(!to_delete.empty())
-			{
-				manager.m_erase_mutex.lock();
-				for(const auto &name : to_delete)
-				{
-					manager.m_cache.unsafe_erase(name);
-				}
-				manager.m_erase_mutex.unlock();
+				manager.refresh(due, ts, base_refresh_timeout, max_refresh_timeout);
 			}
 		}
 
-		if(f_exit.wait_for(std::chrono::nanoseconds(base_refresh_timeout)) == std::future_status::ready)
+		// jittered, so that many agents started together do not
+		// hit the DNS servers in lockstep
+		if(f_exit.wait_for(std::chrono::nanoseconds(manager.jitter(base_refresh_timeout))) == std::future_status::ready)
 		{
 			break;
 		}
@@ -80,35 +78,182 @@ void sinsp_dns_resolver::refresh(uint64_t erase_timeout, uint64_t base_refresh_t
 }
 
 #if defined(HAS_CAPTURE) && !defined(CYGWING_AGENT) && !defined(_WIN32)
-inline sinsp_dns_manager::dns_info sinsp_dns_manager::resolve(const std::string &name, uint64_t ts)
+sinsp_dns_manager::name_shard& sinsp_dns_manager::shard_of(const std::string& name)
+{
+	return m_name_shards[std::hash<std::string>()(name) % SHARD_COUNT];
+}
+
+sinsp_dns_manager::addr_shard& sinsp_dns_manager::shard_of(uint32_t addr)
+{
+	// addresses are in network byte order, mix all the bytes in
+	return m_addr_shards[(static_cast<uint32_t>(addr * 2654435761u) >> 16) % SHARD_COUNT];
+}
+
+sinsp_dns_manager::addr_shard& sinsp_dns_manager::shard_of(const ipv6addr& addr)
+{
+	return m_addr_shards[std::hash<ipv6addr>()(addr) % SHARD_COUNT];
+}
+
+sinsp_dns_manager::dns_info sinsp_dns_manager::resolve(const std::string &name)
 {
 	dns_info dinfo;
+	sinsp_dns_lookup::ptr_t lookup = std::atomic_load(&m_lookup);
+	if(lookup)
+	{
+		lookup->resolve(name, dinfo.m_v4_addrs, dinfo.m_v6_addrs);
+	}
+	return dinfo;
+}
 
-	struct addrinfo hints, *result, *rp;
-	memset(&hints, 0, sizeof(struct addrinfo));
+void sinsp_dns_manager::index(const std::string& name, const dns_info& info)
+{
+	for(uint32_t addr : info.m_v4_addrs)
+	{
+		addr_shard& shard = shard_of(addr);
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+		name_list& names = shard.m_v4[addr];
+		if(std::find(names.begin(), names.end(), name) == names.end())
+		{
+			names.push_back(name);
+		}
+	}
+	for(const ipv6addr& addr : info.m_v6_addrs)
+	{
+		addr_shard& shard = shard_of(addr);
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+		name_list& names = shard.m_v6[addr];
+		if(std::find(names.begin(), names.end(), name) == names.end())
+		{
+			names.push_back(name);
+		}
+	}
+}
 
-	// Allow IPv4 or IPv6, all socket types, all protocols
-	hints.ai_family = AF_UNSPEC;
+void sinsp_dns_manager::unindex(const std::string& name, const dns_info& info)
+{
+	for(uint32_t addr : info.m_v4_addrs)
+	{
+		addr_shard& shard = shard_of(addr);
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+		auto it = shard.m_v4.find(addr);
+		if(it != shard.m_v4.end())
+		{
+			it->second.erase(std::remove(it->second.begin(), it->second.end(), name), it->second.end());
+			if(it->second.empty())
+			{
+				shard.m_v4.erase(it);
+			}
+		}
+	}
+	for(const ipv6addr& addr : info.m_v6_addrs)
+	{
+		addr_shard& shard = shard_of(addr);
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+		auto it = shard.m_v6.find(addr);
+		if(it != shard.m_v6.end())
+		{
+			it->second.erase(std::remove(it->second.begin(), it->second.end(), name), it->second.end());
+			if(it->second.empty())
+			{
+				shard.m_v6.erase(it);
+			}
+		}
+	}
+}
 
-	int s = getaddrinfo(name.c_str(), NULL, &hints, &result);
-	if (!s && result)
+void sinsp_dns_manager::erase(name_shard& shard, std::unordered_map<std::string, dns_info>::iterator it)
+{
+	unindex(it->first, it->second);
+	shard.m_lru.erase(it->second.m_lru);
+	shard.m_names.erase(it);
+	--m_size;
+}
+
+void sinsp_dns_manager::collect(uint64_t ts, uint64_t erase_timeout, std::vector<std::string>& due)
+{
+	for(auto& shard : m_name_shards)
 	{
-		for (rp = result; rp != NULL; rp = rp->ai_next)
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+		for(auto it = shard.m_names.begin(); it != shard.m_names.end();)
 		{
-			if(rp->ai_family == AF_INET)
+			const dns_info &info = it->second;
+			if((ts > info.m_last_used_ts) &&
+			   (ts - info.m_last_used_ts) > erase_timeout)
 			{
-				dinfo.m_v4_addrs.insert(((struct sockaddr_in*)rp->ai_addr)->sin_addr.s_addr);
+				// remove the entry if it's hasn't been used for a whole hour
+				erase(shard, it++);
+				continue;
 			}
-			else // AF_INET6
+			if(ts > info.m_next_resolve_ts)
 			{
-				ipv6addr v6;
-				memcpy(v6.m_b, ((struct sockaddr_in6*)rp->ai_addr)->sin6_addr.s6_addr, sizeof(ipv6addr));
-				dinfo.m_v6_addrs.insert(v6);
+				due.push_back(it->first);
 			}
+			++it;
 		}
-		freeaddrinfo(result);
 	}
-	return dinfo;
+}
+
+void sinsp_dns_manager::refresh(const std::vector<std::string>& names, uint64_t ts,
+				uint64_t base_refresh_timeout, uint64_t max_refresh_timeout)
+{
+	// resolve in parallel batches, without holding any lock
+	std::vector<dns_info> resolved(names.size());
+	size_t workers = (names.size() < MAX_RESOLVE_THREADS) ? names.size() : MAX_RESOLVE_THREADS;
+	size_t batch = (names.size() + workers - 1) / workers;
+	std::vector<std::future<void>> tasks;
+	for(size_t start = 0; start < names.size(); start += batch)
+	{
+		size_t end = (start + batch < names.size()) ? start + batch : names.size();
+		tasks.emplace_back(std::async(std::launch::async, [this, &names, &resolved, start, end]()
+		{
+			for(size_t i = start; i < end; ++i)
+			{
+				resolved[i] = resolve(names[i]);
+			}
+		}));
+	}
+	for(auto& task : tasks)
+	{
+		task.wait();
+	}
+
+	for(size_t i = 0; i < names.size(); ++i)
+	{
+		name_shard& shard = shard_of(names[i]);
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+		auto it = shard.m_names.find(names[i]);
+		if(it == shard.m_names.end())
+		{
+			// evicted while being resolved
+			continue;
+		}
+		dns_info &info = it->second;
+		info.m_last_resolve_ts = ts;
+
+		// dns_info::operator!= will check if some
+		// v4 or v6 addresses are changed from the
+		// last resolution
+		if(resolved[i] != info)
+		{
+			unindex(names[i], info);
+			info.m_v4_addrs.swap(resolved[i].m_v4_addrs);
+			info.m_v6_addrs.swap(resolved[i].m_v6_addrs);
+			index(names[i], info);
+			info.m_timeout = base_refresh_timeout;
+		}
+		else if(info.m_timeout < max_refresh_timeout)
+		{
+			// double the timeout until 320 secs
+			info.m_timeout <<= 1;
+		}
+		info.m_next_resolve_ts = ts + jitter(info.m_timeout);
+	}
+}
+
+uint64_t sinsp_dns_manager::jitter(uint64_t timeout)
+{
+	// shorten by up to 1/8th
+	return timeout - (m_rand() % (timeout / 8 + 1));
 }
 #endif
 
@@ -121,21 +266,43 @@ bool sinsp_dns_manager::match(const char *name, int af, void *addr, uint64_t ts)
 	}
 
 	string sname = string(name);
+	name_shard& shard = shard_of(sname);
 
-	m_erase_mutex.lock();
-
-	if(m_cache.find(sname) == m_cache.end())
+	std::unique_lock<std::mutex> lock(shard.m_mutex);
+	auto it = shard.m_names.find(sname);
+	if(it == shard.m_names.end())
 	{
-		dns_info dinfo = resolve(sname, ts);
+		// do not block other lookups on this shard while resolving
+		lock.unlock();
+		dns_info dinfo = resolve(sname);
 		dinfo.m_timeout = m_base_refresh_timeout;
 		dinfo.m_last_resolve_ts = ts;
-		m_cache[sname] = dinfo;
-	}
+		dinfo.m_next_resolve_ts = ts + dinfo.m_timeout;
+		lock.lock();
 
-	m_cache[sname].m_last_used_ts = ts;
-	dns_info &dinfo = m_cache[sname];
+		it = shard.m_names.find(sname);
+		if(it == shard.m_names.end())
+		{
+			size_t max_shard_entries = m_max_entries / SHARD_COUNT;
+			if(!max_shard_entries)
+			{
+				max_shard_entries = 1;
+			}
+			while(shard.m_names.size() >= max_shard_entries && !shard.m_lru.empty())
+			{
+				erase(shard, shard.m_names.find(shard.m_lru.back()));
+			}
+			shard.m_lru.push_front(sname);
+			dinfo.m_lru = shard.m_lru.begin();
+			it = shard.m_names.emplace(sname, std::move(dinfo)).first;
+			index(sname, it->second);
+			++m_size;
+		}
+	}
 
-	m_erase_mutex.unlock();
+	dns_info &dinfo = it->second;
+	dinfo.m_last_used_ts = ts;
+	shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, dinfo.m_lru);
 
 	if(af == AF_INET6)
 	{
@@ -156,38 +323,64 @@ string sinsp_dns_manager::name_of(int af, void *addr, uint64_t ts)
 	string ret;
 
 #if defined(HAS_CAPTURE) && !defined(CYGWING_AGENT) && !defined(_WIN32)
-	if(!m_cache.empty())
+	if(!m_size)
+	{
+		return ret;
+	}
+
+	if(af == AF_INET6)
+	{
+		ipv6addr v6;
+		memcpy(v6.m_b, addr, sizeof(ipv6addr));
+		addr_shard& ashard = shard_of(v6);
+		std::lock_guard<std::mutex> lock(ashard.m_mutex);
+		auto it = ashard.m_v6.find(v6);
+		if(it != ashard.m_v6.end())
+		{
+			ret = it->second.front();
+		}
+	}
+	else if(af == AF_INET)
 	{
-		m_erase_mutex.lock();
-		for(auto &it: m_cache)
+		uint32_t v4 = *(uint32_t *)addr;
+		addr_shard& ashard = shard_of(v4);
+		std::lock_guard<std::mutex> lock(ashard.m_mutex);
+		auto it = ashard.m_v4.find(v4);
+		if(it != ashard.m_v4.end())
 		{
-			const std::string &name = it.first;
-			sinsp_dns_manager::dns_info &info = it.second;
+			ret = it->second.front();
+		}
+	}
 
-			if(af == AF_INET6)
-			{
-				ipv6addr v6;
-				memcpy(v6.m_b, addr, sizeof(ipv6addr));
-				if (info.m_v6_addrs.find(v6) != info.m_v6_addrs.end())
-				{
-					info.m_last_used_ts = ts;
-					ret = name;
-					break;
-				}
-			}
-			else if(af == AF_INET && info.m_v4_addrs.find(*(uint32_t *)addr) != info.m_v4_addrs.end())
-			{
-				info.m_last_used_ts = ts;
-				ret = name;
-				break;
-			}
+	if(!ret.empty())
+	{
+		name_shard& shard = shard_of(ret);
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+		auto it = shard.m_names.find(ret);
+		if(it != shard.m_names.end())
+		{
+			it->second.m_last_used_ts = ts;
+			shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second.m_lru);
 		}
-		m_erase_mutex.unlock();
 	}
 #endif
 	return ret;
 }
 
+void sinsp_dns_manager::clear()
+{
+#if defined(HAS_CAPTURE) && !defined(CYGWING_AGENT) && !defined(_WIN32)
+	for(auto& shard : m_name_shards)
+	{
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+		for(auto it = shard.m_names.begin(); it != shard.m_names.end();)
+		{
+			erase(shard, it++);
+		}
+	}
+#endif
+}
+
 void sinsp_dns_manager::cleanup()
 {
 	if(m_resolver)
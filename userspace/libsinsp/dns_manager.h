@@ -27,11 +27,36 @@ limitations under the License.
 #include <chrono>
 #include <future>
 #include <mutex>
-#if defined(HAS_CAPTURE) && !defined(CYGWING_AGENT) && !defined(_WIN32)
-#include "tbb/concurrent_unordered_map.h"
-#endif
+#include <atomic>
+#include <list>
+#include <memory>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
 #include "sinsp.h"
 
+//
+// Name resolution backend used by the DNS manager. The default one
+// calls getaddrinfo(); a stub can be plugged in to run without network.
+//
+class sinsp_dns_lookup
+{
+public:
+	typedef std::shared_ptr<sinsp_dns_lookup> ptr_t;
+
+	virtual ~sinsp_dns_lookup() = default;
+
+	// fills the sets with all the addresses name resolves to
+	// (sets are left empty if the name can not be resolved)
+	virtual void resolve(const std::string& name, std::set<uint32_t>& v4_addrs, std::set<ipv6addr>& v6_addrs) = 0;
+};
+
+class sinsp_getaddrinfo_lookup : public sinsp_dns_lookup
+{
+public:
+	void resolve(const std::string& name, std::set<uint32_t>& v4_addrs, std::set<ipv6addr>& v6_addrs) override;
+};
 
 struct sinsp_dns_resolver
 {
@@ -47,6 +72,9 @@ public:
 
 	void cleanup();
 
+	// drops all the cached names
+	void clear();
+
         static sinsp_dns_manager& get()
         {
             static sinsp_dns_manager instance;
@@ -66,26 +94,40 @@ public:
 		m_max_refresh_timeout = ns;
 	};
 
+	// upper bound for the number of cached names; when reached, the
+	// least recently used names are evicted
+	void set_max_entries(size_t max_entries)
+	{
+		m_max_entries = max_entries;
+	};
+
+	void set_lookup(sinsp_dns_lookup::ptr_t lookup)
+	{
+		std::atomic_store(&m_lookup, lookup);
+	};
+
 	size_t size()
 	{
-#if defined(HAS_CAPTURE) && !defined(CYGWING_AGENT) && !defined(_WIN32)
-		return m_cache.size();
-#else
-		return 0;
-#endif
+		return m_size;
 	};
 
 private:
 
 	sinsp_dns_manager() :
+		m_lookup(std::make_shared<sinsp_getaddrinfo_lookup>()),
+		m_resolver(NULL),
 		m_erase_timeout(3600 * ONE_SECOND_IN_NS),
 		m_base_refresh_timeout(10 * ONE_SECOND_IN_NS),
-		m_max_refresh_timeout(320 * ONE_SECOND_IN_NS)
+		m_max_refresh_timeout(320 * ONE_SECOND_IN_NS),
+		m_max_entries(65536),
+		m_size(0)
 	{};
         sinsp_dns_manager(sinsp_dns_manager const&) = delete;
         void operator=(sinsp_dns_manager const&) = delete;
 
 #if defined(HAS_CAPTURE) && !defined(CYGWING_AGENT) && !defined(_WIN32)
+	typedef std::list<std::string> lru_list;
+
 	struct dns_info
 	{
 		bool operator==(const dns_info &other) const
@@ -97,23 +139,62 @@ private:
 			return !operator==(other);
 		};
 
-		uint64_t m_timeout;
-		uint64_t m_last_resolve_ts;
-		uint64_t m_last_used_ts;
+		uint64_t m_timeout = 0;
+		uint64_t m_last_resolve_ts = 0;
+		uint64_t m_next_resolve_ts = 0;
+		uint64_t m_last_used_ts = 0;
 		std::set<uint32_t> m_v4_addrs;
 		std::set<ipv6addr> m_v6_addrs;
+		lru_list::iterator m_lru;
+	};
+
+	typedef std::vector<std::string> name_list;
+
+	// names are spread over shards by name hash, each shard keeping
+	// its own LRU list (most recently used first)
+	struct name_shard
+	{
+		std::mutex m_mutex;
+		std::unordered_map<std::string, dns_info> m_names;
+		lru_list m_lru;
 	};
 
-	static inline dns_info resolve(const std::string &name, uint64_t ts);
+	// reverse (address -> names) index, spread over shards by address
+	struct addr_shard
+	{
+		std::mutex m_mutex;
+		std::unordered_map<uint32_t, name_list> m_v4;
+		std::unordered_map<ipv6addr, name_list> m_v6;
+	};
+
+	static const size_t SHARD_COUNT = 16;
+
+	// maximum number of concurrent lookups done by the refresh thread
+	static const size_t MAX_RESOLVE_THREADS = 4;
+
+	name_shard& shard_of(const std::string& name);
+	addr_shard& shard_of(uint32_t addr);
+	addr_shard& shard_of(const ipv6addr& addr);
+
+	dns_info resolve(const std::string &name);
+
+	// must be called with the name shard locked
+	void index(const std::string& name, const dns_info& info);
+	void unindex(const std::string& name, const dns_info& info);
+	void erase(name_shard& shard, std::unordered_map<std::string, dns_info>::iterator it);
+
+	// refresh thread helpers
+	void collect(uint64_t ts, uint64_t erase_timeout, std::vector<std::string>& due);
+	void refresh(const std::vector<std::string>& names, uint64_t ts,
+		     uint64_t base_refresh_timeout, uint64_t max_refresh_timeout);
+	uint64_t jitter(uint64_t timeout);
 
-	typedef tbb::concurrent_unordered_map<std::string, dns_info> c_dns_table;
-	c_dns_table m_cache;
+	name_shard m_name_shards[SHARD_COUNT];
+	addr_shard m_addr_shards[SHARD_COUNT];
+	std::minstd_rand m_rand;
 #endif
 
-	// tbb concurrent unordered map is not thread-safe for deletions,
-	// so we still need a mutex, but the chances of waiting are really
-	// low, since we will almost never do an erase.
-	std::mutex m_erase_mutex;
+	sinsp_dns_lookup::ptr_t m_lookup;
 
 	// used to let m_resolver know when to terminate
 	std::promise<void> m_exit_signal;
@@ -123,6 +204,8 @@ private:
 	uint64_t m_erase_timeout;
 	uint64_t m_base_refresh_timeout;
 	uint64_t m_max_refresh_timeout;
+	size_t m_max_entries;
+	std::atomic<size_t> m_size;
 
 	friend sinsp_dns_resolver;
 };
@@ -19,6 +19,7 @@ limitations under the License.
 #include "sinsp_int.h"
 #include "scap.h"
 #include "dumper.h"
+#include "stage_timers.h"
 
 sinsp_dumper::sinsp_dumper(sinsp* inspector)
 {
@@ -135,6 +136,8 @@ bool sinsp_dumper::written_events()
 
 void sinsp_dumper::dump(sinsp_evt* evt)
 {
+	internal_metrics::scoped_stage_timer stage_timer(internal_metrics::STAGE_DUMP);
+
 	if(m_dumper == NULL)
 	{
 		throw sinsp_exception("dumper not opened yet");
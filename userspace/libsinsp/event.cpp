@@ -162,7 +162,7 @@ uint32_t sinsp_evt::get_num_params()
 		m_flags |= (uint32_t)sinsp_evt::SINSP_EF_PARAMS_LOADED;
 	}
 
-	return (uint32_t)m_params.size();
+	return m_nparams;
 }
 
 sinsp_evt_param *sinsp_evt::get_param(uint32_t id)
@@ -173,9 +173,26 @@ sinsp_evt_param *sinsp_evt::get_param(uint32_t id)
 		m_flags |= (uint32_t)sinsp_evt::SINSP_EF_PARAMS_LOADED;
 	}
 
+	ASSERT(id < m_nparams);
+
 	return &(m_params[id]);
 }
 
+int32_t sinsp_evt::get_param_index(const char* name)
+{
+	uint32_t np = get_num_params();
+
+	for(uint32_t j = 0; j < np; j++)
+	{
+		if(strcmp(name, m_info->params[j].name) == 0)
+		{
+			return (int32_t)j;
+		}
+	}
+
+	return -1;
+}
+
 const char *sinsp_evt::get_param_name(uint32_t id)
 {
 	if((m_flags & sinsp_evt::SINSP_EF_PARAMS_LOADED) == 0)
@@ -2417,22 +2434,18 @@ const char* sinsp_evt::get_param_as_str(uint32_t id, OUT const char** resolved_s
 
 string sinsp_evt::get_param_value_str(const string &name, bool resolved)
 {
-	for(uint32_t i = 0; i < get_num_params(); i++)
-	{
-		if(name == get_param_name(i))
-		{
-			return get_param_value_str(i, resolved);
-		}
-	}
-
-	return string("");
+	return get_param_value_str(name.c_str(), resolved);
 }
 
 string sinsp_evt::get_param_value_str(const char *name, bool resolved)
 {
-	// TODO fix this !!
-	string s_name = string(name);
-	return get_param_value_str(s_name, resolved);
+	int32_t id = get_param_index(name);
+	if(id < 0)
+	{
+		return string("");
+	}
+
+	return get_param_value_str((uint32_t)id, resolved);
 }
 
 string sinsp_evt::get_param_value_str(uint32_t i, bool resolved)
@@ -2453,43 +2466,25 @@ string sinsp_evt::get_param_value_str(uint32_t i, bool resolved)
 
 const char* sinsp_evt::get_param_value_str(const char* name, OUT const char** resolved_str, param_fmt fmt)
 {
-	for(uint32_t i = 0; i < get_num_params(); i++)
+	int32_t id = get_param_index(name);
+	if(id < 0)
 	{
-		if(strcmp(name, get_param_name(i)) == 0)
-		{
-			return get_param_as_str(i, resolved_str, fmt);
-		}
+		*resolved_str = NULL;
+		return NULL;
 	}
 
-	*resolved_str = NULL;
-	return NULL;
+	return get_param_as_str((uint32_t)id, resolved_str, fmt);
 }
 
 const sinsp_evt_param* sinsp_evt::get_param_value_raw(const char* name)
 {
-	//
-	// Make sure the params are actually loaded
-	//
-	if((m_flags & sinsp_evt::SINSP_EF_PARAMS_LOADED) == 0)
+	int32_t id = get_param_index(name);
+	if(id < 0)
 	{
-		load_params();
-		m_flags |= (uint32_t)sinsp_evt::SINSP_EF_PARAMS_LOADED;
+		return NULL;
 	}
 
-	//
-	// Locate the parameter given the name
-	//
-	uint32_t np = get_num_params();
-
-	for(uint32_t j = 0; j < np; j++)
-	{
-		if(strcmp(name, get_param_name(j)) == 0)
-		{
-			return &(m_params[j]);
-		}
-	}
-
-	return NULL;
+	return &(m_params[id]);
 }
 
 void sinsp_evt::get_category(OUT sinsp_evt::category* cat)
@@ -2747,8 +2742,10 @@ bool sinsp_evt::evtcpy(sinsp_evt& dest, const sinsp_evt& src)
 	dest.m_cpuid = src.m_cpuid;
 	// m_evtnum is used in cached filters and that is safe for reuse
 	dest.m_evtnum = src.m_evtnum;
-	dest.m_flags = src.m_flags;
-	dest.m_params_loaded = src.m_params_loaded;
+	// the params of src point into its own buffer, dest reloads them
+	// from its copy on first access
+	dest.m_flags = src.m_flags & ~(uint32_t)sinsp_evt::SINSP_EF_PARAMS_LOADED;
+	dest.m_params_loaded = false;
 
 	dest.m_iosize = src.m_iosize;
 	dest.m_errorcode = src.m_errorcode;
@@ -2756,7 +2753,6 @@ bool sinsp_evt::evtcpy(sinsp_evt& dest, const sinsp_evt& src)
 	dest.m_filtered_out = src.m_filtered_out;
 
 	// vectors
-	dest.m_params = src.m_params;
 	dest.m_paramstr_storage = src.m_paramstr_storage;
 	dest.m_resolved_paramstr_storage = src.m_resolved_paramstr_storage;
 
@@ -304,6 +304,33 @@ public:
 	*/
 	sinsp_evt_param* get_param(uint32_t id);
 
+	/*!
+	  \brief Get a fixed size parameter by value, e.g. an int64_t fd or a
+	   uint32_t flags field.
+
+	  \param id The parameter number.
+
+	  \note T must have the size given to the parameter type in
+	   driver/event_table.c.
+	*/
+	template<typename T>
+	inline T get_param_as(uint32_t id)
+	{
+		const sinsp_evt_param* param = get_param(id);
+		T val = T();
+		ASSERT(param->m_len == sizeof(T));
+		memcpy(&val, param->m_val, param->m_len < sizeof(T) ? param->m_len : sizeof(T));
+		return val;
+	}
+
+	/*!
+	  \brief Get the number of the parameter with the given name, or -1 if
+	   this event type has no such parameter.
+
+	  \param name The parameter name.
+	*/
+	int32_t get_param_index(const char* name);
+
 	/*!
 	  \brief Get a parameter in raw format.
 
@@ -440,7 +467,6 @@ private:
 	{
 		uint32_t j;
 		uint32_t nparams;
-		sinsp_evt_param par;
 
 		// If we're reading a capture created with a newer version, it may contain
 		// new parameters. If instead we're reading an older version, the current
@@ -450,14 +476,17 @@ private:
 		uint16_t *lens = (uint16_t *)((char *)m_pevt + sizeof(struct ppm_evt_hdr));
 		// The offset in the block is instead always based on the capture value.
 		char *valptr = (char *)lens + m_pevt->nparams * sizeof(uint16_t);
-		m_params.clear();
+		if(nparams > PPM_MAX_EVENT_PARAMS)
+		{
+			nparams = PPM_MAX_EVENT_PARAMS;
+		}
 
 		for(j = 0; j < nparams; j++)
 		{
-			par.init(valptr, lens[j]);
-			m_params.push_back(par);
+			m_params[j].init(valptr, lens[j]);
 			valptr += lens[j];
 		}
+		m_nparams = nparams;
 	}
 	std::string get_param_value_str(uint32_t id, bool resolved);
 	std::string get_param_value_str(const char* name, bool resolved = true);
@@ -484,7 +513,8 @@ VISIBILITY_PRIVATE
 	uint32_t m_flags;
 	bool m_params_loaded;
 	const struct ppm_event_info* m_info;
-	std::vector<sinsp_evt_param> m_params;
+	sinsp_evt_param m_params[PPM_MAX_EVENT_PARAMS];
+	uint32_t m_nparams;
 
 	std::vector<char> m_paramstr_storage;
 	std::vector<char> m_resolved_paramstr_storage;
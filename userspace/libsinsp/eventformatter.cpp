@@ -20,6 +20,7 @@ limitations under the License.
 #include "filter.h"
 #include "filterchecks.h"
 #include "eventformatter.h"
+#include "stage_timers.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // rawstring_check implementation
@@ -30,6 +31,14 @@ extern sinsp_filter_check_list g_filterlist;
 sinsp_evt_formatter::sinsp_evt_formatter(sinsp* inspector, const string& fmt)
 {
 	m_inspector = inspector;
+	m_group = NULL;
+	set_format(fmt);
+}
+
+sinsp_evt_formatter::sinsp_evt_formatter(sinsp* inspector, const string& fmt, sinsp_evt_formatter_group* group)
+{
+	m_inspector = inspector;
+	m_group = group;
 	set_format(fmt);
 }
 
@@ -87,6 +96,7 @@ void sinsp_evt_formatter::set_format(const string& fmt)
 				rawstring_check* newtkn = new rawstring_check(lfmt.substr(last_nontoken_str_start, j - last_nontoken_str_start));
 				m_tokens.emplace_back(make_pair("", newtkn));
 				m_tokenlens.push_back(0);
+				m_token_fields.push_back(-1);
 				m_chks_to_free.push_back(newtkn);
 			}
 
@@ -135,15 +145,26 @@ void sinsp_evt_formatter::set_format(const string& fmt)
 				throw sinsp_exception("invalid formatting token " + string(cfmt + j + 1));
 			}
 
-			m_chks_to_free.push_back(chk);
-
 			const char * fstart = cfmt + j + 1;
 			uint32_t fsize = chk->parse_field_name(fstart, true, false);
 
 			j += fsize;
 			ASSERT(j <= lfmt.length());
 
-			m_tokens.emplace_back(make_pair(string(fstart, fsize), chk));
+			string fname(fstart, fsize);
+			if(m_group != NULL)
+			{
+				int32_t id = m_group->share_field(fname, chk);
+				chk = m_group->m_fields[id].m_chk;
+				m_token_fields.push_back(id);
+			}
+			else
+			{
+				m_chks_to_free.push_back(chk);
+				m_token_fields.push_back(-1);
+			}
+
+			m_tokens.emplace_back(make_pair(fname, chk));
 			m_tokenlens.push_back(toklen);
 
 			last_nontoken_str_start = j + 1;
@@ -156,6 +177,22 @@ void sinsp_evt_formatter::set_format(const string& fmt)
 		m_tokens.emplace_back(make_pair("", chk));
 		m_chks_to_free.push_back(chk);
 		m_tokenlens.push_back(0);
+		m_token_fields.push_back(-1);
+	}
+
+	map<string, uint32_t> json_fields;
+	for(j = 0; j < m_tokens.size(); j++)
+	{
+		if(m_tokens[j].second->get_field_info() != NULL)
+		{
+			json_fields[m_tokens[j].first] = j;
+		}
+	}
+
+	m_json_tokens.clear();
+	for(const auto& field : json_fields)
+	{
+		m_json_tokens.emplace_back(make_pair(Json::valueToQuotedString(field.first.c_str()) + ":", field.second));
 	}
 }
 
@@ -203,91 +240,229 @@ bool sinsp_evt_formatter::resolve_tokens(sinsp_evt *evt, map<string,string>& val
 
 bool sinsp_evt_formatter::tostring(sinsp_evt* evt, OUT string* res)
 {
-	bool retval = true;
-	const filtercheck_field_info* fi;
+	internal_metrics::scoped_stage_timer stage_timer(internal_metrics::STAGE_FORMAT);
 
-	uint32_t j = 0;
-	vector<sinsp_filter_check*>::iterator it;
 	res->clear();
+	return append(evt, res);
+}
 
-	ASSERT(m_tokenlens.size() == m_tokens.size());
-
-	for(j = 0; j < m_tokens.size(); j++)
+inline char* sinsp_evt_formatter::token_tostring(sinsp_evt* evt, uint32_t j)
+{
+	if(m_token_fields[j] != -1)
 	{
-		if(m_inspector->get_buffer_format() == sinsp_evt::PF_JSON
-		   || m_inspector->get_buffer_format() == sinsp_evt::PF_JSONEOLS
-		   || m_inspector->get_buffer_format() == sinsp_evt::PF_JSONHEX
-		   || m_inspector->get_buffer_format() == sinsp_evt::PF_JSONHEXASCII
-		   || m_inspector->get_buffer_format() == sinsp_evt::PF_JSONBASE64)
-		{
-			Json::Value json_value = m_tokens[j].second->tojson(evt);
+		return m_group->field_tostring(evt, m_token_fields[j]);
+	}
+	return m_tokens[j].second->tostring(evt);
+}
 
-			if(retval == false)
-			{
-				continue;
-			}
+inline bool sinsp_evt_formatter::token_append_json(sinsp_evt* evt, uint32_t j, OUT string* res)
+{
+	if(m_token_fields[j] != -1)
+	{
+		return m_group->field_append_json(evt, m_token_fields[j], res);
+	}
+	return m_tokens[j].second->append_json(evt, res);
+}
 
-			if(json_value == Json::nullValue && m_require_all_values)
-			{
-				retval = false;
-				continue;
-			}
+bool sinsp_evt_formatter::append(sinsp_evt* evt, OUT string* res)
+{
+	bool retval = true;
+	uint32_t j = 0;
 
-			fi = m_tokens[j].second->get_field_info();
+	ASSERT(m_tokenlens.size() == m_tokens.size());
 
-			if(fi)
-			{
-				m_root[m_tokens[j].first] = m_tokens[j].second->tojson(evt);
-			}
-		}
-		else
+	sinsp_evt::param_fmt buffer_format = m_inspector->get_buffer_format();
+	if(buffer_format == sinsp_evt::PF_JSON
+	   || buffer_format == sinsp_evt::PF_JSONEOLS
+	   || buffer_format == sinsp_evt::PF_JSONHEX
+	   || buffer_format == sinsp_evt::PF_JSONHEXASCII
+	   || buffer_format == sinsp_evt::PF_JSONBASE64)
+	{
+		if(m_json_tokens.empty())
 		{
-			char* str = m_tokens[j].second->tostring(evt);
+			res->append("null");
+			return retval;
+		}
 
-			if(retval == false)
+		res->push_back('{');
+		for(j = 0; j < m_json_tokens.size(); j++)
+		{
+			if(j > 0)
 			{
-				continue;
+				res->push_back(',');
 			}
+			res->append(m_json_tokens[j].first);
 
-			if(str == NULL)
+			if(!token_append_json(evt, m_json_tokens[j].second, res))
 			{
 				if(m_require_all_values)
 				{
 					retval = false;
-					continue;
-				}
-				else
-				{
-					str = (char*)"<NA>";
 				}
+				res->append("null");
 			}
+		}
+		res->push_back('}');
+
+		return retval;
+	}
+
+	for(j = 0; j < m_tokens.size(); j++)
+	{
+		char* str = token_tostring(evt, j);
 
-			uint32_t tks = m_tokenlens[j];
+		if(retval == false)
+		{
+			continue;
+		}
 
-			if(tks != 0)
+		if(str == NULL)
+		{
+			if(m_require_all_values)
 			{
-				string sstr(str);
-				sstr.resize(tks, ' ');
-				(*res) += sstr;
+				retval = false;
+				continue;
 			}
 			else
 			{
-				(*res) += str;
+				str = (char*)"<NA>";
 			}
 		}
+
+		uint32_t tks = m_tokenlens[j];
+
+		if(tks != 0)
+		{
+			size_t len = strnlen(str, tks);
+			res->append(str, len);
+			res->append(tks - len, ' ');
+		}
+		else
+		{
+			(*res) += str;
+		}
 	}
 
-	if(m_inspector->get_buffer_format() == sinsp_evt::PF_JSON
-	   || m_inspector->get_buffer_format() == sinsp_evt::PF_JSONEOLS
-	   || m_inspector->get_buffer_format() == sinsp_evt::PF_JSONHEX
-	   || m_inspector->get_buffer_format() == sinsp_evt::PF_JSONHEXASCII
-	   || m_inspector->get_buffer_format() == sinsp_evt::PF_JSONBASE64)
+	return retval;
+}
+
+sinsp_evt_formatter_group::sinsp_evt_formatter_group(sinsp* inspector):
+	m_inspector(inspector),
+	m_pass(0)
+{
+}
+
+sinsp_evt_formatter_group::~sinsp_evt_formatter_group()
+{
+	m_formatters.clear();
+	for(auto& f : m_fields)
 	{
-		(*res) = m_writer.write(m_root);
-		(*res) = res->substr(0, res->size() - 1);
+		delete f.m_chk;
 	}
+}
 
-	return retval;
+uint32_t sinsp_evt_formatter_group::add_format(const string& fmt)
+{
+	m_formatters.emplace_back(new sinsp_evt_formatter(m_inspector, fmt, this));
+	return (uint32_t)m_formatters.size() - 1;
+}
+
+uint32_t sinsp_evt_formatter_group::get_num_formats() const
+{
+	return (uint32_t)m_formatters.size();
+}
+
+void sinsp_evt_formatter_group::tostring(sinsp_evt* evt, OUT vector<string>* res, OUT vector<bool>* show)
+{
+	res->resize(m_formatters.size());
+	show->resize(m_formatters.size());
+
+	m_pass++;
+	for(uint32_t j = 0; j < m_formatters.size(); j++)
+	{
+		(*show)[j] = m_formatters[j]->tostring(evt, &(*res)[j]);
+	}
+}
+
+void sinsp_evt_formatter_group::tostring(const vector<sinsp_evt*>& evts, OUT string* buf, OUT vector<size_t>* ends, OUT vector<bool>* show)
+{
+	internal_metrics::scoped_stage_timer stage_timer(internal_metrics::STAGE_FORMAT);
+
+	buf->clear();
+	ends->clear();
+	show->clear();
+	ends->reserve(evts.size() * m_formatters.size());
+	show->reserve(evts.size() * m_formatters.size());
+
+	for(sinsp_evt* evt : evts)
+	{
+		m_pass++;
+		for(auto& formatter : m_formatters)
+		{
+			show->push_back(formatter->append(evt, buf));
+			ends->push_back(buf->size());
+		}
+	}
+}
+
+int32_t sinsp_evt_formatter_group::share_field(const string& name, sinsp_filter_check* chk)
+{
+	auto it = m_field_ids.find(name);
+	if(it != m_field_ids.end())
+	{
+		delete chk;
+		return it->second;
+	}
+
+	field f;
+	f.m_chk = chk;
+	f.m_str_pass = 0;
+	f.m_str_valid = false;
+	f.m_json_pass = 0;
+	f.m_json_valid = false;
+	m_fields.push_back(f);
+
+	int32_t id = (int32_t)m_fields.size() - 1;
+	m_field_ids[name] = id;
+	return id;
+}
+
+//
+// The first format that needs a field during a pass extracts it; the
+// others reuse the value. The value is copied: the string returned by
+// tostring() can live in a buffer of the event (e.g. evt.arg.*) that
+// the next extracted field overwrites.
+//
+char* sinsp_evt_formatter_group::field_tostring(sinsp_evt* evt, int32_t id)
+{
+	field& f = m_fields[id];
+	if(f.m_str_pass != m_pass)
+	{
+		char* str = f.m_chk->tostring(evt);
+		f.m_str_valid = (str != NULL);
+		if(f.m_str_valid)
+		{
+			f.m_str.assign(str);
+		}
+		f.m_str_pass = m_pass;
+	}
+	return f.m_str_valid ? (char*)f.m_str.c_str() : NULL;
+}
+
+bool sinsp_evt_formatter_group::field_append_json(sinsp_evt* evt, int32_t id, OUT string* res)
+{
+	field& f = m_fields[id];
+	if(f.m_json_pass != m_pass)
+	{
+		f.m_json.clear();
+		f.m_json_valid = f.m_chk->append_json(evt, &f.m_json);
+		f.m_json_pass = m_pass;
+	}
+	if(f.m_json_valid)
+	{
+		res->append(f.m_json);
+	}
+	return f.m_json_valid;
 }
 
 #else  // HAS_FILTERING
@@ -310,6 +485,34 @@ bool sinsp_evt_formatter::tostring(sinsp_evt* evt, OUT string* res)
 {
 	throw sinsp_exception("sinsp_evt_formatter unavailable because it was not compiled in the library");
 }
+
+sinsp_evt_formatter_group::sinsp_evt_formatter_group(sinsp* inspector)
+{
+}
+
+sinsp_evt_formatter_group::~sinsp_evt_formatter_group()
+{
+}
+
+uint32_t sinsp_evt_formatter_group::add_format(const string& fmt)
+{
+	throw sinsp_exception("sinsp_evt_formatter_group unavailable because it was not compiled in the library");
+}
+
+uint32_t sinsp_evt_formatter_group::get_num_formats() const
+{
+	return 0;
+}
+
+void sinsp_evt_formatter_group::tostring(sinsp_evt* evt, OUT vector<string>* res, OUT vector<bool>* show)
+{
+	throw sinsp_exception("sinsp_evt_formatter_group unavailable because it was not compiled in the library");
+}
+
+void sinsp_evt_formatter_group::tostring(const vector<sinsp_evt*>& evts, OUT string* buf, OUT vector<size_t>* ends, OUT vector<bool>* show)
+{
+	throw sinsp_exception("sinsp_evt_formatter_group unavailable because it was not compiled in the library");
+}
 #endif // HAS_FILTERING
 
 sinsp_evt_formatter_cache::sinsp_evt_formatter_cache(sinsp *inspector)
@@ -19,6 +19,7 @@ limitations under the License.
 #include <json/json.h>
 
 class sinsp_filter_check;
+class sinsp_evt_formatter_group;
 
 /** @defgroup event Event manipulation
  *  @{
@@ -78,8 +79,15 @@ public:
 	bool on_capture_end(OUT string* res);
 
 private:
+	sinsp_evt_formatter(sinsp* inspector, const string& fmt, sinsp_evt_formatter_group* group);
+
 	void set_format(const string& fmt);
 
+	// Appends the rendering of evt to res, returns the same as tostring()
+	bool append(sinsp_evt* evt, OUT string* res);
+	char* token_tostring(sinsp_evt* evt, uint32_t j);
+	bool token_append_json(sinsp_evt* evt, uint32_t j, OUT string* res);
+
 	// vector of (full string of the token, filtercheck) pairs
 	// e.g. ("proc.aname[2], ptr to sinsp_filter_check_thread)
 	vector<pair<string, sinsp_filter_check*>> m_tokens;
@@ -88,8 +96,97 @@ private:
 	bool m_require_all_values;
 	vector<sinsp_filter_check*> m_chks_to_free;
 
-	Json::Value m_root;
-	Json::FastWriter m_writer;
+	// the field tokens written in JSON output, as (quoted "name": prefix,
+	// index in m_tokens), sorted by name and without duplicates, as they
+	// would be in a serialized Json::Value object
+	vector<pair<string, uint32_t>> m_json_tokens;
+
+	// when part of a group, the group field of each token, or -1
+	sinsp_evt_formatter_group* m_group;
+	vector<int32_t> m_token_fields;
+
+	friend class sinsp_evt_formatter_group;
+};
+
+/*!
+  \brief A set of formats rendered together.
+  Use this class instead of several sinsp_evt_formatter instances when
+  each event is rendered with more than one format: a field that
+  appears in several formats is extracted once per event, and outputs
+  can be rendered in bulk into a single buffer.
+*/
+class SINSP_PUBLIC sinsp_evt_formatter_group
+{
+public:
+	sinsp_evt_formatter_group(sinsp* inspector);
+	~sinsp_evt_formatter_group();
+
+	/*!
+	  \brief Adds a format to the group.
+
+	  \param fmt The format, with the same syntax accepted by
+	   sinsp_evt_formatter.
+
+	  \return the index of the format in the group.
+	*/
+	uint32_t add_format(const string& fmt);
+
+	uint32_t get_num_formats() const;
+
+	/*!
+	  \brief Renders an event with every format of the group.
+
+	  \param evt Pointer to the event to be converted into string.
+	  \param res Filled with the rendering of the event with each format,
+	   in the order they were added.
+	  \param show Filled with the return value sinsp_evt_formatter::tostring()
+	   would have for each format.
+	*/
+	void tostring(sinsp_evt* evt, OUT vector<string>* res, OUT vector<bool>* show);
+
+	/*!
+	  \brief Renders a batch of events with every format of the group into
+	  one contiguous buffer.
+
+	  \param evts The events, which must stay valid for the whole call.
+	  \param buf Filled with the outputs, one after another: first every
+	   format for evts[0], then every format for evts[1] and so on.
+	  \param ends Filled with the end offset in buf of each output.
+	  \param show Filled with the sinsp_evt_formatter::tostring() return
+	   value for each output.
+	*/
+	void tostring(const vector<sinsp_evt*>& evts, OUT string* buf, OUT vector<size_t>* ends, OUT vector<bool>* show);
+
+private:
+	//
+	// A field shared by the formats of the group, with its value for the
+	// event being rendered
+	//
+	struct field
+	{
+		sinsp_filter_check* m_chk;
+		uint64_t m_str_pass;
+		bool m_str_valid;
+		string m_str;
+		uint64_t m_json_pass;
+		bool m_json_valid;
+		string m_json;
+	};
+
+	// returns the id of the field named name, adopting chk if it is new
+	// and deleting it otherwise
+	int32_t share_field(const string& name, sinsp_filter_check* chk);
+	char* field_tostring(sinsp_evt* evt, int32_t id);
+	bool field_append_json(sinsp_evt* evt, int32_t id, OUT string* res);
+
+	sinsp* m_inspector;
+	vector<unique_ptr<sinsp_evt_formatter>> m_formatters;
+	vector<field> m_fields;
+	map<string, int32_t> m_field_ids;
+	// identifies the event being rendered, to invalidate field values
+	uint64_t m_pass;
+
+	friend class sinsp_evt_formatter;
 };
 
 /*!
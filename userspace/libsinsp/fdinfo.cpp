@@ -23,6 +23,79 @@ limitations under the License.
 #include "sinsp.h"
 #include "sinsp_int.h"
 #include "scap-int.h"
+#include "protodecoder.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// fd_callbacks_info implementation
+///////////////////////////////////////////////////////////////////////////////
+fd_callbacks_info::fd_callbacks_info(const fd_callbacks_info& other):
+	m_write_callbacks(other.m_write_callbacks),
+	m_read_callbacks(other.m_read_callbacks)
+{
+}
+
+fd_callbacks_info::~fd_callbacks_info()
+{
+	for(auto& s : m_states)
+	{
+		delete s.second;
+	}
+}
+
+fd_callbacks_info& fd_callbacks_info::operator=(const fd_callbacks_info& other)
+{
+	if(this != &other)
+	{
+		m_write_callbacks = other.m_write_callbacks;
+		m_read_callbacks = other.m_read_callbacks;
+
+		for(auto& s : m_states)
+		{
+			delete s.second;
+		}
+		m_states.clear();
+	}
+
+	return *this;
+}
+
+sinsp_protodecoder_fd_state* fd_callbacks_info::get_state(sinsp_protodecoder* dec)
+{
+	for(auto& s : m_states)
+	{
+		if(s.first == dec)
+		{
+			return s.second;
+		}
+	}
+
+	return NULL;
+}
+
+void fd_callbacks_info::set_state(sinsp_protodecoder* dec, sinsp_protodecoder_fd_state* state)
+{
+	for(auto it = m_states.begin(); it != m_states.end(); ++it)
+	{
+		if(it->first == dec)
+		{
+			delete it->second;
+			if(state != NULL)
+			{
+				it->second = state;
+			}
+			else
+			{
+				m_states.erase(it);
+			}
+			return;
+		}
+	}
+
+	if(state != NULL)
+	{
+		m_states.push_back(make_pair(dec, state));
+	}
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 // sinsp_fdinfo implementation
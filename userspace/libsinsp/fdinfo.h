@@ -60,11 +60,32 @@ typedef union _sinsp_sockinfo
 	unix_tuple m_unixinfo; ///< The tuple if this a unix socket.
 }sinsp_sockinfo;
 
+class sinsp_protodecoder_fd_state;
+
 class fd_callbacks_info
 {
 public:
+	fd_callbacks_info()
+	{
+	}
+	fd_callbacks_info(const fd_callbacks_info& other);
+	~fd_callbacks_info();
+	fd_callbacks_info& operator=(const fd_callbacks_info& other);
+
+	//
+	// The state a decoder keeps for this FD, NULL if it has none.
+	// The state is owned by the FD and deleted with it, and is not
+	// copied with the callbacks: a decoder finding a copied FD without
+	// its state starts a new one.
+	//
+	sinsp_protodecoder_fd_state* get_state(sinsp_protodecoder* dec);
+	void set_state(sinsp_protodecoder* dec, sinsp_protodecoder_fd_state* state);
+
 	std::vector<sinsp_protodecoder*> m_write_callbacks;
 	std::vector<sinsp_protodecoder*> m_read_callbacks;
+
+private:
+	std::vector<std::pair<sinsp_protodecoder*, sinsp_protodecoder_fd_state*>> m_states;
 };
 
 /*!
@@ -504,6 +525,7 @@ private:
 	friend class sinsp_fdtable;
 	friend class sinsp_filter_check_fd;
 	friend class sinsp_filter_check_event;
+	friend class sinsp_protodecoder;
 	friend class lua_cbacks;
 	friend class sinsp_baseliner;
 	friend class protocol_manager;
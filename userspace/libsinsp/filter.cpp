@@ -75,6 +75,8 @@ sinsp_filter_check_list::sinsp_filter_check_list()
 	add_filter_check(new sinsp_filter_check_user());
 	add_filter_check(new sinsp_filter_check_group());
 	add_filter_check(new sinsp_filter_check_syslog());
+	add_filter_check(new sinsp_filter_check_http());
+	add_filter_check(new sinsp_filter_check_dns());
 	add_filter_check(new sinsp_filter_check_container());
 	add_filter_check(new sinsp_filter_check_utils());
 	add_filter_check(new sinsp_filter_check_fdlist());
@@ -283,6 +285,23 @@ bool flt_compare_string(cmpop op, char* operand1, char* operand2)
 	}
 }
 
+bool flt_compare_string(cmpop op, char* operand1, const string_search& operand2)
+{
+	switch(op)
+	{
+	case CO_CONTAINS:
+		return operand2.find(operand1, strlen(operand1)) != NULL;
+	case CO_ICONTAINS:
+		return operand2.find_nocase(operand1, strlen(operand1)) != NULL;
+	case CO_STARTSWITH:
+		return operand2.is_prefix_of(operand1);
+	case CO_ENDSWITH:
+		return operand2.is_suffix_of(operand1, strlen(operand1));
+	default:
+		return flt_compare_string(op, operand1, (char*)operand2.data());
+	}
+}
+
 bool flt_compare_buffer(cmpop op, char* operand1, char* operand2, uint32_t op1_len, uint32_t op2_len)
 {
 	switch(op)
@@ -658,6 +677,120 @@ void sinsp_filter_check::set_inspector(sinsp* inspector)
 	m_inspector = inspector;
 }
 
+//
+// JSON serialization helpers for append_json(). The output is the same
+// that Json::FastWriter produces for the equivalent Json::Value.
+//
+static void append_json_uint(uint64_t val, std::string* res)
+{
+	char buf[24];
+	char* p = buf + sizeof(buf);
+
+	do
+	{
+		*--p = (char)('0' + val % 10);
+		val /= 10;
+	} while(val != 0);
+
+	res->append(p, buf + sizeof(buf) - p);
+}
+
+static void append_json_int(int64_t val, std::string* res)
+{
+	if(val < 0)
+	{
+		res->push_back('-');
+		append_json_uint(-(uint64_t)val, res);
+	}
+	else
+	{
+		append_json_uint((uint64_t)val, res);
+	}
+}
+
+//
+// str must be NUL terminated at len. The escaping is left to jsoncpp,
+// since it differs between versions: e.g. 1.9 writes lowercase hex
+// and escapes non-ASCII characters, the bundled 0.10 doesn't.
+//
+static void append_json_string(const char* str, size_t len, std::string* res)
+{
+	if(memchr(str, '\0', len) == NULL)
+	{
+		res->append(Json::valueToQuotedString(str));
+		return;
+	}
+
+	//
+	// valueToQuotedString() stops at the first NUL, which the writer
+	// escapes instead
+	//
+	Json::FastWriter writer;
+	std::string quoted = writer.write(Json::Value(str, str + len));
+	res->append(quoted, 0, quoted.size() - 1);
+}
+
+static void append_json_value(const Json::Value& val, std::string* res)
+{
+	switch(val.type())
+	{
+	case Json::nullValue:
+		res->append("null");
+		break;
+	case Json::intValue:
+		append_json_int(val.asLargestInt(), res);
+		break;
+	case Json::uintValue:
+		append_json_uint(val.asLargestUInt(), res);
+		break;
+	case Json::realValue:
+		res->append(Json::valueToString(val.asDouble()));
+		break;
+	case Json::stringValue:
+	{
+		const char* begin;
+		const char* end;
+		if(val.getString(&begin, &end))
+		{
+			append_json_string(begin, end - begin, res);
+		}
+		break;
+	}
+	case Json::booleanValue:
+		res->append(val.asBool() ? "true" : "false");
+		break;
+	case Json::arrayValue:
+		res->push_back('[');
+		for(Json::ArrayIndex j = 0; j < val.size(); j++)
+		{
+			if(j > 0)
+			{
+				res->push_back(',');
+			}
+			append_json_value(val[j], res);
+		}
+		res->push_back(']');
+		break;
+	case Json::objectValue:
+	{
+		Json::Value::Members members = val.getMemberNames();
+		res->push_back('{');
+		for(auto it = members.begin(); it != members.end(); ++it)
+		{
+			if(it != members.begin())
+			{
+				res->push_back(',');
+			}
+			append_json_string(it->data(), it->size(), res);
+			res->push_back(':');
+			append_json_value(val[*it], res);
+		}
+		res->push_back('}');
+		break;
+	}
+	}
+}
+
 Json::Value sinsp_filter_check::rawval_to_json(uint8_t* rawval,
 					       ppm_param_type ptype,
 					       ppm_print_format print_format,
@@ -1159,6 +1292,122 @@ Json::Value sinsp_filter_check::tojson(sinsp_evt* evt)
 	return jsonval;
 }
 
+bool sinsp_filter_check::append_json(sinsp_evt* evt, OUT std::string* res)
+{
+	uint32_t len;
+	Json::Value jsonval = extract_as_js(evt, &len);
+
+	if(jsonval != Json::nullValue)
+	{
+		append_json_value(jsonval, res);
+		return true;
+	}
+
+	uint8_t* rawval = extract(evt, &len);
+	if(rawval == NULL)
+	{
+		return false;
+	}
+
+	//
+	// Same conversions as rawval_to_json()
+	//
+	ppm_print_format print_format = m_field->m_print_format;
+	bool as_number = (print_format == PF_DEC || print_format == PF_ID);
+	bool as_string = (print_format == PF_OCT || print_format == PF_HEX);
+
+	switch(m_field->m_type)
+	{
+		case PT_INT8:
+		case PT_INT16:
+		case PT_INT32:
+		case PT_L4PROTO:
+		case PT_UINT8:
+		case PT_PORT:
+		case PT_UINT16:
+		case PT_UINT32:
+			if(!as_number && !as_string)
+			{
+				ASSERT(false);
+				return false;
+			}
+			break;
+		case PT_INT64:
+		case PT_PID:
+			as_string = !as_number;
+			break;
+		case PT_UINT64:
+		case PT_RELTIME:
+		case PT_ABSTIME:
+			as_string = as_string || print_format == PF_10_PADDED_DEC;
+			if(!as_number && !as_string)
+			{
+				ASSERT(false);
+				return false;
+			}
+			break;
+		case PT_SOCKADDR:
+		case PT_SOCKFAMILY:
+			ASSERT(false);
+			return false;
+		case PT_BOOL:
+			res->append(*(uint32_t*)rawval != 0 ? "true" : "false");
+			return true;
+		case PT_CHARBUF:
+		case PT_FSPATH:
+		case PT_BYTEBUF:
+		case PT_IPV4ADDR:
+		case PT_IPV6ADDR:
+		case PT_IPADDR:
+		case PT_FSRELPATH:
+			as_number = false;
+			as_string = true;
+			break;
+		default:
+			ASSERT(false);
+			throw sinsp_exception("wrong event type " + to_string((long long) m_field->m_type));
+	}
+
+	if(as_string)
+	{
+		const char* str = rawval_to_string(rawval, m_field->m_type, print_format, len);
+		append_json_string(str, strlen(str), res);
+		return true;
+	}
+
+	switch(m_field->m_type)
+	{
+		case PT_INT8:
+			append_json_int(*(int8_t*)rawval, res);
+			break;
+		case PT_INT16:
+			append_json_int(*(int16_t*)rawval, res);
+			break;
+		case PT_INT32:
+			append_json_int(*(int32_t*)rawval, res);
+			break;
+		case PT_INT64:
+		case PT_PID:
+			append_json_int(*(int64_t*)rawval, res);
+			break;
+		case PT_L4PROTO:
+		case PT_UINT8:
+			append_json_uint(*(uint8_t*)rawval, res);
+			break;
+		case PT_PORT:
+		case PT_UINT16:
+			append_json_uint(*(uint16_t*)rawval, res);
+			break;
+		case PT_UINT32:
+			append_json_uint(*(uint32_t*)rawval, res);
+			break;
+		default:
+			append_json_uint(*(uint64_t*)rawval, res);
+			break;
+	}
+	return true;
+}
+
 int32_t sinsp_filter_check::parse_field_name(const char* str, bool alloc_state, bool needed_for_filtering)
 {
 	int32_t j;
@@ -1226,6 +1475,16 @@ void sinsp_filter_check::add_filter_value(const char* str, uint32_t len, uint32_
 		m_val_storages_max_size = parsed_len;
 	}
 
+	if(i == 0 && m_field->m_type == PT_CHARBUF)
+	{
+		size_t val_len = strnlen((const char*)filter_value_p(), filter_value()->size());
+		m_val_search.set((const char*)filter_value_p(), val_len);
+		if(m_cmpop == CO_GLOB)
+		{
+			m_val_glob.compile((const char*)filter_value_p(), val_len);
+		}
+	}
+
 	// If the operator is CO_PMATCH, also add the value to the paths set.
 	if (m_cmpop == CO_PMATCH)
 	{
@@ -1328,6 +1587,14 @@ bool sinsp_filter_check::flt_compare(cmpop op, ppm_param_type type, void* operan
 			break;
 		}
 	}
+	else if(type == PT_CHARBUF && op == CO_GLOB && m_val_glob.is_set())
+	{
+		return m_val_glob.match((char*)operand1, strlen((char*)operand1));
+	}
+	else if(type == PT_CHARBUF && m_val_search.is_set())
+	{
+		return flt_compare_string(op, (char*)operand1, m_val_search);
+	}
 	else
 	{
 		return (::flt_compare(op,
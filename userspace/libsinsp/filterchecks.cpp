@@ -2306,8 +2306,7 @@ uint8_t* sinsp_filter_check_thread::extract(sinsp_evt *evt, OUT uint32_t* len, b
 		}
 	case TYPE_PNAME:
 		{
-			sinsp_threadinfo* ptinfo =
-				&*m_inspector->get_thread_ref(tinfo->m_ptid, false, true);
+			sinsp_threadinfo* ptinfo = tinfo->get_parent_thread();
 
 			if(ptinfo != NULL)
 			{
@@ -2321,8 +2320,7 @@ uint8_t* sinsp_filter_check_thread::extract(sinsp_evt *evt, OUT uint32_t* len, b
 		}
 	case TYPE_PCMDLINE:
 		{
-			sinsp_threadinfo* ptinfo =
-				&*m_inspector->get_thread_ref(tinfo->m_ptid, false, true);
+			sinsp_threadinfo* ptinfo = tinfo->get_parent_thread();
 
 			if(ptinfo != NULL)
 			{
@@ -3165,6 +3163,53 @@ uint8_t* extract_argraw(sinsp_evt *evt, OUT uint32_t* len, const char *argname)
 	}
 }
 
+const int8_t sinsp_filter_check_event::ARGNAME_ID_UNRESOLVED;
+
+//
+// Resolves m_argname to a parameter number once per event type, instead of
+// comparing it with the parameter names of every event. Returns -1 if evt
+// has no such parameter.
+//
+int32_t sinsp_filter_check_event::get_argname_id(sinsp_evt *evt)
+{
+	uint16_t etype = evt->get_type();
+	if(etype >= PPM_EVENT_MAX)
+	{
+		return -1;
+	}
+
+	if(m_argname_ids.empty())
+	{
+		m_argname_ids.assign(PPM_EVENT_MAX, ARGNAME_ID_UNRESOLVED);
+	}
+
+	int8_t argid = m_argname_ids[etype];
+	if(argid == ARGNAME_ID_UNRESOLVED)
+	{
+		const ppm_event_info* ei = &g_infotables.m_event_info[etype];
+
+		argid = -1;
+		for(uint32_t j = 0; j < ei->nparams; j++)
+		{
+			if(strcmp(m_argname.c_str(), ei->params[j].name) == 0)
+			{
+				argid = (int8_t)j;
+				break;
+			}
+		}
+
+		m_argname_ids[etype] = argid;
+	}
+
+	// captures written with an older event table may have fewer parameters
+	if(argid >= (int32_t)evt->get_num_params())
+	{
+		return -1;
+	}
+
+	return argid;
+}
+
 uint8_t *sinsp_filter_check_event::extract_abspath(sinsp_evt *evt, OUT uint32_t *len)
 {
 	sinsp_evt_param *parinfo;
@@ -3802,7 +3847,17 @@ uint8_t* sinsp_filter_check_event::extract(sinsp_evt *evt, OUT uint32_t* len, bo
 	case TYPE_CPU:
 		RETURN_EXTRACT_VAR(evt->m_cpuid);
 	case TYPE_ARGRAW:
-		return extract_argraw(evt, len, m_arginfo->name);
+		{
+			int32_t argid = get_argname_id(evt);
+			if(argid < 0)
+			{
+				return NULL;
+			}
+
+			const sinsp_evt_param* pi = evt->get_param(argid);
+			*len = pi->m_len;
+			return (uint8_t*)pi->m_val;
+		}
 		break;
 	case TYPE_ARGSTR:
 		{
@@ -3822,7 +3877,13 @@ uint8_t* sinsp_filter_check_event::extract(sinsp_evt *evt, OUT uint32_t* len, bo
 			}
 			else
 			{
-				argstr = evt->get_param_value_str(m_argname.c_str(), &resolved_argstr, m_inspector->get_buffer_format());
+				int32_t argid = get_argname_id(evt);
+				if(argid < 0)
+				{
+					return NULL;
+				}
+
+				argstr = evt->get_param_as_str(argid, &resolved_argstr, m_inspector->get_buffer_format());
 			}
 
 			if(resolved_argstr != NULL && resolved_argstr[0] != 0)
@@ -5988,6 +6049,149 @@ uint8_t* sinsp_filter_check_syslog::extract(sinsp_evt *evt, OUT uint32_t* len, b
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// sinsp_filter_check_http implementation
+///////////////////////////////////////////////////////////////////////////////
+const filtercheck_field_info sinsp_filter_check_http_fields[] =
+{
+	{PT_CHARBUF, EPF_NONE, PF_NA, "http.method", "the method of the HTTP request that starts in this read or write, e.g. GET."},
+	{PT_CHARBUF, EPF_NONE, PF_NA, "http.url", "the URL of the HTTP request that starts in this read or write, as in the request line."},
+	{PT_CHARBUF, EPF_NONE, PF_NA, "http.host", "the Host header of an HTTP request, for the read or write that carries it."},
+	{PT_UINT32, EPF_NONE, PF_DEC, "http.status", "the status code of the HTTP response that starts in this read or write."},
+};
+
+sinsp_filter_check_http::sinsp_filter_check_http()
+{
+	m_info.m_name = "http";
+	m_info.m_fields = sinsp_filter_check_http_fields;
+	m_info.m_nfields = sizeof(sinsp_filter_check_http_fields) / sizeof(sinsp_filter_check_http_fields[0]);
+	m_decoder = NULL;
+}
+
+sinsp_filter_check* sinsp_filter_check_http::allocate_new()
+{
+	return (sinsp_filter_check*) new sinsp_filter_check_http();
+}
+
+int32_t sinsp_filter_check_http::parse_field_name(const char* str, bool alloc_state, bool needed_for_filtering)
+{
+	int32_t res = sinsp_filter_check::parse_field_name(str, alloc_state, needed_for_filtering);
+	if(res != -1)
+	{
+		m_decoder = (sinsp_decoder_http*)m_inspector->require_protodecoder("http");
+	}
+
+	return res;
+}
+
+uint8_t* sinsp_filter_check_http::extract(sinsp_evt *evt, OUT uint32_t* len, bool sanitize_strings)
+{
+	*len = 0;
+	ASSERT(m_decoder != NULL);
+	if(!m_decoder->is_data_valid())
+	{
+		return NULL;
+	}
+
+	switch(m_field_id)
+	{
+	case TYPE_METHOD:
+		if(!m_decoder->m_is_request)
+		{
+			return NULL;
+		}
+		RETURN_EXTRACT_STRING(m_decoder->m_method);
+	case TYPE_URL:
+		if(!m_decoder->m_is_request)
+		{
+			return NULL;
+		}
+		RETURN_EXTRACT_STRING(m_decoder->m_url);
+	case TYPE_HOST:
+		if(m_decoder->m_host.empty())
+		{
+			return NULL;
+		}
+		RETURN_EXTRACT_STRING(m_decoder->m_host);
+	case TYPE_STATUS:
+		if(!m_decoder->m_is_response)
+		{
+			return NULL;
+		}
+		RETURN_EXTRACT_VAR(m_decoder->m_status);
+	default:
+		ASSERT(false);
+		return NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// sinsp_filter_check_dns implementation
+///////////////////////////////////////////////////////////////////////////////
+const filtercheck_field_info sinsp_filter_check_dns_fields[] =
+{
+	{PT_CHARBUF, EPF_NONE, PF_NA, "dns.name", "the name in the question of the DNS query or response in this read or write."},
+	{PT_CHARBUF, EPF_NONE, PF_NA, "dns.type", "the type of the question as a string, e.g. A, AAAA, PTR."},
+	{PT_BOOL, EPF_NONE, PF_NA, "dns.is_response", "'true' if the message is a response, 'false' if it's a query."},
+	{PT_UINT32, EPF_NONE, PF_DEC, "dns.rcode", "the response code of a DNS response, 0 for success, 3 for a name that doesn't exist."},
+};
+
+sinsp_filter_check_dns::sinsp_filter_check_dns()
+{
+	m_info.m_name = "dns";
+	m_info.m_fields = sinsp_filter_check_dns_fields;
+	m_info.m_nfields = sizeof(sinsp_filter_check_dns_fields) / sizeof(sinsp_filter_check_dns_fields[0]);
+	m_decoder = NULL;
+}
+
+sinsp_filter_check* sinsp_filter_check_dns::allocate_new()
+{
+	return (sinsp_filter_check*) new sinsp_filter_check_dns();
+}
+
+int32_t sinsp_filter_check_dns::parse_field_name(const char* str, bool alloc_state, bool needed_for_filtering)
+{
+	int32_t res = sinsp_filter_check::parse_field_name(str, alloc_state, needed_for_filtering);
+	if(res != -1)
+	{
+		m_decoder = (sinsp_decoder_dns*)m_inspector->require_protodecoder("dns");
+	}
+
+	return res;
+}
+
+uint8_t* sinsp_filter_check_dns::extract(sinsp_evt *evt, OUT uint32_t* len, bool sanitize_strings)
+{
+	*len = 0;
+	const char *str;
+	ASSERT(m_decoder != NULL);
+	if(!m_decoder->is_data_valid())
+	{
+		return NULL;
+	}
+
+	switch(m_field_id)
+	{
+	case TYPE_NAME:
+		RETURN_EXTRACT_STRING(m_decoder->m_qname);
+	case TYPE_TYPE:
+		str = m_decoder->get_type_str();
+		RETURN_EXTRACT_CSTR(str);
+	case TYPE_IS_RESPONSE:
+		m_is_response = m_decoder->m_is_response;
+		RETURN_EXTRACT_VAR(m_is_response);
+	case TYPE_RCODE:
+		if(!m_decoder->m_is_response)
+		{
+			return NULL;
+		}
+		RETURN_EXTRACT_VAR(m_decoder->m_rcode);
+	default:
+		ASSERT(false);
+		return NULL;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // sinsp_filter_check_container implementation
 ///////////////////////////////////////////////////////////////////////////////
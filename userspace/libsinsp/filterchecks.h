@@ -20,6 +20,8 @@ limitations under the License.
 #include <json/json.h>
 #include "filter_value.h"
 #include "prefix_search.h"
+#include "glob_matcher.h"
+#include "string_search.h"
 #if !defined(CYGWING_AGENT) && !defined(MINIMAL_BUILD)
 #include "k8s.h"
 #include "mesos.h"
@@ -31,6 +33,7 @@ limitations under the License.
 class sinsp_filter_check_reference;
 
 bool flt_compare(cmpop op, ppm_param_type type, void* operand1, void* operand2, uint32_t op1_len = 0, uint32_t op2_len = 0);
+bool flt_compare_string(cmpop op, char* operand1, const string_search& operand2);
 bool flt_compare_avg(cmpop op, ppm_param_type type, void* operand1, void* operand2, uint32_t op1_len, uint32_t op2_len, uint32_t cnt1, uint32_t cnt2);
 bool flt_compare_ipv4net(cmpop op, uint64_t operand1, ipv4net* operand2);
 bool flt_compare_ipv6net(cmpop op, ipv6addr *operand1, ipv6addr* operand2);
@@ -153,6 +156,13 @@ public:
 	//
 	virtual Json::Value tojson(sinsp_evt* evt);
 
+	//
+	// Extract the value from the event and append it to res, serialized
+	// as the value returned by tojson() would be, without building it.
+	// Returns false, leaving res untouched, if tojson() would return null.
+	//
+	virtual bool append_json(sinsp_evt* evt, OUT std::string* res);
+
 	sinsp* m_inspector;
 	bool m_needs_state_tracking = false;
 	sinsp_field_aggregation m_aggregation;
@@ -181,6 +191,10 @@ protected:
 
 	path_prefix_search m_val_storages_paths;
 
+	// the first filter value, prepared for string comparisons
+	string_search m_val_search;
+	glob_matcher m_val_glob;
+
 	uint32_t m_val_storages_min_size;
 	uint32_t m_val_storages_max_size;
 
@@ -504,12 +518,16 @@ private:
 	uint8_t* extract_error_count(sinsp_evt *evt, OUT uint32_t* len);
 	uint8_t *extract_abspath(sinsp_evt *evt, OUT uint32_t *len);
 	inline uint8_t* extract_buflen(sinsp_evt *evt, OUT uint32_t* len);
+	int32_t get_argname_id(sinsp_evt *evt);
+
+	static const int8_t ARGNAME_ID_UNRESOLVED = -2;
 
 	bool m_is_compare;
 	char* m_storage;
 	uint32_t m_storage_size;
 	const char* m_cargname;
 	sinsp_filter_check_reference* m_converter;
+	vector<int8_t> m_argname_ids;	// m_argname parameter number per event type
 };
 
 //
@@ -731,6 +749,55 @@ public:
 	string m_name;
 };
 
+//
+// http checks
+//
+class sinsp_decoder_http;
+
+class sinsp_filter_check_http : public sinsp_filter_check
+{
+public:
+	enum check_type
+	{
+		TYPE_METHOD = 0,
+		TYPE_URL,
+		TYPE_HOST,
+		TYPE_STATUS,
+	};
+
+	sinsp_filter_check_http();
+	sinsp_filter_check* allocate_new();
+	int32_t parse_field_name(const char* str, bool alloc_state, bool needed_for_filtering);
+	uint8_t* extract(sinsp_evt *evt, OUT uint32_t* len, bool sanitize_strings = true);
+
+	sinsp_decoder_http* m_decoder;
+};
+
+//
+// dns checks
+//
+class sinsp_decoder_dns;
+
+class sinsp_filter_check_dns : public sinsp_filter_check
+{
+public:
+	enum check_type
+	{
+		TYPE_NAME = 0,
+		TYPE_TYPE,
+		TYPE_IS_RESPONSE,
+		TYPE_RCODE,
+	};
+
+	sinsp_filter_check_dns();
+	sinsp_filter_check* allocate_new();
+	int32_t parse_field_name(const char* str, bool alloc_state, bool needed_for_filtering);
+	uint8_t* extract(sinsp_evt *evt, OUT uint32_t* len, bool sanitize_strings = true);
+
+	sinsp_decoder_dns* m_decoder;
+	uint32_t m_is_response;
+};
+
 class sinsp_filter_check_container : public sinsp_filter_check
 {
 public:
@@ -0,0 +1,314 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "glob_matcher.h"
+#include "utils.h"
+
+glob_matcher::glob_matcher():
+	m_kind(MK_FALLBACK),
+	m_set(false)
+{
+}
+
+void glob_matcher::compile(const char* pattern, size_t len)
+{
+	clear();
+	m_pattern.assign(pattern, len);
+	m_set = true;
+
+	std::vector<token> tokens;
+	if(!parse(pattern, len, tokens))
+	{
+		return;
+	}
+
+	size_t begin = 0;
+	size_t end = tokens.size();
+	while(begin < end && tokens[begin].m_type == TT_CHAR)
+	{
+		m_prefix += (char)tokens[begin++].m_char;
+	}
+	size_t suffix_begin = end;
+	while(suffix_begin > begin && tokens[suffix_begin - 1].m_type == TT_CHAR)
+	{
+		suffix_begin--;
+	}
+	for(size_t j = suffix_begin; j < end; j++)
+	{
+		m_suffix += (char)tokens[j].m_char;
+	}
+	end = suffix_begin;
+
+	if(begin == end)
+	{
+		m_kind = MK_EXACT;
+		return;
+	}
+	if(end - begin == 1 && tokens[begin].m_type == TT_STAR)
+	{
+		m_kind = MK_ANY;
+		return;
+	}
+
+	if(end - begin > 2 && tokens[begin].m_type == TT_STAR && tokens[end - 1].m_type == TT_STAR)
+	{
+		std::string infix;
+		for(size_t j = begin + 1; j < end - 1 && tokens[j].m_type == TT_CHAR; j++)
+		{
+			infix += (char)tokens[j].m_char;
+		}
+		if(infix.size() == end - begin - 2)
+		{
+			m_infix.set(infix.c_str(), infix.size());
+			m_kind = MK_CONTAINS;
+			return;
+		}
+	}
+
+	m_tokens.assign(tokens.begin() + begin, tokens.begin() + end);
+	m_kind = MK_TOKENS;
+}
+
+void glob_matcher::clear()
+{
+	m_kind = MK_FALLBACK;
+	m_pattern.clear();
+	m_prefix.clear();
+	m_suffix.clear();
+	m_infix.clear();
+	m_tokens.clear();
+	m_sets.clear();
+	m_set = false;
+}
+
+bool glob_matcher::match(const char* str, size_t len) const
+{
+	if(m_kind == MK_FALLBACK)
+	{
+		return sinsp_utils::glob_match(m_pattern.c_str(), str);
+	}
+
+	if(len < m_prefix.size() + m_suffix.size() ||
+	   memcmp(str, m_prefix.data(), m_prefix.size()) != 0 ||
+	   memcmp(str + len - m_suffix.size(), m_suffix.data(), m_suffix.size()) != 0)
+	{
+		return false;
+	}
+
+	const char* middle = str + m_prefix.size();
+	size_t middle_len = len - m_prefix.size() - m_suffix.size();
+	switch(m_kind)
+	{
+	case MK_EXACT:
+		return middle_len == 0;
+	case MK_ANY:
+		return true;
+	case MK_CONTAINS:
+		return m_infix.find(middle, middle_len) != NULL;
+	default:
+		return match_tokens(middle, middle_len);
+	}
+}
+
+bool glob_matcher::parse(const char* pattern, size_t len, std::vector<token>& tokens)
+{
+#ifdef _WIN32
+	// glob_match() is PathMatchSpec() here, which has its own syntax
+	return false;
+#endif
+	size_t pos = 0;
+	while(pos < len)
+	{
+		token t = {TT_CHAR, 0, 0};
+		switch(pattern[pos])
+		{
+		case '*':
+			pos++;
+			// consecutive stars match the same strings as one
+			if(!tokens.empty() && tokens.back().m_type == TT_STAR)
+			{
+				continue;
+			}
+			t.m_type = TT_STAR;
+			break;
+		case '?':
+			pos++;
+			t.m_type = TT_ANY;
+			break;
+		case '[':
+			if(!parse_set(pattern, len, pos, tokens))
+			{
+				return false;
+			}
+			continue;
+		case '\\':
+			if(pos + 1 == len)
+			{
+				return false;
+			}
+			t.m_char = pattern[pos + 1];
+			pos += 2;
+			break;
+		default:
+			t.m_char = pattern[pos++];
+			break;
+		}
+		tokens.push_back(t);
+	}
+	return true;
+}
+
+//
+// Parses the bracket expression starting at pattern[pos]. Brackets that
+// are never closed are left to fnmatch(), whose handling of them is
+// irregular.
+//
+bool glob_matcher::parse_set(const char* pattern, size_t len, size_t& pos, std::vector<token>& tokens)
+{
+	std::bitset<256> set;
+	size_t p = pos + 1;
+	bool negate = false;
+	if(p < len && (pattern[p] == '!' || pattern[p] == '^'))
+	{
+		negate = true;
+		p++;
+	}
+
+	bool first = true;
+	while(true)
+	{
+		if(p >= len)
+		{
+			return false;
+		}
+
+		if(pattern[p] == ']' && !first)
+		{
+			p++;
+			break;
+		}
+		first = false;
+
+		if(pattern[p] == '[' && p + 1 < len &&
+		   (pattern[p + 1] == ':' || pattern[p + 1] == '=' || pattern[p + 1] == '.'))
+		{
+			return false;
+		}
+
+		if(pattern[p] == '\\' && ++p >= len)
+		{
+			return false;
+		}
+		uint8_t lo = pattern[p++];
+		uint8_t hi = lo;
+
+		if(p + 1 < len && pattern[p] == '-' && pattern[p + 1] != ']')
+		{
+			p++;
+			if(pattern[p] == '[' && p + 1 < len &&
+			   (pattern[p + 1] == ':' || pattern[p + 1] == '=' || pattern[p + 1] == '.'))
+			{
+				return false;
+			}
+			if(pattern[p] == '\\' && ++p >= len)
+			{
+				return false;
+			}
+			hi = pattern[p++];
+			if(hi < lo)
+			{
+				return false;
+			}
+		}
+
+		for(unsigned c = lo; c <= hi; c++)
+		{
+			set.set(c);
+		}
+	}
+
+	if(negate)
+	{
+		set.flip();
+	}
+	// the string terminator is never part of a match
+	set.reset(0);
+
+	token t = {TT_SET, 0, (uint32_t)m_sets.size()};
+	m_sets.push_back(set);
+	tokens.push_back(t);
+	pos = p;
+	return true;
+}
+
+inline bool glob_matcher::token_matches(const token& t, uint8_t c) const
+{
+	switch(t.m_type)
+	{
+	case TT_CHAR:
+		return t.m_char == c;
+	case TT_ANY:
+		return true;
+	default:
+		return m_sets[t.m_set].test(c);
+	}
+}
+
+//
+// Classic single-pass matching with backtracking to the last star: every
+// token other than a star consumes exactly one character, so when a
+// mismatch happens it is enough to let the last star absorb one more
+// character and retry from there.
+//
+bool glob_matcher::match_tokens(const char* str, size_t len) const
+{
+	const size_t npos = (size_t)-1;
+	const size_t ntokens = m_tokens.size();
+	size_t t = 0;
+	size_t s = 0;
+	size_t star_t = npos;
+	size_t star_s = 0;
+
+	while(s < len)
+	{
+		if(t < ntokens && m_tokens[t].m_type == TT_STAR)
+		{
+			star_t = t++;
+			star_s = s;
+		}
+		else if(t < ntokens && token_matches(m_tokens[t], str[s]))
+		{
+			t++;
+			s++;
+		}
+		else if(star_t != npos)
+		{
+			t = star_t + 1;
+			s = ++star_s;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	while(t < ntokens && m_tokens[t].m_type == TT_STAR)
+	{
+		t++;
+	}
+	return t == ntokens;
+}
@@ -0,0 +1,96 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "string_search.h"
+
+//
+// A glob pattern compiled once, with the same semantics as
+// sinsp_utils::glob_match() (fnmatch() without flags, bytewise).
+//
+// The literal prefix and suffix of the pattern are checked first. What
+// is left in between is matched directly when it is empty, a single '*'
+// or '*literal*', and otherwise by a backtracking matcher over the
+// pre-parsed '?', '[...]', '*' and literal tokens. Patterns using
+// constructs that are not compiled ([:class:], [=equiv=], [.coll.],
+// reversed ranges) are passed to sinsp_utils::glob_match().
+//
+class glob_matcher
+{
+public:
+	glob_matcher();
+
+	void compile(const char* pattern, size_t len);
+	void clear();
+
+	// true if compile() was called
+	bool is_set() const;
+
+	// str must be NUL terminated, len is strlen(str)
+	bool match(const char* str, size_t len) const;
+
+private:
+	enum match_kind
+	{
+		MK_EXACT,	// the pattern is a literal
+		MK_ANY,		// prefix*suffix
+		MK_CONTAINS,	// prefix*literal*suffix
+		MK_TOKENS,	// prefix<tokens>suffix
+		MK_FALLBACK,	// sinsp_utils::glob_match()
+	};
+
+	enum token_type
+	{
+		TT_CHAR,
+		TT_ANY,
+		TT_SET,
+		TT_STAR,
+	};
+
+	struct token
+	{
+		token_type m_type;
+		uint8_t m_char;
+		uint32_t m_set;
+	};
+
+	bool parse(const char* pattern, size_t len, std::vector<token>& tokens);
+	bool parse_set(const char* pattern, size_t len, size_t& pos, std::vector<token>& tokens);
+	bool token_matches(const token& t, uint8_t c) const;
+	bool match_tokens(const char* str, size_t len) const;
+
+	match_kind m_kind;
+	std::string m_pattern;
+	std::string m_prefix;
+	std::string m_suffix;
+	string_search m_infix;
+	std::vector<token> m_tokens;
+	std::vector<std::bitset<256>> m_sets;
+	bool m_set;
+};
+
+inline bool glob_matcher::is_set() const
+{
+	return m_set;
+}
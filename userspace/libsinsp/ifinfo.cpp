@@ -68,36 +68,185 @@ string sinsp_ipv4_ifinfo::to_string() const
 	return string(s);
 }
 
-uint32_t sinsp_network_interfaces::infer_ipv4_address(uint32_t destination_address)
+void sinsp_network_interfaces::index_ipv4_interface(size_t pos)
 {
-	vector<sinsp_ipv4_ifinfo>::iterator it;
+	const sinsp_ipv4_ifinfo& info = m_ipv4_interfaces[pos];
+	m_ipv4_addrs.emplace(info.m_addr, pos);
 
-	// first try to find exact match
-	for(it = m_ipv4_interfaces.begin(); it != m_ipv4_interfaces.end(); it++)
+	auto mask = m_ipv4_subnets.begin();
+	for(; mask != m_ipv4_subnets.end(); ++mask)
 	{
-		if(it->m_addr == destination_address)
+		if(mask->first == info.m_netmask)
 		{
-			return it->m_addr;
+			break;
 		}
 	}
+	if(mask == m_ipv4_subnets.end())
+	{
+		m_ipv4_subnets.emplace_back(info.m_netmask, ipv4_index());
+		mask = m_ipv4_subnets.end() - 1;
+	}
+	mask->second.emplace(info.m_addr & info.m_netmask, pos);
 
-	// try to find an interface for the same subnet
-	for(it = m_ipv4_interfaces.begin(); it != m_ipv4_interfaces.end(); it++)
+	if(m_ipv4_nonloopback == NO_INTERFACE && info.m_addr != ntohl(INADDR_LOOPBACK))
+	{
+		m_ipv4_nonloopback = pos;
+	}
+}
+
+uint64_t sinsp_network_interfaces::ipv6_prefix(const ipv6addr& addr)
+{
+	return (static_cast<uint64_t>(addr.m_b[0]) << 32) | addr.m_b[1];
+}
+
+void sinsp_network_interfaces::index_ipv6_interface(size_t pos)
+{
+	const sinsp_ipv6_ifinfo& info = m_ipv6_interfaces[pos];
+	m_ipv6_addrs.emplace(info.m_net, pos);
+	m_ipv6_subnets.emplace(ipv6_prefix(info.m_net), pos);
+	if(m_ipv6_nonloopback == NO_INTERFACE && info.m_net != m_ipv6_loopback_addr)
+	{
+		m_ipv6_nonloopback = pos;
+	}
+}
+
+//
+// Removes the entries of the interfaces from position pos on
+//
+template<typename index_t>
+static void unindex_from(index_t* index, size_t pos)
+{
+	for(auto it = index->begin(); it != index->end();)
 	{
-		if((it->m_addr & it->m_netmask) == (destination_address & it->m_netmask))
+		if(it->second >= pos)
+		{
+			it = index->erase(it);
+		}
+		else
 		{
-			return it->m_addr;
+			++it;
 		}
 	}
+}
 
-	// otherwise take the first non loopback interface
-	for(it = m_ipv4_interfaces.begin(); it != m_ipv4_interfaces.end(); it++)
+void sinsp_network_interfaces::unindex_ipv4_interfaces(size_t pos)
+{
+	if(pos >= m_ipv4_indexed)
 	{
-		if(it->m_addr != ntohl(INADDR_LOOPBACK))
+		return;
+	}
+
+	if(pos == 0)
+	{
+		m_ipv4_addrs.clear();
+		m_ipv4_subnets.clear();
+	}
+	else
+	{
+		unindex_from(&m_ipv4_addrs, pos);
+		for(auto mask = m_ipv4_subnets.begin(); mask != m_ipv4_subnets.end();)
 		{
-			return it->m_addr;
+			unindex_from(&mask->second, pos);
+			if(mask->second.empty())
+			{
+				mask = m_ipv4_subnets.erase(mask);
+			}
+			else
+			{
+				++mask;
+			}
 		}
 	}
+
+	if(m_ipv4_nonloopback != NO_INTERFACE && m_ipv4_nonloopback >= pos)
+	{
+		m_ipv4_nonloopback = NO_INTERFACE;
+	}
+	m_ipv4_indexed = pos;
+}
+
+void sinsp_network_interfaces::unindex_ipv6_interfaces(size_t pos)
+{
+	if(pos >= m_ipv6_indexed)
+	{
+		return;
+	}
+
+	if(pos == 0)
+	{
+		m_ipv6_addrs.clear();
+		m_ipv6_subnets.clear();
+	}
+	else
+	{
+		unindex_from(&m_ipv6_addrs, pos);
+		unindex_from(&m_ipv6_subnets, pos);
+	}
+
+	if(m_ipv6_nonloopback != NO_INTERFACE && m_ipv6_nonloopback >= pos)
+	{
+		m_ipv6_nonloopback = NO_INTERFACE;
+	}
+	m_ipv6_indexed = pos;
+}
+
+void sinsp_network_interfaces::update_index()
+{
+	//
+	// A list handed out by get_ipv4_list() or get_ipv6_list() may have
+	// been changed anywhere: reindex it entirely
+	//
+	if(m_ipv4_stale)
+	{
+		unindex_ipv4_interfaces(0);
+		m_ipv4_stale = false;
+	}
+	for(; m_ipv4_indexed < m_ipv4_interfaces.size(); ++m_ipv4_indexed)
+	{
+		index_ipv4_interface(m_ipv4_indexed);
+	}
+
+	if(m_ipv6_stale)
+	{
+		unindex_ipv6_interfaces(0);
+		m_ipv6_stale = false;
+	}
+	for(; m_ipv6_indexed < m_ipv6_interfaces.size(); ++m_ipv6_indexed)
+	{
+		index_ipv6_interface(m_ipv6_indexed);
+	}
+}
+
+uint32_t sinsp_network_interfaces::infer_ipv4_address(uint32_t destination_address)
+{
+	update_index();
+
+	// first try to find exact match
+	if(m_ipv4_addrs.find(destination_address) != m_ipv4_addrs.end())
+	{
+		return destination_address;
+	}
+
+	// try to find an interface for the same subnet
+	size_t pos = NO_INTERFACE;
+	for(const auto& mask : m_ipv4_subnets)
+	{
+		auto it = mask.second.find(destination_address & mask.first);
+		if(it != mask.second.end() && it->second < pos)
+		{
+			pos = it->second;
+		}
+	}
+	if(pos != NO_INTERFACE)
+	{
+		return m_ipv4_interfaces[pos].m_addr;
+	}
+
+	// otherwise take the first non loopback interface
+	if(m_ipv4_nonloopback != NO_INTERFACE)
+	{
+		return m_ipv4_interfaces[m_ipv4_nonloopback].m_addr;
+	}
 	return 0;
 }
 
@@ -196,8 +345,6 @@ void sinsp_network_interfaces::update_fd(sinsp_fdinfo_t *fd)
 
 bool sinsp_network_interfaces::is_ipv4addr_in_subnet(uint32_t addr)
 {
-	vector<sinsp_ipv4_ifinfo>::iterator it;
-
 	//
 	// Accept everything that comes from private internets:
 	// - 10.0.0.0/8
@@ -213,9 +360,10 @@ bool sinsp_network_interfaces::is_ipv4addr_in_subnet(uint32_t addr)
 	}
 
 	// try to find an interface for the same subnet
-	for(it = m_ipv4_interfaces.begin(); it != m_ipv4_interfaces.end(); it++)
+	update_index();
+	for(const auto& mask : m_ipv4_subnets)
 	{
-		if((it->m_addr & it->m_netmask) == (addr & it->m_netmask))
+		if(mask.second.find(addr & mask.first) != mask.second.end())
 		{
 			return true;
 		}
@@ -284,27 +432,32 @@ bool sinsp_network_interfaces::is_ipv4addr_in_local_machine(uint32_t addr, sinsp
 		}
 	}
 
-	vector<sinsp_ipv4_ifinfo>::iterator it;
-
 	// try to find an interface that has the given IP as address
-	for(it = m_ipv4_interfaces.begin(); it != m_ipv4_interfaces.end(); it++)
-	{
-		if(it->m_addr == addr)
-		{
-			return true;
-		}
-	}
-
-	return false;
+	update_index();
+	return m_ipv4_addrs.find(addr) != m_ipv4_addrs.end();
 }
 
 void sinsp_network_interfaces::import_ipv4_ifaddr_list(uint32_t count, scap_ifinfo_ipv4* plist)
 {
-	if (count == 0)
+	//
+	// Keep the interfaces that didn't change, up to the first one that
+	// did, and replace the others
+	//
+	size_t pos = 0;
+	while(pos < count && pos < m_ipv4_interfaces.size() &&
+	      m_ipv4_interfaces[pos].m_addr == plist->addr &&
+	      m_ipv4_interfaces[pos].m_netmask == plist->netmask &&
+	      m_ipv4_interfaces[pos].m_bcast == plist->bcast &&
+	      m_ipv4_interfaces[pos].m_name == plist->ifname)
 	{
-		return;
+		pos++;
+		plist++;
 	}
-	for(uint32_t j = 0; j < count; j++)
+
+	unindex_ipv4_interfaces(pos);
+	m_ipv4_interfaces.resize(pos);
+
+	for(uint32_t j = (uint32_t)pos; j < count; j++)
 	{
 		sinsp_ipv4_ifinfo info;
 		info.m_addr = plist->addr;
@@ -314,37 +467,30 @@ void sinsp_network_interfaces::import_ipv4_ifaddr_list(uint32_t count, scap_ifin
 		m_ipv4_interfaces.push_back(info);
 		plist++;
 	}
+	update_index();
 }
 
 ipv6addr sinsp_network_interfaces::infer_ipv6_address(ipv6addr &destination_address)
 {
-	vector<sinsp_ipv6_ifinfo>::iterator it;
+	update_index();
 
 	// first try to find exact match
-	for(it = m_ipv6_interfaces.begin(); it != m_ipv6_interfaces.end(); it++)
+	if(m_ipv6_addrs.find(destination_address) != m_ipv6_addrs.end())
 	{
-		if(destination_address == it->m_net)
-		{
-			return it->m_net;
-		}
+		return destination_address;
 	}
 
 	// try to find an interface for the same subnet
-	for(it = m_ipv6_interfaces.begin(); it != m_ipv6_interfaces.end(); it++)
+	auto it = m_ipv6_subnets.find(ipv6_prefix(destination_address));
+	if(it != m_ipv6_subnets.end())
 	{
-		if(it->m_net.in_subnet(destination_address))
-		{
-			return it->m_net;
-		}
+		return m_ipv6_interfaces[it->second].m_net;
 	}
 
 	// otherwise take the first non loopback interface
-	for(it = m_ipv6_interfaces.begin(); it != m_ipv6_interfaces.end(); it++)
+	if(m_ipv6_nonloopback != NO_INTERFACE)
 	{
-		if(it->m_net != m_ipv6_loopback_addr)
-		{
-			return it->m_net;
-		}
+		return m_ipv6_interfaces[m_ipv6_nonloopback].m_net;
 	}
 
 	return ipv6addr::empty_address;
@@ -358,27 +504,26 @@ bool sinsp_network_interfaces::is_ipv6addr_in_local_machine(ipv6addr &addr, sins
 		return false;
 	}
 
-	vector<sinsp_ipv6_ifinfo>::iterator it;
-
 	// try to find an interface that has the given IP as address
-	for(it = m_ipv6_interfaces.begin(); it != m_ipv6_interfaces.end(); it++)
-	{
-		if(addr.in_subnet(it->m_net))
-		{
-			return true;
-		}
-	}
-
-	return false;
+	update_index();
+	return m_ipv6_subnets.find(ipv6_prefix(addr)) != m_ipv6_subnets.end();
 }
 
 void sinsp_network_interfaces::import_ipv6_ifaddr_list(uint32_t count, scap_ifinfo_ipv6* plist)
 {
-	if (count == 0)
+	size_t pos = 0;
+	while(pos < count && pos < m_ipv6_interfaces.size() &&
+	      memcmp(m_ipv6_interfaces[pos].m_net.m_b, plist->addr, SCAP_IPV6_ADDR_LEN) == 0 &&
+	      m_ipv6_interfaces[pos].m_name == plist->ifname)
 	{
-		return;
+		pos++;
+		plist++;
 	}
-	for(uint32_t j = 0; j < count; j++)
+
+	unindex_ipv6_interfaces(pos);
+	m_ipv6_interfaces.resize(pos);
+
+	for(uint32_t j = (uint32_t)pos; j < count; j++)
 	{
 		sinsp_ipv6_ifinfo info;
 
@@ -391,13 +536,13 @@ void sinsp_network_interfaces::import_ipv6_ifaddr_list(uint32_t count, scap_ifin
 		m_ipv6_interfaces.push_back(info);
 		plist++;
 	}
+	update_index();
 }
 
 void sinsp_network_interfaces::import_interfaces(scap_addrlist* paddrlist)
 {
 	if(NULL != paddrlist)
 	{
-		clear();
 		import_ipv4_ifaddr_list(paddrlist->n_v4_addrs, paddrlist->v4list);
 		import_ipv6_ifaddr_list(paddrlist->n_v6_addrs, paddrlist->v6list);
 	}
@@ -406,19 +551,33 @@ void sinsp_network_interfaces::import_interfaces(scap_addrlist* paddrlist)
 void sinsp_network_interfaces::import_ipv4_interface(const sinsp_ipv4_ifinfo& ifinfo)
 {
 	m_ipv4_interfaces.push_back(ifinfo);
+	update_index();
 }
 
 void sinsp_network_interfaces::import_ipv6_interface(const sinsp_ipv6_ifinfo& ifinfo)
 {
 	m_ipv6_interfaces.push_back(ifinfo);
+	update_index();
 }
 
 vector<sinsp_ipv4_ifinfo>* sinsp_network_interfaces::get_ipv4_list()
 {
+	m_ipv4_stale = true;
 	return &m_ipv4_interfaces;
 }
 
 vector<sinsp_ipv6_ifinfo>* sinsp_network_interfaces::get_ipv6_list()
+{
+	m_ipv6_stale = true;
+	return &m_ipv6_interfaces;
+}
+
+const vector<sinsp_ipv4_ifinfo>* sinsp_network_interfaces::get_ipv4_list() const
+{
+	return &m_ipv4_interfaces;
+}
+
+const vector<sinsp_ipv6_ifinfo>* sinsp_network_interfaces::get_ipv6_list() const
 {
 	return &m_ipv6_interfaces;
 }
@@ -18,6 +18,9 @@ limitations under the License.
 #pragma once
 
 #include "tuples.h"
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #ifndef VISIBILITY_PRIVATE
 #define VISIBILITY_PRIVATE private:
@@ -62,6 +65,10 @@ class SINSP_PUBLIC sinsp_network_interfaces
 public:
 	sinsp_network_interfaces(sinsp* inspector);
 
+	//
+	// Replaces the interfaces with the ones in paddrlist. The interfaces
+	// before the first one that changed keep their index entries.
+	//
 	void import_interfaces(scap_addrlist* paddrlist);
 	void import_ipv4_interface(const sinsp_ipv4_ifinfo& ifinfo);
 	void update_fd(sinsp_fdinfo_t *fd);
@@ -69,8 +76,16 @@ public:
 	bool is_ipv4addr_in_local_machine(uint32_t addr, sinsp_threadinfo* tinfo);
 	void import_ipv6_interface(const sinsp_ipv6_ifinfo& ifinfo);
 	bool is_ipv6addr_in_local_machine(ipv6addr &addr, sinsp_threadinfo* tinfo);
+	//
+	// The lists can be changed through the returned pointers: every call
+	// invalidates the lookup indexes of the list, which are rebuilt at
+	// the next lookup. Call them again for every change. The const
+	// versions leave the indexes alone.
+	//
 	vector<sinsp_ipv4_ifinfo>* get_ipv4_list();
 	vector<sinsp_ipv6_ifinfo>* get_ipv6_list();
+	const vector<sinsp_ipv4_ifinfo>* get_ipv4_list() const;
+	const vector<sinsp_ipv6_ifinfo>* get_ipv6_list() const;
 	inline void clear();
 
 	ipv6addr m_ipv6_loopback_addr;
@@ -80,13 +95,52 @@ VISIBILITY_PRIVATE
 	void import_ipv4_ifaddr_list(uint32_t count, scap_ifinfo_ipv4* plist);
 	ipv6addr infer_ipv6_address(ipv6addr &destination_address);
 	void import_ipv6_ifaddr_list(uint32_t count, scap_ifinfo_ipv6* plist);
+	void index_ipv4_interface(size_t pos);
+	void index_ipv6_interface(size_t pos);
+	void unindex_ipv4_interfaces(size_t pos);
+	void unindex_ipv6_interfaces(size_t pos);
+	void update_index();
+	static uint64_t ipv6_prefix(const ipv6addr& addr);
 	vector<sinsp_ipv4_ifinfo> m_ipv4_interfaces;
 	vector<sinsp_ipv6_ifinfo> m_ipv6_interfaces;
 	sinsp* m_inspector;
+
+	//
+	// Lookup indexes over the interface lists, kept up to date as
+	// interfaces are imported. Every entry holds the position of the
+	// first interface it was built from, so lookups pick the same
+	// interface a scan of the list would. The interfaces from position
+	// m_ipv4_indexed (m_ipv6_indexed) on aren't indexed yet.
+	//
+	static const size_t NO_INTERFACE = static_cast<size_t>(-1);
+	typedef std::unordered_map<uint32_t, size_t> ipv4_index;
+	ipv4_index m_ipv4_addrs;
+	// subnets, one index per distinct netmask (there are only a few)
+	std::vector<std::pair<uint32_t, ipv4_index>> m_ipv4_subnets;
+	size_t m_ipv4_nonloopback = NO_INTERFACE;
+	size_t m_ipv4_indexed = 0;
+	// the list was handed out by get_ipv4_list() and may have changed
+	bool m_ipv4_stale = false;
+	std::unordered_map<ipv6addr, size_t> m_ipv6_addrs;
+	// subnets, keyed by the first 64 bits (see ipv6addr::in_subnet())
+	std::unordered_map<uint64_t, size_t> m_ipv6_subnets;
+	size_t m_ipv6_nonloopback = NO_INTERFACE;
+	size_t m_ipv6_indexed = 0;
+	bool m_ipv6_stale = false;
 };
 
 void sinsp_network_interfaces::clear()
 {
 	m_ipv4_interfaces.clear();
 	m_ipv6_interfaces.clear();
+	m_ipv4_addrs.clear();
+	m_ipv4_subnets.clear();
+	m_ipv4_nonloopback = NO_INTERFACE;
+	m_ipv4_indexed = 0;
+	m_ipv4_stale = false;
+	m_ipv6_addrs.clear();
+	m_ipv6_subnets.clear();
+	m_ipv6_nonloopback = NO_INTERFACE;
+	m_ipv6_indexed = 0;
+	m_ipv6_stale = false;
 }
@@ -18,7 +18,6 @@ limitations under the License.
 #include "sinsp.h"
 #include "sinsp_int.h"
 
-#ifdef GATHER_INTERNAL_STATS
 namespace internal_metrics
 {
 
@@ -40,5 +39,91 @@ void registry::clear_all_metrics()
 
 }
 
+counter& registry::register_counter(const metric_name& name)
+{
+	std::shared_ptr<counter> p;
+	p = std::make_shared<counter>();
+	m_metrics[name] = p;
+	return *p.get();
 }
+
+histogram& registry::register_histogram(const metric_name& name)
+{
+	std::shared_ptr<histogram> p;
+	p = std::make_shared<histogram>();
+	m_metrics[name] = p;
+	return *p.get();
+}
+
+histogram::histogram():
+	m_count(0),
+	m_sum(0),
+	m_buckets(NBUCKETS, 0)
+{
+}
+
+uint32_t histogram::bucket(uint64_t value)
+{
+	if(value == 0)
+	{
+		return 0;
+	}
+#if defined(__GNUC__)
+	return 64 - __builtin_clzll(value);
+#else
+	uint32_t res = 0;
+	while(value != 0)
+	{
+		value >>= 1;
+		res++;
+	}
+	return res;
 #endif
+}
+
+void histogram::add(uint64_t value)
+{
+	m_count++;
+	m_sum += value;
+	m_buckets[bucket(value)]++;
+}
+
+void histogram::add(const histogram& other)
+{
+	m_count += other.m_count;
+	m_sum += other.m_sum;
+	for(uint32_t j = 0; j < NBUCKETS; j++)
+	{
+		m_buckets[j] += other.m_buckets[j];
+	}
+}
+
+void histogram::clear()
+{
+	m_count = 0;
+	m_sum = 0;
+	m_buckets.assign(NBUCKETS, 0);
+}
+
+uint64_t histogram::get_quantile(double q) const
+{
+	if(m_count == 0)
+	{
+		return 0;
+	}
+
+	uint64_t target = (uint64_t)(q * m_count);
+	uint64_t seen = 0;
+	for(uint32_t j = 0; j < NBUCKETS; j++)
+	{
+		seen += m_buckets[j];
+		if(seen > target || seen == m_count)
+		{
+			return j == 0 ? 0 : (j == 64 ? UINT64_MAX : (1ULL << j) - 1);
+		}
+	}
+
+	return UINT64_MAX;
+}
+
+}
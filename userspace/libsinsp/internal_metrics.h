@@ -16,18 +16,29 @@ limitations under the License.
 */
 
 #pragma once
-#ifdef GATHER_INTERNAL_STATS
+#include <stdint.h>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
+#ifdef GATHER_INTERNAL_STATS
 #define INTERNAL_COUNTER(X) internal_metrics::counter *X
+#else
+#define INTERNAL_COUNTER(X)
+#endif // GATHER_INTERNAL_STATS
 
+//
+// The metric classes are always built, so that the stage timers in
+// stage_timers.h can be exported without GATHER_INTERNAL_STATS. Only the
+// INTERNAL_COUNTER() counters depend on it.
+//
 namespace internal_metrics {
 
 class metric;
 class registry;
 class counter;
+class histogram;
 
 class SINSP_PUBLIC metric_name
 {
@@ -62,6 +73,7 @@ class SINSP_PUBLIC processor
 {
 public:
 	virtual void process(counter& metric) {};
+	virtual void process(histogram& metric) {};
 };
 
 class SINSP_PUBLIC metric
@@ -75,16 +87,11 @@ public:
 class SINSP_PUBLIC registry
 {
 public:
-	typedef std::map<metric_name,std::shared_ptr<counter>> metric_map_t;
+	typedef std::map<metric_name,std::shared_ptr<metric>> metric_map_t;
 	typedef metric_map_t::iterator metric_map_iterator_t;
 
-	counter& register_counter(const metric_name& name)
-	{
-		std::shared_ptr<counter> p;
-		p = std::make_shared<counter>();
-    	m_metrics[name] = p;
-		return *p.get();
-	}
+	counter& register_counter(const metric_name& name);
+	histogram& register_histogram(const metric_name& name);
 
 	metric_map_t& get_metrics()
 	{
@@ -129,7 +136,7 @@ public:
 		m_value = 0;
 	}
 
-	const uint64_t get_value()
+	uint64_t get_value() const
 	{
 		return m_value;
 	}
@@ -144,7 +151,53 @@ private:
 	uint64_t m_value;
 };
 
+//
+// A distribution of values in power of two buckets: bucket j counts the
+// values v with 2^(j-1) <= v < 2^j, bucket 0 counts the zeros
+//
+class SINSP_PUBLIC histogram : public metric
+{
+public:
+	static const uint32_t NBUCKETS = 65;
+
+	histogram();
+
+	static uint32_t bucket(uint64_t value);
+
+	void add(uint64_t value);
+	void add(const histogram& other);
+
+	void clear();
+
+	uint64_t get_count() const
+	{
+		return m_count;
+	}
+
+	uint64_t get_sum() const
+	{
+		return m_sum;
+	}
+
+	const std::vector<uint64_t>& get_buckets() const
+	{
+		return m_buckets;
+	}
+
+	// upper bound of the bucket holding the given quantile (0 to 1)
+	uint64_t get_quantile(double q) const;
+
+	void process(processor& metric_processor)
+	{
+		metric_processor.process(*this);
+	}
+
+private:
+	friend class stage_timers;
+
+	uint64_t m_count;
+	uint64_t m_sum;
+	std::vector<uint64_t> m_buckets;
+};
+
 }
-#else
-#define INTERNAL_COUNTER(X)
-#endif // GATHER_INTERNAL_STATS
@@ -0,0 +1,218 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+//
+// json_list_splitter.cpp
+//
+
+#include "json_list_splitter.h"
+
+json_list_splitter::json_list_splitter(const std::string& items_key):
+	m_items_key(items_key)
+{
+}
+
+size_t json_list_splitter::feed(const char* data, size_t len, json_list_t& out)
+{
+	size_t count = out.size();
+	m_buf.append(data, len);
+	for(; m_pos < m_buf.size(); ++m_pos)
+	{
+		char c = m_buf[m_pos];
+		if(m_in_string)
+		{
+			if(m_escape)
+			{
+				m_escape = false;
+			}
+			else if(c == '\\')
+			{
+				m_escape = true;
+			}
+			else if(c == '"')
+			{
+				m_in_string = false;
+				if(m_key_start != npos)
+				{
+					m_key.assign(m_buf, m_key_start + 1, m_pos - m_key_start - 1);
+					m_key_start = npos;
+				}
+			}
+			continue;
+		}
+
+		switch(c)
+		{
+		case '"':
+			if(m_depth == 0) { break; }
+			m_in_string = true;
+			if(m_depth == 1 && m_expect_key)
+			{
+				m_key_start = m_pos;
+				m_member_start = m_pos;
+			}
+			break;
+
+		case ':':
+			if(m_depth == 1)
+			{
+				m_expect_key = false;
+			}
+			break;
+
+		case ',':
+			if(m_depth == 1 && m_raw_start == npos)
+			{
+				end_member(m_pos);
+				m_expect_key = true;
+			}
+			break;
+
+		case '{':
+		case '[':
+			if(m_depth == 0)
+			{
+				if(c == '[')
+				{
+					// not a list document, pass it through as a whole
+					m_raw_start = m_pos;
+				}
+				m_expect_key = (c == '{');
+			}
+			else if(m_depth == 1 && c == '[' && !m_expect_key && m_key == m_items_key)
+			{
+				m_in_items = true;
+				m_has_items = true;
+				m_member_start = npos;
+			}
+			else if(m_depth == 2 && m_in_items && m_item_start == npos)
+			{
+				m_item_start = m_pos;
+			}
+			++m_depth;
+			break;
+
+		case '}':
+		case ']':
+			if(m_depth == 0) { break; }
+			--m_depth;
+			if(m_depth == 2 && m_in_items && m_item_start != npos)
+			{
+				std::string doc;
+				doc.reserve(m_header.size() + m_items_key.size() + (m_pos + 1 - m_item_start) + 8);
+				doc.append(1, '{').append(m_header);
+				if(!m_header.empty()) { doc.append(1, ','); }
+				doc.append(1, '"').append(m_items_key).append("\":[");
+				doc.append(m_buf, m_item_start, m_pos + 1 - m_item_start).append("]}");
+				out.emplace_back(std::move(doc));
+				m_item_start = npos;
+				++m_items_emitted;
+			}
+			else if(m_depth == 1 && m_in_items)
+			{
+				m_in_items = false;
+			}
+			else if(m_depth == 0)
+			{
+				if(m_raw_start != npos)
+				{
+					out.emplace_back(m_buf, m_raw_start, m_pos + 1 - m_raw_start);
+					m_raw_start = npos;
+				}
+				else
+				{
+					end_member(m_pos);
+					end_document(out);
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+	trim();
+	return out.size() - count;
+}
+
+void json_list_splitter::end_member(size_t pos)
+{
+	if(m_member_start != npos)
+	{
+		if(!m_header.empty()) { m_header.append(1, ','); }
+		m_header.append(m_buf, m_member_start, pos - m_member_start);
+		m_member_start = npos;
+	}
+}
+
+void json_list_splitter::end_document(json_list_t& out)
+{
+	if(!m_items_emitted)
+	{
+		std::string doc;
+		doc.append(1, '{').append(m_header);
+		if(m_has_items)
+		{
+			if(!m_header.empty()) { doc.append(1, ','); }
+			doc.append(1, '"').append(m_items_key).append("\":[]");
+		}
+		doc.append(1, '}');
+		out.emplace_back(std::move(doc));
+	}
+	m_header.clear();
+	m_key.clear();
+	m_expect_key = false;
+	m_in_items = false;
+	m_has_items = false;
+	m_items_emitted = 0;
+}
+
+void json_list_splitter::trim()
+{
+	size_t keep = m_pos;
+	if(m_member_start < keep) { keep = m_member_start; }
+	if(m_item_start < keep) { keep = m_item_start; }
+	if(m_key_start < keep) { keep = m_key_start; }
+	if(m_raw_start < keep) { keep = m_raw_start; }
+	if(keep)
+	{
+		m_buf.erase(0, keep);
+		m_pos -= keep;
+		if(m_member_start != npos) { m_member_start -= keep; }
+		if(m_item_start != npos) { m_item_start -= keep; }
+		if(m_key_start != npos) { m_key_start -= keep; }
+		if(m_raw_start != npos) { m_raw_start -= keep; }
+	}
+}
+
+void json_list_splitter::reset()
+{
+	m_buf.clear();
+	m_pos = 0;
+	m_depth = 0;
+	m_in_string = false;
+	m_escape = false;
+	m_key_start = npos;
+	m_member_start = npos;
+	m_item_start = npos;
+	m_raw_start = npos;
+	m_header.clear();
+	m_key.clear();
+	m_expect_key = false;
+	m_in_items = false;
+	m_has_items = false;
+	m_items_emitted = 0;
+}
@@ -0,0 +1,96 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+//
+// json_list_splitter.h
+//
+// incremental splitter for list-style JSON documents
+//
+#pragma once
+
+#include <string>
+#include <vector>
+
+//
+// Scans a stream of bytes holding JSON documents shaped like
+//
+//   {"kind":"PodList","apiVersion":"v1","metadata":{...},"items":[{...},{...}]}
+//
+// and, as soon as an element of the top-level "items" array is
+// complete, emits a standalone document containing all the top-level
+// members seen so far plus that single item:
+//
+//   {"kind":"PodList","apiVersion":"v1","metadata":{...},"items":[{...}]}
+//
+// Only the current item (and the small top-level members) are kept in
+// memory, so huge list responses never have to be buffered, filtered
+// or parsed as a whole. Documents without an "items" array, or with an
+// empty one, are emitted unchanged (minus insignificant whitespace).
+//
+class json_list_splitter
+{
+public:
+	typedef std::vector<std::string> json_list_t;
+
+	json_list_splitter(const std::string& items_key = "items");
+
+	// consumes len bytes of data and appends every complete
+	// document to out; returns the number of documents appended
+	size_t feed(const char* data, size_t len, json_list_t& out);
+
+	// drops any partially received document
+	void reset();
+
+	// true if a document has been started but not completed
+	bool in_progress() const;
+
+	// number of bytes currently held for incomplete data
+	size_t buffered() const;
+
+private:
+	static const size_t npos = std::string::npos;
+
+	void end_member(size_t pos);
+	void end_document(json_list_t& out);
+	void trim();
+
+	const std::string m_items_key;
+	std::string m_buf;
+	size_t      m_pos = 0;
+	int         m_depth = 0;
+	bool        m_in_string = false;
+	bool        m_escape = false;
+	bool        m_expect_key = false;
+	bool        m_in_items = false;
+	bool        m_has_items = false;
+	size_t      m_items_emitted = 0;
+	size_t      m_key_start = npos;
+	size_t      m_member_start = npos;
+	size_t      m_item_start = npos;
+	size_t      m_raw_start = npos;
+	std::string m_key;
+	std::string m_header;
+};
+
+inline bool json_list_splitter::in_progress() const
+{
+	return m_depth > 0;
+}
+
+inline size_t json_list_splitter::buffered() const
+{
+	return m_buf.size();
+}
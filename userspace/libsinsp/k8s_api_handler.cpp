@@ -102,8 +102,7 @@ void k8s_api_handler::handle_json(Json::Value&& root)
 {
 	if(g_logger.get_severity() >= sinsp_logger::SEV_TRACE)
 	{
-		g_logger.log("K8S API handler [" + json_as_string(root) + "] reply:\n",
-					 sinsp_logger::SEV_TRACE);
+		SINSP_STR_TRACE("K8S API handler [" + json_as_string(root) + "] reply:\n");
 	}
 
 	handle_component(root);
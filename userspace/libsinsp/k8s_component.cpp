@@ -405,6 +405,11 @@ bool k8s_component::selectors_in_labels(const k8s_pair_list& labels) const
 	return true;
 }
 
+bool k8s_component::selects(const k8s_component& other) const
+{
+	return selectors_in_labels(other.get_labels()) && get_namespace() == other.get_namespace();
+}
+
 //
 // namespace
 //
@@ -557,12 +562,12 @@ k8s_rc_t::k8s_rc_t(const std::string& name, const std::string& uid, const std::s
 {
 }
 
-std::vector<const k8s_pod_t*> k8s_rc_t::get_selected_pods(const std::vector<k8s_pod_t>& pods) const
+std::vector<const k8s_pod_t*> k8s_rc_t::get_selected_pods(const k8s_pods& pods) const
 {
 	std::vector<const k8s_pod_t*> pod_vec;
 	for(const auto& pod : pods)
 	{
-		if(selectors_in_labels(pod.get_labels()) && get_namespace() == pod.get_namespace())
+		if(selects(pod))
 		{
 			pod_vec.push_back(&pod);
 		}
@@ -594,12 +599,12 @@ k8s_service_t::k8s_service_t(const std::string& name, const std::string& uid, co
 {
 }
 
-std::vector<const k8s_pod_t*> k8s_service_t::get_selected_pods(const std::vector<k8s_pod_t>& pods) const
+std::vector<const k8s_pod_t*> k8s_service_t::get_selected_pods(const k8s_pods& pods) const
 {
 	std::vector<const k8s_pod_t*> pod_vec;
 	for(const auto& pod : pods)
 	{
-		if (selectors_in_labels(pod.get_labels()) && get_namespace() == pod.get_namespace())
+		if(selects(pod))
 		{
 			pod_vec.push_back(&pod);
 		}
@@ -627,12 +632,12 @@ k8s_deployment_t::k8s_deployment_t(const std::string& name, const std::string& u
 {
 }
 
-std::vector<const k8s_pod_t*> k8s_deployment_t::get_selected_pods(const std::vector<k8s_pod_t>& pods) const
+std::vector<const k8s_pod_t*> k8s_deployment_t::get_selected_pods(const k8s_pods& pods) const
 {
 	std::vector<const k8s_pod_t*> pod_vec;
 	for(const auto& pod : pods)
 	{
-		if(selectors_in_labels(pod.get_labels()) && get_namespace() == pod.get_namespace())
+		if(selects(pod))
 		{
 			pod_vec.push_back(&pod);
 		}
@@ -30,6 +30,8 @@ limitations under the License.
 #include "user_event.h"
 #include "user_event_logger.h"
 #include <vector>
+#include <list>
+#include <unordered_map>
 #include <unordered_set>
 
 typedef std::pair<std::string, std::string> k8s_pair_t;
@@ -38,6 +40,109 @@ typedef std::vector<k8s_pair_t>             k8s_pair_list;
 class k8s_pod_t;
 class k8s_service_t;
 
+//
+// component store
+//
+// Keeps components in insertion order and indexes them by uid;
+// lookups, insertions and removals are O(1) and references to
+// stored components remain valid until that very component is
+// removed, so they can be safely cached in lookup maps.
+// If a uid is inserted more than once, the index points to the
+// most recently inserted component.
+//
+
+template <typename T>
+class k8s_component_store
+{
+public:
+	typedef T                                  value_type;
+	typedef std::list<T>                       list_t;
+	typedef typename list_t::iterator          iterator;
+	typedef typename list_t::const_iterator    const_iterator;
+	typedef typename list_t::size_type         size_type;
+
+	iterator begin() { return m_items.begin(); }
+	iterator end() { return m_items.end(); }
+	const_iterator begin() const { return m_items.begin(); }
+	const_iterator end() const { return m_items.end(); }
+
+	size_type size() const { return m_items.size(); }
+	bool empty() const { return m_items.empty(); }
+
+	T& back() { return m_items.back(); }
+	const T& back() const { return m_items.back(); }
+
+	void push_back(const T& component)
+	{
+		m_items.push_back(component);
+		index_last();
+	}
+
+	void emplace_back(T&& component)
+	{
+		m_items.emplace_back(std::move(component));
+		index_last();
+	}
+
+	T* find(const std::string& uid)
+	{
+		typename index_t::iterator it = m_index.find(uid);
+		return (it != m_index.end()) ? &*it->second : nullptr;
+	}
+
+	const T* find(const std::string& uid) const
+	{
+		typename index_t::const_iterator it = m_index.find(uid);
+		return (it != m_index.end()) ? &*it->second : nullptr;
+	}
+
+	bool has(const std::string& uid) const
+	{
+		return m_index.find(uid) != m_index.end();
+	}
+
+	iterator erase(iterator it)
+	{
+		typename index_t::iterator idx = m_index.find(it->get_uid());
+		if(idx != m_index.end() && idx->second == it)
+		{
+			m_index.erase(idx);
+		}
+		return m_items.erase(it);
+	}
+
+	bool erase(const std::string& uid)
+	{
+		typename index_t::iterator idx = m_index.find(uid);
+		if(idx != m_index.end())
+		{
+			m_items.erase(idx->second);
+			m_index.erase(idx);
+			return true;
+		}
+		return false;
+	}
+
+	void clear()
+	{
+		m_index.clear();
+		m_items.clear();
+	}
+
+private:
+	typedef std::unordered_map<std::string, iterator> index_t;
+
+	void index_last()
+	{
+		iterator last = m_items.end();
+		--last;
+		m_index[last->get_uid()] = last;
+	}
+
+	list_t  m_items;
+	index_t m_index;
+};
+
 class k8s_container
 {
 public:
@@ -252,6 +357,9 @@ public:
 
 	bool selectors_in_labels(const k8s_pair_list& labels) const;
 
+	// true if this component's selectors match the other (pod) component
+	bool selects(const k8s_component& other) const;
+
 private:
 
 	type          m_type;
@@ -402,7 +510,7 @@ public:
 			 const std::string& ns = "",
 			 k8s_component::type type = K8S_REPLICATIONCONTROLLERS);
 
-	std::vector<const k8s_pod_t*> get_selected_pods(const std::vector<k8s_pod_t>& pods) const;
+	std::vector<const k8s_pod_t*> get_selected_pods(const k8s_component_store<k8s_pod_t>& pods) const;
 
 	void set_spec_replicas(int replicas);
 	int get_spec_replicas() const;
@@ -460,7 +568,7 @@ public:
 
 	void set_port_list(port_list&& ports);
 
-	std::vector<const k8s_pod_t*> get_selected_pods(const std::vector<k8s_pod_t>& pods) const;
+	std::vector<const k8s_pod_t*> get_selected_pods(const k8s_component_store<k8s_pod_t>& pods) const;
 
 private:
 	std::string m_cluster_ip;
@@ -509,7 +617,7 @@ public:
 	void set_replicas(const Json::Value& item);
 	void set_replicas(int desired, int current);
 
-	std::vector<const k8s_pod_t*> get_selected_pods(const std::vector<k8s_pod_t>& pods) const;
+	std::vector<const k8s_pod_t*> get_selected_pods(const k8s_component_store<k8s_pod_t>& pods) const;
 	
 private:
 	k8s_replicas_t m_replicas;
@@ -547,15 +655,15 @@ private:
 	bool m_force_delete = false;
 };
 
-typedef std::vector<k8s_ns_t>         k8s_namespaces;
-typedef std::vector<k8s_node_t>       k8s_nodes;
-typedef std::vector<k8s_pod_t>        k8s_pods;
-typedef std::vector<k8s_rc_t>         k8s_controllers;
-typedef std::vector<k8s_rs_t>         k8s_replicasets;
-typedef std::vector<k8s_service_t>    k8s_services;
-typedef std::vector<k8s_daemonset_t>  k8s_daemonsets;
-typedef std::vector<k8s_deployment_t> k8s_deployments;
-typedef std::vector<k8s_event_t>      k8s_events;
+typedef k8s_component_store<k8s_ns_t>         k8s_namespaces;
+typedef k8s_component_store<k8s_node_t>       k8s_nodes;
+typedef k8s_component_store<k8s_pod_t>        k8s_pods;
+typedef k8s_component_store<k8s_rc_t>         k8s_controllers;
+typedef k8s_component_store<k8s_rs_t>         k8s_replicasets;
+typedef k8s_component_store<k8s_service_t>    k8s_services;
+typedef k8s_component_store<k8s_daemonset_t>  k8s_daemonsets;
+typedef k8s_component_store<k8s_deployment_t> k8s_deployments;
+typedef k8s_component_store<k8s_event_t>      k8s_events;
 
 //
 // container
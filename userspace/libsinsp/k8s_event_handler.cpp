@@ -30,6 +30,7 @@ std::string k8s_event_handler::EVENT_FILTER =
 	"{"
 	" type: .type,"
 	" apiVersion: .object.apiVersion,"
+	" resourceVersion: .object.metadata.resourceVersion,"
 	" kind: .object.kind,"
 	" items:"
 	" ["
@@ -52,6 +53,8 @@ std::string k8s_event_handler::STATE_FILTER =
 	"{"
 	" type: \"ADDED\","
 	" apiVersion: .apiVersion,"
+	" resourceVersion: .metadata.resourceVersion,"
+	" continueToken: .metadata.continue,"
 	" kind: \"Event\","
 	" items:"
 	" ["
@@ -109,7 +112,7 @@ bool k8s_event_handler::handle_component(const Json::Value& json, const msg_data
 				if((data->m_reason == k8s_component::COMPONENT_ADDED) ||
 				   (data->m_reason == k8s_component::COMPONENT_MODIFIED))
 				{
-					g_logger.log("K8s EVENT: handling event.", sinsp_logger::SEV_TRACE);
+					SINSP_STR_TRACE("K8s EVENT: handling event.");
 					const Json::Value& involved_object = json["involvedObject"];
 					if(!involved_object.isNull())
 					{
@@ -138,16 +141,14 @@ bool k8s_event_handler::handle_component(const Json::Value& json, const msg_data
 							g_logger.log("K8s EVENT: both eventTime and lastTimestamp are null, using current timestamp. Event Json : " + Json::FastWriter().write(json) , sinsp_logger::SEV_INFO);
 							last_ts = now_ts;
 						}
-						g_logger.log("K8s EVENT: lastTimestamp=" + std::to_string(last_ts) + ", now_ts=" + std::to_string(now_ts),
-							     sinsp_logger::SEV_TRACE);
+						SINSP_STR_TRACE("K8s EVENT: lastTimestamp=" + std::to_string(last_ts) + ", now_ts=" + std::to_string(now_ts));
 						if(((last_ts > 0) && (now_ts > 0)) && // we got good timestamps
 						   !is_aggregate && // not an aggregated cached event
 						   ((now_ts - last_ts) < 10)) // event not older than 10 seconds
 						{
 							const Json::Value& kind = involved_object["kind"];
 							const Json::Value& event_reason = json["reason"];
-							g_logger.log("K8s EVENT: involved object and event reason found:" + kind.asString() + '/' + event_reason.asString(),
-										 sinsp_logger::SEV_TRACE);
+							SINSP_STR_TRACE("K8s EVENT: involved object and event reason found:" + kind.asString() + '/' + event_reason.asString());
 							if(!kind.isNull() && kind.isConvertibleTo(Json::stringValue) &&
 								!event_reason.isNull() && event_reason.isConvertibleTo(Json::stringValue))
 							{
@@ -173,8 +174,8 @@ bool k8s_event_handler::handle_component(const Json::Value& json, const msg_data
 										m_event_limit_exceeded = false;
 										if(g_logger.get_severity() >= sinsp_logger::SEV_DEBUG)
 										{
-											g_logger.log("K8s EVENT: added event [" + data->m_name + "]. "
-														 "Queued events count=" + std::to_string(evts.size()), sinsp_logger::SEV_DEBUG);
+											SINSP_STR_DEBUG("K8s EVENT: added event [" + data->m_name + "]. "
+														 "Queued events count=" + std::to_string(evts.size()));
 										}
 									}
 									else if(!m_event_limit_exceeded) // only get in here once per cycle, to send event overflow warning
@@ -192,9 +193,8 @@ bool k8s_event_handler::handle_component(const Json::Value& json, const msg_data
 								{
 									if(g_logger.get_severity() >= sinsp_logger::SEV_TRACE)
 									{
-										g_logger.log("K8s EVENT: filter does not allow {\"" + type + "\", \"{" + event_reason.asString() + "\"} }",
-												 sinsp_logger::SEV_TRACE);
-										g_logger.log(m_event_filter->to_string(), sinsp_logger::SEV_TRACE);
+										SINSP_STR_TRACE("K8s EVENT: filter does not allow {\"" + type + "\", \"{" + event_reason.asString() + "\"} }");
+										SINSP_STR_TRACE(m_event_filter->to_string());
 									}
 									m_event_ignored = true;
 									return false;
@@ -205,16 +205,15 @@ bool k8s_event_handler::handle_component(const Json::Value& json, const msg_data
 								g_logger.log("K8s EVENT: event type or involvedObject kind not found.", sinsp_logger::SEV_ERROR);
 								if(g_logger.get_severity() >= sinsp_logger::SEV_TRACE)
 								{
-									g_logger.log(Json::FastWriter().write(json), sinsp_logger::SEV_TRACE);
+									SINSP_STR_TRACE(Json::FastWriter().write(json));
 								}
 								return false;
 							}
 						}
 						else // old event, ignore
 						{
-							g_logger.log("K8s EVENT: old event, ignoring: "
-										 ", lastTimestamp=" + std::to_string(last_ts) + ", now_ts=" + std::to_string(now_ts),
-										sinsp_logger::SEV_DEBUG);
+							SINSP_STR_DEBUG("K8s EVENT: old event, ignoring: "
+										 ", lastTimestamp=" + std::to_string(last_ts) + ", now_ts=" + std::to_string(now_ts));
 							m_event_ignored = true;
 							return false;
 						}
@@ -222,7 +221,7 @@ bool k8s_event_handler::handle_component(const Json::Value& json, const msg_data
 					else
 					{
 						g_logger.log("K8s EVENT: involvedObject not found.", sinsp_logger::SEV_ERROR);
-						g_logger.log(Json::FastWriter().write(json), sinsp_logger::SEV_TRACE);
+						SINSP_STR_TRACE(Json::FastWriter().write(json));
 						return false;
 					}
 				}
@@ -235,7 +234,7 @@ bool k8s_event_handler::handle_component(const Json::Value& json, const msg_data
 			else
 			{
 				g_logger.log("K8s EVENT: msg data is null.", sinsp_logger::SEV_ERROR);
-				g_logger.log(Json::FastWriter().write(json), sinsp_logger::SEV_TRACE);
+				SINSP_STR_TRACE(Json::FastWriter().write(json));
 				return false;
 			}
 		}
@@ -247,7 +246,7 @@ bool k8s_event_handler::handle_component(const Json::Value& json, const msg_data
 	}
 	else
 	{
-		g_logger.log("K8s EVENT: no filter, K8s events disabled.", sinsp_logger::SEV_TRACE);
+		SINSP_STR_TRACE("K8s EVENT: no filter, K8s events disabled.");
 		return false;
 	}
 	return true;
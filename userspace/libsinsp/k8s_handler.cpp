@@ -88,17 +88,17 @@ k8s_handler::k8s_handler(const std::string& id,
 		m_is_captured(is_captured)
 {
 #if defined(HAS_CAPTURE) && !defined(_WIN32)
-	g_logger.log("Creating K8s " + name() + " (" + m_id + ") "
-				 "handler object for [" + uri(m_url).to_string(false) + m_path + ']',
-				 sinsp_logger::SEV_DEBUG);
+	SINSP_STR_DEBUG("Creating K8s " + name() + " (" + m_id + ") "
+				 "handler object for [" + uri(m_url).to_string(false) + m_path + ']');
 	if(m_connect)
 	{
-		g_logger.log(std::string("K8s (" + m_id + ") creating handler for " +
-							 uri(m_url).to_string(false) + m_path), sinsp_logger::SEV_DEBUG);
-		m_handler = std::make_shared<handler_t>(*this, m_id, m_url, m_path, m_http_version,
+		SINSP_STR_DEBUG(std::string("K8s (" + m_id + ") creating handler for " +
+							 uri(m_url).to_string(false) + m_path));
+		m_handler = std::make_shared<handler_t>(*this, m_id, m_url, request_path(false), m_http_version,
 											 m_timeout_ms, m_ssl, m_bt, !m_blocking_socket, m_blocking_socket,
 											 SOCKET_HANDLER_DATA_LIMIT, true, data_max_b, data_chunk_wait_us);
 		m_handler->set_json_callback(&k8s_handler::set_event_json);
+		m_handler->stream_list_items();
 
 		// filter order is important; there are four kinds of filters:
 		// 1.a state filter (filters init state JSONs)
@@ -132,11 +132,20 @@ void k8s_handler::make_http()
 #if defined(HAS_CAPTURE) && !defined(_WIN32)
 	if(m_connect && m_collector)
 	{
+		if(!m_continue.empty())
+		{
+			// state list was interrupted before the last page, the watch
+			// has to replay the whole collection
+			g_logger.log("K8s (" + m_id + ") state list incomplete, watch will start from current state.",
+						 sinsp_logger::SEV_WARNING);
+			m_continue.clear();
+			m_resource_version.clear();
+		}
 		if(!m_handler)
 		{
 			g_logger.log("K8s (" + m_id + ") creating handler for " +
 						 uri(m_url).to_string(false) + m_path, sinsp_logger::SEV_INFO);
-			m_handler = std::make_shared<handler_t>(*this, m_id, m_url, m_path, m_http_version,
+			m_handler = std::make_shared<handler_t>(*this, m_id, m_url, request_path(true), m_http_version,
 												 m_timeout_ms, m_ssl, m_bt, true, m_blocking_socket);
 			m_handler->set_json_callback(&k8s_handler::set_event_json);
 		}
@@ -163,7 +172,7 @@ void k8s_handler::make_http()
 		m_handler->add_json_filter(*m_filter, ERROR_FILTER);
 		// end filter adjustment
 
-		m_handler->set_path(m_path);
+		m_handler->set_path(request_path(true));
 		m_handler->set_id(m_id);
 		m_collector->set_steady_state(true);
 		m_watching = true;
@@ -178,20 +187,92 @@ void k8s_handler::make_http()
 #endif // HAS_CAPTURE
 }
 
+#if defined(HAS_CAPTURE) && !defined(_WIN32)
+
+std::string k8s_handler::request_path(bool watch) const
+{
+	std::string path = m_path;
+	if(watch)
+	{
+		if(!m_resource_version.empty())
+		{
+			set_query_param(path, "resourceVersion", m_resource_version);
+			set_query_param(path, "allowWatchBookmarks", "true");
+		}
+	}
+	else if(m_watch)
+	{
+		set_query_param(path, "limit", std::to_string(LIST_PAGE_LIMIT));
+		if(!m_continue.empty())
+		{
+			set_query_param(path, "continue", m_continue);
+		}
+	}
+	return path;
+}
+
+void k8s_handler::set_query_param(std::string& path, const std::string& name, const std::string& value)
+{
+	std::string::size_type pos = path.find('?');
+	if(pos == std::string::npos)
+	{
+		path.append(1, '?').append(name).append(1, '=').append(value);
+		return;
+	}
+	std::string param = name + '=';
+	while(pos != std::string::npos)
+	{
+		if(path.compare(pos + 1, param.size(), param) == 0)
+		{
+			std::string::size_type end = path.find('&', pos + 1);
+			pos += param.size() + 1;
+			path.replace(pos, (end == std::string::npos) ? std::string::npos : end - pos, value);
+			return;
+		}
+		pos = path.find('&', pos + 1);
+	}
+	path.append(1, '&').append(name).append(1, '=').append(value);
+}
+
+void k8s_handler::track_versions(const Json::Value& json)
+{
+	const Json::Value& type = json["type"];
+	if(type.isString() && type.asString() == "ERROR")
+	{
+		// version expired (410 Gone) or list failed; whatever comes next
+		// must be treated as the full current state
+		m_resource_version.clear();
+		m_continue.clear();
+		return;
+	}
+	const Json::Value& version = json["resourceVersion"];
+	if(version.isString() && !version.asString().empty())
+	{
+		m_resource_version = version.asString();
+	}
+	if(!m_watching)
+	{
+		const Json::Value& token = json["continueToken"];
+		m_continue = token.isString() ? token.asString() : "";
+	}
+}
+
+#endif // HAS_CAPTURE
+
 void k8s_handler::check_enabled()
 {
 #if defined(HAS_CAPTURE) && !defined(_WIN32)
 	if(!m_handler->is_enabled())
 	{
-		g_logger.log("k8s_handler (" + m_id +
-					") check_enabled() enabling socket in collector", sinsp_logger::SEV_TRACE);
+		SINSP_STR_TRACE("k8s_handler (" + m_id +
+					") check_enabled() enabling socket in collector");
 		m_handler->enable();
 	}
 	else
 	{
-		g_logger.log("k8s_handler (" + m_id +
+		SINSP_STR_TRACE("k8s_handler (" + m_id +
 					") check_enabled() socket in collector is enabled, "
-					"checking collector status.", sinsp_logger::SEV_TRACE);
+					"checking collector status.");
 		check_collector_status();
 	}
 #endif // HAS_CAPTURE
@@ -204,21 +285,21 @@ bool k8s_handler::connect()
 	{
 		if(!m_collector->has(m_handler))
 		{
-			g_logger.log(std::string("k8s_handler (" + m_id +
-									 ") k8s_handler::connect() adding handler to collector"), sinsp_logger::SEV_TRACE);
+			SINSP_STR_TRACE(std::string("k8s_handler (" + m_id +
+									 ") k8s_handler::connect() adding handler to collector"));
 			m_collector->add(m_handler);
 			return false;
 		}
 		if(m_handler->is_connecting())
 		{
-			g_logger.log(std::string("k8s_handler (" + m_id +
-									 "), k8s_handler::connect() connecting to " + m_handler->get_url().to_string(false)), sinsp_logger::SEV_TRACE);
+			SINSP_STR_TRACE(std::string("k8s_handler (" + m_id +
+									 "), k8s_handler::connect() connecting to " + m_handler->get_url().to_string(false)));
 			return false;
 		}
 		if(m_handler->is_connected())
 		{
-			g_logger.log("k8s_handler (" + m_id +
-						") k8s_handler::connect() socket is connected.", sinsp_logger::SEV_TRACE);
+			SINSP_STR_TRACE("k8s_handler (" + m_id +
+						") k8s_handler::connect() socket is connected.");
 			check_enabled();
 			return true;
 		}
@@ -243,17 +324,15 @@ void k8s_handler::send_data_request()
 		{
 			if(m_handler->is_connected())
 			{
-				g_logger.log("k8s_handler (" + m_id + ") sending request to " +
-							 m_handler->get_url().to_string(false) + m_path,
-							 sinsp_logger::SEV_DEBUG);
+				SINSP_STR_DEBUG("k8s_handler (" + m_id + ") sending request to " +
+							 m_handler->get_url().to_string(false) + m_path);
 				m_handler->send_request();
 				m_req_sent = true;
 			}
 			else if(m_handler->is_connecting())
 			{
-				g_logger.log("k8s_handler (" + m_id + ") is connecting to " +
-							 m_handler->get_url().to_string(false),
-							 sinsp_logger::SEV_DEBUG);
+				SINSP_STR_DEBUG("k8s_handler (" + m_id + ") is connecting to " +
+							 m_handler->get_url().to_string(false));
 			}
 		}
 	}
@@ -335,11 +414,23 @@ void k8s_handler::check_state()
 #if defined(HAS_CAPTURE) && !defined(_WIN32)
 	if(m_collector && m_handler)
 	{
-		if(m_resp_recvd && m_watch && !m_watching)
+		// request the next page of the state list on the same connection
+		if(m_resp_recvd && !m_watching && !m_continue.empty() &&
+		   !m_handler->is_streaming_list() && m_handler->wants_send())
 		{
-			g_logger.log("k8s_handler (" + m_id + ") switching to watch connection for " +
-						 uri(m_url).to_string(false) + m_path,
-						 sinsp_logger::SEV_DEBUG);
+			std::string path = request_path(false);
+			SINSP_STR_DEBUG("k8s_handler (" + m_id + ") requesting next state page from " +
+						 uri(m_url).to_string(false) + path);
+			m_handler->set_path(path);
+			m_handler->set_fetching_state();
+			m_req_sent = false;
+			m_resp_recvd = false;
+		}
+		// a streamed state response is complete only when the whole list was received
+		if(m_resp_recvd && m_watch && !m_watching && m_continue.empty() && !m_handler->is_streaming_list())
+		{
+			SINSP_STR_DEBUG("k8s_handler (" + m_id + ") switching to watch connection for " +
+						 uri(m_url).to_string(false) + m_path);
 			std::string::size_type pos = m_id.find("_state");
 			if(pos != std::string::npos)
 			{
@@ -363,6 +454,8 @@ void k8s_handler::check_state()
 		}
 		if(m_watching && m_id.find("_state") == std::string::npos && m_handler->wants_send())
 		{
+			// resume from the latest version seen on the previous watch
+			m_handler->set_path(request_path(true));
 			m_req_sent = false;
 			m_resp_recvd = false;
 		}
@@ -388,25 +481,24 @@ void k8s_handler::collect_data()
 	{
 		process_events(); // there may be leftovers from state connection closed by collector
 		check_state(); // switch to events, if needed
-		g_logger.log("k8s_handler (" + m_id + ")::collect_data(), checking connection to " + uri(m_url).to_string(false), sinsp_logger::SEV_DEBUG);
+		SINSP_STR_DEBUG("k8s_handler (" + m_id + ")::collect_data(), checking connection to " + uri(m_url).to_string(false));
 		if(m_handler->is_connecting())
 		{
-			g_logger.log("k8s_handler (" + m_id + ")::collect_data(), connecting to " + uri(m_url).to_string(false), sinsp_logger::SEV_DEBUG);
+			SINSP_STR_DEBUG("k8s_handler (" + m_id + ")::collect_data(), connecting to " + uri(m_url).to_string(false));
 			return;
 		}
 		else if(m_handler->is_connected())
 		{
 			if(!m_connect_logged)
 			{
-				g_logger.log("k8s_handler (" + m_id + ")::collect_data(), connected to " + uri(m_url).to_string(false) + m_path,  sinsp_logger::SEV_DEBUG);
+				SINSP_STR_DEBUG("k8s_handler (" + m_id + ")::collect_data(), connected to " + uri(m_url).to_string(false) + m_path);
 				m_connect_logged = true;
 			}
 			check_enabled();
 			if(!m_req_sent)
 			{
-				g_logger.log("k8s_handler (" + m_id + ")::collect_data() [" + uri(m_url).to_string(false) + "], requesting data "
-							 "from " + m_path + "... m_blocking_socket=" + std::to_string(m_blocking_socket) + ", m_watching=" + std::to_string(m_watching),
-							 sinsp_logger::SEV_DEBUG);
+				SINSP_STR_DEBUG("k8s_handler (" + m_id + ")::collect_data() [" + uri(m_url).to_string(false) + "], requesting data "
+							 "from " + m_path + "... m_blocking_socket=" + std::to_string(m_blocking_socket) + ", m_watching=" + std::to_string(m_watching));
 				send_data_request();
 				if(m_blocking_socket && !m_watching)
 				{
@@ -417,28 +509,26 @@ void k8s_handler::collect_data()
 			}
 			if(m_collector->subscription_count())
 			{
-				g_logger.log("k8s_handler (" + m_id + ")::collect_data() [" + uri(m_url).to_string(false) + "], getting data "
-							 "from " + m_path + "...",  sinsp_logger::SEV_DEBUG);
+				SINSP_STR_DEBUG("k8s_handler (" + m_id + ")::collect_data() [" + uri(m_url).to_string(false) + "], getting data "
+							 "from " + m_path + "...");
 				m_collector->get_data();
-				g_logger.log("k8s_handler (" + m_id + ")::collect_data(), " + std::to_string(m_events.size()) +
-							 " events from " + uri(m_url).to_string(false) + m_path, sinsp_logger::SEV_DEBUG);
+				SINSP_STR_DEBUG("k8s_handler (" + m_id + ")::collect_data(), " + std::to_string(m_events.size()) +
+							 " events from " + uri(m_url).to_string(false) + m_path);
 				if(m_events.size())
 				{
-					g_logger.log("k8s_handler (" + m_id + ")::collect_data(), data from " + uri(m_url).to_string(false) + m_path +
-								 ", event count=" + std::to_string(m_events.size()), sinsp_logger::SEV_DEBUG);
+					SINSP_STR_DEBUG("k8s_handler (" + m_id + ")::collect_data(), data from " + uri(m_url).to_string(false) + m_path +
+								 ", event count=" + std::to_string(m_events.size()));
 					process_events();
 					check_state();
 				}
 				else
 				{
-					g_logger.log("k8s_handler (" + m_id + ") collect_data(), no data from " + uri(m_url).to_string(false) + m_path,
-							 sinsp_logger::SEV_DEBUG);
+					SINSP_STR_DEBUG("k8s_handler (" + m_id + ") collect_data(), no data from " + uri(m_url).to_string(false) + m_path);
 				}
 			}
 			else
 			{
-				g_logger.log("k8s_handler (" + m_id + ") collect_data(), no subscriptions to " + uri(m_url).to_string(false) + m_path,
-						 sinsp_logger::SEV_DEBUG);
+				SINSP_STR_DEBUG("k8s_handler (" + m_id + ") collect_data(), no subscriptions to " + uri(m_url).to_string(false) + m_path);
 			}
 			return;
 		}
@@ -555,7 +645,7 @@ void k8s_handler::handle_json(Json::Value&& root)
 									  " [" << uri(m_url).to_string(false) << "]"
 #endif // HAS_CAPTURE
 									  "for existing " << data.m_kind << " [" << data.m_uid << "], updating only.";
-								g_logger.log(os.str(), sinsp_logger::SEV_DEBUG);
+								SINSP_STR_DEBUG(os.str());
 							}
 						}
 						else if(data.m_reason == k8s_component::COMPONENT_MODIFIED)
@@ -595,8 +685,8 @@ void k8s_handler::handle_json(Json::Value&& root)
 						{
 							if(data.m_reason == k8s_component::COMPONENT_NONEXISTENT)
 							{
-								g_logger.log(std::string("Non-existent K8S component (" + name() + "), reason: ") +
-											 std::to_string(data.m_reason), sinsp_logger::SEV_DEBUG);
+								SINSP_STR_DEBUG(std::string("Non-existent K8S component (" + name() + "), reason: ") +
+											 std::to_string(data.m_reason));
 							}
 							else
 							{
@@ -615,7 +705,7 @@ void k8s_handler::handle_json(Json::Value&& root)
 							os << "K8s [" + reason_type + ", " << data.m_kind <<
 								", " << data.m_name << ", " << data.m_uid << "]";
 							g_logger.log(os.str(), sinsp_logger::SEV_INFO);
-							m_state->update_cache(k8s_component::get_type(name()));
+							m_state->update_cache(k8s_component::get_type(name()), data.m_uid);
 						}
 						else
 						{
@@ -676,10 +766,9 @@ k8s_handler::ip_addr_list_t k8s_handler::hostname_to_ip(const std::string& hostn
 bool k8s_handler::dependency_ready() const
 {
 #if defined(HAS_CAPTURE) && !defined(_WIN32)
-	g_logger.log("k8s_handler (" + m_id + ") dependency "
+	SINSP_STR_TRACE("k8s_handler (" + m_id + ") dependency "
 				 "(" + m_dependency_handler->get_id() + ") ready: " +
-				 std::to_string(m_dependency_handler->is_state_built()),
-				 sinsp_logger::SEV_TRACE);
+				 std::to_string(m_dependency_handler->is_state_built()));
 	return m_dependency_handler->is_state_built();
 #else
 	return true;
@@ -699,8 +788,7 @@ void k8s_handler::process_events()
 			{
 				if(g_logger.get_severity() >= sinsp_logger::SEV_TRACE)
 				{
-					g_logger.log("k8s_handler (" + m_id + ") processing event data:\n" + json_as_string(*(*evt)),
-								 sinsp_logger::SEV_TRACE);
+					SINSP_STR_TRACE("k8s_handler (" + m_id + ") processing event data:\n" + json_as_string(*(*evt)));
 				}
 #if defined(HAS_CAPTURE) && !defined(_WIN32)
 				if(m_is_captured)
@@ -721,25 +809,45 @@ void k8s_handler::process_events()
 			}
 			evt = m_events.erase(evt);
 		}
-		if(!m_state_built && m_state_processing_started && !m_events.size()) { m_state_built = true; }
+		bool streaming = false;
+#if defined(HAS_CAPTURE) && !defined(_WIN32)
+		// state items are posted as they arrive, so the state is not
+		// built until the whole list (ie. all of its pages) has been received
+		streaming = (m_handler && m_handler->is_streaming_list()) || !m_continue.empty();
+#endif // HAS_CAPTURE
+		if(!m_state_built && m_state_processing_started && !m_events.size() && !streaming) { m_state_built = true; }
 	}
 }
 
 void k8s_handler::set_event_json(json_ptr_t json, const std::string&)
 {
-	g_logger.log("k8s_handler adding event, (" + m_id + ") has " + std::to_string(m_events.size())
+	if(g_logger.is_enabled(sinsp_logger::SEV_TRACE))
+	{
+		std::string msg = "k8s_handler adding event, (" + m_id + ") has " + std::to_string(m_events.size());
+#if defined(HAS_CAPTURE) && !defined(_WIN32)
+		msg += " events from " + uri(m_url).to_string(false);
+#endif // HAS_CAPTURE
+		g_logger.log(msg, sinsp_logger::SEV_TRACE);
+	}
 #if defined(HAS_CAPTURE) && !defined(_WIN32)
-				+ " events from " + uri(m_url).to_string(false)
+	if(json && json->isObject())
+	{
+		track_versions(*json);
+		// bookmarks carry nothing but the latest resourceVersion
+		if((*json)["type"].asString() == "BOOKMARK") { return; }
+	}
 #endif // HAS_CAPTURE
-				, sinsp_logger::SEV_TRACE);
 	// empty JSON is fine here; if there are no entities, state and first watch will pass nothing in here
 	// null is checked when processing
 	m_events.emplace_back(json);
-	g_logger.log("k8s_handler added event, (" + m_id + ") has " + std::to_string(m_events.size())
+	if(g_logger.is_enabled(sinsp_logger::SEV_TRACE))
+	{
+		std::string msg = "k8s_handler added event, (" + m_id + ") has " + std::to_string(m_events.size());
 #if defined(HAS_CAPTURE) && !defined(_WIN32)
-				+ " events from " + uri(m_url).to_string(false)
+		msg += " events from " + uri(m_url).to_string(false);
 #endif // HAS_CAPTURE
-				, sinsp_logger::SEV_TRACE);
+		g_logger.log(msg, sinsp_logger::SEV_TRACE);
+	}
 #if defined(HAS_CAPTURE) && !defined(_WIN32)
 	if(!m_resp_recvd) { m_resp_recvd = true; }
 #endif // HAS_CAPTURE
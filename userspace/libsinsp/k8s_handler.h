@@ -142,6 +142,11 @@ private:
 
 	bool connect();
 	void make_http();
+#if defined(HAS_CAPTURE) && !defined(_WIN32)
+	std::string request_path(bool watch) const;
+	static void set_query_param(std::string& path, const std::string& name, const std::string& value);
+	void track_versions(const Json::Value& json);
+#endif // HAS_CAPTURE
 	void send_data_request();
 	void receive_response();
 	void check_enabled();
@@ -188,6 +193,16 @@ private:
 
 	bool m_blocking_socket = false;
 
+	// initial state is listed in pages of (at most) this many items; the list
+	// continuation token is held in m_continue until the last page is received
+	static const unsigned LIST_PAGE_LIMIT = 500;
+	std::string m_continue;
+
+	// latest resourceVersion seen, either from the list or from watch events;
+	// (re)established watches resume from it instead of replaying the whole
+	// collection, an empty version means full replay is needed
+	std::string m_resource_version;
+
 #endif // HAS_CAPTURE
 
 	// limits the number of messages handled in single cycle
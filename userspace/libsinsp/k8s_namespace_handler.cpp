@@ -30,6 +30,7 @@ std::string k8s_namespace_handler::EVENT_FILTER =
 	"{"
 	" type: .type,"
 	" apiVersion: .object.apiVersion,"
+	" resourceVersion: .object.metadata.resourceVersion,"
 	" kind: .object.kind,"
 	" items:"
 	" [ .object |"
@@ -46,6 +47,8 @@ std::string k8s_namespace_handler::STATE_FILTER =
 	"{"
 	" type: \"ADDED\","
 	" apiVersion: .apiVersion,"
+	" resourceVersion: .metadata.resourceVersion,"
+	" continueToken: .metadata.continue,"
 	" kind: \"Namespace\","
 	" items:"
 	" ["
@@ -30,6 +30,7 @@ std::string k8s_node_handler::EVENT_FILTER =
 	"{"
 	" type: .type,"
 	" apiVersion: .object.apiVersion,"
+	" resourceVersion: .object.metadata.resourceVersion,"
 	" kind: .object.kind,"
 	" items:"
 	" ["
@@ -48,6 +49,8 @@ std::string k8s_node_handler::STATE_FILTER =
 	"{"
 	" type: \"ADDED\","
 	" apiVersion: .apiVersion,"
+	" resourceVersion: .metadata.resourceVersion,"
+	" continueToken: .metadata.continue,"
 	" kind: \"Node\", "
 	" items:"
 	" ["
@@ -30,6 +30,7 @@ std::string k8s_service_handler::EVENT_FILTER =
 	"{"
 	" type: .type,"
 	" apiVersion: .object.apiVersion,"
+	" resourceVersion: .object.metadata.resourceVersion,"
 	" kind: .object.kind,"
 	" items:"
 	" ["
@@ -51,6 +52,8 @@ std::string k8s_service_handler::STATE_FILTER =
 	"{"
 	" type: \"ADDED\","
 	" apiVersion: .apiVersion,"
+	" resourceVersion: .metadata.resourceVersion,"
+	" continueToken: .metadata.continue,"
 	" kind: \"Service\", "
 	" items:"
 	" ["
@@ -72,6 +75,8 @@ std::string k8s_service_handler::NULL_FILTER =
 	"{"
 	" type: \"NONEXISTENT\","
 	" apiVersion: .apiVersion,"
+	" resourceVersion: .metadata.resourceVersion,"
+	" continueToken: .metadata.continue,"
 	" kind: \"Service\", "
 	" items: [ null ]"
 	"}";
@@ -58,42 +58,39 @@ void k8s_state_t::cache_pod(container_pod_map& map, const std::string& id, const
 {
 	ASSERT(pod);
 	ASSERT(!pod->get_name().empty());
-	std::string::size_type pos = id.find(m_docker_prefix);
-	if(pos == 0)
+	std::string key;
+	if(id.find(m_docker_prefix) == 0)
 	{
-		map[id.substr(m_docker_prefix.size(), m_id_length)] = pod;
-		return;
+		key = id.substr(m_docker_prefix.size(), m_id_length);
 	}
-	pos = id.find(m_rkt_prefix);
-	if(pos == 0)
+	else if(id.find(m_rkt_prefix) == 0)
 	{
-		map[id.substr(m_rkt_prefix.size())] = pod;
-		return;
+		key = id.substr(m_rkt_prefix.size());
 	}
-	pos = id.find(m_containerd_prefix);
-	if(pos == 0)
+	else if(id.find(m_containerd_prefix) == 0)
 	{
-		map[id.substr(m_containerd_prefix.size(), m_id_length)] = pod;
-		return;
+		key = id.substr(m_containerd_prefix.size(), m_id_length);
 	}
-	pos = id.find(m_crio_prefix);
-	if(pos == 0)
+	else if(id.find(m_crio_prefix) == 0)
 	{
-		map[id.substr(m_crio_prefix.size(), m_id_length)] = pod;
-		return;
+		key = id.substr(m_crio_prefix.size(), m_id_length);
 	}
-	throw sinsp_exception("Invalid container ID (expected one of: '" + m_docker_prefix +
-						 "{ID}', '" + m_rkt_prefix + "{ID}', '" + m_containerd_prefix +
-						 "{ID}', '" + m_crio_prefix + "{ID}'): " + id);
+	else
+	{
+		throw sinsp_exception("Invalid container ID (expected one of: '" + m_docker_prefix +
+							 "{ID}', '" + m_rkt_prefix + "{ID}', '" + m_containerd_prefix +
+							 "{ID}', '" + m_crio_prefix + "{ID}'): " + id);
+	}
+#ifndef HAS_ANALYZER
+	m_pod_containers[pod->get_uid()].push_back(key);
+#endif // HAS_ANALYZER
+	map[key] = pod;
 }
 
 bool k8s_state_t::has_pod(k8s_pod_t& pod)
 {
-	for(const auto& p : m_pods)
-	{
-		if(p == pod) { return true; }
-	}
-	return false;
+	const k8s_pod_t* p = m_pods.find(pod.get_uid());
+	return p && (*p == pod);
 }
 
 // state/events
@@ -262,15 +259,7 @@ k8s_component& k8s_state_t::add_common_single_value(k8s_component::type componen
 
 k8s_node_t* k8s_state_t::get_node(const std::string& uid)
 {
-	for (auto& node : m_nodes)
-	{
-		if(node.get_uid() == uid)
-		{
-			return &node;
-		}
-	}
-
-	return nullptr;
+	return m_nodes.find(uid);
 }
 
 void k8s_state_t::clear(k8s_component::type type)
@@ -282,6 +271,8 @@ void k8s_state_t::clear(k8s_component::type type)
 		m_pods.clear();
 		m_controllers.clear();
 		m_services.clear();
+		clear_cache(k8s_component::K8S_NAMESPACES);
+		clear_cache(k8s_component::K8S_PODS);
 	}
 	else
 	{
@@ -318,185 +309,215 @@ void k8s_state_t::clear(k8s_component::type type)
 		default:
 			break;
 		}
+		clear_cache(type);
 	}
 }
 
 // state/caching
 
-void k8s_state_t::update_cache(const k8s_component::type_map::key_type& component)
+//
+// Caches are maintained incrementally: when a component changes, only
+// the entries referring to it are dropped and recomputed, so the cost
+// of an event is proportional to the number of related components
+// rather than to the size of the whole cluster state.
+//
+
+void k8s_state_t::update_cache(k8s_component::type component, const std::string& uid)
 {
 #ifndef HAS_ANALYZER
 	switch (component)
 	{
 		case k8s_component::K8S_NAMESPACES:
 		{
-			const k8s_namespaces& nspaces = get_namespaces();
-			k8s_state_t::namespace_map& ns_map = get_namespace_map();
-			ns_map.clear();
-			for(const auto& ns : nspaces)
+			const k8s_ns_t* ns = m_namespaces.find(uid);
+			if(ns)
 			{
-				std::string ns_name = ns.get_name();
-				if(!is_component_cached(ns_map, ns_name, &ns))
-				{
-					cache_component(ns_map, ns_name, &ns);
-				}
-				else
-				{
-					g_logger.log("Attempt to cache already cached NAMESPACE: " + ns_name, sinsp_logger::SEV_ERROR);
-				}
+				uncache(component, *ns);
+				m_namespace_map[ns->get_name()] = ns;
 			}
 		}
 		break;
 
 		case k8s_component::K8S_PODS:
 		{
-			const k8s_pods& pods = get_pods();
-			k8s_state_t::container_pod_map& container_pod_map = get_container_pod_map();
-			container_pod_map.clear();
-			for(const auto& pod : pods)
+			const k8s_pod_t* pod = m_pods.find(uid);
+			if(pod)
 			{
-				const k8s_pod_t::container_id_list& c_ids = pod.get_container_ids();
-				for(const auto& c_id : c_ids)
+				uncache(component, *pod);
+				for(const auto& c_id : pod->get_container_ids())
 				{
-					if(!is_component_cached(container_pod_map, c_id, &pod))
-					{
-						cache_pod(container_pod_map, c_id, &pod);
-					}
-					else
-					{
-						g_logger.log("Attempt to cache already cached POD: " + c_id, sinsp_logger::SEV_ERROR);
-					}
+					cache_pod(m_container_pods, c_id, pod);
 				}
+				cache_pod_owners(pod);
 			}
 		}
 		break;
 
 		case k8s_component::K8S_REPLICATIONCONTROLLERS:
 		{
-			const k8s_controllers& rcs = get_rcs();
-			const k8s_pods& pods = get_pods();
-			k8s_state_t::pod_rc_map& pod_ctrl_map = get_pod_rc_map();
-			pod_ctrl_map.clear();
-			for(const auto& rc : rcs)
+			const k8s_rc_t* rc = m_controllers.find(uid);
+			if(rc)
 			{
-				std::vector<const k8s_pod_t*> pod_subset = rc.get_selected_pods(pods);
-				for(auto& pod : pod_subset)
-				{
-					const std::string& pod_uid = pod->get_uid();
-					if(!is_component_cached(pod_ctrl_map, pod_uid, &rc))
-					{
-						cache_component(pod_ctrl_map, pod_uid, &rc);
-					}
-					else
-					{
-						g_logger.log("Attempt to cache already cached REPLICATION CONTROLLER: " + pod_uid, sinsp_logger::SEV_ERROR);
-					}
-				}
+				uncache(component, *rc);
+				cache_selected_pods(m_pod_rcs, rc);
 			}
 		}
 		break;
 
 		case k8s_component::K8S_REPLICASETS:
 		{
-			const k8s_replicasets& rss = get_rss();
-			const k8s_pods& pods = get_pods();
-			k8s_state_t::pod_rs_map& pod_rset_map = get_pod_rs_map();
-			pod_rset_map.clear();
-			for(const auto& rs : rss)
+			const k8s_rs_t* rs = m_replicasets.find(uid);
+			if(rs)
 			{
-				std::vector<const k8s_pod_t*> pod_subset = rs.get_selected_pods(pods);
-				for(auto& pod : pod_subset)
-				{
-					const std::string& pod_uid = pod->get_uid();
-					if(!is_component_cached(pod_rset_map, pod_uid, &rs))
-					{
-						cache_component(pod_rset_map, pod_uid, &rs);
-					}
-					else
-					{
-						g_logger.log("Attempt to cache already cached REPLICA SET: " + pod_uid, sinsp_logger::SEV_ERROR);
-					}
-				}
+				uncache(component, *rs);
+				cache_selected_pods(m_pod_rss, rs);
 			}
 		}
 		break;
 
 		case k8s_component::K8S_SERVICES:
 		{
-			const k8s_services& services = get_services();
-			const k8s_pods& pods = get_pods();
-			k8s_state_t::pod_service_map& pod_svc_map = get_pod_service_map();
-			pod_svc_map.clear();
-			for(const auto& service : services)
+			const k8s_service_t* service = m_services.find(uid);
+			if(service)
 			{
-				std::vector<const k8s_pod_t*> pod_subset = service.get_selected_pods(pods);
-				for(auto& pod : pod_subset)
-				{
-					const std::string& pod_uid = pod->get_uid();
-					if(!is_component_cached(pod_svc_map, pod_uid, &service))
-					{
-						cache_component(pod_svc_map, pod_uid, &service);
-					}
-					else
-					{
-						g_logger.log("Attempt to cache already cached SERVICE: " + pod_uid, sinsp_logger::SEV_ERROR);
-					}
-				}
+				uncache(component, *service);
+				cache_selected_pods(m_pod_services, service);
 			}
 		}
 		break;
 
-		case k8s_component::K8S_DAEMONSETS:
+		case k8s_component::K8S_DEPLOYMENTS:
 		{
-			// TODO
-			/*const k8s_daemonsets& daemonsets = get_daemonsets();
-			const k8s_pods& pods = get_pods();
-			k8s_state_t::pod_daemonset_map& pod_svc_map = get_pod_daemonset_map();
-			pod_svc_map.clear();
-			for(const auto& daemonset : daemonsets)
+			const k8s_deployment_t* deployment = m_deployments.find(uid);
+			if(deployment)
 			{
-				std::vector<const k8s_pod_t*> pod_subset = daemonset.get_selected_pods(pods);
-				for(auto& pod : pod_subset)
-				{
-					const std::string& pod_uid = pod->get_uid();
-					if(!is_component_cached(pod_svc_map, pod_uid, &daemonset))
-					{
-						cache_component(pod_svc_map, pod_uid, &daemonset);
-					}
-					else
-					{
-						g_logger.log("Attempt to cache already cached SERVICE: " + pod_uid, sinsp_logger::SEV_ERROR);
-					}
-				}
-			}*/
+				uncache(component, *deployment);
+				cache_selected_pods(m_pod_deployments, deployment);
+			}
 		}
 		break;
 
-		case k8s_component::K8S_DEPLOYMENTS:
+		default: return;
+	}
+#endif // HAS_ANALYZER
+}
+
+void k8s_state_t::cache_pod_owners(const k8s_pod_t* pod)
+{
+#ifndef HAS_ANALYZER
+	const std::string& pod_uid = pod->get_uid();
+	for(const auto& rc : m_controllers)
+	{
+		if(rc.selects(*pod)) { cache_component(m_pod_rcs, pod_uid, &rc); }
+	}
+	for(const auto& rs : m_replicasets)
+	{
+		if(rs.selects(*pod)) { cache_component(m_pod_rss, pod_uid, &rs); }
+	}
+	for(const auto& service : m_services)
+	{
+		if(service.selects(*pod)) { cache_component(m_pod_services, pod_uid, &service); }
+	}
+	for(const auto& deployment : m_deployments)
+	{
+		if(deployment.selects(*pod)) { cache_component(m_pod_deployments, pod_uid, &deployment); }
+	}
+#endif // HAS_ANALYZER
+}
+
+void k8s_state_t::uncache(k8s_component::type component, const k8s_component& comp)
+{
+#ifndef HAS_ANALYZER
+	switch (component)
+	{
+		case k8s_component::K8S_NAMESPACES:
+		{
+			namespace_map::iterator it = m_namespace_map.find(comp.get_name());
+			if(it != m_namespace_map.end() && it->second == &comp)
+			{
+				m_namespace_map.erase(it);
+			}
+		}
+		break;
+
+		case k8s_component::K8S_PODS:
 		{
-			const k8s_deployments& deployments = get_deployments();
-			const k8s_pods& pods = get_pods();
-			k8s_state_t::pod_deployment_map& pod_deployment_map = get_pod_deployment_map();
-			pod_deployment_map.clear();
-			for(const auto& deployment : deployments)
+			const std::string& pod_uid = comp.get_uid();
+			pod_container_map::iterator it = m_pod_containers.find(pod_uid);
+			if(it != m_pod_containers.end())
 			{
-				std::vector<const k8s_pod_t*> pod_subset = deployment.get_selected_pods(pods);
-				for(auto& pod : pod_subset)
+				for(const auto& key : it->second)
 				{
-					const std::string& pod_uid = pod->get_uid();
-					if(!is_component_cached(pod_deployment_map, pod_uid, &deployment))
-					{
-						cache_component(pod_deployment_map, pod_uid, &deployment);
-					}
-					else
+					container_pod_map::iterator c_it = m_container_pods.find(key);
+					if(c_it != m_container_pods.end() && c_it->second == &comp)
 					{
-						g_logger.log("Attempt to cache already cached Deployment: " + pod_uid, sinsp_logger::SEV_ERROR);
+						m_container_pods.erase(c_it);
 					}
 				}
+				m_pod_containers.erase(it);
 			}
+			m_pod_rcs.erase(pod_uid);
+			m_pod_rss.erase(pod_uid);
+			m_pod_services.erase(pod_uid);
+			m_pod_deployments.erase(pod_uid);
 		}
 		break;
 
+		case k8s_component::K8S_REPLICATIONCONTROLLERS:
+			uncache_value(m_pod_rcs, static_cast<const k8s_rc_t*>(&comp));
+			break;
+
+		case k8s_component::K8S_REPLICASETS:
+			uncache_value(m_pod_rss, static_cast<const k8s_rs_t*>(&comp));
+			break;
+
+		case k8s_component::K8S_SERVICES:
+			uncache_value(m_pod_services, static_cast<const k8s_service_t*>(&comp));
+			break;
+
+		case k8s_component::K8S_DEPLOYMENTS:
+			uncache_value(m_pod_deployments, static_cast<const k8s_deployment_t*>(&comp));
+			break;
+
+		default: return;
+	}
+#endif // HAS_ANALYZER
+}
+
+void k8s_state_t::clear_cache(k8s_component::type component)
+{
+#ifndef HAS_ANALYZER
+	switch (component)
+	{
+		case k8s_component::K8S_NAMESPACES:
+			m_namespace_map.clear();
+			break;
+
+		case k8s_component::K8S_PODS:
+			m_container_pods.clear();
+			m_pod_containers.clear();
+			m_pod_rcs.clear();
+			m_pod_rss.clear();
+			m_pod_services.clear();
+			m_pod_deployments.clear();
+			break;
+
+		case k8s_component::K8S_REPLICATIONCONTROLLERS:
+			m_pod_rcs.clear();
+			break;
+
+		case k8s_component::K8S_REPLICASETS:
+			m_pod_rss.clear();
+			break;
+
+		case k8s_component::K8S_SERVICES:
+			m_pod_services.clear();
+			break;
+
+		case k8s_component::K8S_DEPLOYMENTS:
+			m_pod_deployments.clear();
+			break;
+
 		default: return;
 	}
 #endif // HAS_ANALYZER
@@ -153,14 +153,7 @@ public:
 	template <typename C>
 	bool has(const C& components, const std::string& uid) const
 	{
-		for (auto& comp : components)
-		{
-			if(uid == comp.get_uid())
-			{
-				return true;
-			}
-		}
-		return false;
+		return components.has(uid);
 	}
 
 	bool has(const std::string& uid) const
@@ -173,27 +166,13 @@ public:
 	template <typename C, typename T>
 	T* get_component(C& components, const std::string& uid)
 	{
-		for (auto& comp : components)
-		{
-			if(comp.get_uid() == uid)
-			{
-				return &comp;
-			}
-		}
-		return 0;
+		return components.find(uid);
 	}
 
 	template <typename C, typename T>
 	const T* get_component(const C& components, const std::string& uid) const
 	{
-		for (const auto& comp : components)
-		{
-			if(comp.get_uid() == uid)
-			{
-				return &comp;
-			}
-		}
-		return 0;
+		return components.find(uid);
 	}
 
 	template <typename C, typename T>
@@ -210,30 +189,26 @@ public:
 	template <typename C, typename T>
 	T& get_component(C& container, const std::string& name, const std::string& uid, const std::string& ns = "")
 	{
-		for (auto& comp : container)
+		T* comp = container.find(uid);
+		if(comp)
 		{
-			if(comp.get_uid() == uid)
-			{
-				return comp;
-			}
+			return *comp;
 		}
 		return add_component<C, T>(container, name, uid, ns);
 	}
 
+	// Removes the component and drops all the cached
+	// references to it before it is destroyed.
 	template <typename C>
 	bool delete_component(C& components, const std::string& uid)
 	{
-		for (typename C::iterator component = components.begin(),
-			end = components.end();
-			component != end;
-			++component)
+		const typename C::value_type* component = components.find(uid);
+		if(component)
 		{
-			if(component->get_uid() == uid)
-			{
-				components.erase(component);
-				m_component_map.erase(uid);
-				return true;
-			}
+			uncache(C::value_type::COMPONENT_TYPE, *component);
+			components.erase(uid);
+			m_component_map.erase(uid);
+			return true;
 		}
 
 		return false;
@@ -248,6 +223,10 @@ public:
 	// any component by uid
 	const k8s_component* get_component(const std::string& uid, std::string* t = 0) const;
 
+	// refreshes cached lookups for the component with the given uid;
+	// must be called after the component was added or modified
+	void update_cache(k8s_component::type component, const std::string& uid);
+
 #ifndef HAS_ANALYZER
 
 	// pod by container;
@@ -282,7 +261,8 @@ public:
 
 private:
 
-	void update_cache(const k8s_component::type_map::key_type& component);
+	void uncache(k8s_component::type component, const k8s_component& comp);
+	void clear_cache(k8s_component::type component);
 	static k8s_component::type component_from_json(const Json::Value& item);
 	static Json::Value extract_capture_data(const Json::Value& item);
 
@@ -318,6 +298,35 @@ private:
 	}
 
 	void cache_pod(container_pod_map& map, const std::string& id, const k8s_pod_t* pod);
+	void cache_pod_owners(const k8s_pod_t* pod);
+
+	template<typename C, typename S>
+	void cache_selected_pods(C& map, const S* selector)
+	{
+		for(const auto& pod : m_pods)
+		{
+			if(selector->selects(pod))
+			{
+				cache_component(map, pod.get_uid(), selector);
+			}
+		}
+	}
+
+	template<typename C>
+	void uncache_value(C& map, const typename C::mapped_type value)
+	{
+		for(typename C::iterator it = map.begin(); it != map.end();)
+		{
+			if(it->second == value)
+			{
+				it = map.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
 
 	template<typename C>
 	void cache_component(C& map, const std::string& key, typename C::mapped_type component)
@@ -357,8 +366,11 @@ private:
 
 #ifndef HAS_ANALYZER
 
+	typedef std::unordered_map<std::string, std::vector<std::string>> pod_container_map;
+
 	namespace_map            m_namespace_map;
 	container_pod_map        m_container_pods;
+	pod_container_map        m_pod_containers; // pod uid -> keys cached in m_container_pods
 	pod_service_map          m_pod_services;
 	pod_rc_map               m_pod_rcs;
 	pod_rs_map               m_pod_rss;
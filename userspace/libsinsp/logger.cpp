@@ -25,6 +25,11 @@ limitations under the License.
 #endif
 #include <stdarg.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace
 {
 
@@ -32,8 +37,285 @@ thread_local char s_tbuf[16384];
 
 const size_t ENCODE_LEN = sizeof(uint64_t);
 
+// How often the async writer looks for messages when nobody wakes it up
+const std::chrono::milliseconds ASYNC_POLL_INTERVAL(20);
+
+struct log_record
+{
+	sinsp_logger::severity m_sev;
+	uint64_t m_ts_us;
+	std::string m_msg;
+};
+
+//
+// A single producer, single consumer ring of log records: the producer
+// is the thread that logs, the consumer the async writer. A record is
+// released only after it's written, so the producer can wait for it.
+//
+class log_ring
+{
+public:
+	explicit log_ring(uint32_t size):
+		m_records(size),
+		m_mask(size - 1),
+		m_head(0),
+		m_tail(0)
+	{
+	}
+
+	bool push(sinsp_logger::severity sev, uint64_t ts_us, std::string&& msg)
+	{
+		uint64_t head = m_head.load(std::memory_order_relaxed);
+		if(head - m_tail.load(std::memory_order_acquire) > m_mask)
+		{
+			return false;
+		}
+
+		log_record& r = m_records[head & m_mask];
+		r.m_sev = sev;
+		r.m_ts_us = ts_us;
+		r.m_msg = std::move(msg);
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	log_record* front()
+	{
+		uint64_t tail = m_tail.load(std::memory_order_relaxed);
+		if(tail == m_head.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		return &m_records[tail & m_mask];
+	}
+
+	void pop()
+	{
+		m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	uint64_t get_head() const
+	{
+		return m_head.load(std::memory_order_acquire);
+	}
+
+	uint64_t get_tail() const
+	{
+		return m_tail.load(std::memory_order_acquire);
+	}
+
+private:
+	std::vector<log_record> m_records;
+	const uint64_t m_mask;
+	alignas(64) std::atomic<uint64_t> m_head;
+	alignas(64) std::atomic<uint64_t> m_tail;
+};
+
+//
+// The rings of the calling thread, by async writer generation. An entry
+// whose ring is only referenced from here belongs to a stopped writer.
+//
+thread_local std::vector<std::pair<uint64_t, std::shared_ptr<log_ring>>> s_rings;
+
+std::atomic<uint64_t> s_async_generation(0);
+
 } // end namespace
 
+class sinsp_logger::async_writer
+{
+public:
+	async_writer(sinsp_logger* logger, uint32_t ring_size):
+		m_logger(logger),
+		m_ring_size(ring_size),
+		m_generation(++s_async_generation),
+		m_stop(false),
+		m_dropped(0),
+		m_reported_dropped(0)
+	{
+		m_thread = std::thread(&async_writer::run, this);
+	}
+
+	~async_writer()
+	{
+		stop();
+	}
+
+	void push(severity sev, uint64_t ts_us, std::string&& msg)
+	{
+		if(!get_ring(true)->push(sev, ts_us, std::move(msg)))
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void flush()
+	{
+		log_ring* ring = get_ring(false);
+		if(ring == nullptr)
+		{
+			return;
+		}
+
+		uint64_t head = ring->get_head();
+		m_cond.notify_one();
+		while(ring->get_tail() < head && !m_stop)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	//
+	// Write what's left and stop the thread
+	//
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if(m_stop)
+			{
+				return;
+			}
+			m_stop = true;
+		}
+
+		m_cond.notify_one();
+		m_thread.join();
+	}
+
+	uint64_t get_dropped() const
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	log_ring* get_ring(bool create)
+	{
+		for(auto& r : s_rings)
+		{
+			if(r.first == m_generation)
+			{
+				return r.second.get();
+			}
+		}
+
+		if(!create)
+		{
+			return nullptr;
+		}
+
+		//
+		// First message of this thread: forget the rings of the
+		// writers that were stopped, and register a new one
+		//
+		for(auto it = s_rings.begin(); it != s_rings.end();)
+		{
+			if(it->second.use_count() == 1)
+			{
+				it = s_rings.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		std::shared_ptr<log_ring> ring = std::make_shared<log_ring>(m_ring_size);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_rings.push_back(ring);
+		}
+		s_rings.push_back(std::make_pair(m_generation, ring));
+
+		return ring.get();
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while(!m_stop)
+		{
+			m_cond.wait_for(lock, ASYNC_POLL_INTERVAL);
+			drain();
+		}
+
+		drain();
+		m_rings.clear();
+	}
+
+	//
+	// Write all the pending messages. Called with m_mutex held, which
+	// only new threads and stop() ever wait for.
+	//
+	void drain()
+	{
+		for(auto it = m_rings.begin(); it != m_rings.end();)
+		{
+			//
+			// The thread exited: nobody will push here anymore. This is
+			// checked before draining, so that the messages it pushed
+			// right before exiting are written too.
+			//
+			bool exited = it->use_count() == 1;
+			if(exited)
+			{
+				std::atomic_thread_fence(std::memory_order_acquire);
+			}
+
+			log_ring* ring = it->get();
+			log_record* r;
+			while((r = ring->front()) != nullptr)
+			{
+				m_logger->write(r->m_msg, r->m_sev, r->m_ts_us);
+				ring->pop();
+			}
+
+			if(exited)
+			{
+				it = m_rings.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		uint64_t dropped = get_dropped();
+		if(dropped != m_reported_dropped)
+		{
+			std::string msg = "sinsp_logger: " + std::to_string(dropped - m_reported_dropped) +
+				" log messages dropped, the logging threads are faster than the log output";
+			m_logger->write(msg, SEV_WARNING, now_us());
+			m_reported_dropped = dropped;
+		}
+	}
+
+	static uint64_t now_us()
+	{
+		struct timeval ts = {};
+		if(gettimeofday(&ts, nullptr) != 0)
+		{
+			return 0;
+		}
+
+		return (uint64_t)ts.tv_sec * 1000000 + ts.tv_usec;
+	}
+
+	sinsp_logger* m_logger;
+	const uint32_t m_ring_size;
+	const uint64_t m_generation;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::vector<std::shared_ptr<log_ring>> m_rings;
+	std::atomic<bool> m_stop;
+	std::atomic<uint64_t> m_dropped;
+	uint64_t m_reported_dropped;
+	std::thread m_thread;
+
+	friend class sinsp_logger;
+};
+
 const uint32_t sinsp_logger::OT_NONE       = 0;
 const uint32_t sinsp_logger::OT_STDOUT     = 1;
 const uint32_t sinsp_logger::OT_STDERR     = (OT_STDOUT   << 1);
@@ -46,11 +328,15 @@ sinsp_logger::sinsp_logger():
 	m_file(nullptr),
 	m_callback(nullptr),
 	m_flags(OT_NONE),
-	m_sev(SEV_INFO)
+	m_sev(SEV_INFO),
+	m_async(nullptr)
 { }
 
 sinsp_logger::~sinsp_logger()
 {
+	disable_async();
+	m_retired_async.clear();
+
 	if(m_file)
 	{
 		ASSERT(m_flags & sinsp_logger::OT_FILE);
@@ -135,46 +421,109 @@ sinsp_logger::severity sinsp_logger::get_severity() const
 	return m_sev;
 }
 
-void sinsp_logger::log(std::string msg, const severity sev)
+void sinsp_logger::enable_async(uint32_t ring_size)
 {
-	sinsp_logger_callback cb = nullptr;
+	if(m_async != nullptr)
+	{
+		return;
+	}
 
+	uint32_t size = 2;
+	while(size < ring_size)
+	{
+		size <<= 1;
+	}
+
+	m_async = new async_writer(this, size);
+}
+
+void sinsp_logger::disable_async()
+{
+	async_writer* async = m_async.exchange(nullptr);
+	if(async == nullptr)
+	{
+		return;
+	}
+
+	async->stop();
+	m_retired_async.emplace_back(async);
+}
+
+void sinsp_logger::flush()
+{
+	async_writer* async = m_async;
+	if(async != nullptr)
+	{
+		async->flush();
+	}
+}
+
+uint64_t sinsp_logger::get_dropped() const
+{
+	async_writer* async = m_async;
+	return async != nullptr ? async->get_dropped() : 0;
+}
+
+void sinsp_logger::log(std::string msg, const severity sev)
+{
 	if(sev > m_sev)
 	{
 		return;
 	}
 
+	uint64_t ts_us = 0;
 	if((m_flags & sinsp_logger::OT_NOTS) == 0)
 	{
 		struct timeval ts = {};
 
 		if(gettimeofday(&ts, nullptr) == 0)
 		{
-			const std::string::size_type ts_length = sizeof("31-12 23:59:59.999999 ");
-			char ts_buf[ts_length];
-			struct tm* ti;
-			struct tm time_info = {};
+			ts_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_usec;
+		}
+	}
+
+	async_writer* async = m_async;
+	if(async != nullptr && sev > SEV_CRITICAL)
+	{
+		async->push(sev, ts_us, std::move(msg));
+		return;
+	}
+
+	write(msg, sev, ts_us);
+}
+
+void sinsp_logger::write(std::string& msg, const severity sev, uint64_t ts_us)
+{
+	sinsp_logger_callback cb = nullptr;
+
+	if(ts_us != 0 && (m_flags & sinsp_logger::OT_NOTS) == 0)
+	{
+		const std::string::size_type ts_length = sizeof("31-12 23:59:59.999999 ");
+		char ts_buf[ts_length];
+		struct tm* ti;
+		struct tm time_info = {};
+		time_t ts_sec = (time_t)(ts_us / 1000000);
 
 #ifdef _WIN32
-			ti = _gmtime32((__time32_t*)&ts.tv_sec);
+		__time32_t ts_sec32 = (__time32_t)ts_sec;
+		ti = _gmtime32(&ts_sec32);
 #else
-			gmtime_r(&ts.tv_sec, &time_info);
-			ti = &time_info;
+		gmtime_r(&ts_sec, &time_info);
+		ti = &time_info;
 #endif
 
-			snprintf(ts_buf,
-				 sizeof(ts_buf),
-				 "%.2d-%.2d %.2d:%.2d:%.2d.%.6d ",
-				 ti->tm_mon + 1,
-				 ti->tm_mday,
-				 ti->tm_hour,
-				 ti->tm_min,
-				 ti->tm_sec,
-				 (int)ts.tv_usec);
-
-			ts_buf[sizeof(ts_buf) - 1] = '\0';
-			msg.insert(0, ts_buf);
-		}
+		snprintf(ts_buf,
+			 sizeof(ts_buf),
+			 "%.2d-%.2d %.2d:%.2d:%.2d.%.6d ",
+			 ti->tm_mon + 1,
+			 ti->tm_mday,
+			 ti->tm_hour,
+			 ti->tm_min,
+			 ti->tm_sec,
+			 (int)(ts_us % 1000000));
+
+		ts_buf[sizeof(ts_buf) - 1] = '\0';
+		msg.insert(0, ts_buf);
 	}
 
 	if(m_flags & sinsp_logger::OT_ENCODE_SEV)
@@ -18,9 +18,12 @@ limitations under the License.
 #pragma once
 
 #include "sinsp_public.h"
+#include "token_bucket.h"
 
 #include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
 /**
  * Component logging API.  This API exposes the ability to log to a
@@ -57,6 +60,8 @@ public:
 	const static uint32_t OT_NOTS;
 	const static uint32_t OT_ENCODE_SEV;
 
+	const static uint32_t DEFAULT_ASYNC_RING_SIZE = 4096;
+
 	/**
 	 * Initialize this sinsp_logger with no output sinks enabled.
 	 */
@@ -125,6 +130,48 @@ public:
 	 */
 	void log(std::string msg, severity sev = SEV_INFO);
 
+	/**
+	 * Emit the message returned by build() if the given sev is enabled.
+	 * build() is not called otherwise, so the message costs nothing to
+	 * build when it isn't logged.
+	 */
+	template<typename F>
+	void log_lazy(severity sev, F build)
+	{
+		if(is_enabled(sev))
+		{
+			log(build(), sev);
+		}
+	}
+
+	/**
+	 * Hand the messages to a background thread that formats and writes
+	 * them, instead of doing it on the calling thread. Each
+	 * thread that logs gets a lock-free ring of ring_size messages
+	 * (rounded up to a power of two); when it's full, the messages are
+	 * dropped and counted instead of blocking the caller.
+	 * SEV_FATAL and SEV_CRITICAL messages are still written right away.
+	 */
+	void enable_async(uint32_t ring_size = DEFAULT_ASYNC_RING_SIZE);
+
+	/**
+	 * Write the pending messages and go back to writing them on the
+	 * calling thread. Messages logged while this runs may be lost.
+	 */
+	void disable_async();
+
+	/**
+	 * In async mode, wait until the messages logged so far by the
+	 * calling thread have been written.
+	 */
+	void flush();
+
+	/**
+	 * The number of messages dropped since enable_async() because the
+	 * ring of the logging thread was full.
+	 */
+	uint64_t get_dropped() const;
+
 	/**
 	 * Write the given printf-style log message of the given severity
 	 * with the given format to the configured log sink.
@@ -153,9 +200,17 @@ public:
 	static size_t decode_severity(const std::string &s, severity& sev);
 
 private:
+	class async_writer;
+
 	/** Returns true if the callback log sync is enabled, false otherwise. */
 	bool is_callback() const;
 
+	/**
+	 * Timestamp msg with ts_us (microseconds since the epoch, 0 for
+	 * none) and write it to the log sink.
+	 */
+	void write(std::string& msg, severity sev, uint64_t ts_us);
+
 
 	/** Returns a string containing encoded severity, for OT_ENCODE_SEV. */
 	static const char* encode_severity(severity sev);
@@ -163,10 +218,36 @@ private:
 	std::atomic<callback_t> m_callback;
 	std::atomic<uint32_t> m_flags;
 	std::atomic<severity> m_sev;
+	std::atomic<async_writer*> m_async;
+
+	// Threads may still be logging to a writer that was disabled
+	std::vector<std::unique_ptr<async_writer>> m_retired_async;
 };
 
 using sinsp_logger_callback = sinsp_logger::callback_t;
 
+/**
+ * Limits the rate of the messages logged from one place, with a token
+ * bucket of max_burst messages filled at rate messages per second. Not
+ * thread-safe: SINSP_LOG_RATE_LIMITED keeps one per thread.
+ */
+class SINSP_PUBLIC sinsp_log_rate_limiter
+{
+public:
+	sinsp_log_rate_limiter(double rate, double max_burst)
+	{
+		m_bucket.init(rate, max_burst);
+	}
+
+	bool claim()
+	{
+		return m_bucket.claim();
+	}
+
+private:
+	token_bucket m_bucket;
+};
+
 extern sinsp_logger g_logger;
 
 #define SINSP_LOG_(severity, fmt, ...)                                         \
@@ -189,6 +270,41 @@ extern sinsp_logger g_logger;
 	}                                                                      \
 	while(false)
 
+//
+// Like SINSP_LOG_ and SINSP_LOG_STR_, but log at most rate messages per
+// second, with bursts of max_burst, from this call site and thread. The
+// other messages are dropped before they're built.
+//
+#define SINSP_LOG_RATE_LIMITED(severity, rate, max_burst, fmt, ...)           \
+	do                                                                     \
+	{                                                                      \
+		if(g_logger.is_enabled(severity))                              \
+		{                                                              \
+			static thread_local sinsp_log_rate_limiter s_limiter(  \
+				(rate), (max_burst));                          \
+			if(s_limiter.claim())                                  \
+			{                                                      \
+				g_logger.format((severity), ("" fmt), ##__VA_ARGS__); \
+			}                                                      \
+		}                                                              \
+	}                                                                      \
+	while(false)
+
+#define SINSP_LOG_STR_RATE_LIMITED(severity, rate, max_burst, msg)             \
+	do                                                                     \
+	{                                                                      \
+		if(g_logger.is_enabled(severity))                              \
+		{                                                              \
+			static thread_local sinsp_log_rate_limiter s_limiter(  \
+				(rate), (max_burst));                          \
+			if(s_limiter.claim())                                  \
+			{                                                      \
+				g_logger.log((msg), (severity));               \
+			}                                                      \
+		}                                                              \
+	}                                                                      \
+	while(false)
+
 #define SINSP_FATAL(...)    SINSP_LOG_(sinsp_logger::SEV_FATAL,    ##__VA_ARGS__)
 #define SINSP_CRITICAL(...) SINSP_LOG_(sinsp_logger::SEV_CRITICAL, ##__VA_ARGS__)
 #define SINSP_ERROR(...)    SINSP_LOG_(sinsp_logger::SEV_ERROR,    ##__VA_ARGS__)
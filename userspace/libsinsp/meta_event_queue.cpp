@@ -0,0 +1,98 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "meta_event_queue.h"
+#include "event.h"
+
+sinsp_meta_event_queue::sinsp_meta_event_queue():
+	m_pending(false),
+	m_local(NULL),
+	m_batch_pos(0)
+{
+}
+
+void sinsp_meta_event_queue::push(std::shared_ptr<sinsp_evt> evt)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_incoming.push_back(std::move(evt));
+	m_pending.store(true, std::memory_order_release);
+}
+
+void sinsp_meta_event_queue::push(std::vector<std::shared_ptr<sinsp_evt>>& evts)
+{
+	if(evts.empty())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if(m_incoming.empty())
+	{
+		m_incoming.swap(evts);
+	}
+	else
+	{
+		for(auto& evt : evts)
+		{
+			m_incoming.push_back(std::move(evt));
+		}
+	}
+	evts.clear();
+	m_pending.store(true, std::memory_order_release);
+}
+
+void sinsp_meta_event_queue::set_local(sinsp_evt* evt)
+{
+	m_local = evt;
+	if(evt != NULL)
+	{
+		m_pending.store(true, std::memory_order_release);
+	}
+}
+
+sinsp_evt* sinsp_meta_event_queue::pop_local()
+{
+	sinsp_evt* evt = m_local;
+	m_local = NULL;
+	return evt;
+}
+
+sinsp_evt* sinsp_meta_event_queue::pop()
+{
+	m_current.reset();
+
+	if(m_batch_pos == m_batch.size())
+	{
+		m_batch.clear();
+		m_batch_pos = 0;
+
+		//
+		// The flag is cleared with the lock held, so a push can't be
+		// missed between the swap and the store
+		//
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_batch.swap(m_incoming);
+		if(m_batch.empty())
+		{
+			m_pending.store(m_local != NULL, std::memory_order_release);
+			return NULL;
+		}
+	}
+
+	m_current = std::move(m_batch[m_batch_pos++]);
+	return m_current.get();
+}
@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class sinsp_evt;
+
+//
+// The events that sinsp::next() returns before reading the next event
+// from the driver or the capture file: container, k8s and mesos metadata
+// and the events added by users. All the sources share one atomic flag,
+// so when nothing is pending next() pays a single load per event.
+//
+// Two kinds of events can be pending:
+//  - one local event, owned by the caller and set from the inspector
+//    thread. It comes first, and is how chains of events that reuse the
+//    same buffer (like the /proc cpu events) are returned.
+//  - the shared events, that any thread can push. The inspector thread
+//    takes them all at once when the ones it took before are exhausted,
+//    so the lock is taken once per batch rather than once per event.
+//    The events of a batch, and of a thread, come out in push order.
+//
+class sinsp_meta_event_queue
+{
+public:
+	sinsp_meta_event_queue();
+
+	//
+	// Is any event pending? Cheap, called for every event.
+	//
+	inline bool pending() const
+	{
+		return m_pending.load(std::memory_order_acquire);
+	}
+
+	//
+	// From any thread
+	//
+	void push(std::shared_ptr<sinsp_evt> evt);
+	void push(std::vector<std::shared_ptr<sinsp_evt>>& evts);
+
+	//
+	// From the inspector thread only
+	//
+	void set_local(sinsp_evt* evt);
+	sinsp_evt* pop_local();
+
+	//
+	// The next shared event, or NULL if there are none. From the
+	// inspector thread only; the event stays valid until the next call.
+	//
+	sinsp_evt* pop();
+
+private:
+	std::atomic<bool> m_pending;
+
+	// Pushed and not taken yet, protected by m_mutex
+	std::mutex m_mutex;
+	std::vector<std::shared_ptr<sinsp_evt>> m_incoming;
+
+	// Owned by the inspector thread
+	sinsp_evt* m_local;
+	std::vector<std::shared_ptr<sinsp_evt>> m_batch;
+	size_t m_batch_pos;
+	std::shared_ptr<sinsp_evt> m_current;
+};
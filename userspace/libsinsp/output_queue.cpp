@@ -0,0 +1,340 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "sinsp.h"
+#include "sinsp_int.h"
+#include "eventformatter.h"
+#include "output_queue.h"
+
+//
+// A bucket with a rate of 0 lets everything through. The timestamps can
+// go back a little between events of different CPUs, the bucket must
+// not see that as a very long time.
+//
+static bool claim_bucket(token_bucket& bucket, const sinsp_output_queue::limits& limits, uint64_t ts)
+{
+	if(limits.m_rate == 0)
+	{
+		return true;
+	}
+
+	uint64_t last_seen = bucket.get_last_seen();
+	return bucket.claim(1, ts > last_seen ? ts : last_seen);
+}
+
+sinsp_output_queue::sinsp_output_queue(const params& params, sink_t sink):
+	m_params(params),
+	m_sink(sink),
+	m_queued(0),
+	m_queued_bytes(0),
+	m_delivering(false),
+	m_stop(false)
+{
+	if(m_params.m_priorities.empty())
+	{
+		throw sinsp_exception("output queue: at least one priority is needed");
+	}
+
+	m_queues.resize(m_params.m_priorities.size());
+	m_stats.resize(m_params.m_priorities.size());
+	m_priority_buckets.resize(m_params.m_priorities.size());
+	for(uint32_t j = 0; j < m_params.m_priorities.size(); j++)
+	{
+		const limits& l = m_params.m_priorities[j];
+		m_priority_buckets[j].init(l.m_rate, l.m_max_burst, 1);
+	}
+
+	m_thread = std::thread(&sinsp_output_queue::run, this);
+}
+
+sinsp_output_queue::~sinsp_output_queue()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_cond.notify_one();
+	m_thread.join();
+}
+
+uint32_t sinsp_output_queue::get_priority(uint32_t priority) const
+{
+	return priority < m_queues.size() ? priority : (uint32_t)m_queues.size() - 1;
+}
+
+bool sinsp_output_queue::push(sinsp_evt* evt, sinsp_evt_formatter& formatter, uint32_t priority, const std::string& key)
+{
+	uint64_t ts = evt->get_ts();
+	priority = get_priority(priority);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stats[priority].m_pushed++;
+		if(!claim(ts, priority, key))
+		{
+			return false;
+		}
+	}
+
+	//
+	// Format outside of the lock, so that the output thread isn't
+	// kept waiting
+	//
+	std::string text;
+	if(!formatter.tostring(evt, &text))
+	{
+		//
+		// Not a message after all
+		//
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stats[priority].m_pushed--;
+		return false;
+	}
+
+	bool res;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		res = enqueue(ts, priority, key, text);
+	}
+
+	if(res)
+	{
+		m_cond.notify_one();
+	}
+
+	return res;
+}
+
+bool sinsp_output_queue::push(uint64_t ts, uint32_t priority, const std::string& key, std::string text)
+{
+	priority = get_priority(priority);
+
+	bool res;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stats[priority].m_pushed++;
+		res = claim(ts, priority, key) && enqueue(ts, priority, key, text);
+	}
+
+	if(res)
+	{
+		m_cond.notify_one();
+	}
+
+	return res;
+}
+
+bool sinsp_output_queue::claim(uint64_t ts, uint32_t priority, const std::string& key)
+{
+	bool res = claim_bucket(m_priority_buckets[priority], m_params.m_priorities[priority], ts);
+
+	if(res && m_params.m_per_key.m_rate != 0)
+	{
+		auto it = m_key_buckets.find(key);
+		if(it == m_key_buckets.end())
+		{
+			if(m_key_buckets.size() >= m_params.m_max_keys && !m_key_buckets.empty())
+			{
+				auto oldest = m_key_buckets.begin();
+				for(auto k = m_key_buckets.begin(); k != m_key_buckets.end(); ++k)
+				{
+					if(k->second.get_last_seen() < oldest->second.get_last_seen())
+					{
+						oldest = k;
+					}
+				}
+				m_key_buckets.erase(oldest);
+			}
+
+			it = m_key_buckets.emplace(key, token_bucket()).first;
+			it->second.init(m_params.m_per_key.m_rate, m_params.m_per_key.m_max_burst, ts);
+		}
+
+		res = claim_bucket(it->second, m_params.m_per_key, ts);
+	}
+
+	if(!res)
+	{
+		m_stats[priority].m_dropped_rate++;
+	}
+
+	return res;
+}
+
+bool sinsp_output_queue::enqueue(uint64_t ts, uint32_t priority, const std::string& key, std::string& text)
+{
+	uint64_t hash = 0;
+	if(m_params.m_coalesce_window_ns != 0)
+	{
+		hash = std::hash<std::string>()(text) ^ (std::hash<std::string>()(key) * 0x9e3779b97f4a7c15ULL) ^
+			((uint64_t)priority << 56);
+
+		auto it = m_coalescing.find(hash);
+		if(it != m_coalescing.end())
+		{
+			message& msg = it->second->m_msg;
+			if(ts >= msg.m_ts && ts - msg.m_ts <= m_params.m_coalesce_window_ns &&
+			   msg.m_priority == priority && msg.m_text == text && msg.m_key == key)
+			{
+				msg.m_count++;
+				if(ts > msg.m_last_ts)
+				{
+					msg.m_last_ts = ts;
+				}
+				m_stats[priority].m_coalesced++;
+				return true;
+			}
+		}
+	}
+
+	uint64_t size = text.size() + key.size();
+	if(!make_room(priority, size))
+	{
+		m_stats[priority].m_dropped_full++;
+		return false;
+	}
+
+	std::list<entry>& queue = m_queues[priority];
+	queue.emplace_back();
+	entry& e = queue.back();
+	e.m_hash = hash;
+	e.m_msg.m_priority = priority;
+	e.m_msg.m_key = key;
+	e.m_msg.m_text = std::move(text);
+	e.m_msg.m_ts = ts;
+	e.m_msg.m_last_ts = ts;
+
+	m_queued++;
+	m_queued_bytes += size;
+
+	if(m_params.m_coalesce_window_ns != 0)
+	{
+		m_coalescing[hash] = std::prev(queue.end());
+	}
+
+	return true;
+}
+
+bool sinsp_output_queue::make_room(uint32_t priority, uint64_t size)
+{
+	if(size > m_params.m_max_bytes)
+	{
+		return false;
+	}
+
+	while(m_queued >= m_params.m_max_messages || m_queued_bytes + size > m_params.m_max_bytes)
+	{
+		//
+		// Evict the oldest message of the lowest priority, if it's
+		// lower than the new one
+		//
+		uint32_t victim = (uint32_t)m_queues.size();
+		while(victim > priority + 1 && m_queues[victim - 1].empty())
+		{
+			victim--;
+		}
+
+		if(victim <= priority + 1)
+		{
+			return false;
+		}
+
+		victim--;
+		m_stats[victim].m_dropped_full++;
+		remove(victim, m_queues[victim].begin());
+	}
+
+	return true;
+}
+
+sinsp_output_queue::message sinsp_output_queue::remove(uint32_t priority, entry_it it)
+{
+	auto c = m_coalescing.find(it->m_hash);
+	if(c != m_coalescing.end() && c->second == it)
+	{
+		m_coalescing.erase(c);
+	}
+
+	m_queued--;
+	m_queued_bytes -= it->m_msg.m_text.size() + it->m_msg.m_key.size();
+
+	message msg = std::move(it->m_msg);
+	m_queues[priority].erase(it);
+	return msg;
+}
+
+void sinsp_output_queue::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while(true)
+	{
+		m_cond.wait(lock, [this]() { return m_stop || m_queued != 0; });
+
+		if(m_queued == 0)
+		{
+			break;
+		}
+
+		uint32_t priority = 0;
+		while(m_queues[priority].empty())
+		{
+			priority++;
+		}
+
+		message msg = remove(priority, m_queues[priority].begin());
+		m_delivering = true;
+
+		lock.unlock();
+		m_sink(msg);
+		lock.lock();
+
+		m_delivering = false;
+		m_stats[priority].m_delivered++;
+		if(m_queued == 0)
+		{
+			m_idle_cond.notify_all();
+		}
+	}
+
+	m_idle_cond.notify_all();
+}
+
+void sinsp_output_queue::flush()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle_cond.wait(lock, [this]() { return m_queued == 0 && !m_delivering; });
+}
+
+sinsp_output_queue::stats sinsp_output_queue::get_stats(uint32_t priority) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats[get_priority(priority)];
+}
+
+uint32_t sinsp_output_queue::get_queued() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_queued;
+}
+
+uint64_t sinsp_output_queue::get_queued_bytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_queued_bytes;
+}
@@ -0,0 +1,189 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "sinsp_public.h"
+#include "token_bucket.h"
+
+class sinsp_evt;
+class sinsp_evt_formatter;
+
+/*!
+  \brief A bounded queue between the capture loop and a slow output, like
+  a file, a socket or a user_event_logger callback.
+
+  The capture loop pushes messages, usually the formatted events that
+  matched a rule, and a background thread hands them to the sink. Pushing
+  never waits for the sink: when it falls behind, messages are shed
+  instead, and counted.
+
+  - Every priority, and optionally every key (e.g. the rule name), has a
+    token bucket. The messages over the rate are dropped before being
+    formatted. The rates are measured with the event timestamps.
+  - The queue holds at most m_max_messages messages and m_max_bytes bytes.
+    When it's full, a new message takes the place of the oldest queued
+    message of a lower priority, or is dropped if there's none.
+  - A message identical to a queued one of the same priority, pushed
+    within the coalescing window of the first, is counted in it instead
+    of being queued.
+  - The sink gets the highest priority messages first.
+
+  Priority 0 is the highest.
+*/
+class SINSP_PUBLIC sinsp_output_queue
+{
+public:
+	class message
+	{
+	public:
+		uint32_t m_priority = 0;
+		std::string m_key;
+		std::string m_text;
+		uint64_t m_ts = 0;	// of the first occurrence
+		uint64_t m_last_ts = 0;	// of the last coalesced occurrence
+		uint32_t m_count = 1;	// occurrences, coalesced ones included
+	};
+
+	typedef std::function<void(const message&)> sink_t;
+
+	//
+	// A token bucket: m_rate messages per second, with bursts of
+	// m_max_burst. A rate of 0 means no limit.
+	//
+	class limits
+	{
+	public:
+		double m_rate = 0;
+		double m_max_burst = 0;
+	};
+
+	class params
+	{
+	public:
+		// One per priority, the first is priority 0. The priorities
+		// beyond the last use the last.
+		std::vector<limits> m_priorities = {limits()};
+		// Applied to every key on top of the priority limits
+		limits m_per_key;
+		// When more keys are seen, the one seen the longest ago is forgotten
+		uint32_t m_max_keys = 1024;
+		uint32_t m_max_messages = 10000;
+		uint64_t m_max_bytes = 16 * 1024 * 1024;
+		// 0 disables coalescing
+		uint64_t m_coalesce_window_ns = 1000000000;
+	};
+
+	//
+	// Per priority. Every pushed message ends up delivered, coalesced
+	// or dropped: once the queue is flushed,
+	// m_pushed == m_delivered + m_coalesced + m_dropped_rate + m_dropped_full
+	//
+	class stats
+	{
+	public:
+		uint64_t m_pushed = 0;
+		uint64_t m_delivered = 0;
+		uint64_t m_coalesced = 0;
+		uint64_t m_dropped_rate = 0;
+		uint64_t m_dropped_full = 0;	// not queued, or evicted
+	};
+
+	sinsp_output_queue(const params& params, sink_t sink);
+
+	//
+	// Delivers the queued messages, then stops the output thread
+	//
+	~sinsp_output_queue();
+
+	/*!
+	  \brief Format evt with formatter and queue it.
+
+	  \return false if the message was dropped, or the formatter says
+	   the event shouldn't be shown. The event is only formatted if the
+	   rate limits allow it.
+	*/
+	bool push(sinsp_evt* evt, sinsp_evt_formatter& formatter, uint32_t priority, const std::string& key = "");
+
+	//
+	// Queue an already formatted message, with timestamp ts in
+	// nanoseconds. Returns false if it was dropped.
+	//
+	bool push(uint64_t ts, uint32_t priority, const std::string& key, std::string text);
+
+	//
+	// Wait until all the queued messages are delivered
+	//
+	void flush();
+
+	stats get_stats(uint32_t priority) const;
+	uint32_t get_queued() const;
+	uint64_t get_queued_bytes() const;
+
+private:
+	struct entry
+	{
+		message m_msg;
+		uint64_t m_hash;
+	};
+
+	typedef std::list<entry>::iterator entry_it;
+
+	uint32_t get_priority(uint32_t priority) const;
+
+	// With m_mutex held
+	bool claim(uint64_t ts, uint32_t priority, const std::string& key);
+	bool enqueue(uint64_t ts, uint32_t priority, const std::string& key, std::string& text);
+	bool make_room(uint32_t priority, uint64_t size);
+	message remove(uint32_t priority, entry_it it);
+
+	void run();
+
+	const params m_params;
+	sink_t m_sink;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::condition_variable m_idle_cond;
+
+	// Queued messages by priority, oldest first
+	std::vector<std::list<entry>> m_queues;
+	uint32_t m_queued;
+	uint64_t m_queued_bytes;
+	bool m_delivering;
+
+	// Queued messages that may get coalesced, by hash of key and text
+	std::unordered_map<uint64_t, entry_it> m_coalescing;
+
+	std::vector<token_bucket> m_priority_buckets;
+	std::unordered_map<std::string, token_bucket> m_key_buckets;
+
+	std::vector<stats> m_stats;
+
+	bool m_stop;
+	std::thread m_thread;
+};
@@ -38,6 +38,7 @@ limitations under the License.
 #include "filter.h"
 #include "filterchecks.h"
 #include "protodecoder.h"
+#include "stage_timers.h"
 #ifdef SIMULATE_DROP_MODE
 bool should_drop(sinsp_evt *evt);
 #endif
@@ -63,9 +64,9 @@ sinsp_parser::sinsp_parser(sinsp *inspector) :
 	//
 	m_inspector->m_partial_tracers_pool = new simple_lifo_queue<sinsp_partial_tracer>(128);
 
-	init_metaevt(m_k8s_metaevents_state, PPME_K8S_E, SP_EVT_BUF_SIZE);
-	init_metaevt(m_mesos_metaevents_state, PPME_MESOS_E, SP_EVT_BUF_SIZE);
 	m_drop_event_flags = EF_NONE;
+
+	init_event_parsers();
 }
 
 sinsp_parser::~sinsp_parser()
@@ -83,34 +84,218 @@ sinsp_parser::~sinsp_parser()
 	}
 	m_protodecoders.clear();
 
-	free(m_k8s_metaevents_state.m_piscapevt);
-	free(m_mesos_metaevents_state.m_piscapevt);
-
 	if(m_inspector->m_partial_tracers_pool != NULL)
 	{
 		delete m_inspector->m_partial_tracers_pool;
 	}
 }
 
-void sinsp_parser::init_scapevt(metaevents_state& evt_state, uint16_t evt_type, uint16_t buf_size)
+void sinsp_parser::set_event_parser(uint16_t etype, event_parser_t parser, uint32_t flags, uint8_t enter_params)
 {
-	evt_state.m_piscapevt = (scap_evt*) realloc(evt_state.m_piscapevt, buf_size);
-	evt_state.m_scap_buf_size = buf_size;
-	evt_state.m_piscapevt->type = evt_type;
-	evt_state.m_metaevt.m_pevt = evt_state.m_piscapevt;
+	ASSERT(etype < PPM_EVENT_MAX);
+	ASSERT(enter_params <= g_infotables.m_event_info[etype].nparams);
+	m_event_parsers[etype].m_parser = parser;
+	m_event_parsers[etype].m_flags = flags;
+	m_event_parsers[etype].m_enter_params = enter_params;
 }
 
-void sinsp_parser::init_metaevt(metaevents_state& evt_state, uint16_t evt_type, uint16_t buf_size)
+void sinsp_parser::init_event_parsers()
 {
-	evt_state.m_piscapevt = 0;
-	init_scapevt(evt_state, evt_type, buf_size);
-	evt_state.m_metaevt.m_inspector = m_inspector;
-	evt_state.m_metaevt.m_info = &(g_infotables.m_event_info[PPME_SYSDIGEVENT_X]);
-	evt_state.m_metaevt.m_cpuid = 0;
-	evt_state.m_metaevt.m_evtnum = 0;
-	evt_state.m_metaevt.m_fdinfo = NULL;
+	for(uint32_t j = 0; j < PPM_EVENT_MAX; j++)
+	{
+		m_event_parsers[j].m_parser = NULL;
+		m_event_parsers[j].m_flags = PARSER_NONE;
+		m_event_parsers[j].m_enter_params = 0;
+	}
+
+	//
+	// Enter events that are only stored for their exit event, with the
+	// number of leading parameters that the exit parser reads. The open,
+	// creat, eventfd, chdir, fchdir, shutdown and setpgid exit events
+	// carry everything they need, so their enter events are not stored.
+	//
+	const struct
+	{
+		uint16_t m_etype;
+		uint8_t m_nparams;
+	} stored_enter_events[] =
+	{
+		{PPME_SOCKET_SOCKET_E, 3},		// domain, type, proto
+		{PPME_SYSCALL_OPENAT_E, 3},		// dirfd, name, flags
+		{PPME_SYSCALL_GETRLIMIT_E, 1},		// resource
+		{PPME_SYSCALL_SETRLIMIT_E, 1},		// resource
+		{PPME_SYSCALL_PRLIMIT_E, 2},		// pid, resource
+		{PPME_SOCKET_SENDMSG_E, 3},		// fd, size, tuple
+		{PPME_SYSCALL_SENDFILE_E, 2},		// out_fd, in_fd
+		{PPME_SYSCALL_SETRESUID_E, 2},		// ruid, euid
+		{PPME_SYSCALL_SETRESGID_E, 2},		// rgid, egid
+		{PPME_SYSCALL_SETUID_E, 1},		// uid
+		{PPME_SYSCALL_SETGID_E, 1},		// gid
+		{PPME_SYSCALL_EXECVE_18_E, 1},		// filename
+		{PPME_SYSCALL_EXECVE_19_E, 1},		// filename
+	};
+
+	for(const auto& stored : stored_enter_events)
+	{
+		set_event_parser(stored.m_etype, NULL, PARSER_STORE_ENTER, stored.m_nparams);
+	}
+
+	set_event_parser(PPME_SOCKET_SENDTO_E, &sinsp_parser::parse_sendto_enter, PARSER_STORE_ENTER, 3);	// fd, size, tuple
+	set_event_parser(PPME_SYSCALL_WRITE_E, NULL, PARSER_TRACER_WRITE);
+
+	const uint16_t rw_exit_events[] =
+	{
+		PPME_SYSCALL_READ_X,
+		PPME_SYSCALL_WRITE_X,
+		PPME_SOCKET_RECV_X,
+		PPME_SOCKET_SEND_X,
+		PPME_SOCKET_RECVFROM_X,
+		PPME_SOCKET_RECVMSG_X,
+		PPME_SOCKET_SENDTO_X,
+		PPME_SOCKET_SENDMSG_X,
+		PPME_SYSCALL_READV_X,
+		PPME_SYSCALL_WRITEV_X,
+		PPME_SYSCALL_PREAD_X,
+		PPME_SYSCALL_PWRITE_X,
+		PPME_SYSCALL_PREADV_X,
+		PPME_SYSCALL_PWRITEV_X,
+	};
+
+	for(uint16_t etype : rw_exit_events)
+	{
+		set_event_parser(etype, &sinsp_parser::parse_rw_exit);
+	}
+
+	set_event_parser(PPME_SYSCALL_SENDFILE_X, &sinsp_parser::parse_sendfile_exit);
+
+	set_event_parser(PPME_SYSCALL_OPEN_X, &sinsp_parser::parse_open_openat_creat_exit);
+	set_event_parser(PPME_SYSCALL_CREAT_X, &sinsp_parser::parse_open_openat_creat_exit);
+	set_event_parser(PPME_SYSCALL_OPENAT_X, &sinsp_parser::parse_open_openat_creat_exit);
+	set_event_parser(PPME_SYSCALL_OPENAT_2_X, &sinsp_parser::parse_open_openat_creat_exit);
+
+	set_event_parser(PPME_SYSCALL_SELECT_E, &sinsp_parser::parse_select_poll_epollwait_enter);
+	set_event_parser(PPME_SYSCALL_POLL_E, &sinsp_parser::parse_select_poll_epollwait_enter);
+	set_event_parser(PPME_SYSCALL_PPOLL_E, &sinsp_parser::parse_select_poll_epollwait_enter);
+	set_event_parser(PPME_SYSCALL_EPOLLWAIT_E, &sinsp_parser::parse_select_poll_epollwait_enter);
+
+	const uint16_t clone_exit_events[] =
+	{
+		PPME_SYSCALL_CLONE_11_X,
+		PPME_SYSCALL_CLONE_16_X,
+		PPME_SYSCALL_CLONE_17_X,
+		PPME_SYSCALL_CLONE_20_X,
+		PPME_SYSCALL_FORK_X,
+		PPME_SYSCALL_FORK_17_X,
+		PPME_SYSCALL_FORK_20_X,
+		PPME_SYSCALL_VFORK_X,
+		PPME_SYSCALL_VFORK_17_X,
+		PPME_SYSCALL_VFORK_20_X,
+	};
+
+	for(uint16_t etype : clone_exit_events)
+	{
+		set_event_parser(etype, &sinsp_parser::parse_clone_exit);
+	}
+
+	const uint16_t execve_exit_events[] =
+	{
+		PPME_SYSCALL_EXECVE_8_X,
+		PPME_SYSCALL_EXECVE_13_X,
+		PPME_SYSCALL_EXECVE_14_X,
+		PPME_SYSCALL_EXECVE_15_X,
+		PPME_SYSCALL_EXECVE_16_X,
+		PPME_SYSCALL_EXECVE_17_X,
+		PPME_SYSCALL_EXECVE_18_X,
+		PPME_SYSCALL_EXECVE_19_X,
+	};
+
+	for(uint16_t etype : execve_exit_events)
+	{
+		set_event_parser(etype, &sinsp_parser::parse_execve_exit);
+	}
+
+	set_event_parser(PPME_PROCEXIT_E, &sinsp_parser::parse_thread_exit);
+	set_event_parser(PPME_PROCEXIT_1_E, &sinsp_parser::parse_thread_exit);
+	set_event_parser(PPME_SYSCALL_PIPE_X, &sinsp_parser::parse_pipe_exit);
+
+	set_event_parser(PPME_SOCKET_SOCKET_X, &sinsp_parser::parse_socket_exit);
+	set_event_parser(PPME_SOCKET_BIND_X, &sinsp_parser::parse_bind_exit);
+	set_event_parser(PPME_SOCKET_CONNECT_E, &sinsp_parser::parse_connect_enter);
+	set_event_parser(PPME_SOCKET_CONNECT_X, &sinsp_parser::parse_connect_exit);
+	set_event_parser(PPME_SOCKET_ACCEPT_X, &sinsp_parser::parse_accept_exit);
+	set_event_parser(PPME_SOCKET_ACCEPT_5_X, &sinsp_parser::parse_accept_exit);
+	set_event_parser(PPME_SOCKET_ACCEPT4_X, &sinsp_parser::parse_accept_exit);
+	set_event_parser(PPME_SOCKET_ACCEPT4_5_X, &sinsp_parser::parse_accept_exit);
+	set_event_parser(PPME_SYSCALL_CLOSE_E, &sinsp_parser::parse_close_enter);
+	set_event_parser(PPME_SYSCALL_CLOSE_X, &sinsp_parser::parse_close_exit);
+	// only F_DUPFD enter events are stored, to pair them with the exit
+	set_event_parser(PPME_SYSCALL_FCNTL_E, &sinsp_parser::parse_fcntl_enter);
+	set_event_parser(PPME_SYSCALL_FCNTL_X, &sinsp_parser::parse_fcntl_exit);
+	set_event_parser(PPME_SYSCALL_EVENTFD_X, &sinsp_parser::parse_eventfd_exit);
+	set_event_parser(PPME_SYSCALL_CHDIR_X, &sinsp_parser::parse_chdir_exit);
+	set_event_parser(PPME_SYSCALL_FCHDIR_X, &sinsp_parser::parse_fchdir_exit);
+	set_event_parser(PPME_SYSCALL_GETCWD_X, &sinsp_parser::parse_getcwd_exit);
+	set_event_parser(PPME_SOCKET_SHUTDOWN_X, &sinsp_parser::parse_shutdown_exit);
+	set_event_parser(PPME_SYSCALL_DUP_X, &sinsp_parser::parse_dup_exit);
+	set_event_parser(PPME_SYSCALL_SIGNALFD_X, &sinsp_parser::parse_signalfd_exit);
+	set_event_parser(PPME_SYSCALL_TIMERFD_CREATE_X, &sinsp_parser::parse_timerfd_create_exit);
+	set_event_parser(PPME_SYSCALL_INOTIFY_INIT_X, &sinsp_parser::parse_inotify_init_exit);
+	set_event_parser(PPME_SYSCALL_GETRLIMIT_X, &sinsp_parser::parse_getrlimit_setrlimit_exit);
+	set_event_parser(PPME_SYSCALL_SETRLIMIT_X, &sinsp_parser::parse_getrlimit_setrlimit_exit);
+	set_event_parser(PPME_SYSCALL_PRLIMIT_X, &sinsp_parser::parse_prlimit_exit);
+	set_event_parser(PPME_SOCKET_SOCKETPAIR_X, &sinsp_parser::parse_socketpair_exit);
+	set_event_parser(PPME_SCHEDSWITCH_1_E, &sinsp_parser::parse_context_switch);
+	set_event_parser(PPME_SCHEDSWITCH_6_E, &sinsp_parser::parse_context_switch);
+	set_event_parser(PPME_SYSCALL_BRK_4_X, &sinsp_parser::parse_brk_munmap_mmap_exit);
+	set_event_parser(PPME_SYSCALL_MMAP_X, &sinsp_parser::parse_brk_munmap_mmap_exit);
+	set_event_parser(PPME_SYSCALL_MMAP2_X, &sinsp_parser::parse_brk_munmap_mmap_exit);
+	set_event_parser(PPME_SYSCALL_MUNMAP_X, &sinsp_parser::parse_brk_munmap_mmap_exit);
+	set_event_parser(PPME_SYSCALL_SETRESUID_X, &sinsp_parser::parse_setresuid_exit);
+	set_event_parser(PPME_SYSCALL_SETRESGID_X, &sinsp_parser::parse_setresgid_exit);
+	set_event_parser(PPME_SYSCALL_SETUID_X, &sinsp_parser::parse_setuid_exit);
+	set_event_parser(PPME_SYSCALL_SETGID_X, &sinsp_parser::parse_setgid_exit);
+	set_event_parser(PPME_CONTAINER_E, &sinsp_parser::parse_container_evt); // deprecated, only here for backwards compatibility
+	set_event_parser(PPME_CONTAINER_JSON_E, &sinsp_parser::parse_container_json_evt);
+	set_event_parser(PPME_CPU_HOTPLUG_E, &sinsp_parser::parse_cpu_hotplug_enter);
+#if !defined(CYGWING_AGENT) && !defined(MINIMAL_BUILD)
+	set_event_parser(PPME_K8S_E, &sinsp_parser::parse_k8s_evt);
+	set_event_parser(PPME_MESOS_E, &sinsp_parser::parse_mesos_evt);
+#endif // #if !defined(CYGWING_AGENT) && !defined(MINIMAL_BUILD)
+	set_event_parser(PPME_SYSCALL_CHROOT_X, &sinsp_parser::parse_chroot_exit);
+	set_event_parser(PPME_SYSCALL_SETSID_X, &sinsp_parser::parse_setsid_exit);
+	set_event_parser(PPME_SOCKET_GETSOCKOPT_X, &sinsp_parser::parse_getsockopt_exit);
 }
 
+#ifdef GATHER_INTERNAL_STATS
+//
+// Accounts the cycles spent in process_event() to the event type
+//
+class parser_cost_scope
+{
+public:
+	parser_cost_scope(sinsp_stats& stats, uint16_t etype):
+		m_stats(stats),
+		m_etype(etype),
+		m_start(internal_metrics::stage_timers::now())
+	{
+	}
+
+	~parser_cost_scope()
+	{
+		if(m_etype < PPM_EVENT_MAX)
+		{
+			m_stats.m_n_parsed_evts[m_etype]++;
+			m_stats.m_parser_cycles[m_etype] += internal_metrics::stage_timers::now() - m_start;
+		}
+	}
+
+private:
+	sinsp_stats& m_stats;
+	uint16_t m_etype;
+	uint64_t m_start;
+};
+#endif // GATHER_INTERNAL_STATS
+
 ///////////////////////////////////////////////////////////////////////////////
 // PROCESSING ENTRY POINT
 ///////////////////////////////////////////////////////////////////////////////
@@ -119,6 +304,11 @@ void sinsp_parser::process_event(sinsp_evt *evt)
 	uint16_t etype = evt->m_pevt->type;
 	bool is_live = m_inspector->is_live();
 
+	internal_metrics::scoped_stage_timer stage_timer(internal_metrics::STAGE_PARSE);
+#ifdef GATHER_INTERNAL_STATS
+	parser_cost_scope cost_scope(m_inspector->m_stats, etype);
+#endif
+
 	//
 	// Cleanup the event-related state
 	//
@@ -236,238 +426,21 @@ void sinsp_parser::process_event(sinsp_evt *evt)
 	//
 	// Route the event to the proper function
 	//
-	switch(etype)
+	const event_parser& ep = m_event_parsers[etype];
+
+	if(ep.m_parser != NULL)
 	{
-	case PPME_SOCKET_SENDTO_E:
-		if((evt->m_fdinfo == nullptr) && (evt->m_tinfo != nullptr))
-		{
-			infer_sendto_fdinfo(evt);
-		}
-
-		// FALLTHRU
-	case PPME_SYSCALL_OPEN_E:
-	case PPME_SOCKET_SOCKET_E:
-	case PPME_SYSCALL_EVENTFD_E:
-	case PPME_SYSCALL_CHDIR_E:
-	case PPME_SYSCALL_FCHDIR_E:
-	case PPME_SYSCALL_CREAT_E:
-	case PPME_SYSCALL_OPENAT_E:
-	case PPME_SOCKET_SHUTDOWN_E:
-	case PPME_SYSCALL_GETRLIMIT_E:
-	case PPME_SYSCALL_SETRLIMIT_E:
-	case PPME_SYSCALL_PRLIMIT_E:
-	case PPME_SOCKET_SENDMSG_E:
-	case PPME_SYSCALL_SENDFILE_E:
-	case PPME_SYSCALL_SETRESUID_E:
-	case PPME_SYSCALL_SETRESGID_E:
-	case PPME_SYSCALL_SETUID_E:
-	case PPME_SYSCALL_SETGID_E:
-	case PPME_SYSCALL_EXECVE_18_E:
-	case PPME_SYSCALL_EXECVE_19_E:
-	case PPME_SYSCALL_SETPGID_E:
-		store_event(evt);
-		break;
-	case PPME_SYSCALL_WRITE_E:
-		if(!m_inspector->m_is_dumping && evt->m_tinfo != nullptr)
-		{
-			evt->m_fdinfo = evt->m_tinfo->get_fd(evt->m_tinfo->m_lastevent_fd);
-			if(evt->m_fdinfo)
-			{
-				if(evt->m_fdinfo->m_flags & sinsp_fdinfo_t::FLAGS_IS_TRACER_FD)
-				{
-					evt->m_filtered_out = true;
-					return;
-				}
-			}
-		}
-		break;
-	case PPME_SYSCALL_READ_X:
-	case PPME_SYSCALL_WRITE_X:
-	case PPME_SOCKET_RECV_X:
-	case PPME_SOCKET_SEND_X:
-	case PPME_SOCKET_RECVFROM_X:
-	case PPME_SOCKET_RECVMSG_X:
-	case PPME_SOCKET_SENDTO_X:
-	case PPME_SOCKET_SENDMSG_X:
-	case PPME_SYSCALL_READV_X:
-	case PPME_SYSCALL_WRITEV_X:
-	case PPME_SYSCALL_PREAD_X:
-	case PPME_SYSCALL_PWRITE_X:
-	case PPME_SYSCALL_PREADV_X:
-	case PPME_SYSCALL_PWRITEV_X:
-		parse_rw_exit(evt);
-		break;
-	case PPME_SYSCALL_SENDFILE_X:
-		parse_sendfile_exit(evt);
-		break;
-	case PPME_SYSCALL_OPEN_X:
-	case PPME_SYSCALL_CREAT_X:
-	case PPME_SYSCALL_OPENAT_X:
-	case PPME_SYSCALL_OPENAT_2_X:
-		parse_open_openat_creat_exit(evt);
-		break;
-	case PPME_SYSCALL_SELECT_E:
-	case PPME_SYSCALL_POLL_E:
-	case PPME_SYSCALL_PPOLL_E:
-	case PPME_SYSCALL_EPOLLWAIT_E:
-		parse_select_poll_epollwait_enter(evt);
-		break;
-	case PPME_SYSCALL_CLONE_11_X:
-	case PPME_SYSCALL_CLONE_16_X:
-	case PPME_SYSCALL_CLONE_17_X:
-	case PPME_SYSCALL_CLONE_20_X:
-	case PPME_SYSCALL_FORK_X:
-	case PPME_SYSCALL_FORK_17_X:
-	case PPME_SYSCALL_FORK_20_X:
-	case PPME_SYSCALL_VFORK_X:
-	case PPME_SYSCALL_VFORK_17_X:
-	case PPME_SYSCALL_VFORK_20_X:
-		parse_clone_exit(evt);
-		break;
-	case PPME_SYSCALL_EXECVE_8_X:
-	case PPME_SYSCALL_EXECVE_13_X:
-	case PPME_SYSCALL_EXECVE_14_X:
-	case PPME_SYSCALL_EXECVE_15_X:
-	case PPME_SYSCALL_EXECVE_16_X:
-	case PPME_SYSCALL_EXECVE_17_X:
-	case PPME_SYSCALL_EXECVE_18_X:
-	case PPME_SYSCALL_EXECVE_19_X:
-		parse_execve_exit(evt);
-		break;
-	case PPME_PROCEXIT_E:
-	case PPME_PROCEXIT_1_E:
-		parse_thread_exit(evt);
-		break;
-	case PPME_SYSCALL_PIPE_X:
-		parse_pipe_exit(evt);
-		break;
+		(this->*ep.m_parser)(evt);
+	}
 
-	case PPME_SOCKET_SOCKET_X:
-		parse_socket_exit(evt);
-		break;
-	case PPME_SOCKET_BIND_X:
-		parse_bind_exit(evt);
-		break;
-	case PPME_SOCKET_CONNECT_E:
-		parse_connect_enter(evt);
-		break;
-	case PPME_SOCKET_CONNECT_X:
-		parse_connect_exit(evt);
-		break;
-	case PPME_SOCKET_ACCEPT_X:
-	case PPME_SOCKET_ACCEPT_5_X:
-	case PPME_SOCKET_ACCEPT4_X:
-	case PPME_SOCKET_ACCEPT4_5_X:
-		parse_accept_exit(evt);
-		break;
-	case PPME_SYSCALL_CLOSE_E:
-		parse_close_enter(evt);
-		break;
-	case PPME_SYSCALL_CLOSE_X:
-		parse_close_exit(evt);
-		break;
-	case PPME_SYSCALL_FCNTL_E:
-		parse_fcntl_enter(evt);
-		break;
-	case PPME_SYSCALL_FCNTL_X:
-		parse_fcntl_exit(evt);
-		break;
-	case PPME_SYSCALL_EVENTFD_X :
-		parse_eventfd_exit(evt);
-		break;
-	case PPME_SYSCALL_CHDIR_X:
-		parse_chdir_exit(evt);
-		break;
-	case PPME_SYSCALL_FCHDIR_X:
-		parse_fchdir_exit(evt);
-		break;
-	case PPME_SYSCALL_GETCWD_X:
-		parse_getcwd_exit(evt);
-		break;
-	case PPME_SOCKET_SHUTDOWN_X:
-		parse_shutdown_exit(evt);
-		break;
-	case PPME_SYSCALL_DUP_X:
-		parse_dup_exit(evt);
-		break;
-	case PPME_SYSCALL_SIGNALFD_X:
-		parse_signalfd_exit(evt);
-		break;
-	case PPME_SYSCALL_TIMERFD_CREATE_X:
-		parse_timerfd_create_exit(evt);
-		break;
-	case PPME_SYSCALL_INOTIFY_INIT_X:
-		parse_inotify_init_exit(evt);
-		break;
-	case PPME_SYSCALL_GETRLIMIT_X:
-	case PPME_SYSCALL_SETRLIMIT_X:
-		parse_getrlimit_setrlimit_exit(evt);
-		break;
-	case PPME_SYSCALL_PRLIMIT_X:
-		parse_prlimit_exit(evt);
-		break;
-	case PPME_SOCKET_SOCKETPAIR_X:
-		parse_socketpair_exit(evt);
-		break;
-	case PPME_SCHEDSWITCH_1_E:
-	case PPME_SCHEDSWITCH_6_E:
-		parse_context_switch(evt);
-		break;
-	case PPME_SYSCALL_BRK_4_X:
-	case PPME_SYSCALL_MMAP_X:
-	case PPME_SYSCALL_MMAP2_X:
-	case PPME_SYSCALL_MUNMAP_X:
-		parse_brk_munmap_mmap_exit(evt);
-		break;
-	case PPME_SYSCALL_SETRESUID_X:
-		parse_setresuid_exit(evt);
-		break;
-	case PPME_SYSCALL_SETRESGID_X:
-		parse_setresgid_exit(evt);
-		break;
-	case PPME_SYSCALL_SETUID_X:
-		parse_setuid_exit(evt);
-		break;
-	case PPME_SYSCALL_SETGID_X:
-		parse_setgid_exit(evt);
-		break;
-	case PPME_CONTAINER_E:
-		parse_container_evt(evt); // deprecated, only here for backwards compatibility
-		break;
-	case PPME_CONTAINER_JSON_E:
-		parse_container_json_evt(evt);
-		break;
-	case PPME_CPU_HOTPLUG_E:
-		parse_cpu_hotplug_enter(evt);
-		break;
-#if !defined(CYGWING_AGENT) && !defined(MINIMAL_BUILD)
-	case PPME_K8S_E:
-		if(!m_inspector->is_live())
-		{
-			parse_k8s_evt(evt);
-		}
-		break;
-	case PPME_MESOS_E:
-		if(!m_inspector->is_live())
-		{
-			parse_mesos_evt(evt);
-		}
-		break;
-#endif // #if !defined(CYGWING_AGENT) && !defined(MINIMAL_BUILD)
-	case PPME_SYSCALL_CHROOT_X:
-		parse_chroot_exit(evt);
-		break;
-	case PPME_SYSCALL_SETSID_X:
-		parse_setsid_exit(evt);
-		break;
-	case PPME_SOCKET_GETSOCKOPT_X:
-		if(evt->get_num_params() > 0)
-		{
-			parse_getsockopt_exit(evt);
-		}
-		break;
-	default:
-		break;
+	if(ep.m_flags & PARSER_STORE_ENTER)
+	{
+		store_event(evt);
+	}
+	else if((ep.m_flags & PARSER_TRACER_WRITE) && is_tracer_write(evt))
+	{
+		evt->m_filtered_out = true;
+		return;
 	}
 
 	//
@@ -522,6 +495,21 @@ void sinsp_parser::event_cleanup(sinsp_evt *evt)
 // HELPERS
 ///////////////////////////////////////////////////////////////////////////////
 
+//
+// Whether a write enter event writes to a tracer fd, in which case it's
+// not returned to the user. Only the exit carries the tracer.
+//
+bool sinsp_parser::is_tracer_write(sinsp_evt *evt)
+{
+	if(m_inspector->m_is_dumping || evt->m_tinfo == nullptr)
+	{
+		return false;
+	}
+
+	evt->m_fdinfo = evt->m_tinfo->get_fd(evt->m_tinfo->m_lastevent_fd);
+	return evt->m_fdinfo != NULL && (evt->m_fdinfo->m_flags & sinsp_fdinfo_t::FLAGS_IS_TRACER_FD);
+}
+
 //
 // Called before starting the parsing.
 // Returns false in case of issues resetting the state.
@@ -714,11 +702,7 @@ bool sinsp_parser::reset(sinsp_evt *evt)
 			  evt->m_info->params[0].name[1] == 'd' &&
 			  evt->m_info->params[0].name[2] == '\0')))
 		{
-			sinsp_evt_param *parinfo;
-
-			parinfo = evt->get_param(0);
-			ASSERT(parinfo->m_len == sizeof(int64_t));
-			int64_t res = *(int64_t *)parinfo->m_val;
+			int64_t res = evt->get_param_as<int64_t>(0);
 
 			if(res < 0)
 			{
@@ -786,13 +770,32 @@ void sinsp_parser::store_event(sinsp_evt *evt)
 		return;
 	}
 
-	uint32_t elen;
+	//
+	// Only the parameters read by the exit parser are kept: the stored
+	// event is the header and the first m_enter_params parameters of the
+	// enter event, which is still a well formed event for sinsp_evt
+	//
+	scap_evt* pevt = evt->m_pevt;
+	uint32_t nparams = m_event_parsers[pevt->type].m_enter_params;
+	if(nparams > pevt->nparams)
+	{
+		nparams = pevt->nparams;
+	}
+
+	const uint16_t* lens = (uint16_t*)((char*)pevt + sizeof(struct ppm_evt_hdr));
+	const char* vals = (char*)lens + pevt->nparams * sizeof(uint16_t);
+	uint32_t valslen = 0;
+	for(uint32_t j = 0; j < nparams; j++)
+	{
+		valslen += lens[j];
+	}
+
+	uint32_t lenslen = nparams * sizeof(uint16_t);
+	uint32_t elen = sizeof(struct ppm_evt_hdr) + lenslen + valslen;
 
 	//
 	// Make sure the event data is going to fit
 	//
-	elen = scap_event_getlen(evt->m_pevt);
-
 	if(elen > SP_EVT_BUF_SIZE)
 	{
 		ASSERT(false);
@@ -807,11 +810,18 @@ void sinsp_parser::store_event(sinsp_evt *evt)
 	{
 		tinfo->m_lastevent_data = reserve_event_buffer();
 	}
-	memcpy(tinfo->m_lastevent_data, evt->m_pevt, elen);
+
+	uint8_t* dest = tinfo->m_lastevent_data;
+	memcpy(dest, pevt, sizeof(struct ppm_evt_hdr));
+	((scap_evt*)dest)->len = elen;
+	((scap_evt*)dest)->nparams = nparams;
+	memcpy(dest + sizeof(struct ppm_evt_hdr), lens, lenslen);
+	memcpy(dest + sizeof(struct ppm_evt_hdr) + lenslen, vals, valslen);
 	tinfo->m_lastevent_cpuid = evt->get_cpuid();
 
 #ifdef GATHER_INTERNAL_STATS
 	m_inspector->m_stats.m_n_stored_evts++;
+	m_inspector->m_stats.m_n_stored_bytes += elen;
 #endif
 }
 
@@ -896,6 +906,9 @@ void sinsp_parser::register_event_callback(sinsp_pd_callback_type etype, sinsp_p
 	case CT_CONNECT:
 		m_connect_callbacks.push_back(dec);
 		break;
+	case CT_ACCEPT:
+		m_accept_callbacks.push_back(dec);
+		break;
 	default:
 		ASSERT(false);
 		break;
@@ -923,9 +936,7 @@ void sinsp_parser::parse_clone_exit(sinsp_evt *evt)
 	//
 	// Validate the return value and get the child tid
 	//
-	parinfo = evt->get_param(0);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	childtid = *(int64_t *)parinfo->m_val;
+	childtid = evt->get_param_as<int64_t>(0);
 
 	switch(evt->get_type())
 	{
@@ -977,13 +988,9 @@ void sinsp_parser::parse_clone_exit(sinsp_evt *evt)
 	case PPME_SYSCALL_CLONE_20_X:
 	case PPME_SYSCALL_FORK_20_X:
 	case PPME_SYSCALL_VFORK_20_X:
-		parinfo = evt->get_param(18);
-		ASSERT(parinfo->m_len == sizeof(int64_t));
-		vtid = *(int64_t *)parinfo->m_val;
+		vtid = evt->get_param_as<int64_t>(18);
 
-		parinfo = evt->get_param(19);
-		ASSERT(parinfo->m_len == sizeof(int64_t));
-		vpid = *(int64_t *)parinfo->m_val;
+		vpid = evt->get_param_as<int64_t>(19);
 		break;
 	default:
 		ASSERT(false);
@@ -1025,18 +1032,14 @@ void sinsp_parser::parse_clone_exit(sinsp_evt *evt)
 			//
 			// This is a thread, the parent tid is the pid
 			//
-			parinfo = evt->get_param(4);
-			ASSERT(parinfo->m_len == sizeof(int64_t));
-			parenttid = *(int64_t *)parinfo->m_val;
+			parenttid = evt->get_param_as<int64_t>(4);
 		}
 		else
 		{
 			//
 			// This is not a thread, the parent tid is ptid
 			//
-			parinfo = evt->get_param(5);
-			ASSERT(parinfo->m_len == sizeof(int64_t));
-			parenttid = *(int64_t *)parinfo->m_val;
+			parenttid = evt->get_param_as<int64_t>(5);
 		}
 
 		// Validate that the child thread info has actually been created.
@@ -1268,9 +1271,7 @@ void sinsp_parser::parse_clone_exit(sinsp_evt *evt)
 	}
 
 	// Copy the pid
-	parinfo = evt->get_param(4);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	tinfo->m_pid = *(int64_t *)parinfo->m_val;
+	tinfo->m_pid = evt->get_param_as<int64_t>(4);
 
 	// Get the flags, and check if this is a thread or a new thread
 	tinfo->m_flags = flags;
@@ -1375,9 +1376,7 @@ void sinsp_parser::parse_clone_exit(sinsp_evt *evt)
 	tinfo->set_args(parinfo->m_val, parinfo->m_len);
 
 	// Copy the fdlimit
-	parinfo = evt->get_param(7);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	tinfo->m_fdlimit = *(int64_t *)parinfo->m_val;
+	tinfo->m_fdlimit = evt->get_param_as<int64_t>(7);
 
 	switch(etype)
 	{
@@ -1393,29 +1392,19 @@ void sinsp_parser::parse_clone_exit(sinsp_evt *evt)
 	case PPME_SYSCALL_VFORK_17_X:
 	case PPME_SYSCALL_VFORK_20_X:
 		// Get the pgflt_maj
-		parinfo = evt->get_param(8);
-		ASSERT(parinfo->m_len == sizeof(uint64_t));
-		tinfo->m_pfmajor = *(uint64_t *)parinfo->m_val;
+		tinfo->m_pfmajor = evt->get_param_as<uint64_t>(8);
 
 		// Get the pgflt_min
-		parinfo = evt->get_param(9);
-		ASSERT(parinfo->m_len == sizeof(uint64_t));
-		tinfo->m_pfminor = *(uint64_t *)parinfo->m_val;
+		tinfo->m_pfminor = evt->get_param_as<uint64_t>(9);
 
 		// Get the vm_size
-		parinfo = evt->get_param(10);
-		ASSERT(parinfo->m_len == sizeof(uint32_t));
-		tinfo->m_vmsize_kb = *(uint32_t *)parinfo->m_val;
+		tinfo->m_vmsize_kb = evt->get_param_as<uint32_t>(10);
 
 		// Get the vm_rss
-		parinfo = evt->get_param(11);
-		ASSERT(parinfo->m_len == sizeof(uint32_t));
-		tinfo->m_vmrss_kb = *(uint32_t *)parinfo->m_val;
+		tinfo->m_vmrss_kb = evt->get_param_as<uint32_t>(11);
 
 		// Get the vm_swap
-		parinfo = evt->get_param(12);
-		ASSERT(parinfo->m_len == sizeof(uint32_t));
-		tinfo->m_vmswap_kb = *(uint32_t *)parinfo->m_val;
+		tinfo->m_vmswap_kb = evt->get_param_as<uint32_t>(12);
 		break;
 	default:
 		ASSERT(false);
@@ -1558,9 +1547,7 @@ void sinsp_parser::parse_execve_exit(sinsp_evt *evt)
 	sinsp_evt *enter_evt = &m_tmp_evt;
 
 	// Validate the return value
-	parinfo = evt->get_param(0);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	retval = *(int64_t *)parinfo->m_val;
+	retval = evt->get_param_as<int64_t>(0);
 
 	if(retval < 0)
 	{
@@ -1612,9 +1599,7 @@ void sinsp_parser::parse_execve_exit(sinsp_evt *evt)
 	evt->m_tinfo->set_args(parinfo->m_val, parinfo->m_len);
 
 	// Get the pid
-	parinfo = evt->get_param(4);
-	ASSERT(parinfo->m_len == sizeof(uint64_t));
-	evt->m_tinfo->m_pid = *(uint64_t *)parinfo->m_val;
+	evt->m_tinfo->m_pid = evt->get_param_as<uint64_t>(4);
 
 	//
 	// In case this thread is a fake entry,
@@ -1623,15 +1608,11 @@ void sinsp_parser::parse_execve_exit(sinsp_evt *evt)
 	//
 	if(evt->m_tinfo->m_ptid == -1)
 	{
-		parinfo = evt->get_param(5);
-		ASSERT(parinfo->m_len == sizeof(uint64_t));
-		evt->m_tinfo->m_ptid = *(uint64_t *)parinfo->m_val;
+		evt->m_tinfo->m_ptid = evt->get_param_as<uint64_t>(5);
 	}
 
 	// Get the fdlimit
-	parinfo = evt->get_param(7);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	evt->m_tinfo->m_fdlimit = *(int64_t *)parinfo->m_val;
+	evt->m_tinfo->m_fdlimit = evt->get_param_as<int64_t>(7);
 
 	switch(etype)
 	{
@@ -1645,29 +1626,19 @@ void sinsp_parser::parse_execve_exit(sinsp_evt *evt)
 	case PPME_SYSCALL_EXECVE_18_X:
 	case PPME_SYSCALL_EXECVE_19_X:
 		// Get the pgflt_maj
-		parinfo = evt->get_param(8);
-		ASSERT(parinfo->m_len == sizeof(uint64_t));
-		evt->m_tinfo->m_pfmajor = *(uint64_t *)parinfo->m_val;
+		evt->m_tinfo->m_pfmajor = evt->get_param_as<uint64_t>(8);
 
 		// Get the pgflt_min
-		parinfo = evt->get_param(9);
-		ASSERT(parinfo->m_len == sizeof(uint64_t));
-		evt->m_tinfo->m_pfminor = *(uint64_t *)parinfo->m_val;
+		evt->m_tinfo->m_pfminor = evt->get_param_as<uint64_t>(9);
 
 		// Get the vm_size
-		parinfo = evt->get_param(10);
-		ASSERT(parinfo->m_len == sizeof(uint32_t));
-		evt->m_tinfo->m_vmsize_kb = *(uint32_t *)parinfo->m_val;
+		evt->m_tinfo->m_vmsize_kb = evt->get_param_as<uint32_t>(10);
 
 		// Get the vm_rss
-		parinfo = evt->get_param(11);
-		ASSERT(parinfo->m_len == sizeof(uint32_t));
-		evt->m_tinfo->m_vmrss_kb = *(uint32_t *)parinfo->m_val;
+		evt->m_tinfo->m_vmrss_kb = evt->get_param_as<uint32_t>(11);
 
 		// Get the vm_swap
-		parinfo = evt->get_param(12);
-		ASSERT(parinfo->m_len == sizeof(uint32_t));
-		evt->m_tinfo->m_vmswap_kb = *(uint32_t *)parinfo->m_val;
+		evt->m_tinfo->m_vmswap_kb = evt->get_param_as<uint32_t>(12);
 		break;
 	default:
 		ASSERT(false);
@@ -1730,9 +1701,7 @@ void sinsp_parser::parse_execve_exit(sinsp_evt *evt)
 	case PPME_SYSCALL_EXECVE_18_X:
 	case PPME_SYSCALL_EXECVE_19_X:
 		// Get the tty
-		parinfo = evt->get_param(16);
-		ASSERT(parinfo->m_len == sizeof(int32_t));
-		evt->m_tinfo->m_tty = *(int32_t *) parinfo->m_val;
+		evt->m_tinfo->m_tty = evt->get_param_as<int32_t>(16);
 		break;
 	default:
 		ASSERT(false);
@@ -1783,9 +1752,7 @@ void sinsp_parser::parse_execve_exit(sinsp_evt *evt)
 		break;
 	case PPME_SYSCALL_EXECVE_19_X:
 		// Get the vpgid
-		parinfo = evt->get_param(17);
-		ASSERT(parinfo->m_len == sizeof(int64_t));
-		evt->m_tinfo->m_vpgid = *(int64_t *) parinfo->m_val;
+		evt->m_tinfo->m_vpgid = evt->get_param_as<int64_t>(17);
 		break;
 	default:
 		ASSERT(false);
@@ -1805,9 +1772,7 @@ void sinsp_parser::parse_execve_exit(sinsp_evt *evt)
 	// Get the loginuid
 	if(evt->get_num_params() > 18)
 	{
-		parinfo = evt->get_param(18);
-		ASSERT(parinfo->m_len == sizeof(uint32_t));
-		evt->m_tinfo->m_loginuid = *(uint32_t *) parinfo->m_val;
+		evt->m_tinfo->m_loginuid = evt->get_param_as<uint32_t>(18);
 	}
 
 	//
@@ -1896,65 +1861,41 @@ void sinsp_parser::parse_openat_dir(sinsp_evt *evt, char* name, int64_t dirfd, O
 	}
 }
 
+#if !defined(CYGWING_AGENT) && !defined(MINIMAL_BUILD)
 template <typename T>
-void schedule_more_evts(sinsp* inspector, void* data, T* client, ppm_event_type evt_type)
+void sinsp_parser::queue_client_events(T* client, uint16_t evt_type)
 {
-#ifdef HAS_CAPTURE
-	ASSERT(data);
-	bool good_event = false;
-	metaevents_state* state = (metaevents_state*)data;
+	std::vector<std::shared_ptr<sinsp_evt>> evts;
+	uint64_t ts = m_inspector->m_lastevent_ts;
 
-	if(state->m_new_group == true)
+	while(client->get_capture_events().size())
 	{
-		state->m_new_group = false;
-		inspector->add_meta_event(&state->m_metaevt);
-		return;
-	}
+		string payload = client->dequeue_capture_event();
+		std::size_t tot_len = sizeof(scap_evt) + sizeof(uint16_t) + payload.size() + 1;
 
-	ASSERT(client);
-	if(!client->get_capture_events().size())
-	{
-		SINSP_STR_ERROR(
-			std::string("An event scheduled but no events available."
-			            "All pending event requests for "
-			            "[") + typeid(T).name() + "] are cancelled.");
-		state->m_new_group = false;
-		state->m_n_additional_events_to_add = 0;
-		inspector->remove_meta_event_callback();
-		return;
-	}
-	string payload = client->dequeue_capture_event();
-	std::size_t tot_len = sizeof(scap_evt) + sizeof(uint16_t) + payload.size() + 1;
+		std::shared_ptr<sinsp_evt> evt = std::make_shared<sinsp_evt>(m_inspector);
+		evt->m_pevt_storage = new char[tot_len];
+		evt->m_pevt = (scap_evt*)evt->m_pevt_storage;
+		evt->m_cpuid = 0;
+		evt->m_evtnum = 0;
 
-	if(tot_len > state->m_scap_buf_size)
-	{
-		sinsp_parser::init_scapevt(*state, evt_type, tot_len);
-	}
+		scap_evt* scapevt = evt->m_pevt;
+		scapevt->ts = ts;
+		scapevt->tid = 0;
+		scapevt->len = (uint32_t)tot_len;
+		scapevt->type = evt_type;
+		scapevt->nparams = 1;
 
-	state->m_piscapevt->len = tot_len;
-	state->m_piscapevt->nparams = 1;
-	uint16_t* plen = (uint16_t*)((char *)state->m_piscapevt + sizeof(struct ppm_evt_hdr));
-	plen[0] = (uint16_t)payload.size() + 1;
-	uint8_t* edata = (uint8_t*)plen + sizeof(uint16_t);
-	memcpy(edata, payload.c_str(), plen[0]);
-	good_event = true;
+		uint16_t* plen = (uint16_t*)((char *)scapevt + sizeof(struct ppm_evt_hdr));
+		plen[0] = (uint16_t)payload.size() + 1;
+		uint8_t* edata = (uint8_t*)plen + sizeof(uint16_t);
+		memcpy(edata, payload.c_str(), plen[0]);
 
-	state->m_n_additional_events_to_add--;
-	if(state->m_n_additional_events_to_add == 0)
-	{
-		inspector->remove_meta_event_callback();
-	}
-	else if(good_event)
-	{
-		inspector->add_meta_event(&state->m_metaevt);
+		evt->init();
+		evts.push_back(evt);
 	}
-#endif // HAS_CAPTURE
-}
 
-#if !defined(CYGWING_AGENT) && !defined(MINIMAL_BUILD)
-void schedule_more_k8s_evts(sinsp* inspector, void* data)
-{
-	schedule_more_evts(inspector, data, inspector->get_k8s_client(), PPME_K8S_E);
+	m_inspector->queue_meta_events(evts);
 }
 
 void sinsp_parser::schedule_k8s_events()
@@ -1966,26 +1907,11 @@ void sinsp_parser::schedule_k8s_events()
 	k8s* k8s_client = 0;
 	if(m_inspector && (k8s_client = m_inspector->m_k8s_client))
 	{
-		int event_count = k8s_client->get_capture_events().size();
-		if(event_count)
-		{
-			m_k8s_metaevents_state.m_piscapevt->tid = 0;
-			m_k8s_metaevents_state.m_piscapevt->ts = m_inspector->m_lastevent_ts;
-			m_k8s_metaevents_state.m_new_group = true;
-			m_k8s_metaevents_state.m_n_additional_events_to_add = event_count;
-			m_inspector->add_meta_event_callback(&schedule_more_k8s_evts, &m_k8s_metaevents_state);
-
-			schedule_more_k8s_evts(m_inspector, &m_k8s_metaevents_state);
-		}
+		queue_client_events(k8s_client, PPME_K8S_E);
 	}
 #endif // HAS_CAPTURE
 }
 
-void schedule_more_mesos_evts(sinsp* inspector, void* data)
-{
-	schedule_more_evts(inspector, data, inspector->get_mesos_client(), PPME_MESOS_E);
-}
-
 void sinsp_parser::schedule_mesos_events()
 {
 #ifdef HAS_CAPTURE
@@ -1995,17 +1921,7 @@ void sinsp_parser::schedule_mesos_events()
 	mesos* mesos_client = 0;
 	if(m_inspector && (mesos_client = m_inspector->m_mesos_client))
 	{
-		int event_count = mesos_client->get_capture_events().size();
-		if(event_count)
-		{
-			m_mesos_metaevents_state.m_piscapevt->tid = 0;
-			m_mesos_metaevents_state.m_piscapevt->ts = m_inspector->m_lastevent_ts;
-			m_mesos_metaevents_state.m_new_group = true;
-			m_mesos_metaevents_state.m_n_additional_events_to_add = event_count;
-			m_inspector->add_meta_event_callback(&schedule_more_mesos_evts, &m_mesos_metaevents_state);
-
-			schedule_more_mesos_evts(m_inspector, &m_mesos_metaevents_state);
-		}
+		queue_client_events(mesos_client, PPME_MESOS_E);
 	}
 #endif // HAS_CAPTURE
 }
@@ -2031,7 +1947,7 @@ void sinsp_parser::parse_open_openat_creat_exit(sinsp_evt *evt)
 	}
 
 
-	if(etype != PPME_SYSCALL_OPENAT_2_X)
+	if(etype == PPME_SYSCALL_OPENAT_X)
 	{
 		//
 		// Load the enter event so we can access its arguments
@@ -2045,9 +1961,7 @@ void sinsp_parser::parse_open_openat_creat_exit(sinsp_evt *evt)
 	//
 	// Check the return value
 	//
-	parinfo = evt->get_param(0);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	fd = *(int64_t *)parinfo->m_val;
+	fd = evt->get_param_as<int64_t>(0);
 
 	//
 	// Parse the parameters, based on the event type
@@ -2058,15 +1972,11 @@ void sinsp_parser::parse_open_openat_creat_exit(sinsp_evt *evt)
 		name = parinfo->m_val;
 		namelen = parinfo->m_len;
 
-		parinfo = evt->get_param(2);
-		ASSERT(parinfo->m_len == sizeof(uint32_t));
-		flags = *(uint32_t *)parinfo->m_val;
+		flags = evt->get_param_as<uint32_t>(2);
 
 		if(evt->get_num_params() > 4)
 		{
-			parinfo = evt->get_param(4);
-			ASSERT(parinfo->m_len == sizeof(uint32_t));
-			dev = *(uint32_t *)parinfo->m_val;
+			dev = evt->get_param_as<uint32_t>(4);
 		}
 
 		sdir = evt->m_tinfo->get_cwd();
@@ -2081,9 +1991,7 @@ void sinsp_parser::parse_open_openat_creat_exit(sinsp_evt *evt)
 
 		if(evt->get_num_params() > 3)
 		{
-			parinfo = evt->get_param(3);
-			ASSERT(parinfo->m_len == sizeof(uint32_t));
-			dev = *(uint32_t *)parinfo->m_val;
+			dev = evt->get_param_as<uint32_t>(3);
 		}
 
 		sdir = evt->m_tinfo->get_cwd();
@@ -2110,13 +2018,9 @@ void sinsp_parser::parse_open_openat_creat_exit(sinsp_evt *evt)
 		name = parinfo->m_val;
 		namelen = parinfo->m_len;
 
-		parinfo = evt->get_param(3);
-		ASSERT(parinfo->m_len == sizeof(uint32_t));
-		flags = *(uint32_t *)parinfo->m_val;
+		flags = evt->get_param_as<uint32_t>(3);
 
-		parinfo = evt->get_param(1);
-		ASSERT(parinfo->m_len == sizeof(int64_t));
-		int64_t dirfd = *(int64_t *)parinfo->m_val;
+		int64_t dirfd = evt->get_param_as<int64_t>(1);
 
 		if(evt->get_num_params() > 5)
 		{
@@ -2368,6 +2272,14 @@ inline void sinsp_parser::infer_sendto_fdinfo(sinsp_evt* const evt)
 	}
 }
 
+void sinsp_parser::parse_sendto_enter(sinsp_evt *evt)
+{
+	if((evt->m_fdinfo == nullptr) && (evt->m_tinfo != nullptr))
+	{
+		infer_sendto_fdinfo(evt);
+	}
+}
+
 void sinsp_parser::parse_socket_exit(sinsp_evt *evt)
 {
 	sinsp_evt_param *parinfo;
@@ -2383,9 +2295,7 @@ void sinsp_parser::parse_socket_exit(sinsp_evt *evt)
 	// parameters in one scan. We don't care too much because we assume that we get here
 	// seldom enough that saving few tens of CPU cycles is not important.
 	//
-	parinfo = evt->get_param(0);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	fd = *(int64_t *)parinfo->m_val;
+	fd = evt->get_param_as<int64_t>(0);
 
 	if(fd < 0)
 	{
@@ -2761,9 +2671,7 @@ void sinsp_parser::parse_accept_exit(sinsp_evt *evt)
 	//
 	// Extract the fd
 	//
-	parinfo = evt->get_param(0);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	fd = *(int64_t *)parinfo->m_val;
+	fd = evt->get_param_as<int64_t>(0);
 
 	if(fd < 0)
 	{
@@ -2861,6 +2769,18 @@ void sinsp_parser::parse_accept_exit(sinsp_evt *evt)
 	// Add the entry to the table
 	//
 	evt->m_fdinfo = evt->m_tinfo->add_fd(fd, &fdi);
+
+	//
+	// Call the protocol decoder callbacks associated to this event
+	//
+	if(evt->m_fdinfo != NULL)
+	{
+		vector<sinsp_protodecoder*>::iterator it;
+		for(it = m_accept_callbacks.begin(); it != m_accept_callbacks.end(); ++it)
+		{
+			(*it)->on_event(evt, CT_ACCEPT);
+		}
+	}
 }
 
 void sinsp_parser::parse_close_enter(sinsp_evt *evt)
@@ -3039,21 +2959,13 @@ void sinsp_parser::parse_socketpair_exit(sinsp_evt *evt)
 		return;
 	}
 
-	parinfo = evt->get_param(1);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	fd1 = *(int64_t *)parinfo->m_val;
+	fd1 = evt->get_param_as<int64_t>(1);
 
-	parinfo = evt->get_param(2);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	fd2 = *(int64_t *)parinfo->m_val;
+	fd2 = evt->get_param_as<int64_t>(2);
 
-	parinfo = evt->get_param(3);
-	ASSERT(parinfo->m_len == sizeof(uint64_t));
-	source_address = *(uint64_t *)parinfo->m_val;
+	source_address = evt->get_param_as<uint64_t>(3);
 
-	parinfo = evt->get_param(4);
-	ASSERT(parinfo->m_len == sizeof(uint64_t));
-	peer_address = *(uint64_t *)parinfo->m_val;
+	peer_address = evt->get_param_as<uint64_t>(4);
 
 	sinsp_fdinfo_t fdi;
 	fdi.m_type = SCAP_FD_UNIX_SOCK;
@@ -3082,17 +2994,11 @@ void sinsp_parser::parse_pipe_exit(sinsp_evt *evt)
 		return;
 	}
 
-	parinfo = evt->get_param(1);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	fd1 = *(int64_t *)parinfo->m_val;
+	fd1 = evt->get_param_as<int64_t>(1);
 
-	parinfo = evt->get_param(2);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	fd2 = *(int64_t *)parinfo->m_val;
+	fd2 = evt->get_param_as<int64_t>(2);
 
-	parinfo = evt->get_param(3);
-	ASSERT(parinfo->m_len == sizeof(uint64_t));
-	ino = *(uint64_t *)parinfo->m_val;
+	ino = evt->get_param_as<uint64_t>(3);
 
 	add_pipe(evt, evt->get_tid(), fd1, ino);
 	add_pipe(evt, evt->get_tid(), fd2, ino);
@@ -3549,9 +3455,7 @@ void sinsp_parser::parse_rw_exit(sinsp_evt *evt)
 	//
 	// Extract the return value
 	//
-	parinfo = evt->get_param(0);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	retval = *(int64_t *)parinfo->m_val;
+	retval = evt->get_param_as<int64_t>(0);
 
 	if(evt->m_fdinfo == NULL)
 	{
@@ -3677,9 +3581,19 @@ void sinsp_parser::parse_rw_exit(sinsp_evt *evt)
 			{
 				vector<sinsp_protodecoder*>* cbacks = &(evt->m_fdinfo->m_callbacks->m_read_callbacks);
 
-				for(auto it = cbacks->begin(); it != cbacks->end(); ++it)
+				for(uint32_t j = 0; j < cbacks->size();)
 				{
-					(*it)->on_read(evt, data, datalen);
+					sinsp_protodecoder* dec = (*cbacks)[j];
+					dec->on_read(evt, data, datalen);
+
+					//
+					// A decoder can unregister itself when it sees
+					// that the FD doesn't carry its protocol
+					//
+					if(j < cbacks->size() && (*cbacks)[j] == dec)
+					{
+						j++;
+					}
 				}
 			}
 		}
@@ -3765,9 +3679,19 @@ void sinsp_parser::parse_rw_exit(sinsp_evt *evt)
 			{
 				vector<sinsp_protodecoder*>* cbacks = &(evt->m_fdinfo->m_callbacks->m_write_callbacks);
 
-				for(auto it = cbacks->begin(); it != cbacks->end(); ++it)
+				for(uint32_t j = 0; j < cbacks->size();)
 				{
-					(*it)->on_write(evt, data, datalen);
+					sinsp_protodecoder* dec = (*cbacks)[j];
+					dec->on_write(evt, data, datalen);
+
+					//
+					// A decoder can unregister itself when it sees
+					// that the FD doesn't carry its protocol
+					//
+					if(j < cbacks->size() && (*cbacks)[j] == dec)
+					{
+						j++;
+					}
 				}
 			}
 		}
@@ -3796,9 +3720,7 @@ void sinsp_parser::parse_sendfile_exit(sinsp_evt *evt)
 	//
 	// Extract the return value
 	//
-	parinfo = evt->get_param(0);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	retval = *(int64_t *)parinfo->m_val;
+	retval = evt->get_param_as<int64_t>(0);
 
 	//
 	// If the operation was successful, validate that the fd exists
@@ -3832,7 +3754,6 @@ void sinsp_parser::parse_sendfile_exit(sinsp_evt *evt)
 
 void sinsp_parser::parse_eventfd_exit(sinsp_evt *evt)
 {
-	sinsp_evt_param *parinfo;
 	int64_t fd;
 	sinsp_fdinfo_t fdi;
 
@@ -3845,9 +3766,7 @@ void sinsp_parser::parse_eventfd_exit(sinsp_evt *evt)
 		return;
 	}
 
-	parinfo = evt->get_param(0);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	fd = *(int64_t *)parinfo->m_val;
+	fd = evt->get_param_as<int64_t>(0);
 
 	if(fd < 0)
 	{
@@ -4001,15 +3920,12 @@ void sinsp_parser::parse_getcwd_exit(sinsp_evt *evt)
 
 void sinsp_parser::parse_shutdown_exit(sinsp_evt *evt)
 {
-	sinsp_evt_param *parinfo;
 	int64_t retval;
 
 	//
 	// Extract the return value
 	//
-	parinfo = evt->get_param(0);
-	ASSERT(parinfo->m_len == sizeof(int64_t));
-	retval = *(int64_t *)parinfo->m_val;
+	retval = evt->get_param_as<int64_t>(0);
 
 	//
 	// If the operation was successful, do the cleanup
@@ -4970,6 +4886,11 @@ int sinsp_parser::get_k8s_version(const std::string& json)
 
 void sinsp_parser::parse_k8s_evt(sinsp_evt *evt)
 {
+	if(m_inspector->is_live())
+	{
+		return;
+	}
+
 	sinsp_evt_param *parinfo = evt->get_param(0);
 	ASSERT(parinfo);
 	ASSERT(parinfo->m_len > 0);
@@ -4996,6 +4917,11 @@ void sinsp_parser::parse_k8s_evt(sinsp_evt *evt)
 
 void sinsp_parser::parse_mesos_evt(sinsp_evt *evt)
 {
+	if(m_inspector->is_live())
+	{
+		return;
+	}
+
 	sinsp_evt_param *parinfo = evt->get_param(0);
 	ASSERT(parinfo);
 	ASSERT(parinfo->m_len > 0);
@@ -5057,7 +4983,7 @@ void sinsp_parser::parse_getsockopt_exit(sinsp_evt *evt)
 	int64_t fd;
 	int8_t level, optname;
 
-	if(!evt->m_tinfo)
+	if(!evt->m_tinfo || evt->get_num_params() == 0)
 	{
 		return;
 	}
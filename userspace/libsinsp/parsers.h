@@ -23,16 +23,6 @@ limitations under the License.
 
 class sinsp_fd_listener;
 
-class metaevents_state
-{
-public:
-	bool m_new_group;
-	uint32_t m_n_additional_events_to_add;
-	sinsp_evt m_metaevt;
-	scap_evt* m_piscapevt;
-	uint32_t m_scap_buf_size;
-};
-
 class sinsp_parser
 {
 public:
@@ -63,6 +53,9 @@ public:
 	sinsp_protodecoder* add_protodecoder(string decoder_name);
 	void register_event_callback(sinsp_pd_callback_type etype, sinsp_protodecoder* dec);
 
+	//
+	// Queue the pending k8s and mesos capture events to the inspector
+	//
 	void schedule_k8s_events();
 	void schedule_mesos_events();
 
@@ -71,25 +64,55 @@ public:
 	//
 	vector<sinsp_protodecoder*> m_open_callbacks;
 	vector<sinsp_protodecoder*> m_connect_callbacks;
+	vector<sinsp_protodecoder*> m_accept_callbacks;
 
 	ppm_event_flags m_drop_event_flags;
 
 	//
-	// Initializers
+	// What the parser of each event type does, see get_event_parser_flags()
 	//
-	static void init_scapevt(metaevents_state& evt_state, uint16_t evt_type, uint16_t buf_size);
+	enum event_parser_flags
+	{
+		PARSER_NONE = 0,
+		PARSER_STORE_ENTER = 1,			// the enter event is stored for the exit event
+		PARSER_TRACER_WRITE = (1 << 1),		// the event is dropped when it writes to a tracer fd
+	};
+
+	inline uint32_t get_event_parser_flags(uint16_t etype) const
+	{
+		return etype < PPM_EVENT_MAX ? m_event_parsers[etype].m_flags : PARSER_NONE;
+	}
 
 private:
 	//
-	// Initializers
+	// Turn the pending capture events of a k8s or mesos client into meta
+	// events of the given type, queued to the inspector in one batch
 	//
-	inline void init_metaevt(metaevents_state& evt_state, uint16_t evt_type, uint16_t buf_size);
+	template<typename T>
+	void queue_client_events(T* client, uint16_t evt_type);
+
+	//
+	// Per event type dispatch, set up once by init_event_parsers() so that
+	// process_event() does a single table lookup instead of a switch
+	//
+	typedef void (sinsp_parser::*event_parser_t)(sinsp_evt* evt);
+
+	struct event_parser
+	{
+		event_parser_t m_parser;
+		uint32_t m_flags;
+		uint8_t m_enter_params;	// leading parameters kept by store_event()
+	};
+
+	void init_event_parsers();
+	void set_event_parser(uint16_t etype, event_parser_t parser, uint32_t flags = PARSER_NONE, uint8_t enter_params = 0);
 
 	//
 	// Helpers
 	//
 	bool reset(sinsp_evt *evt);
 	inline void store_event(sinsp_evt* evt);
+	bool is_tracer_write(sinsp_evt* evt);
 
 	//
 	// Parsers
@@ -131,6 +154,7 @@ private:
 	void parse_setresgid_exit(sinsp_evt* evt);
 	void parse_setuid_exit(sinsp_evt* evt);
 	void parse_setgid_exit(sinsp_evt* evt);
+	void parse_sendto_enter(sinsp_evt* evt);
 	void parse_container_evt(sinsp_evt* evt); // deprecated, only for backward-compatibility
 	void parse_container_json_evt(sinsp_evt *evt);
 	inline uint32_t parse_tracer(sinsp_evt *evt, int64_t retval);
@@ -184,14 +208,16 @@ private:
 	//
 	vector<sinsp_protodecoder*> m_protodecoders;
 
-	metaevents_state m_k8s_metaevents_state;
 	int              m_k8s_capture_version = -1;
-	metaevents_state m_mesos_metaevents_state;
 
 	stack<uint8_t*> m_tmp_events_buffer;
+
+	event_parser m_event_parsers[PPM_EVENT_MAX];
+
 	friend class sinsp_analyzer;
 	friend class sinsp_analyzer_fd_listener;
 	friend class sinsp_protodecoder;
 	friend class sinsp_baseliner;
 	friend class sinsp_container_manager;
+	friend class sinsp_threadinfo;
 };
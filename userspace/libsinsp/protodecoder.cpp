@@ -87,6 +87,167 @@ void sinsp_protodecoder::unregister_write_callback(sinsp_fdinfo_t* fdinfo)
 	fdinfo->unregister_event_callback(CT_WRITE, this);
 }
 
+bool sinsp_protodecoder::has_read_callback(sinsp_fdinfo_t* fdinfo)
+{
+	if(fdinfo->m_callbacks == NULL)
+	{
+		return false;
+	}
+
+	vector<sinsp_protodecoder*>& cbacks = fdinfo->m_callbacks->m_read_callbacks;
+	return find(cbacks.begin(), cbacks.end(), this) != cbacks.end();
+}
+
+sinsp_protodecoder_fd_state* sinsp_protodecoder::get_fd_state(sinsp_fdinfo_t* fdinfo)
+{
+	if(fdinfo->m_callbacks == NULL)
+	{
+		return NULL;
+	}
+
+	return fdinfo->m_callbacks->get_state(this);
+}
+
+void sinsp_protodecoder::set_fd_state(sinsp_fdinfo_t* fdinfo, sinsp_protodecoder_fd_state* state)
+{
+	if(fdinfo->m_callbacks == NULL)
+	{
+		if(state == NULL)
+		{
+			return;
+		}
+
+		fdinfo->m_callbacks = new fd_callbacks_info();
+	}
+
+	fdinfo->m_callbacks->set_state(this, state);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// sinsp_socket_decoder implementation
+///////////////////////////////////////////////////////////////////////////////
+sinsp_socket_decoder::sinsp_socket_decoder()
+{
+	m_tcp = false;
+	m_udp = false;
+}
+
+void sinsp_socket_decoder::init()
+{
+	register_event_callback(CT_CONNECT);
+	register_event_callback(CT_ACCEPT);
+}
+
+void sinsp_socket_decoder::set_ports(const set<uint16_t>& ports)
+{
+	m_ports = ports;
+}
+
+void sinsp_socket_decoder::on_fd_from_proc(sinsp_fdinfo_t* fdinfo)
+{
+	if(fdinfo == NULL)
+	{
+		ASSERT(false);
+		return;
+	}
+
+	if(accepts_fd(fdinfo))
+	{
+		attach(fdinfo, false);
+	}
+}
+
+void sinsp_socket_decoder::on_event(sinsp_evt* evt, sinsp_pd_callback_type etype)
+{
+	sinsp_fdinfo_t* fdinfo = evt->get_fd_info();
+	if(fdinfo == NULL)
+	{
+		return;
+	}
+
+	switch(etype)
+	{
+	case CT_ACCEPT:
+		if(accepts_fd(fdinfo))
+		{
+			attach(fdinfo, true);
+		}
+		break;
+	case CT_CONNECT:
+	case CT_TUPLE_CHANGE:
+		//
+		// UDP sockets can be connected again, or send to a different
+		// address, so this can also be the end of a stream we decode
+		//
+		if(accepts_fd(fdinfo))
+		{
+			attach(fdinfo, true);
+		}
+		else if(has_read_callback(fdinfo))
+		{
+			detach(fdinfo);
+		}
+		break;
+	default:
+		ASSERT(false);
+		break;
+	}
+}
+
+bool sinsp_socket_decoder::accepts_fd(sinsp_fdinfo_t* fdinfo)
+{
+	if(fdinfo->m_type != SCAP_FD_IPV4_SOCK && fdinfo->m_type != SCAP_FD_IPV6_SOCK)
+	{
+		return false;
+	}
+
+	//
+	// Sockets from proc or that didn't transfer data yet may not know
+	// their protocol: the port is all we have
+	//
+	scap_l4_proto l4proto = fdinfo->get_l4proto();
+	if((l4proto == SCAP_L4_TCP && !m_tcp) || (l4proto == SCAP_L4_UDP && !m_udp))
+	{
+		return false;
+	}
+
+	return m_ports.find(fdinfo->get_serverport()) != m_ports.end();
+}
+
+void sinsp_socket_decoder::on_attach(sinsp_fdinfo_t* fdinfo, bool new_connection)
+{
+}
+
+void sinsp_socket_decoder::attach(sinsp_fdinfo_t* fdinfo, bool new_connection)
+{
+	if(has_read_callback(fdinfo))
+	{
+		return;
+	}
+
+	register_read_callback(fdinfo);
+	register_write_callback(fdinfo);
+	on_attach(fdinfo, new_connection);
+}
+
+void sinsp_socket_decoder::detach(sinsp_fdinfo_t* fdinfo)
+{
+	unregister_read_callback(fdinfo);
+	unregister_write_callback(fdinfo);
+	set_fd_state(fdinfo, NULL);
+}
+
+bool sinsp_socket_decoder::is_truncated(sinsp_evt* evt, uint32_t len)
+{
+	return evt->get_param_as<int64_t>(0) > (int64_t)len;
+}
+
+uint32_t sinsp_socket_decoder::get_io_size(sinsp_evt* evt, uint32_t len)
+{
+	int64_t res = evt->get_param_as<int64_t>(0);
+	return res > (int64_t)len ? (uint32_t)res : len;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // sinsp_protodecoder_list implementation
 ///////////////////////////////////////////////////////////////////////////////
@@ -96,6 +257,8 @@ sinsp_protodecoder_list::sinsp_protodecoder_list()
 	// ADD NEW DECODER CLASSES HERE
 	//////////////////////////////////////////////////////////////////////////////
 	add_protodecoder(new sinsp_decoder_syslog());
+	add_protodecoder(new sinsp_decoder_http());
+	add_protodecoder(new sinsp_decoder_dns());
 }
 
 sinsp_protodecoder_list::~sinsp_protodecoder_list()
@@ -327,3 +490,617 @@ bool sinsp_decoder_syslog::get_info_line(char** res)
 	*res = (char*)m_infostr.c_str();
 	return (m_priority != -1);
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// sinsp_decoder_http implementation
+///////////////////////////////////////////////////////////////////////////////
+static const char* http_methods[] =
+{
+	"GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"
+};
+
+//
+// Whether the data can be the beginning of a request or a response, i.e.
+// starts with a method followed by a space or with "HTTP/". Data shorter
+// than that is compared as far as it goes, unless full_match is set.
+//
+static bool http_is_start(const char* data, uint32_t len, bool full_match)
+{
+	if(len == 0 || data[0] < 'A' || data[0] > 'Z')
+	{
+		return false;
+	}
+
+	if(len >= 5 || !full_match)
+	{
+		if(memcmp(data, "HTTP/", min(len, (uint32_t)5)) == 0)
+		{
+			return true;
+		}
+	}
+
+	for(uint32_t j = 0; j < sizeof(http_methods) / sizeof(http_methods[0]); j++)
+	{
+		uint32_t mlen = (uint32_t)strlen(http_methods[j]);
+
+		if(len > mlen)
+		{
+			if(memcmp(data, http_methods[j], mlen) == 0 && data[mlen] == ' ')
+			{
+				return true;
+			}
+		}
+		else if(!full_match && memcmp(data, http_methods[j], len) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+sinsp_decoder_http::sinsp_decoder_http()
+{
+	m_name = "http";
+	m_tcp = true;
+	m_ports = {80, 8000, 8080, 8888};
+	m_is_request = false;
+	m_is_response = false;
+	m_status = 0;
+	m_has_data = false;
+}
+
+sinsp_protodecoder* sinsp_decoder_http::allocate_new()
+{
+	return (sinsp_protodecoder*) new sinsp_decoder_http();
+}
+
+void sinsp_decoder_http::on_attach(sinsp_fdinfo_t* fdinfo, bool new_connection)
+{
+	set_fd_state(fdinfo, new sinsp_http_fd_state(new_connection));
+}
+
+void sinsp_decoder_http::on_read(sinsp_evt* evt, char *data, uint32_t len)
+{
+	on_data(evt, true, data, len);
+}
+
+void sinsp_decoder_http::on_write(sinsp_evt* evt, char *data, uint32_t len)
+{
+	on_data(evt, false, data, len);
+}
+
+void sinsp_decoder_http::on_data(sinsp_evt* evt, bool read, char *data, uint32_t len)
+{
+	sinsp_fdinfo_t* fdinfo = evt->get_fd_info();
+	if(fdinfo == NULL || len == 0)
+	{
+		return;
+	}
+
+	sinsp_http_fd_state* state = (sinsp_http_fd_state*)get_fd_state(fdinfo);
+	if(state == NULL)
+	{
+		//
+		// A copy of an FD we follow, for example inherited by a new
+		// process: we don't know where its stream is
+		//
+		state = new sinsp_http_fd_state(false);
+		set_fd_state(fdinfo, state);
+	}
+
+	bool is_http = decode(read? &state->m_in : &state->m_out, data, len, is_truncated(evt, len));
+
+	if(state->m_probe)
+	{
+		state->m_probe = false;
+
+		//
+		// A new connection that doesn't start like HTTP, for example
+		// TLS on an HTTP port: stop following it
+		//
+		if(!is_http)
+		{
+			detach(fdinfo);
+		}
+	}
+}
+
+bool sinsp_decoder_http::decode(sinsp_http_stream* stream, const char* data, uint32_t len, bool truncated)
+{
+	const char* p = data;
+	const char* end = data + len;
+
+	if(stream->m_line.empty())
+	{
+		if(stream->m_state == sinsp_http_stream::ST_START_LINE)
+		{
+			if(!http_is_start(data, len, false))
+			{
+				//
+				// The body of a message, or not HTTP at all
+				//
+				return false;
+			}
+		}
+		else if(http_is_start(data, len, true))
+		{
+			//
+			// A new message while we were in the headers of the
+			// previous one, whose end we missed
+			//
+			stream->m_state = sinsp_http_stream::ST_START_LINE;
+		}
+	}
+
+	while(p < end)
+	{
+		const char* nl = (const char*)memchr(p, '\n', end - p);
+		if(nl == NULL)
+		{
+			//
+			// The line continues in the next read or write, unless
+			// the data was truncated
+			//
+			if(!truncated)
+			{
+				if(stream->m_line.size() + (end - p) > HTTP_MAX_LINE_LEN)
+				{
+					stream->reset();
+				}
+				else
+				{
+					stream->m_line.append(p, end - p);
+				}
+			}
+			break;
+		}
+
+		const char* line = p;
+		uint32_t linelen = (uint32_t)(nl - p);
+		if(!stream->m_line.empty())
+		{
+			stream->m_line.append(p, linelen);
+			line = stream->m_line.data();
+			linelen = (uint32_t)stream->m_line.size();
+		}
+
+		if(linelen > 0 && line[linelen - 1] == '\r')
+		{
+			linelen--;
+		}
+
+		bool more;
+		if(stream->m_state == sinsp_http_stream::ST_START_LINE)
+		{
+			more = parse_start_line(stream, line, linelen);
+
+			//
+			// Not a start line after all
+			//
+			if(!more && p == data)
+			{
+				stream->m_line.clear();
+				return false;
+			}
+		}
+		else
+		{
+			more = parse_header_line(stream, line, linelen);
+		}
+
+		stream->m_line.clear();
+		p = nl + 1;
+
+		if(!more)
+		{
+			break;
+		}
+	}
+
+	//
+	// The rest of this message wasn't captured: expect a new one next
+	//
+	if(truncated)
+	{
+		stream->reset();
+	}
+
+	return true;
+}
+
+bool sinsp_decoder_http::parse_start_line(sinsp_http_stream* stream, const char* line, uint32_t len)
+{
+	const char* end = line + len;
+	const char* sp = (const char*)memchr(line, ' ', len);
+	if(sp == NULL)
+	{
+		return false;
+	}
+
+	if(len >= 5 && memcmp(line, "HTTP/", 5) == 0)
+	{
+		//
+		// HTTP/1.1 200 OK
+		//
+		const char* st = sp + 1;
+		if(end - st < 3 ||
+			!isdigit((uint8_t)st[0]) || !isdigit((uint8_t)st[1]) || !isdigit((uint8_t)st[2]) ||
+			(end - st > 3 && st[3] != ' '))
+		{
+			return false;
+		}
+
+		m_status = (st[0] - '0') * 100 + (st[1] - '0') * 10 + (st[2] - '0');
+		m_is_response = true;
+	}
+	else
+	{
+		//
+		// GET /index.html HTTP/1.1
+		//
+		const char* url = sp + 1;
+		const char* sp2 = (const char*)memchr(url, ' ', end - url);
+		if(sp2 == NULL || sp2 == url || end - sp2 < 6 || memcmp(sp2 + 1, "HTTP/", 5) != 0)
+		{
+			return false;
+		}
+
+		m_method.assign(line, sp - line);
+		m_url.assign(url, sp2 - url);
+		m_is_request = true;
+	}
+
+	set_has_data();
+	stream->m_state = sinsp_http_stream::ST_HEADERS;
+	return true;
+}
+
+bool sinsp_decoder_http::parse_header_line(sinsp_http_stream* stream, const char* line, uint32_t len)
+{
+	if(len == 0)
+	{
+		//
+		// The end of the headers. The body isn't decoded.
+		//
+		stream->m_state = sinsp_http_stream::ST_START_LINE;
+		return false;
+	}
+
+	if(len > 5 && strncasecmp(line, "host:", 5) == 0)
+	{
+		const char* val = line + 5;
+		const char* end = line + len;
+
+		while(val < end && (*val == ' ' || *val == '\t'))
+		{
+			val++;
+		}
+
+		while(end > val && (end[-1] == ' ' || end[-1] == '\t'))
+		{
+			end--;
+		}
+
+		m_host.assign(val, end - val);
+		set_has_data();
+	}
+
+	return true;
+}
+
+void sinsp_decoder_http::set_has_data()
+{
+	if(!m_has_data)
+	{
+		m_has_data = true;
+		m_inspector->protodecoder_register_reset(this);
+	}
+}
+
+void sinsp_decoder_http::on_reset(sinsp_evt* evt)
+{
+	m_has_data = false;
+	m_is_request = false;
+	m_is_response = false;
+	m_host.clear();
+}
+
+bool sinsp_decoder_http::get_info_line(char** res)
+{
+	if(m_is_request)
+	{
+		m_infostr = "http " + m_method + " " + m_url;
+	}
+	else if(m_is_response)
+	{
+		m_infostr = "http " + to_string(m_status);
+	}
+	else
+	{
+		return false;
+	}
+
+	*res = (char*)m_infostr.c_str();
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// sinsp_decoder_dns implementation
+///////////////////////////////////////////////////////////////////////////////
+sinsp_decoder_dns::sinsp_decoder_dns()
+{
+	m_name = "dns";
+	m_tcp = true;
+	m_udp = true;
+	m_ports = {53};
+	m_is_response = false;
+	m_rcode = 0;
+	m_type = 0;
+	m_has_data = false;
+}
+
+sinsp_protodecoder* sinsp_decoder_dns::allocate_new()
+{
+	return (sinsp_protodecoder*) new sinsp_decoder_dns();
+}
+
+void sinsp_decoder_dns::on_read(sinsp_evt* evt, char *data, uint32_t len)
+{
+	on_data(evt, true, data, len);
+}
+
+void sinsp_decoder_dns::on_write(sinsp_evt* evt, char *data, uint32_t len)
+{
+	on_data(evt, false, data, len);
+}
+
+void sinsp_decoder_dns::on_data(sinsp_evt* evt, bool read, char *data, uint32_t len)
+{
+	sinsp_fdinfo_t* fdinfo = evt->get_fd_info();
+	if(fdinfo == NULL || len == 0)
+	{
+		return;
+	}
+
+	if(fdinfo->get_l4proto() != SCAP_L4_TCP)
+	{
+		decode_message((const uint8_t*)data, len);
+		return;
+	}
+
+	sinsp_dns_fd_state* state = (sinsp_dns_fd_state*)get_fd_state(fdinfo);
+	if(state == NULL)
+	{
+		state = new sinsp_dns_fd_state();
+		set_fd_state(fdinfo, state);
+	}
+
+	decode_tcp(read? &state->m_in : &state->m_out, data, len, get_io_size(evt, len));
+}
+
+bool sinsp_decoder_dns::decode_tcp(sinsp_dns_stream* stream, const char* data, uint32_t len, uint32_t size)
+{
+	string& partial = stream->m_partial;
+	const char* p = data;
+	const char* end = data + len;
+	bool res = false;
+
+	while(p < end)
+	{
+		if(stream->m_skip != 0)
+		{
+			//
+			// The rest of the current message
+			//
+			uint32_t n = min(stream->m_skip, (uint32_t)(end - p));
+			stream->m_skip -= n;
+			p += n;
+			continue;
+		}
+
+		const char* msg = p;
+		uint32_t msglen = (uint32_t)(end - p);
+		uint32_t buffered = (uint32_t)partial.size();
+		if(buffered != 0)
+		{
+			partial.append(p, min(msglen, (uint32_t)DNS_MAX_MESSAGE_PREFIX - buffered));
+			msg = partial.data();
+			msglen = (uint32_t)partial.size();
+		}
+
+		uint32_t total = DNS_MAX_MESSAGE_PREFIX;
+		bool decoded = false;
+		if(msglen >= 2)
+		{
+			uint32_t expected = ((uint8_t)msg[0] << 8) | (uint8_t)msg[1];
+			total = expected + 2;
+			decoded = decode_message((const uint8_t*)msg + 2, min(msglen - 2, expected));
+		}
+
+		if(!decoded && msglen < min(total, (uint32_t)DNS_MAX_MESSAGE_PREFIX))
+		{
+			//
+			// The beginning of the message continues in the next read
+			// or write
+			//
+			if(buffered == 0)
+			{
+				partial.assign(p, end - p);
+			}
+			break;
+		}
+
+		//
+		// Decoded, or never will be: the next message starts after the
+		// end of this one, which can be several reads or writes away
+		//
+		res = res || decoded;
+		partial.clear();
+
+		uint32_t n = total - buffered;
+		if(n > (uint32_t)(end - p))
+		{
+			stream->m_skip = n - (uint32_t)(end - p);
+			break;
+		}
+		p += n;
+	}
+
+	if(size > len)
+	{
+		//
+		// The data that wasn't captured can be skipped if it's part
+		// of the current message. Otherwise, we lost track of where
+		// messages start.
+		//
+		uint32_t lost = size - len;
+
+		if(partial.size() >= 2)
+		{
+			uint32_t total = (((uint8_t)partial[0] << 8) | (uint8_t)partial[1]) + 2;
+			stream->m_skip = total - (uint32_t)partial.size();
+			partial.clear();
+		}
+
+		if(partial.empty() && stream->m_skip >= lost)
+		{
+			stream->m_skip -= lost;
+		}
+		else
+		{
+			stream->reset();
+		}
+	}
+
+	return res;
+}
+
+bool sinsp_decoder_dns::decode_message(const uint8_t* data, uint32_t len)
+{
+	if(len < 12)
+	{
+		return false;
+	}
+
+	uint16_t flags = (data[2] << 8) | data[3];
+	uint16_t qdcount = (data[4] << 8) | data[5];
+	uint16_t opcode = (flags >> 11) & 0x0f;
+
+	//
+	// Only the standard opcodes (query, status, notify, update) carry
+	// the usual question
+	//
+	if(qdcount == 0 || opcode > 5)
+	{
+		return false;
+	}
+
+	const uint8_t* p = data + 12;
+	const uint8_t* end = data + len;
+
+	m_qname.clear();
+	while(true)
+	{
+		if(p >= end)
+		{
+			return false;
+		}
+
+		uint8_t llen = *p++;
+		if(llen == 0)
+		{
+			break;
+		}
+
+		//
+		// Compression pointers aren't used in the first question
+		//
+		if((llen & 0xc0) != 0 || end - p < llen || m_qname.size() + llen + 1 > 255)
+		{
+			return false;
+		}
+
+		if(!m_qname.empty())
+		{
+			m_qname += '.';
+		}
+		m_qname.append((const char*)p, llen);
+		p += llen;
+	}
+
+	if(end - p < 4)
+	{
+		return false;
+	}
+
+	if(m_qname.empty())
+	{
+		m_qname = ".";
+	}
+
+	m_type = (p[0] << 8) | p[1];
+	m_is_response = (flags & 0x8000) != 0;
+	m_rcode = flags & 0x0f;
+
+	if(!m_has_data)
+	{
+		m_has_data = true;
+		m_inspector->protodecoder_register_reset(this);
+	}
+
+	return true;
+}
+
+void sinsp_decoder_dns::on_reset(sinsp_evt* evt)
+{
+	m_has_data = false;
+}
+
+const char* sinsp_decoder_dns::get_type_str()
+{
+	switch(m_type)
+	{
+	case 1:
+		return "A";
+	case 2:
+		return "NS";
+	case 5:
+		return "CNAME";
+	case 6:
+		return "SOA";
+	case 12:
+		return "PTR";
+	case 15:
+		return "MX";
+	case 16:
+		return "TXT";
+	case 28:
+		return "AAAA";
+	case 33:
+		return "SRV";
+	case 65:
+		return "HTTPS";
+	case 255:
+		return "ANY";
+	default:
+		return "<NA>";
+	}
+}
+
+bool sinsp_decoder_dns::get_info_line(char** res)
+{
+	if(!m_has_data)
+	{
+		return false;
+	}
+
+	m_infostr = string("dns ") + (m_is_response? "response " : "query ") + get_type_str() + " " + m_qname;
+	if(m_is_response)
+	{
+		m_infostr += " rcode=" + to_string(m_rcode);
+	}
+
+	*res = (char*)m_infostr.c_str();
+	return true;
+}
@@ -17,6 +17,19 @@ limitations under the License.
 
 #pragma once
 
+///////////////////////////////////////////////////////////////////////////////
+// The state a protocol decoder keeps for an FD, for example the part of a
+// message that was split across reads. Decoders derive from this and store
+// it in the FD with set_fd_state().
+///////////////////////////////////////////////////////////////////////////////
+class sinsp_protodecoder_fd_state
+{
+public:
+	virtual ~sinsp_protodecoder_fd_state()
+	{
+	}
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // The protocol decoder interface
 ///////////////////////////////////////////////////////////////////////////////
@@ -83,6 +96,14 @@ protected:
 
 	void unregister_read_callback(sinsp_fdinfo_t* fdinfo);
 	void unregister_write_callback(sinsp_fdinfo_t* fdinfo);
+	bool has_read_callback(sinsp_fdinfo_t* fdinfo);
+
+	//
+	// The state of this decoder for an FD. The FD owns it: set_fd_state()
+	// deletes the previous one, and the FD deletes it when it's closed.
+	//
+	sinsp_protodecoder_fd_state* get_fd_state(sinsp_fdinfo_t* fdinfo);
+	void set_fd_state(sinsp_fdinfo_t* fdinfo, sinsp_protodecoder_fd_state* state);
 
 	string m_name;
 	sinsp* m_inspector;
@@ -109,10 +130,67 @@ private:
 	vector<sinsp_protodecoder*> m_decoders_list;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// Base class of the decoders of the protocols running on TCP or UDP, like
+// HTTP and DNS. The decoder attaches to the sockets that have one of its
+// server ports, when they are connected, accepted or found in proc, so the
+// reads and writes of all the other FDs don't go through it.
+///////////////////////////////////////////////////////////////////////////////
+class sinsp_socket_decoder : public sinsp_protodecoder
+{
+public:
+	sinsp_socket_decoder();
+	void init();
+	void on_fd_from_proc(sinsp_fdinfo_t* fdinfo);
+	void on_event(sinsp_evt* evt, sinsp_pd_callback_type etype);
+
+	//
+	// The server ports of the sockets to decode. Changing them only
+	// affects the sockets that are connected or accepted afterwards.
+	//
+	void set_ports(const set<uint16_t>& ports);
+	const set<uint16_t>& get_ports()
+	{
+		return m_ports;
+	}
+
+protected:
+	//
+	// Whether to decode this FD. By default, a TCP or UDP socket (as
+	// allowed by m_tcp and m_udp) with one of the server ports.
+	//
+	virtual bool accepts_fd(sinsp_fdinfo_t* fdinfo);
+
+	//
+	// Called when the decoder attaches to an FD. new_connection is true
+	// for sockets connected or accepted during the capture, where the
+	// first data is the beginning of the stream.
+	//
+	virtual void on_attach(sinsp_fdinfo_t* fdinfo, bool new_connection);
+
+	void attach(sinsp_fdinfo_t* fdinfo, bool new_connection);
+	void detach(sinsp_fdinfo_t* fdinfo);
+
+	//
+	// Whether the data of a read or write is only the beginning of what
+	// was transferred, because of the snaplen
+	//
+	static bool is_truncated(sinsp_evt* evt, uint32_t len);
+
+	//
+	// The number of bytes that were transferred by a read or write whose
+	// captured data is len bytes long
+	//
+	static uint32_t get_io_size(sinsp_evt* evt, uint32_t len);
+
+	set<uint16_t> m_ports;
+	bool m_tcp;
+	bool m_udp;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // Decoder classes
-// NOTE: these should be moved to a separate file but, since we have only one
-//       for the moment, we keep it here
+// NOTE: these should be moved to a separate file
 ///////////////////////////////////////////////////////////////////////////////
 class sinsp_decoder_syslog : public sinsp_protodecoder
 {
@@ -140,3 +218,181 @@ private:
 	void decode_message(char *data, uint32_t len, char* pristr, uint32_t pristrlen);
 	string m_infostr;
 };
+
+//
+// One direction of an HTTP connection. Complete lines are parsed in place
+// in the event data; only a line that is split across reads or writes is
+// copied, up to HTTP_MAX_LINE_LEN.
+//
+#define HTTP_MAX_LINE_LEN 2048
+
+class sinsp_http_stream
+{
+public:
+	enum state
+	{
+		ST_START_LINE = 0,
+		ST_HEADERS,
+	};
+
+	sinsp_http_stream():
+		m_state(ST_START_LINE)
+	{
+	}
+
+	void reset()
+	{
+		m_state = ST_START_LINE;
+		m_line.clear();
+	}
+
+	state m_state;
+	string m_line;
+};
+
+class sinsp_http_fd_state : public sinsp_protodecoder_fd_state
+{
+public:
+	sinsp_http_fd_state(bool probe):
+		m_probe(probe)
+	{
+	}
+
+	sinsp_http_stream m_in;
+	sinsp_http_stream m_out;
+
+	//
+	// True until the first data of a new connection, which tells if
+	// the connection is HTTP at all
+	//
+	bool m_probe;
+};
+
+class sinsp_decoder_http : public sinsp_socket_decoder
+{
+public:
+	sinsp_decoder_http();
+	sinsp_protodecoder* allocate_new();
+	void on_read(sinsp_evt* evt, char *data, uint32_t len);
+	void on_write(sinsp_evt* evt, char *data, uint32_t len);
+	void on_reset(sinsp_evt* evt);
+	bool get_info_line(char** res);
+
+	//
+	// Decodes the data read or written in one direction of a connection.
+	// Returns false if the data can't be the beginning of an HTTP
+	// message while one was expected.
+	//
+	bool decode(sinsp_http_stream* stream, const char* data, uint32_t len, bool truncated);
+
+	bool is_data_valid()
+	{
+		return m_has_data;
+	}
+
+	//
+	// The fields of the current event: the start line of a request or
+	// of a response, and the Host header
+	//
+	bool m_is_request;
+	bool m_is_response;
+	string m_method;
+	string m_url;
+	uint32_t m_status;
+	string m_host;
+
+protected:
+	void on_attach(sinsp_fdinfo_t* fdinfo, bool new_connection);
+
+private:
+	void on_data(sinsp_evt* evt, bool read, char *data, uint32_t len);
+	bool parse_start_line(sinsp_http_stream* stream, const char* line, uint32_t len);
+	bool parse_header_line(sinsp_http_stream* stream, const char* line, uint32_t len);
+	void set_has_data();
+
+	bool m_has_data;
+	string m_infostr;
+};
+
+//
+// DNS over UDP, where every read or write is a message, and over TCP, where
+// messages are prefixed by their length and can be split across reads.
+// Only the header and the first question are decoded.
+//
+#define DNS_MAX_MESSAGE_PREFIX 512
+
+//
+// One direction of a DNS over TCP connection
+//
+class sinsp_dns_stream
+{
+public:
+	sinsp_dns_stream():
+		m_skip(0)
+	{
+	}
+
+	void reset()
+	{
+		m_partial.clear();
+		m_skip = 0;
+	}
+
+	// the beginning of the current message, while it's too short to be
+	// decoded
+	string m_partial;
+	// the bytes of the current message that are still to come, after
+	// its beginning was decoded or given up on
+	uint32_t m_skip;
+};
+
+class sinsp_dns_fd_state : public sinsp_protodecoder_fd_state
+{
+public:
+	sinsp_dns_stream m_in;
+	sinsp_dns_stream m_out;
+};
+
+class sinsp_decoder_dns : public sinsp_socket_decoder
+{
+public:
+	sinsp_decoder_dns();
+	sinsp_protodecoder* allocate_new();
+	void on_read(sinsp_evt* evt, char *data, uint32_t len);
+	void on_write(sinsp_evt* evt, char *data, uint32_t len);
+	void on_reset(sinsp_evt* evt);
+	bool get_info_line(char** res);
+
+	//
+	// Decodes a DNS message, without the TCP length prefix.
+	// Returns false if it's not a valid message.
+	//
+	bool decode_message(const uint8_t* data, uint32_t len);
+
+	//
+	// Decodes the data of a TCP stream, buffering the beginning of a
+	// message until its header and question are complete, and skipping
+	// the rest of it. size is the number of bytes that were transferred,
+	// of which only the first len were captured.
+	// Returns true if a message was decoded.
+	//
+	bool decode_tcp(sinsp_dns_stream* stream, const char* data, uint32_t len, uint32_t size);
+
+	bool is_data_valid()
+	{
+		return m_has_data;
+	}
+
+	const char* get_type_str();
+
+	bool m_is_response;
+	uint32_t m_rcode;
+	uint32_t m_type;
+	string m_qname;
+
+private:
+	void on_data(sinsp_evt* evt, bool read, char *data, uint32_t len);
+
+	bool m_has_data;
+	string m_infostr;
+};
@@ -35,6 +35,8 @@ limitations under the License.
 #include "cyclewriter.h"
 #include "protodecoder.h"
 #include "dns_manager.h"
+#include "stage_timers.h"
+#include "tracers.h"
 
 #ifndef CYGWING_AGENT
 #ifndef MINIMAL_BUILD
@@ -78,7 +80,6 @@ sinsp::sinsp(bool static_container, const std::string static_id, const std::stri
 	m_parser = NULL;
 	m_dumper = NULL;
 	m_is_dumping = false;
-	m_metaevt = NULL;
 	m_meinfo.m_piscapevt = NULL;
 	m_network_interfaces = NULL;
 	m_parser = new sinsp_parser(this);
@@ -319,11 +320,7 @@ void sinsp::init()
 	//
 	// Return the tracers to the pool and clear the tracers list
 	//
-	for(auto it = m_partial_tracers_list.begin(); it != m_partial_tracers_list.end(); ++it)
-	{
-		m_partial_tracers_pool->push(*it);
-	}
-	m_partial_tracers_list.clear();
+	sinsp_tracerparser::clear_partial_tracers(this);
 
 	//
 	// If we're reading from file, we try to pre-parse the container events before
@@ -976,7 +973,6 @@ void sinsp::refresh_ifaddr_list()
 	{
 		ASSERT(m_network_interfaces);
 		scap_refresh_iflist(m_h);
-		m_network_interfaces->clear();
 		m_network_interfaces->import_interfaces(scap_get_ifaddr_list(m_h));
 	}
 #endif
@@ -986,7 +982,42 @@ bool should_drop(sinsp_evt *evt, bool* stopped, bool* switched);
 
 void sinsp::add_meta_event(sinsp_evt *metaevt)
 {
-	m_metaevt = metaevt;
+	m_meta_events.set_local(metaevt);
+}
+
+void sinsp::queue_meta_event(std::shared_ptr<sinsp_evt> evt)
+{
+	m_meta_events.push(std::move(evt));
+}
+
+void sinsp::queue_meta_events(std::vector<std::shared_ptr<sinsp_evt>>& evts)
+{
+	m_meta_events.push(evts);
+}
+
+sinsp_evt* sinsp::next_meta_event()
+{
+	//
+	// The local event comes first: the callback may set the next one
+	//
+	sinsp_evt* evt = m_meta_events.pop_local();
+	if(evt != NULL)
+	{
+		if(m_meta_event_callback != NULL)
+		{
+			m_meta_event_callback(this, m_meta_event_callback_data);
+		}
+
+		return evt;
+	}
+
+	evt = m_meta_events.pop();
+	if(evt != NULL && evt->m_pevt->ts < m_lastevent_ts)
+	{
+		evt->m_pevt->ts = m_lastevent_ts;
+	}
+
+	return evt;
 }
 
 void sinsp::add_meta_event_callback(meta_event_callback cback, void* data)
@@ -1126,30 +1157,19 @@ void sinsp::get_procs_cpu_from_driver(uint64_t ts)
 
 int32_t sinsp::next(OUT sinsp_evt **puevt)
 {
+	internal_metrics::scoped_stage_timer stage_timer(internal_metrics::STAGE_NEXT);
 	sinsp_evt* evt;
 	int32_t res;
 
 	//
-	// Check if there are fake cpu events to  events
+	// Check if there are meta events (container, k8s, mesos, fake cpu
+	// events...) to return before the next event of the capture
 	//
-	if(m_metaevt != NULL)
+	evt = m_meta_events.pending() ? next_meta_event() : NULL;
+	if(evt != NULL)
 	{
 		res = SCAP_SUCCESS;
-		evt = m_metaevt;
-		m_metaevt = NULL;
-
-		if(m_meta_event_callback != NULL)
-		{
-			m_meta_event_callback(this, m_meta_event_callback_data);
-		}
 	}
-#ifndef _WIN32
-	else if (m_pending_container_evts.try_pop(m_container_evt))
-	{
-		res = SCAP_SUCCESS;
-		evt = m_container_evt.get();
-	}
-#endif
 	else
 	{
 		evt = &m_evt;
@@ -1171,7 +1191,10 @@ int32_t sinsp::next(OUT sinsp_evt **puevt)
 		//
 		// Get the event from libscap
 		//
-		res = scap_next(m_h, &(evt->m_pevt), &(evt->m_cpuid));
+		{
+			internal_metrics::scoped_stage_timer scap_timer(internal_metrics::STAGE_SCAP_NEXT);
+			res = scap_next(m_h, &(evt->m_pevt), &(evt->m_cpuid));
+		}
 
 		if(res != SCAP_SUCCESS)
 		{
@@ -1385,7 +1408,10 @@ int32_t sinsp::next(OUT sinsp_evt **puevt)
 
 		scap_evt* pdevt = (evt->m_poriginal_evt)? evt->m_poriginal_evt : evt->m_pevt;
 
-		res = scap_dump(m_h, m_dumper, pdevt, evt->m_cpuid, dflags);
+		{
+			internal_metrics::scoped_stage_timer dump_timer(internal_metrics::STAGE_DUMP);
+			res = scap_dump(m_h, m_dumper, pdevt, evt->m_cpuid, dflags);
+		}
 
 		if(SCAP_SUCCESS != res)
 		{
@@ -1705,6 +1731,8 @@ void sinsp::add_evttype_filter(string &name,
 
 bool sinsp::run_filters_on_evt(sinsp_evt *evt)
 {
+	internal_metrics::scoped_stage_timer stage_timer(internal_metrics::STAGE_FILTER);
+
 	//
 	// First run the global filter, if there is one.
 	//
@@ -46,8 +46,6 @@ limitations under the License.
 
 #ifdef _WIN32
 #pragma warning(disable: 4251 4200 4221 4190)
-#else
-#include "tbb/concurrent_queue.h"
 #endif
 
 #include "sinsp_inet.h"
@@ -95,6 +93,7 @@ using namespace std;
 #include "ifinfo.h"
 #include "eventformatter.h"
 #include "sinsp_pd_callback_type.h"
+#include "meta_event_queue.h"
 
 #include "include/sinsp_external_processor.h"
 class sinsp_partial_transaction;
@@ -885,6 +884,18 @@ public:
 	void import_ipv4_interface(const sinsp_ipv4_ifinfo& ifinfo);
 	void add_meta_event(sinsp_evt *metaevt);
 	void add_meta_event_callback(meta_event_callback cback, void* data);
+
+	/*!
+	  \brief Queue an event to be returned by \ref next() before the next
+	   event of the capture source. Unlike add_meta_event(), this can be
+	   called from any thread, and the inspector owns the event.
+
+	  \note The queued events keep their order. An event with a timestamp
+	   older than the last returned event gets the timestamp of that
+	   event, so that the timestamps returned by next() never go back.
+	*/
+	void queue_meta_event(std::shared_ptr<sinsp_evt> evt);
+	void queue_meta_events(std::vector<std::shared_ptr<sinsp_evt>>& evts);
 	void remove_meta_event_callback();
 	void filter_proc_table_when_saving(bool filter);
 	void enable_tracers_capture();
@@ -1008,6 +1019,11 @@ private:
 
 	void restart_capture_at_filepos(uint64_t filepos);
 
+	//
+	// The next pending meta event, or NULL
+	//
+	sinsp_evt* next_meta_event();
+
 	void fseek(uint64_t filepos)
 	{
 		scap_fseek(m_h, filepos);
@@ -1193,6 +1209,8 @@ public:
 	//
 	bool m_track_tracers_state;
 	list<sinsp_partial_tracer*> m_partial_tracers_list;
+	// Heads of the chains of open spans, by hash of id and tags
+	unordered_map<uint64_t, sinsp_partial_tracer*> m_partial_tracers_index;
 	simple_lifo_queue<sinsp_partial_tracer>* m_partial_tracers_pool;
 
 	//
@@ -1201,22 +1219,13 @@ public:
 	std::vector<sinsp_protodecoder*> m_decoders_reset_list;
 
 	//
-	// meta event management for other sources like k8s, mesos.
+	// meta event management for other sources like containers, k8s,
+	// mesos and the users
 	//
-	sinsp_evt* m_metaevt;
+	sinsp_meta_event_queue m_meta_events;
 	meta_event_callback m_meta_event_callback;
 	void* m_meta_event_callback_data;
 
-	// A queue of pending container events. Written from async
-	// callbacks that occur after looking up container
-	// information, read from sinsp::next().
-#ifndef _WIN32
-	tbb::concurrent_queue<shared_ptr<sinsp_evt>> m_pending_container_evts;
-#endif
-
-	// Holds an event dequeued from the above queue
-	std::shared_ptr<sinsp_evt> m_container_evt;
-
 	//
 	// End of second housekeeping
 	//
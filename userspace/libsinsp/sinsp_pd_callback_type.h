@@ -27,4 +27,5 @@ typedef enum sinsp_pd_callback_type
 	CT_READ,
 	CT_WRITE,
 	CT_TUPLE_CHANGE,
+	CT_ACCEPT,
 }sinsp_pd_callback_type;
@@ -0,0 +1,289 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "sketches.h"
+
+const uint32_t hyperloglog::PRECISION;
+const uint32_t hyperloglog::NREGISTERS;
+const uint32_t tdigest::COMPRESSION;
+const uint32_t tdigest::MAX_CENTROIDS;
+const uint32_t tdigest::BUFFER_SIZE;
+
+static inline uint32_t leading_zeros(uint64_t x)
+{
+#ifdef __GNUC__
+	return (uint32_t)__builtin_clzll(x);
+#else
+	uint32_t res = 0;
+	while((x & (1ULL << 63)) == 0)
+	{
+		x <<= 1;
+		res++;
+	}
+	return res;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// hyperloglog implementation
+///////////////////////////////////////////////////////////////////////////////
+void hyperloglog::init()
+{
+	memset(m_registers, 0, sizeof(m_registers));
+}
+
+void hyperloglog::add(uint64_t hash)
+{
+	uint32_t idx = (uint32_t)(hash >> (64 - PRECISION));
+
+	//
+	// The guard bit bounds the rank when the remaining bits are all zero
+	//
+	uint64_t rest = (hash << PRECISION) | (1ULL << (PRECISION - 1));
+	uint8_t rank = (uint8_t)(leading_zeros(rest) + 1);
+
+	if(rank > m_registers[idx])
+	{
+		m_registers[idx] = rank;
+	}
+}
+
+void hyperloglog::merge(const hyperloglog& other)
+{
+	for(uint32_t j = 0; j < NREGISTERS; j++)
+	{
+		if(other.m_registers[j] > m_registers[j])
+		{
+			m_registers[j] = other.m_registers[j];
+		}
+	}
+}
+
+uint64_t hyperloglog::estimate() const
+{
+	const double m = NREGISTERS;
+	const double alpha = 0.7213 / (1 + 1.079 / m);
+	double sum = 0;
+	uint32_t zeros = 0;
+
+	for(uint32_t j = 0; j < NREGISTERS; j++)
+	{
+		sum += ldexp(1.0, -(int)m_registers[j]);
+		if(m_registers[j] == 0)
+		{
+			zeros++;
+		}
+	}
+
+	double res = alpha * m * m / sum;
+
+	//
+	// Small range correction: count the empty registers instead
+	//
+	if(res <= 2.5 * m && zeros != 0)
+	{
+		res = m * log(m / zeros);
+	}
+
+	return (uint64_t)(res + 0.5);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tdigest implementation
+///////////////////////////////////////////////////////////////////////////////
+void tdigest::init()
+{
+	m_min = 0;
+	m_max = 0;
+	m_total_weight = 0;
+	m_buffer_weight = 0;
+	m_n_centroids = 0;
+	m_n_buffered = 0;
+}
+
+void tdigest::add(double value, double weight)
+{
+	if(weight <= 0)
+	{
+		return;
+	}
+
+	if(get_count() == 0)
+	{
+		m_min = value;
+		m_max = value;
+	}
+	else
+	{
+		m_min = std::min(m_min, value);
+		m_max = std::max(m_max, value);
+	}
+
+	if(m_n_centroids + m_n_buffered == MAX_CENTROIDS + BUFFER_SIZE)
+	{
+		compress();
+	}
+
+	uint32_t pos = m_n_centroids + m_n_buffered;
+	m_means[pos] = value;
+	m_weights[pos] = weight;
+	m_n_buffered++;
+	m_buffer_weight += weight;
+}
+
+void tdigest::compress()
+{
+	if(m_n_buffered == 0)
+	{
+		return;
+	}
+
+	uint32_t n = m_n_centroids + m_n_buffered;
+	std::pair<double, double> sorted[MAX_CENTROIDS + BUFFER_SIZE];
+
+	for(uint32_t j = 0; j < n; j++)
+	{
+		sorted[j] = std::make_pair(m_means[j], m_weights[j]);
+	}
+
+	std::sort(sorted, sorted + n);
+
+	double total = m_total_weight + m_buffer_weight;
+	const double scale = COMPRESSION / (4 * asin(1.0));
+	double wleft = 0;
+	uint32_t out = 0;
+
+	m_means[0] = sorted[0].first;
+	m_weights[0] = sorted[0].second;
+
+	for(uint32_t j = 1; j < n; j++)
+	{
+		double proposed = m_weights[out] + sorted[j].second;
+		double kleft = scale * asin(2 * wleft / total - 1);
+		double kright = scale * asin(std::min(2 * (wleft + proposed) / total - 1, 1.0));
+
+		//
+		// A centroid may span at most one unit of the scale function,
+		// which keeps the centroids at the tails small
+		//
+		if(kright - kleft <= 1 || out + 1 == MAX_CENTROIDS)
+		{
+			m_means[out] += (sorted[j].first - m_means[out]) * sorted[j].second / proposed;
+			m_weights[out] = proposed;
+		}
+		else
+		{
+			wleft += m_weights[out];
+			out++;
+			m_means[out] = sorted[j].first;
+			m_weights[out] = sorted[j].second;
+		}
+	}
+
+	m_n_centroids = out + 1;
+	m_n_buffered = 0;
+	m_total_weight = total;
+	m_buffer_weight = 0;
+}
+
+void tdigest::merge(tdigest& other)
+{
+	if(other.get_count() == 0)
+	{
+		return;
+	}
+
+	other.compress();
+
+	double min = other.m_min;
+	double max = other.m_max;
+	if(get_count() != 0)
+	{
+		min = std::min(min, m_min);
+		max = std::max(max, m_max);
+	}
+
+	for(uint32_t j = 0; j < other.m_n_centroids; j++)
+	{
+		add(other.m_means[j], other.m_weights[j]);
+	}
+
+	m_min = min;
+	m_max = max;
+}
+
+double tdigest::quantile(double q)
+{
+	compress();
+
+	uint32_t n = m_n_centroids;
+	if(n == 0)
+	{
+		return 0;
+	}
+
+	if(q <= 0)
+	{
+		return m_min;
+	}
+	else if(q >= 1)
+	{
+		return m_max;
+	}
+	else if(n == 1)
+	{
+		return m_means[0];
+	}
+
+	//
+	// Every centroid is taken to be centered on its mean, with half of
+	// its weight on each side, and values are interpolated between the
+	// centers. Between the extremes and the first and last centers,
+	// values are interpolated from the exact minimum and maximum.
+	//
+	double index = q * m_total_weight;
+	double first_half = m_weights[0] / 2;
+	double last_half = m_weights[n - 1] / 2;
+
+	if(index < first_half)
+	{
+		return m_min + (m_means[0] - m_min) * index / first_half;
+	}
+	else if(index > m_total_weight - last_half)
+	{
+		return m_max - (m_max - m_means[n - 1]) * (m_total_weight - index) / last_half;
+	}
+
+	double cum = first_half;
+	for(uint32_t j = 0; j < n - 1; j++)
+	{
+		double dw = (m_weights[j] + m_weights[j + 1]) / 2;
+		if(cum + dw >= index)
+		{
+			return m_means[j] + (m_means[j + 1] - m_means[j]) * (index - cum) / dw;
+		}
+
+		cum += dw;
+	}
+
+	return m_means[n - 1];
+}
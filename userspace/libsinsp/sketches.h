@@ -0,0 +1,104 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <cstdint>
+
+//
+// Fixed size summaries of a stream of values, used by sinsp_table for
+// the columns that would otherwise need to keep every value.
+//
+// Both are plain structs without pointers, so that they can be
+// allocated in a table buffer and discarded with it: call init() before
+// using them.
+//
+
+//
+// HyperLogLog distinct counter. The standard error of the estimate is
+// 1.04 / sqrt(NREGISTERS), about 3%.
+//
+struct hyperloglog
+{
+	static const uint32_t PRECISION = 10;
+	static const uint32_t NREGISTERS = 1 << PRECISION;
+
+	void init();
+
+	//
+	// Adds a value, given as a 64-bit hash of it. The hash must be well
+	// mixed in all its bits.
+	//
+	void add(uint64_t hash);
+
+	//
+	// After this, the sketch counts the union of the two streams
+	//
+	void merge(const hyperloglog& other);
+
+	uint64_t estimate() const;
+
+	uint8_t m_registers[NREGISTERS];
+};
+
+//
+// Merging t-digest (Dunning, "Computing extremely accurate quantiles
+// using t-digests"), with the k1 scale function. Quantiles near 0 and 1
+// are the most accurate; the median is typically within 1% of the rank.
+//
+struct tdigest
+{
+	static const uint32_t COMPRESSION = 50;
+	// Compressing always leaves at most COMPRESSION + 1 centroids
+	static const uint32_t MAX_CENTROIDS = COMPRESSION + 2;
+	static const uint32_t BUFFER_SIZE = 64;
+
+	void init();
+
+	void add(double value, double weight = 1);
+
+	//
+	// After this, the sketch summarizes the union of the two streams.
+	// other is compressed as a side effect.
+	//
+	void merge(tdigest& other);
+
+	//
+	// The estimated value at quantile q, in [0, 1]. Returns 0 if the
+	// digest is empty.
+	//
+	double quantile(double q);
+
+	double get_count() const
+	{
+		return m_total_weight + m_buffer_weight;
+	}
+
+	//
+	// Merges the buffered values into the centroids
+	//
+	void compress();
+
+	double m_min;
+	double m_max;
+	double m_total_weight;	// of the centroids
+	double m_buffer_weight;
+	uint32_t m_n_centroids;
+	uint32_t m_n_buffered;
+	double m_means[MAX_CENTROIDS + BUFFER_SIZE];
+	double m_weights[MAX_CENTROIDS + BUFFER_SIZE];
+};
@@ -35,6 +35,7 @@ limitations under the License.
 #include "sinsp_auth.h"
 #include "http_reason.h"
 #include "json_query.h"
+#include "json_list_splitter.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/socket.h>
@@ -103,8 +104,8 @@ public:
 			m_data_chunk_wait_us(data_chunk_wait_us)
 
 	{
-		g_logger.log(std::string("Creating Socket handler object for (" + id + ") "
-					 "[" + uri(url).to_string(false) + ']'), sinsp_logger::SEV_DEBUG);
+		SINSP_STR_DEBUG(std::string("Creating Socket handler object for (" + id + ") "
+					 "[" + uri(url).to_string(false) + ']'));
 		m_buf.resize(1024);
 		init_http_parser();
 	}
@@ -152,6 +153,35 @@ public:
 		m_close_on_chunked_end = close;
 	}
 
+	// when enabled, the initial state response is not buffered as a whole;
+	// instead, every element of its "items" array is posted for processing
+	// as a separate list document as soon as it is received
+	void stream_list_items(bool stream = true)
+	{
+		if(stream && !m_list_splitter)
+		{
+			m_list_splitter.reset(new json_list_splitter());
+		}
+		else if(!stream)
+		{
+			m_list_splitter.reset();
+		}
+		m_http_parser_data.m_list_splitter = m_list_splitter.get();
+	}
+
+	// true while a streamed state response has been only partially received
+	bool is_streaming_list() const
+	{
+		return m_list_splitter && m_fetching_state && m_list_splitter->in_progress();
+	}
+
+	// marks the next response as (a part of) the initial state, eg. when
+	// the state is listed in pages over the same connection
+	void set_fetching_state(bool fetching = true)
+	{
+		m_fetching_state = fetching;
+	}
+
 	const uri& get_url() const
 	{
 		return m_url;
@@ -247,8 +277,8 @@ public:
 		int iolen = 0;
 		if(m_request.size())
 		{
-			g_logger.log("Socket handler (" + m_id + ") socket=" + std::to_string(m_socket) +
-						 ", m_ssl_connection=" + std::to_string((int64_t)m_ssl_connection), sinsp_logger::SEV_TRACE);
+			SINSP_STR_TRACE("Socket handler (" + m_id + ") socket=" + std::to_string(m_socket) +
+						 ", m_ssl_connection=" + std::to_string((int64_t)m_ssl_connection));
 			std::string req = m_request;
 			time_t then; time(&then);
 			while(req.size())
@@ -301,7 +331,7 @@ public:
 		{
 			throw sinsp_exception("Socket handler (" + m_id + ") request is empty.");
 		}
-		g_logger.log(m_request, sinsp_logger::SEV_TRACE);
+		SINSP_STR_TRACE(m_request);
 		return;
 
 		connection_error:
@@ -355,8 +385,7 @@ public:
 
 	int get_all_data()
 	{
-		g_logger.log("Socket handler (" + m_id + ") Retrieving all data in blocking mode ...",
-					 sinsp_logger::SEV_TRACE);
+		SINSP_STR_TRACE("Socket handler (" + m_id + ") Retrieving all data in blocking mode ...");
 		ssize_t rec = 0;
 		std::vector<char> buf(1024, 0);
 		int counter = 0;
@@ -499,8 +528,7 @@ public:
 				// set the m_close_on_chunked_end flag to true (default).
 				if(m_close_on_chunked_end)
 				{
-					g_logger.log("Socket handler (" + m_id + ") chunked response ended",
-						     sinsp_logger::SEV_DEBUG);
+					SINSP_STR_DEBUG("Socket handler (" + m_id + ") chunked response ended");
 					return CONNECTION_CLOSED;
 				}
 				m_wants_send = true;
@@ -543,10 +571,13 @@ public:
 				m_sock_err = errno;
 				sinsp_logger::severity sev = (iolen < 0 && m_sock_err != EAGAIN) ?
 					sinsp_logger::SEV_DEBUG : sinsp_logger::SEV_TRACE;
-				g_logger.log("Socket handler (" + m_id + ") " + m_url.to_string(false) + ", iolen=" +
-					     std::to_string(iolen) + ", data=" + std::to_string(len_read) + " bytes, "
-					     "errno=" + std::to_string(m_sock_err) + " (" + strerror(m_sock_err) + ')',
-					     sev);
+				if(g_logger.is_enabled(sev))
+				{
+					g_logger.log("Socket handler (" + m_id + ") " + m_url.to_string(false) + ", iolen=" +
+						     std::to_string(iolen) + ", data=" + std::to_string(len_read) + " bytes, "
+						     "errno=" + std::to_string(m_sock_err) + " (" + strerror(m_sock_err) + ')',
+						     sev);
+				}
 				/* uncomment to see raw HTTP stream data in trace logs
 					if((iolen > 0) && g_logger.get_severity() >= sinsp_logger::SEV_TRACE)
 					{
@@ -571,9 +602,8 @@ public:
 							int err = SSL_get_error(m_ssl_connection, iolen);
 							if (err != SSL_ERROR_ZERO_RETURN)
 							{
-								g_logger.log("Socket handler(" + m_id + "): SSL conn closed with code "
-									     + std::to_string(err),
-									     sinsp_logger::SEV_DEBUG);
+								SINSP_STR_DEBUG("Socket handler(" + m_id + "): SSL conn closed with code "
+									     + std::to_string(err));
 							}
 
 							int sd = SSL_get_shutdown(m_ssl_connection);
@@ -585,13 +615,13 @@ public:
 							}
 							if(sd & SSL_RECEIVED_SHUTDOWN)
 							{
-								g_logger.log("Socket handler(" + m_id + "): SSL shutdown from [" +
-											 m_url.to_string(false) + "]: ", sinsp_logger::SEV_TRACE);
+								SINSP_STR_TRACE("Socket handler(" + m_id + "): SSL shutdown from [" +
+											 m_url.to_string(false) + "]: ");
 							}
 							if(sd & SSL_SENT_SHUTDOWN)
 							{
-								g_logger.log("Socket handler(" + m_id + "): SSL shutdown sent to [" +
-											 m_url.to_string(false) + "]: ", sinsp_logger::SEV_TRACE);
+								SINSP_STR_TRACE("Socket handler(" + m_id + "): SSL shutdown sent to [" +
+											 m_url.to_string(false) + "]: ");
 							}
 						}
 						else
@@ -625,9 +655,8 @@ public:
 					}
 				}
 			} while(iolen && (m_sock_err != EAGAIN) && (len_read < m_data_limit));
-			g_logger.log("Socket handler (" + m_id + ") " +
-						 std::to_string(len_read) + " bytes of data received",
-						 sinsp_logger::SEV_TRACE);
+			SINSP_STR_TRACE("Socket handler (" + m_id + ") " +
+						 std::to_string(len_read) + " bytes of data received");
 		}
 		catch(const sinsp_exception& ex)
 		{
@@ -812,10 +841,9 @@ public:
 	{
 		socklen_t optlen = sizeof(m_sock_err);
 		int ret = getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &m_sock_err, &optlen);
-		g_logger.log("Socket handler (" + m_id + ") getsockopt() ret=" +
+		SINSP_STR_TRACE("Socket handler (" + m_id + ") getsockopt() ret=" +
 						 std::to_string(ret) + ", m_sock_err=" + std::to_string(m_sock_err) +
-						 " (" + strerror(m_sock_err) + ')',
-						 sinsp_logger::SEV_TRACE);
+						 " (" + strerror(m_sock_err) + ')');
 		if(!ret) { return m_sock_err; }
 		throw sinsp_exception("Socket handler (" + m_id + ") an error occurred "
 					 "trying to obtain socket status while connecting to " +
@@ -891,8 +919,7 @@ private:
 
 			if(preverify_ok && SSL_get_verify_result(ssl) == X509_V_OK)
 			{
-				g_logger.log("Socket handler SSL CA verified: " + std::string(buf),
-							 sinsp_logger::SEV_DEBUG);
+				SINSP_STR_DEBUG("Socket handler SSL CA verified: " + std::string(buf));
 				return 1;
 			}
 			else
@@ -911,8 +938,7 @@ private:
 
 	static int ssl_no_verify_callback(int, X509_STORE_CTX* ctx)
 	{
-		g_logger.log("Socket handler SSL CA verification disabled, certificate accepted.",
-					 sinsp_logger::SEV_DEBUG);
+		SINSP_STR_DEBUG("Socket handler SSL CA verification disabled, certificate accepted.");
 		return 1;
 	}
 
@@ -993,12 +1019,12 @@ private:
 											  "(Verify Peer enabled but no CA certificate specified).");
 					}
 					SSL_CTX_set_verify(m_ssl_context, SSL_VERIFY_PEER, ssl_verify_callback);
-					g_logger.log("Socket handler (" + m_id + "): CA verify set to PEER", sinsp_logger::SEV_TRACE);
+					SINSP_STR_TRACE("Socket handler (" + m_id + "): CA verify set to PEER");
 				}
 				else
 				{
 					SSL_CTX_set_verify(m_ssl_context, SSL_VERIFY_NONE, ssl_no_verify_callback);
-					g_logger.log("Socket handler (" + m_id + "): CA verify set to NONE", sinsp_logger::SEV_TRACE);
+					SINSP_STR_TRACE("Socket handler (" + m_id + "): CA verify set to NONE");
 				}
 
 				const std::string& cert = m_ssl->cert();
@@ -1012,8 +1038,7 @@ private:
 					}
 					else
 					{
-						g_logger.log("Socket handler (" + m_id + "): using SSL certificate from " + cert,
-									 sinsp_logger::SEV_TRACE);
+						SINSP_STR_TRACE("Socket handler (" + m_id + "): using SSL certificate from " + cert);
 					}
 					const std::string& key = m_ssl->key();
 					if(!key.empty())
@@ -1035,7 +1060,7 @@ private:
 						}
 						else
 						{
-							g_logger.log("Socket handler (" + m_id + "): using SSL private key from " + key, sinsp_logger::SEV_TRACE);
+							SINSP_STR_TRACE("Socket handler (" + m_id + "): using SSL private key from " + key);
 						}
 
 						if(!SSL_CTX_check_private_key(m_ssl_context))
@@ -1046,8 +1071,7 @@ private:
 						}
 						else
 						{
-							g_logger.log("Socket handler (" + m_id + "): SSL private key " + key + " matches public certificate " + cert,
-										 sinsp_logger::SEV_TRACE);
+							SINSP_STR_TRACE("Socket handler (" + m_id + "): SSL private key " + key + " matches public certificate " + cert);
 						}
 					}
 					else
@@ -1058,7 +1082,7 @@ private:
 				}
 				else
 				{
-					g_logger.log("Socket handler (" + m_id + "): SSL public certificate not provided.", sinsp_logger::SEV_TRACE);
+					SINSP_STR_TRACE("Socket handler (" + m_id + "): SSL public certificate not provided.");
 				}
 			}
 		}
@@ -1149,8 +1173,8 @@ private:
 
 	bool try_connect()
 	{
-		g_logger.log("Socket handler (" + m_id + ") try_connect() entry, m_connecting=" + std::to_string(m_connecting) +
-						 ", m_connected=" + std::to_string(m_connected), sinsp_logger::SEV_TRACE);
+		SINSP_STR_TRACE("Socket handler (" + m_id + ") try_connect() entry, m_connecting=" + std::to_string(m_connecting) +
+						 ", m_connected=" + std::to_string(m_connected));
 		if(m_connected) { return true; }
 		if(m_socket == -1)
 		{
@@ -1178,12 +1202,12 @@ private:
 			}
 		}
 
-		g_logger.log("Socket handler (" + m_id + ") try_connect() middle, m_connecting=" + std::to_string(m_connecting) +
-						 ", m_connected=" + std::to_string(m_connected), sinsp_logger::SEV_TRACE);
+		SINSP_STR_TRACE("Socket handler (" + m_id + ") try_connect() middle, m_connecting=" + std::to_string(m_connecting) +
+						 ", m_connected=" + std::to_string(m_connected));
 		if(!m_connected)
 		{
-			g_logger.log("Socket handler (" + m_id + ") connecting to " + m_url.to_string(false) +
-						 " (socket=" + std::to_string(m_socket) + ')', sinsp_logger::SEV_DEBUG);
+			SINSP_STR_DEBUG("Socket handler (" + m_id + ") connecting to " + m_url.to_string(false) +
+						 " (socket=" + std::to_string(m_socket) + ')');
 			if(!m_sa || !m_sa_len)
 			{
 				std::ostringstream os;
@@ -1234,10 +1258,9 @@ private:
 						g_logger.log("Socket handler (" + m_id + "): "
 									 "SSL connected to " + m_url.get_host(),
 									 sinsp_logger::SEV_INFO);
-						g_logger.log("Socket handler (" + m_id + "): "
+						SINSP_STR_DEBUG("Socket handler (" + m_id + "): "
 									 "SSL socket=" + std::to_string(m_socket) + ", "
-									 "local port=" + std::to_string(get_local_port()),
-									 sinsp_logger::SEV_DEBUG);
+									 "local port=" + std::to_string(get_local_port()));
 					}
 					else
 					{
@@ -1282,8 +1305,8 @@ private:
 				}
 			}
 
-			g_logger.log("Socket handler (" + m_id + "): Connected: socket=" + std::to_string(m_socket) +
-						 ", collecting data from " + m_url.to_string(false) + m_path, sinsp_logger::SEV_DEBUG);
+			SINSP_STR_DEBUG("Socket handler (" + m_id + "): Connected: socket=" + std::to_string(m_socket) +
+						 ", collecting data from " + m_url.to_string(false) + m_path);
 
 			if(m_url.is_secure() && m_ssl && m_ssl->verify_peer())
 			{
@@ -1329,8 +1352,7 @@ private:
 
 				if (!m_ares_cb_res.call) // first call, call async resolver
 				{
-					g_logger.log("Socket handler (" + m_id + ") resolving " + m_url.get_host(),
-								 sinsp_logger::SEV_TRACE);
+					SINSP_STR_TRACE("Socket handler (" + m_id + ") resolving " + m_url.get_host());
 
 					ares_init_options(&m_ares_channel, &m_ares_opts, 0);
 					ares_gethostbyname(m_ares_channel, m_url.get_host().c_str(), AF_INET, ares_cb, &m_ares_cb_res);
@@ -1354,9 +1376,8 @@ private:
 				{
 					if (m_ares_cb_res.address.empty())
 					{
-						g_logger.log("Socket handler (" + m_id + "): " + m_url.get_host() +
-										 " address not resolved yet.",
-									 sinsp_logger::SEV_TRACE);
+						SINSP_STR_TRACE("Socket handler (" + m_id + "): " + m_url.get_host() +
+										 " address not resolved yet.");
 						return false;
 					}
 					m_address = m_ares_cb_res.address;
@@ -1420,8 +1441,8 @@ private:
 	{
 		if(m_socket != -1)
 		{
-			g_logger.log("Socket handler (" + m_id + ") closing connection to " +
-						 m_url.to_string(false) + m_path, sinsp_logger::SEV_DEBUG);
+			SINSP_STR_DEBUG("Socket handler (" + m_id + ") closing connection to " +
+						 m_url.to_string(false) + m_path);
 			int ret = close(m_socket);
 			if(ret < 0)
 			{
@@ -1458,6 +1479,7 @@ private:
 	{
 		std::string* m_data_buf = nullptr;
 		std::vector<std::string>* m_json = nullptr;
+		json_list_splitter* m_list_splitter = nullptr;
 		int* m_http_response = nullptr;
 		bool* m_msg_completed = nullptr;
 		bool* m_fetching_state = nullptr;
@@ -1472,7 +1494,12 @@ private:
 				if(data && len)
 				{
 					http_parser_data* parser_data = (http_parser_data*) parser->data;
-					if(parser_data->m_data_buf && parser_data->m_json)
+					if(parser_data->m_list_splitter && parser_data->m_fetching_state &&
+					   *(parser_data->m_fetching_state) && parser_data->m_json)
+					{
+						parser_data->m_list_splitter->feed(data, len, *parser_data->m_json);
+					}
+					else if(parser_data->m_data_buf && parser_data->m_json)
 					{
 						parser_data->m_data_buf->append(data, len);
 						// only try to parse this JSON if we are certain it is not pretty-printed
@@ -1517,7 +1544,18 @@ private:
 			http_parser_data* parser_data = (http_parser_data*) parser->data;
 			if(parser_data->m_fetching_state)
 			{
-				if(*(parser_data->m_fetching_state))
+				if(*(parser_data->m_fetching_state) && parser_data->m_list_splitter)
+				{
+					if(parser_data->m_list_splitter->in_progress())
+					{
+						g_logger.log("Initial state fetch completed with incomplete JSON (" +
+									 std::to_string(parser_data->m_list_splitter->buffered()) +
+									 " bytes), discarding.", sinsp_logger::SEV_ERROR);
+					}
+					parser_data->m_list_splitter->reset();
+					*(parser_data->m_fetching_state) = false;
+				}
+				else if(*(parser_data->m_fetching_state))
 				{
 					std::string* buf = parser_data->m_data_buf;
 					if(buf)
@@ -1567,6 +1605,7 @@ private:
 		}
 		m_http_parser_data.m_data_buf = &m_data_buf;
 		m_http_parser_data.m_json = &m_json;
+		m_http_parser_data.m_list_splitter = m_list_splitter.get();
 		m_http_parser_data.m_http_response = &m_http_response;
 		m_http_parser_data.m_msg_completed = &m_msg_completed;
 		m_http_parser_data.m_fetching_state = &m_fetching_state;
@@ -1603,6 +1642,7 @@ private:
 	std::string              m_http_version;
 	std::vector<std::string> m_json_filters;
 	std::vector<std::string> m_json;
+	std::unique_ptr<json_list_splitter> m_list_splitter;
 	json_query               m_jq;
 	bool                     m_ssl_init_complete = false;
 	SSL_CTX*                 m_ssl_context = nullptr;
@@ -0,0 +1,311 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <inttypes.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "stage_timers.h"
+
+namespace internal_metrics
+{
+
+std::atomic<bool> stage_timers::s_enabled(false);
+
+namespace
+{
+
+//
+// A stack of stages is kept as 4 bits per stage in a uint32_t, the
+// innermost stage in the low bits
+//
+const uint32_t MAX_DEPTH = 8;
+const uint32_t MAX_PATHS = 256;
+
+const char* const stage_names[STAGE_MAX] =
+{
+	"none",
+	"next",
+	"scap_next",
+	"parse",
+	"container",
+	"filter",
+	"format",
+	"dump",
+};
+
+//
+// Only the owner thread writes, so a plain load and store is enough and
+// avoids a locked instruction on the hot path
+//
+inline void add_relaxed(std::atomic<uint64_t>& counter, uint64_t value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct thread_timers
+{
+	struct stage_stats
+	{
+		std::atomic<uint64_t> m_count;
+		std::atomic<uint64_t> m_cycles;
+		std::atomic<uint64_t> m_buckets[histogram::NBUCKETS];
+	};
+
+	struct path_stats
+	{
+		std::atomic<uint32_t> m_path;	// 0 for a free slot
+		std::atomic<uint64_t> m_self_cycles;
+	};
+
+	struct frame
+	{
+		stage_id m_stage;
+		uint32_t m_path;
+		uint64_t m_start;
+		uint64_t m_children;
+	};
+
+	stage_stats m_stages[STAGE_MAX];
+	path_stats m_paths[MAX_PATHS];
+
+	// only used by the owner thread
+	frame m_stack[MAX_DEPTH];
+	uint32_t m_depth;
+
+	void add_self_cycles(uint32_t path, uint64_t cycles)
+	{
+		uint32_t slot = (path * 2654435761U) % MAX_PATHS;
+		for(uint32_t j = 0; j < MAX_PATHS; j++)
+		{
+			path_stats& ps = m_paths[(slot + j) % MAX_PATHS];
+			uint32_t cur = ps.m_path.load(std::memory_order_relaxed);
+			if(cur == path)
+			{
+				add_relaxed(ps.m_self_cycles, cycles);
+				return;
+			}
+			else if(cur == 0)
+			{
+				ps.m_self_cycles.store(cycles, std::memory_order_relaxed);
+				ps.m_path.store(path, std::memory_order_release);
+				return;
+			}
+		}
+	}
+};
+
+//
+// Threads that ever timed a stage. The entries are never freed, so the
+// counters of threads that exited are still reported.
+//
+std::mutex s_threads_mutex;
+std::vector<thread_timers*> s_threads;
+thread_local thread_timers* t_timers = NULL;
+
+inline thread_timers* get_thread_timers()
+{
+	if(t_timers == NULL)
+	{
+		// value initialization zeroes all the counters
+		t_timers = new thread_timers();
+
+		std::lock_guard<std::mutex> lock(s_threads_mutex);
+		s_threads.push_back(t_timers);
+	}
+
+	return t_timers;
+}
+
+}
+
+void stage_timers::enable(bool enabled)
+{
+	s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t stage_timers::now()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+const char* stage_timers::stage_name(stage_id stage)
+{
+	return stage < STAGE_MAX ? stage_names[stage] : "unknown";
+}
+
+void stage_timers::enter(stage_id stage)
+{
+	thread_timers* t = get_thread_timers();
+
+	if(t->m_depth < MAX_DEPTH)
+	{
+		thread_timers::frame& f = t->m_stack[t->m_depth];
+		uint32_t parent_path = t->m_depth > 0 ? t->m_stack[t->m_depth - 1].m_path : 0;
+
+		f.m_stage = stage;
+		f.m_path = (parent_path << 4) | (uint32_t)stage;
+		f.m_children = 0;
+		f.m_start = now();
+	}
+
+	t->m_depth++;
+}
+
+void stage_timers::exit()
+{
+	uint64_t end = now();
+	thread_timers* t = t_timers;
+
+	if(t == NULL || t->m_depth == 0)
+	{
+		return;
+	}
+
+	//
+	// Stages nested deeper than MAX_DEPTH are accounted to the innermost
+	// stage that has a frame
+	//
+	t->m_depth--;
+	if(t->m_depth >= MAX_DEPTH)
+	{
+		return;
+	}
+
+	thread_timers::frame& f = t->m_stack[t->m_depth];
+	uint64_t cycles = end - f.m_start;
+
+	thread_timers::stage_stats& st = t->m_stages[f.m_stage];
+	add_relaxed(st.m_count, 1);
+	add_relaxed(st.m_cycles, cycles);
+	add_relaxed(st.m_buckets[histogram::bucket(cycles)], 1);
+
+	t->add_self_cycles(f.m_path, cycles > f.m_children ? cycles - f.m_children : 0);
+
+	if(t->m_depth > 0)
+	{
+		t->m_stack[t->m_depth - 1].m_children += cycles;
+	}
+}
+
+void stage_timers::reset()
+{
+	std::lock_guard<std::mutex> lock(s_threads_mutex);
+
+	for(thread_timers* t : s_threads)
+	{
+		for(uint32_t s = 0; s < STAGE_MAX; s++)
+		{
+			t->m_stages[s].m_count.store(0, std::memory_order_relaxed);
+			t->m_stages[s].m_cycles.store(0, std::memory_order_relaxed);
+			for(uint32_t j = 0; j < histogram::NBUCKETS; j++)
+			{
+				t->m_stages[s].m_buckets[j].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		for(uint32_t j = 0; j < MAX_PATHS; j++)
+		{
+			t->m_paths[j].m_self_cycles.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+void stage_timers::export_metrics(registry& r)
+{
+	std::lock_guard<std::mutex> lock(s_threads_mutex);
+
+	for(uint32_t s = STAGE_NONE + 1; s < STAGE_MAX; s++)
+	{
+		std::string name = stage_names[s];
+		histogram& h = r.register_histogram(metric_name("stage." + name,
+			"Cycles spent in " + name));
+
+		for(thread_timers* t : s_threads)
+		{
+			const thread_timers::stage_stats& st = t->m_stages[s];
+			h.m_count += st.m_count.load(std::memory_order_relaxed);
+			h.m_sum += st.m_cycles.load(std::memory_order_relaxed);
+			for(uint32_t j = 0; j < histogram::NBUCKETS; j++)
+			{
+				h.m_buckets[j] += st.m_buckets[j].load(std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+void stage_timers::write_folded(FILE* f)
+{
+	std::map<uint32_t, uint64_t> paths;
+
+	{
+		std::lock_guard<std::mutex> lock(s_threads_mutex);
+
+		for(thread_timers* t : s_threads)
+		{
+			for(uint32_t j = 0; j < MAX_PATHS; j++)
+			{
+				uint32_t path = t->m_paths[j].m_path.load(std::memory_order_acquire);
+				if(path != 0)
+				{
+					paths[path] += t->m_paths[j].m_self_cycles.load(std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+
+	for(const auto& it : paths)
+	{
+		if(it.second == 0)
+		{
+			continue;
+		}
+
+		std::string stack;
+		for(int32_t shift = (MAX_DEPTH - 1) * 4; shift >= 0; shift -= 4)
+		{
+			uint32_t stage = (it.first >> shift) & 0xf;
+			if(stage != STAGE_NONE)
+			{
+				if(!stack.empty())
+				{
+					stack += ';';
+				}
+				stack += stage_name((stage_id)stage);
+			}
+		}
+
+		fprintf(f, "%s %" PRIu64 "\n", stack.c_str(), it.second);
+	}
+}
+
+}
@@ -0,0 +1,126 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+
+#include "sinsp_public.h"
+#include "internal_metrics.h"
+
+namespace internal_metrics {
+
+//
+// The hot path stages that can be timed
+//
+enum stage_id
+{
+	STAGE_NONE = 0,
+	STAGE_NEXT,		// sinsp::next()
+	STAGE_SCAP_NEXT,	// scap_next()
+	STAGE_PARSE,		// sinsp_parser::process_event()
+	STAGE_CONTAINER,	// sinsp_container_manager::resolve_container()
+	STAGE_FILTER,		// sinsp::run_filters_on_evt()
+	STAGE_FORMAT,		// sinsp_evt_formatter::tostring()
+	STAGE_DUMP,		// sinsp_dumper::dump()
+	STAGE_MAX,
+};
+
+//
+// Runtime enabled cycle accounting for the stages above.
+//
+// Each thread that times a stage gets its own counters and histograms,
+// written only by that thread with relaxed atomics, so timing a stage
+// takes no lock. Stages nest: a stage timed inside another one is
+// accounted to both, and the self time of every stack of stages is kept
+// to write a flamegraph compatible summary. When disabled, which is the
+// default, a scoped_stage_timer costs one relaxed load.
+//
+class SINSP_PUBLIC stage_timers
+{
+public:
+	static void enable(bool enabled);
+
+	static inline bool enabled()
+	{
+		return s_enabled.load(std::memory_order_relaxed);
+	}
+
+	//
+	// Cycle counter used for the timings, rdtsc where available
+	//
+	static uint64_t now();
+
+	static const char* stage_name(stage_id stage);
+
+	//
+	// Zero the counters of every thread. Stages that are being timed
+	// while this runs may be partially accounted.
+	//
+	static void reset();
+
+	//
+	// Register in r one histogram of the cycles spent in each stage,
+	// named "stage.<name>", summed over all the threads
+	//
+	static void export_metrics(registry& r);
+
+	//
+	// Write the self cycles of every stack of stages, one
+	// "next;parse;container <cycles>" line per stack, as expected by
+	// flamegraph.pl
+	//
+	static void write_folded(FILE* f);
+
+	static void enter(stage_id stage);
+	static void exit();
+
+private:
+	static std::atomic<bool> s_enabled;
+};
+
+class scoped_stage_timer
+{
+public:
+	inline explicit scoped_stage_timer(stage_id stage):
+		m_active(stage_timers::enabled())
+	{
+		if(m_active)
+		{
+			stage_timers::enter(stage);
+		}
+	}
+
+	inline ~scoped_stage_timer()
+	{
+		if(m_active)
+		{
+			stage_timers::exit();
+		}
+	}
+
+private:
+	scoped_stage_timer(const scoped_stage_timer&) = delete;
+	scoped_stage_timer& operator=(const scoped_stage_timer&) = delete;
+
+	bool m_active;
+};
+
+}
@@ -23,6 +23,8 @@ limitations under the License.
 
 #ifdef GATHER_INTERNAL_STATS
 
+extern sinsp_evttables g_infotables;
+
 void sinsp_stats::clear()
 {
 	m_n_seen_evts = 0;
@@ -36,9 +38,12 @@ void sinsp_stats::clear()
 	m_n_added_fds = 0;
 	m_n_removed_fds = 0;
 	m_n_stored_evts = 0;
+	m_n_stored_bytes = 0;
 	m_n_store_drops = 0;
 	m_n_retrieved_evts = 0;
 	m_n_retrieve_drops = 0;
+	memset(m_n_parsed_evts, 0, sizeof(m_n_parsed_evts));
+	memset(m_parser_cycles, 0, sizeof(m_parser_cycles));
 	m_metrics_registry.clear_all_metrics();
 }
 
@@ -59,10 +64,23 @@ void sinsp_stats::emit(FILE* f)
 	fprintf(f, "added fds: %" PRIu64 "\n", m_n_added_fds);
 	fprintf(f, "removed fds: %" PRIu64 "\n", m_n_removed_fds);
 	fprintf(f, "stored evts: %" PRIu64 "\n", m_n_stored_evts);
+	fprintf(f, "stored bytes: %" PRIu64 "\n", m_n_stored_bytes);
 	fprintf(f, "store drops: %" PRIu64 "\n", m_n_store_drops);
 	fprintf(f, "retrieved evts: %" PRIu64 "\n", m_n_retrieved_evts);
 	fprintf(f, "retrieve drops: %" PRIu64 "\n", m_n_retrieve_drops);
 
+	for(uint32_t j = 0; j < PPM_EVENT_MAX; j++)
+	{
+		if(m_n_parsed_evts[j] != 0)
+		{
+			fprintf(f, "parser %c %s: %" PRIu64 " evts %" PRIu64 " cycles/evt\n",
+				PPME_IS_ENTER(j) ? '>' : '<',
+				g_infotables.m_event_info[j].name,
+				m_n_parsed_evts[j],
+				m_parser_cycles[j] / m_n_parsed_evts[j]);
+		}
+	}
+
 	for(internal_metrics::registry::metric_map_iterator_t it = m_metrics_registry.get_metrics().begin(); it != m_metrics_registry.get_metrics().end(); it++)
 	{
 		fprintf(f, "%s: ", it->first.get_description().c_str());
@@ -75,4 +93,13 @@ void sinsp_stats::process(internal_metrics::counter& metric)
 	fprintf(m_output_target, "%" PRIu64 "\n", metric.get_value());
 }
 
+void sinsp_stats::process(internal_metrics::histogram& metric)
+{
+	fprintf(m_output_target, "%" PRIu64 " samples, %" PRIu64 " avg, %" PRIu64 " p50, %" PRIu64 " p99\n",
+		metric.get_count(),
+		metric.get_count() != 0 ? metric.get_sum() / metric.get_count() : 0,
+		metric.get_quantile(0.5),
+		metric.get_quantile(0.99));
+}
+
 #endif // GATHER_INTERNAL_STATS
@@ -36,6 +36,7 @@ public:
 	}
 
 	void process(internal_metrics::counter& metric);
+	void process(internal_metrics::histogram& metric);
 
 	uint64_t m_n_seen_evts;
 	uint64_t m_n_drops;
@@ -48,10 +49,18 @@ public:
 	uint64_t m_n_added_fds;
 	uint64_t m_n_removed_fds;
 	uint64_t m_n_stored_evts;
+	uint64_t m_n_stored_bytes;
 	uint64_t m_n_store_drops;
 	uint64_t m_n_retrieved_evts;
 	uint64_t m_n_retrieve_drops;
 
+	//
+	// Parser cost by event type: how many events of each type went through
+	// sinsp_parser::process_event() and the cycles spent there
+	//
+	uint64_t m_n_parsed_evts[PPM_EVENT_MAX];
+	uint64_t m_parser_cycles[PPM_EVENT_MAX];
+
 private:
 	internal_metrics::registry m_metrics_registry;
 	FILE* m_output_target;
@@ -0,0 +1,186 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "string_search.h"
+
+#ifndef _GNU_SOURCE
+//
+// Fallback implementation of memmem
+//
+void *memmem(const void *haystack, size_t haystacklen, const void *needle, size_t needlelen);
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static inline char ascii_tolower(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? (c | 0x20) : c;
+}
+
+// compares len bytes of str, folded to lower case, with the lower case needle
+static inline bool ascii_equal_nocase(const char* str, const char* lower, size_t len)
+{
+	for(size_t j = 0; j < len; j++)
+	{
+		if(ascii_tolower(str[j]) != lower[j])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+#if defined(__SSE2__)
+static inline __m128i ascii_tolower_sse2(__m128i block)
+{
+	// 'A'..'Z' are moved to the bottom of the signed range, so that a
+	// single signed comparison selects them
+	const __m128i shifted = _mm_add_epi8(block, _mm_set1_epi8(0x80 - 'A'));
+	const __m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-0x80 + 26));
+	return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+static inline int ctz(unsigned mask)
+{
+#ifdef _MSC_VER
+	unsigned long pos;
+	_BitScanForward(&pos, mask);
+	return (int)pos;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+string_search::string_search():
+	m_set(false)
+{
+}
+
+void string_search::set(const char* needle, size_t len)
+{
+	m_needle.assign(needle, len);
+	m_lower.resize(len);
+	for(size_t j = 0; j < len; j++)
+	{
+		m_lower[j] = ascii_tolower(needle[j]);
+	}
+	m_set = true;
+}
+
+void string_search::clear()
+{
+	m_needle.clear();
+	m_lower.clear();
+	m_set = false;
+}
+
+const char* string_search::find(const char* haystack, size_t len) const
+{
+	const size_t k = m_needle.size();
+	if(k < 2 || len < k)
+	{
+		return find_scalar(haystack, len);
+	}
+
+	size_t pos = 0;
+#if defined(__SSE2__)
+	const char* needle = m_needle.data();
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i last = _mm_set1_epi8(needle[k - 1]);
+	for(; pos + k - 1 + 16 <= len; pos += 16)
+	{
+		const __m128i block_first = _mm_loadu_si128((const __m128i*)(haystack + pos));
+		const __m128i block_last = _mm_loadu_si128((const __m128i*)(haystack + pos + k - 1));
+		unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+								_mm_cmpeq_epi8(last, block_last)));
+		while(mask)
+		{
+			const char* candidate = haystack + pos + ctz(mask);
+			if(memcmp(candidate + 1, needle + 1, k - 2) == 0)
+			{
+				return candidate;
+			}
+			mask &= mask - 1;
+		}
+	}
+#endif
+	return find_scalar(haystack + pos, len - pos);
+}
+
+const char* string_search::find_nocase(const char* haystack, size_t len) const
+{
+	const size_t k = m_lower.size();
+	if(k < 2 || len < k)
+	{
+		return find_nocase_scalar(haystack, len);
+	}
+
+	size_t pos = 0;
+#if defined(__SSE2__)
+	const char* lower = m_lower.data();
+	const __m128i first = _mm_set1_epi8(lower[0]);
+	const __m128i last = _mm_set1_epi8(lower[k - 1]);
+	for(; pos + k - 1 + 16 <= len; pos += 16)
+	{
+		const __m128i block_first = ascii_tolower_sse2(_mm_loadu_si128((const __m128i*)(haystack + pos)));
+		const __m128i block_last = ascii_tolower_sse2(_mm_loadu_si128((const __m128i*)(haystack + pos + k - 1)));
+		unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+								_mm_cmpeq_epi8(last, block_last)));
+		while(mask)
+		{
+			const char* candidate = haystack + pos + ctz(mask);
+			if(ascii_equal_nocase(candidate + 1, lower + 1, k - 2))
+			{
+				return candidate;
+			}
+			mask &= mask - 1;
+		}
+	}
+#endif
+	return find_nocase_scalar(haystack + pos, len - pos);
+}
+
+const char* string_search::find_scalar(const char* haystack, size_t len) const
+{
+	return (const char*)memmem(haystack, len, m_needle.data(), m_needle.size());
+}
+
+const char* string_search::find_nocase_scalar(const char* haystack, size_t len) const
+{
+	const size_t k = m_lower.size();
+	if(k == 0)
+	{
+		return haystack;
+	}
+	if(len < k)
+	{
+		return NULL;
+	}
+
+	const char* end = haystack + len - k;
+	for(const char* p = haystack; p <= end; p++)
+	{
+		if(ascii_tolower(*p) == m_lower[0] && ascii_equal_nocase(p + 1, m_lower.data() + 1, k - 1))
+		{
+			return p;
+		}
+	}
+	return NULL;
+}
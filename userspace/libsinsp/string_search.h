@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <string.h>
+
+#include <string>
+
+//
+// A string filter value, prepared once when the filter is compiled so
+// that evaluating contains/icontains/startswith/endswith does not have
+// to measure or case-fold it again for every event.
+//
+// Searches scan 16 bytes at a time (SSE2), looking for positions where
+// both the first and the last byte of the needle match, and only then
+// compare the whole needle; builds without SSE2 use a scalar search.
+// Case-insensitive searches fold ASCII letters only.
+//
+class string_search
+{
+public:
+	string_search();
+
+	void set(const char* needle, size_t len);
+	void clear();
+
+	// true if set() was called
+	bool is_set() const;
+
+	const char* data() const;
+	size_t size() const;
+
+	// first occurrence of the needle in haystack (len bytes), or NULL
+	const char* find(const char* haystack, size_t len) const;
+	const char* find_nocase(const char* haystack, size_t len) const;
+
+	bool is_prefix_of(const char* str) const;
+	bool is_suffix_of(const char* str, size_t len) const;
+
+private:
+	const char* find_scalar(const char* haystack, size_t len) const;
+	const char* find_nocase_scalar(const char* haystack, size_t len) const;
+
+	std::string m_needle;
+	std::string m_lower;
+	bool m_set;
+};
+
+inline bool string_search::is_set() const
+{
+	return m_set;
+}
+
+inline const char* string_search::data() const
+{
+	return m_needle.c_str();
+}
+
+inline size_t string_search::size() const
+{
+	return m_needle.size();
+}
+
+inline bool string_search::is_prefix_of(const char* str) const
+{
+	return strncmp(str, m_needle.c_str(), m_needle.size()) == 0;
+}
+
+inline bool string_search::is_suffix_of(const char* str, size_t len) const
+{
+	return len >= m_needle.size() &&
+		memcmp(str + len - m_needle.size(), m_needle.c_str(), m_needle.size()) == 0;
+}
@@ -22,6 +22,7 @@ limitations under the License.
 #include "../../driver/ppm_ringbuffer.h"
 #include "filter.h"
 #include "filterchecks.h"
+#include "sketches.h"
 #include "table.h"
 
 extern sinsp_filter_check_list g_filterlist;
@@ -33,6 +34,17 @@ extern sinsp_evttables g_infotables;
 typedef struct table_row_cmp
 {
 	bool operator()(const sinsp_sample_row& src, const sinsp_sample_row& dst)
+	{
+		return compare(src.m_values[m_colid], dst.m_values[m_colid]);
+	}
+
+	bool operator()(const pair<sinsp_table_field, sinsp_table_field*>& src,
+		const pair<sinsp_table_field, sinsp_table_field*>& dst)
+	{
+		return compare(src.second[m_colid], dst.second[m_colid]);
+	}
+
+	bool compare(const sinsp_table_field& src, const sinsp_table_field& dst)
 	{
 		cmpop op;
 
@@ -45,24 +57,23 @@ typedef struct table_row_cmp
 			op = CO_GT;
 		}
 
-		if(src.m_values[m_colid].m_cnt > 1 ||
-			dst.m_values[m_colid].m_cnt > 1)
+		if(src.m_cnt > 1 || dst.m_cnt > 1)
 		{
 			return flt_compare_avg(op, m_type, 
-				src.m_values[m_colid].m_val, 
-				dst.m_values[m_colid].m_val, 
-				src.m_values[m_colid].m_len, 
-				dst.m_values[m_colid].m_len,
-				src.m_values[m_colid].m_cnt, 
-				dst.m_values[m_colid].m_cnt);
+				src.m_val, 
+				dst.m_val, 
+				src.m_len, 
+				dst.m_len,
+				src.m_cnt, 
+				dst.m_cnt);
 		}
 		else
 		{
 			return flt_compare(op, m_type, 
-				src.m_values[m_colid].m_val, 
-				dst.m_values[m_colid].m_val, 
-				src.m_values[m_colid].m_len, 
-				dst.m_values[m_colid].m_len);
+				src.m_val, 
+				dst.m_val, 
+				src.m_len, 
+				dst.m_len);
 		}
 	}
 
@@ -71,1371 +82,1756 @@ typedef struct table_row_cmp
 	bool m_ascending;
 }table_row_cmp;
 
-sinsp_table::sinsp_table(sinsp* inspector, tabletype type, uint64_t refresh_interval_ns, 
-	sinsp_table::output_type output_type, uint32_t json_first_row, uint32_t json_last_row)
-{
-	m_inspector = inspector;
-	m_type = type;
-	m_is_key_present = false;
-	m_is_groupby_key_present = false;
-	m_fld_pointers = NULL;
-	m_premerge_fld_pointers = NULL;
-	m_postmerge_fld_pointers = NULL;
-	m_n_fields = 0;
-	m_n_premerge_fields = 0;
-	m_n_postmerge_fields = 0;
-	m_refresh_interval_ns = refresh_interval_ns;
-	m_output_type = output_type;
-	m_next_flush_time_ns = 0;
-	m_prev_flush_time_ns = 0;
-	m_printer = new sinsp_filter_check_reference();
-	m_buffer = &m_buffer1;
-	m_is_sorting_ascending = false;
-	m_sorting_col = -1;
-	m_just_sorted = true;
-	m_do_merging = true;
-	m_types = &m_premerge_types;
-	m_table = &m_premerge_table;
-	m_extractors = &m_premerge_extractors;
-	m_filter = NULL;
-	m_use_defaults = false;
-	m_zero_u64 = 0;
-	m_zero_double = 0;
-	m_paused = false;
-	m_sample_data = NULL;
-	m_json_first_row = json_first_row;
-	m_json_last_row = json_last_row;
-}
-
-sinsp_table::~sinsp_table()
+//
+// Row accumulators. Every column gets the one for its type and
+// aggregation in configure(), so that adding a row to an existing one
+// does not dispatch on either.
+//
+static inline void table_copy_buf(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer* buffer)
 {
-	uint32_t j;
-
-	for(j = 0; j < m_chks_to_free.size(); j++)
+	if(dst->m_len >= src->m_len)
 	{
-		delete m_chks_to_free[j];
-	}
-
-	if(m_premerge_fld_pointers != NULL)
-	{
-		delete[] m_premerge_fld_pointers;
+		memcpy(dst->m_val, src->m_val, src->m_len);
 	}
-
-	if(m_postmerge_fld_pointers != NULL)
+	else
 	{
-		delete[] m_postmerge_fld_pointers;
+		dst->m_val = buffer->copy(src->m_val, src->m_len);
 	}
 
-	if(m_filter != NULL)
-	{
-		delete m_filter;
-	}
-	
-	delete m_printer;
+	dst->m_len = src->m_len;
 }
 
-void sinsp_table::configure(vector<sinsp_view_column_info>* entries, const string& filter, 
-	bool use_defaults, uint32_t view_depth)
+template<typename T>
+struct table_num_accumulator
 {
-	m_use_defaults = use_defaults;
-	m_view_depth = view_depth;
-
-	//
-	// If this is a list table, increase the refresh time to improve realtimyiness
-	//
-	if(m_type == sinsp_table::TT_LIST)
-	{
-		set_refresh_interval(200000000);
-	}
-
-	//////////////////////////////////////////////////////////////////////////////////////
-	// If a filter has been specified, compile it
-	//////////////////////////////////////////////////////////////////////////////////////
-	if(filter != "")
-	{
-		sinsp_filter_compiler compiler(m_inspector, filter);
-		m_filter = compiler.compile();
-	}
-
-	//////////////////////////////////////////////////////////////////////////////////////
-	// Extract the tokens
-	//////////////////////////////////////////////////////////////////////////////////////
-	m_premerge_extractors.clear();
-
-	for(auto vit : *entries)
+	static void sum(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
 	{
-		sinsp_filter_check* chk = g_filterlist.new_filter_check_from_fldname(vit.get_field(m_view_depth), 
-			m_inspector,
-			false);
+		if(src->m_cnt < 2)
+		{
+			*(T*)dst->m_val += *(T*)src->m_val;
+			return;
+		}
 
-		if(chk == NULL)
+		//
+		// The source is an average: add it as a single value
+		//
+		if(dst->m_cnt > 1)
 		{
-			throw sinsp_exception("invalid field name " + vit.get_field(m_view_depth));
+			*(T*)dst->m_val = *(T*)dst->m_val / dst->m_cnt;
 		}
 
-		chk->m_aggregation = (sinsp_field_aggregation)vit.m_aggregation;
-		m_chks_to_free.push_back(chk);
+		*(T*)dst->m_val += (*(T*)src->m_val) / src->m_cnt;
 
-		chk->parse_field_name(vit.get_field(m_view_depth).c_str(), true, false);
+		src->m_cnt = 1;
+		dst->m_cnt = 1;
+	}
 
-		if((vit.m_flags & TEF_IS_KEY) != 0)
-		{
-			if(m_is_key_present)
-			{
-				throw sinsp_exception("invalid table configuration: multiple keys specified");
-			}
+	static void avg(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
+	{
+		dst->m_cnt += src->m_cnt;
+		*(T*)dst->m_val += *(T*)src->m_val;
+	}
 
-			m_premerge_extractors.insert(m_premerge_extractors.begin(), chk);
-			m_is_key_present = true;
-		}
-		else
+	static void max(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
+	{
+		if(*(T*)dst->m_val < *(T*)src->m_val)
 		{
-			m_premerge_extractors.push_back(chk);
+			*(T*)dst->m_val = *(T*)src->m_val;
 		}
 	}
 
-	if(m_type == sinsp_table::TT_TABLE)
+	static void min(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
 	{
-		//
-		// Make sure this is a valid table
-		//
-		if(!m_is_key_present)
+		if(src->m_cnt == 0)
 		{
-			throw sinsp_exception("table is missing the key");
+			return;
 		}
-	}
-	else
-	{
-		sinsp_filter_check* chk = g_filterlist.new_filter_check_from_fldname("util.cnt", 
-			m_inspector,
-			false);
 
-		if(chk == NULL)
+		if(dst->m_cnt == 0)
 		{
-			throw sinsp_exception("internal table error");
+			*(T*)dst->m_val += *(T*)src->m_val;
+			dst->m_cnt++;
 		}
-
-		chk->m_aggregation = A_NONE;
-		m_chks_to_free.push_back(chk);
-
-		chk->parse_field_name("util.cnt", true, false);
-
-		if(m_is_key_present)
+		else if(*(T*)dst->m_val > *(T*)src->m_val)
 		{
-			throw sinsp_exception("list table can't have a key");
+			*(T*)dst->m_val = *(T*)src->m_val;
 		}
-
-		m_premerge_extractors.insert(m_premerge_extractors.begin(), chk);
-		m_is_key_present = true;
-	}
-
-	m_premerge_fld_pointers = new sinsp_table_field[m_premerge_extractors.size()];
-	m_fld_pointers = m_premerge_fld_pointers;
-	m_n_premerge_fields = (uint32_t)m_premerge_extractors.size();
-	m_n_fields = m_n_premerge_fields;
-
-	if(m_n_fields < 2)
-	{
-		throw sinsp_exception("table has no values");
-	}
-
-	for(auto it = m_premerge_extractors.begin(); it != m_premerge_extractors.end(); ++it)
-	{
-		m_premerge_types.push_back((*it)->get_field_info()->m_type);
-		m_premerge_legend.push_back(*(*it)->get_field_info());
 	}
+};
 
-	m_premerge_vals_array_sz = (m_n_fields - 1) * sizeof(sinsp_table_field);
-	m_vals_array_sz = m_premerge_vals_array_sz;
-
-	//////////////////////////////////////////////////////////////////////////////////////
-	// If a merge has been specified, configure it 
-	//////////////////////////////////////////////////////////////////////////////////////
-	uint32_t n_gby_keys = 0;
-
-	for(auto vit : *entries)
+//
+// Strings and buffers: max keeps the last value, the other aggregations
+// only track the counts
+//
+struct table_buf_accumulator
+{
+	static void sum(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
 	{
-		if((vit.m_flags & TEF_IS_GROUPBY_KEY) != 0)
+		if(src->m_cnt >= 2)
 		{
-			n_gby_keys++;
+			src->m_cnt = 1;
+			dst->m_cnt = 1;
 		}
 	}
 
-	if(n_gby_keys == 0)
+	static void avg(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
 	{
-		//
-		// No merge string. We can stop here
-		//
-		m_do_merging = false;
-		return;
-	}
-	else if(n_gby_keys > 1)
-	{
-		throw sinsp_exception("invalid table definition: multiple groupby keys");
+		dst->m_cnt += src->m_cnt;
 	}
 
-	//
-	// Merging not supported for lists
-	//
-	if(m_type != sinsp_table::TT_TABLE)
+	static void max(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer* buffer)
 	{
-		throw sinsp_exception("group by not supported for list tables");
+		table_copy_buf(dst, src, buffer);
 	}
 
-	m_do_merging = true;
-
-	for(uint32_t j = 0; j < entries->size(); j++)
+	static void min(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer* buffer)
 	{
-		auto vit = entries->at(j);
-
-		//
-		// Skip original key when grouping
-		//
-		if((vit.m_flags & TEF_IS_KEY) != 0)
+		if(src->m_cnt == 0)
 		{
-			continue;
+			return;
 		}
 
-
-		sinsp_filter_check* chk = m_premerge_extractors[j];
-
-		chk->m_merge_aggregation = (sinsp_field_aggregation)vit.m_groupby_aggregation;
-
-		if((vit.m_flags & TEF_IS_GROUPBY_KEY) != 0)
+		if(dst->m_cnt == 0)
 		{
-			if(m_is_groupby_key_present)
-			{
-				throw sinsp_exception("invalid table configuration: more than one groupby key specified");
-			}
-
-			m_is_groupby_key_present = true;
-			m_postmerge_extractors.insert(m_postmerge_extractors.begin(), chk);
-			m_groupby_columns.insert(m_groupby_columns.begin(), j);
+			dst->m_cnt++;
 		}
 		else
 		{
-			m_postmerge_extractors.push_back(chk);
-			m_groupby_columns.push_back(j);
+			ASSERT(false); // Not supposed to use this
+			table_copy_buf(dst, src, buffer);
 		}
 	}
+};
 
-	m_postmerge_fld_pointers = new sinsp_table_field[m_postmerge_extractors.size()];
-	m_n_postmerge_fields = (uint32_t)m_postmerge_extractors.size();
+//
+// All the other types, which can't be aggregated
+//
+struct table_none_accumulator
+{
+	static void sum(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer* buffer)
+	{
+		table_buf_accumulator::sum(dst, src, buffer);
+	}
 
-	if(!m_is_groupby_key_present)
+	static void avg(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer* buffer)
 	{
-		throw sinsp_exception("table is missing the groupby key");
+		table_buf_accumulator::avg(dst, src, buffer);
 	}
 
-	if(m_groupby_columns.size() < 2)
+	static void max(sinsp_table_field*, sinsp_table_field*, sinsp_table_buffer*)
 	{
-		throw sinsp_exception("groupby table has no values");
 	}
 
-	for(auto it = m_postmerge_extractors.begin(); it != m_postmerge_extractors.end(); ++it)
+	static void min(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
 	{
-		m_postmerge_types.push_back((*it)->get_field_info()->m_type);
-		m_postmerge_legend.push_back(*(*it)->get_field_info());
+		if(src->m_cnt != 0 && dst->m_cnt == 0)
+		{
+			dst->m_cnt++;
+		}
 	}
+};
 
-	m_postmerge_vals_array_sz = (m_n_postmerge_fields - 1) * sizeof(sinsp_table_field);
+template<typename A>
+static sinsp_table_accumulator select_accumulator(uint32_t aggr)
+{
+	switch(aggr)
+	{
+	case A_NONE:
+		return NULL;
+	case A_SUM:
+	case A_TIME_AVG:
+		return &A::sum;
+	case A_AVG:
+		return &A::avg;
+	case A_MAX:
+		return &A::max;
+	case A_MIN:
+		return &A::min;
+	default:
+		ASSERT(false);
+		return NULL;
+	}
 }
 
-void sinsp_table::add_row(bool merging)
+static sinsp_table_accumulator get_accumulator(ppm_param_type type, uint32_t aggr)
 {
-	uint32_t j;
-
-	sinsp_table_field key(m_fld_pointers[0].m_val, 
-		m_fld_pointers[0].m_len,
-		m_fld_pointers[0].m_cnt);
-
-	if(m_type == sinsp_table::TT_TABLE)
+	switch(type)
 	{
-		//
-		// This is a table. Do a proper key lookup and update the entry
-		//
-		auto it = m_table->find(key);
+	case PT_INT8:
+		return select_accumulator<table_num_accumulator<int8_t>>(aggr);
+	case PT_INT16:
+		return select_accumulator<table_num_accumulator<int16_t>>(aggr);
+	case PT_INT32:
+		return select_accumulator<table_num_accumulator<int32_t>>(aggr);
+	case PT_INT64:
+		return select_accumulator<table_num_accumulator<int64_t>>(aggr);
+	case PT_UINT8:
+		return select_accumulator<table_num_accumulator<uint8_t>>(aggr);
+	case PT_UINT16:
+		return select_accumulator<table_num_accumulator<uint16_t>>(aggr);
+	case PT_UINT32:
+	case PT_BOOL:
+		return select_accumulator<table_num_accumulator<uint32_t>>(aggr);
+	case PT_UINT64:
+	case PT_RELTIME:
+	case PT_ABSTIME:
+		return select_accumulator<table_num_accumulator<uint64_t>>(aggr);
+	case PT_DOUBLE:
+		return select_accumulator<table_num_accumulator<double>>(aggr);
+	case PT_CHARBUF:
+	case PT_BYTEBUF:
+		return select_accumulator<table_buf_accumulator>(aggr);
+	default:
+		return select_accumulator<table_none_accumulator>(aggr);
+	}
+}
 
-		if(it == m_table->end())
+//
+// The length of the values of a type, or 0 if it depends on the value
+//
+static uint32_t get_fixed_field_len(ppm_param_type type)
+{
+	switch(type)
+	{
+	case PT_INT8:
+	case PT_UINT8:
+	case PT_FLAGS8:
+	case PT_SIGTYPE:
+		return 1;
+	case PT_INT16:
+	case PT_UINT16:
+	case PT_FLAGS16:
+	case PT_PORT:
+	case PT_SYSCALLID:
+		return 2;
+	case PT_INT32:
+	case PT_UINT32:
+	case PT_FLAGS32:
+	case PT_MODE:
+	case PT_BOOL:
+	case PT_IPV4ADDR:
+	case PT_SIGSET:
+		return 4;
+	case PT_INT64:
+	case PT_UINT64:
+	case PT_FD:
+	case PT_PID:
+	case PT_ERRNO:
+	case PT_RELTIME:
+	case PT_ABSTIME:
+		return 8;
+	case PT_DOUBLE:
+		return sizeof(double);
+	case PT_IPV6ADDR:
+		return sizeof(ipv6addr);
+	default:
+		return 0;
+	}
+}
+
+//
+// The sketch values of a row start with the result, which is what the
+// rest of the table sees, followed by the sketch
+//
+#define TABLE_SKETCH_OFFSET 8
+
+static inline hyperloglog* get_hll(sinsp_table_field* fld)
+{
+	return (hyperloglog*)(fld->m_val + TABLE_SKETCH_OFFSET);
+}
+
+static inline tdigest* get_tdigest(sinsp_table_field* fld)
+{
+	return (tdigest*)(fld->m_val + TABLE_SKETCH_OFFSET);
+}
+
+static sinsp_table_sketch get_sketch(uint32_t aggr, double* quantile)
+{
+	switch(aggr)
+	{
+	case A_DISTINCT:
+		return TS_DISTINCT;
+	case A_P50:
+		*quantile = 0.5;
+		return TS_QUANTILE;
+	case A_P90:
+		*quantile = 0.9;
+		return TS_QUANTILE;
+	case A_P95:
+		*quantile = 0.95;
+		return TS_QUANTILE;
+	case A_P99:
+		*quantile = 0.99;
+		return TS_QUANTILE;
+	default:
+		return TS_NONE;
+	}
+}
+
+static uint32_t get_sketch_storage_len(sinsp_table_sketch sketch)
+{
+	switch(sketch)
+	{
+	case TS_DISTINCT:
+		return TABLE_SKETCH_OFFSET + sizeof(hyperloglog);
+	case TS_QUANTILE:
+		return TABLE_SKETCH_OFFSET + sizeof(tdigest);
+	default:
+		ASSERT(false);
+		return 0;
+	}
+}
+
+static void table_distinct_add(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
+{
+	if(src->m_cnt != 0)
+	{
+		get_hll(dst)->add(sinsp_table_field_hasher::hash64(src->m_val, src->m_len));
+	}
+}
+
+static void table_distinct_merge(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
+{
+	get_hll(dst)->merge(*get_hll(src));
+}
+
+template<typename T>
+static void table_quantile_add(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
+{
+	if(src->m_cnt != 0)
+	{
+		get_tdigest(dst)->add((double)*(T*)src->m_val);
+	}
+}
+
+static void table_quantile_merge(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer*)
+{
+	get_tdigest(dst)->merge(*get_tdigest(src));
+}
+
+static sinsp_table_accumulator get_sketch_accumulator(const sinsp_table_column& col)
+{
+	if(col.m_sketch == TS_DISTINCT)
+	{
+		return col.m_sketch_input? &table_distinct_merge : &table_distinct_add;
+	}
+	else if(col.m_sketch_input)
+	{
+		return &table_quantile_merge;
+	}
+
+	switch(col.m_type)
+	{
+	case PT_INT8:
+		return &table_quantile_add<int8_t>;
+	case PT_INT16:
+		return &table_quantile_add<int16_t>;
+	case PT_INT32:
+		return &table_quantile_add<int32_t>;
+	case PT_INT64:
+		return &table_quantile_add<int64_t>;
+	case PT_UINT8:
+		return &table_quantile_add<uint8_t>;
+	case PT_UINT16:
+		return &table_quantile_add<uint16_t>;
+	case PT_UINT32:
+		return &table_quantile_add<uint32_t>;
+	case PT_UINT64:
+	case PT_RELTIME:
+	case PT_ABSTIME:
+		return &table_quantile_add<uint64_t>;
+	case PT_DOUBLE:
+		return &table_quantile_add<double>;
+	default:
+		return NULL;
+	}
+}
+
+static void store_quantile(ppm_param_type type, uint8_t* dst, double val)
+{
+	switch(type)
+	{
+	case PT_INT8:
+		*(int8_t*)dst = (int8_t)val;
+		return;
+	case PT_INT16:
+		*(int16_t*)dst = (int16_t)val;
+		return;
+	case PT_INT32:
+		*(int32_t*)dst = (int32_t)val;
+		return;
+	case PT_INT64:
+		*(int64_t*)dst = (int64_t)val;
+		return;
+	case PT_UINT8:
+		*(uint8_t*)dst = (uint8_t)val;
+		return;
+	case PT_UINT16:
+		*(uint16_t*)dst = (uint16_t)val;
+		return;
+	case PT_UINT32:
+		*(uint32_t*)dst = (uint32_t)val;
+		return;
+	case PT_UINT64:
+	case PT_RELTIME:
+	case PT_ABSTIME:
+		*(uint64_t*)dst = (uint64_t)val;
+		return;
+	case PT_DOUBLE:
+		*(double*)dst = val;
+		return;
+	default:
+		ASSERT(false);
+		return;
+	}
+}
+
+sinsp_table::sinsp_table(sinsp* inspector, tabletype type, uint64_t refresh_interval_ns, 
+	sinsp_table::output_type output_type, uint32_t json_first_row, uint32_t json_last_row)
+{
+	m_inspector = inspector;
+	m_type = type;
+	m_is_key_present = false;
+	m_is_groupby_key_present = false;
+	m_fld_pointers = NULL;
+	m_premerge_fld_pointers = NULL;
+	m_postmerge_fld_pointers = NULL;
+	m_n_fields = 0;
+	m_n_premerge_fields = 0;
+	m_n_postmerge_fields = 0;
+	m_refresh_interval_ns = refresh_interval_ns;
+	m_output_type = output_type;
+	m_next_flush_time_ns = 0;
+	m_prev_flush_time_ns = 0;
+	m_printer = new sinsp_filter_check_reference();
+	m_buffer = &m_buffer1;
+	m_is_sorting_ascending = false;
+	m_sorting_col = -1;
+	m_just_sorted = true;
+	m_do_merging = true;
+	m_types = &m_premerge_types;
+	m_columns = &m_premerge_columns;
+	m_table = &m_premerge_table;
+	m_extractors = &m_premerge_extractors;
+	m_filter = NULL;
+	m_use_defaults = false;
+	m_zero_u64 = 0;
+	m_zero_double = 0;
+	m_paused = false;
+	m_max_rows = 0;
+	m_sample_data = NULL;
+	m_json_first_row = json_first_row;
+	m_json_last_row = json_last_row;
+}
+
+sinsp_table::~sinsp_table()
+{
+	uint32_t j;
+
+	for(j = 0; j < m_chks_to_free.size(); j++)
+	{
+		delete m_chks_to_free[j];
+	}
+
+	if(m_premerge_fld_pointers != NULL)
+	{
+		delete[] m_premerge_fld_pointers;
+	}
+
+	if(m_postmerge_fld_pointers != NULL)
+	{
+		delete[] m_postmerge_fld_pointers;
+	}
+
+	if(m_filter != NULL)
+	{
+		delete m_filter;
+	}
+	
+	delete m_printer;
+}
+
+void sinsp_table::configure(vector<sinsp_view_column_info>* entries, const string& filter, 
+	bool use_defaults, uint32_t view_depth)
+{
+	m_use_defaults = use_defaults;
+	m_view_depth = view_depth;
+
+	//
+	// If this is a list table, increase the refresh time to improve realtimyiness
+	//
+	if(m_type == sinsp_table::TT_LIST)
+	{
+		set_refresh_interval(200000000);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////
+	// If a filter has been specified, compile it
+	//////////////////////////////////////////////////////////////////////////////////////
+	if(filter != "")
+	{
+		sinsp_filter_compiler compiler(m_inspector, filter);
+		m_filter = compiler.compile();
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////
+	// Extract the tokens
+	//////////////////////////////////////////////////////////////////////////////////////
+	m_premerge_extractors.clear();
+
+	for(auto vit : *entries)
+	{
+		sinsp_filter_check* chk = g_filterlist.new_filter_check_from_fldname(vit.get_field(m_view_depth), 
+			m_inspector,
+			false);
+
+		if(chk == NULL)
 		{
-			//
-			// New entry
-			//
-			key.m_val = key.m_val;
-			key.m_cnt = 1;
-			m_vals = (sinsp_table_field*)m_buffer->reserve(m_vals_array_sz);
+			throw sinsp_exception("invalid field name " + vit.get_field(m_view_depth));
+		}
 
-			for(j = 1; j < m_n_fields; j++)
+		chk->m_aggregation = (sinsp_field_aggregation)vit.m_aggregation;
+		m_chks_to_free.push_back(chk);
+
+		chk->parse_field_name(vit.get_field(m_view_depth).c_str(), true, false);
+
+		if((vit.m_flags & TEF_IS_KEY) != 0)
+		{
+			if(m_is_key_present)
 			{
-				uint32_t vlen = get_field_len(j);
-				m_vals[j - 1].m_val = m_fld_pointers[j].m_val;
-				m_vals[j - 1].m_len = vlen;
-				m_vals[j - 1].m_cnt = m_fld_pointers[j].m_cnt;
+				throw sinsp_exception("invalid table configuration: multiple keys specified");
 			}
 
-			(*m_table)[key] = m_vals;
+			m_premerge_extractors.insert(m_premerge_extractors.begin(), chk);
+			m_is_key_present = true;
 		}
 		else
 		{
-			//
-			// Existing entry
-			//
-			m_vals = it->second;
+			m_premerge_extractors.push_back(chk);
+		}
+	}
 
-			for(j = 1; j < m_n_fields; j++)
-			{
-				if(merging)
-				{
-					add_fields(j, &m_fld_pointers[j], m_postmerge_extractors[j]->m_merge_aggregation);
-				}
-				else
-				{
-					add_fields(j, &m_fld_pointers[j], m_premerge_extractors[j]->m_aggregation);
-				}
-			}
+	if(m_type == sinsp_table::TT_TABLE)
+	{
+		//
+		// Make sure this is a valid table
+		//
+		if(!m_is_key_present)
+		{
+			throw sinsp_exception("table is missing the key");
 		}
 	}
 	else
 	{
+		sinsp_filter_check* chk = g_filterlist.new_filter_check_from_fldname("util.cnt", 
+			m_inspector,
+			false);
+
+		if(chk == NULL)
+		{
+			throw sinsp_exception("internal table error");
+		}
+
+		chk->m_aggregation = A_NONE;
+		m_chks_to_free.push_back(chk);
+
+		chk->parse_field_name("util.cnt", true, false);
+
+		if(m_is_key_present)
+		{
+			throw sinsp_exception("list table can't have a key");
+		}
+
+		m_premerge_extractors.insert(m_premerge_extractors.begin(), chk);
+		m_is_key_present = true;
+	}
+
+	m_premerge_fld_pointers = new sinsp_table_field[m_premerge_extractors.size()];
+	m_fld_pointers = m_premerge_fld_pointers;
+	m_n_premerge_fields = (uint32_t)m_premerge_extractors.size();
+	m_n_fields = m_n_premerge_fields;
+
+	if(m_n_fields < 2)
+	{
+		throw sinsp_exception("table has no values");
+	}
+
+	configure_columns(&m_premerge_extractors, &m_premerge_columns, false);
+
+	for(uint32_t j = 0; j < m_n_premerge_fields; j++)
+	{
+		m_premerge_types.push_back(m_premerge_columns[j].m_result_type);
+		m_premerge_legend.push_back(*m_premerge_extractors[j]->get_field_info());
+
+		if(m_premerge_columns[j].m_result_type != m_premerge_legend[j].m_type)
+		{
+			m_premerge_legend[j].m_type = m_premerge_columns[j].m_result_type;
+			m_premerge_legend[j].m_print_format = PF_DEC;
+		}
+	}
+
+	m_premerge_vals_array_sz = (m_n_fields - 1) * sizeof(sinsp_table_field);
+	m_vals_array_sz = m_premerge_vals_array_sz;
+
+	//////////////////////////////////////////////////////////////////////////////////////
+	// If a merge has been specified, configure it 
+	//////////////////////////////////////////////////////////////////////////////////////
+	uint32_t n_gby_keys = 0;
+
+	for(auto vit : *entries)
+	{
+		if((vit.m_flags & TEF_IS_GROUPBY_KEY) != 0)
+		{
+			n_gby_keys++;
+		}
+	}
+
+	if(n_gby_keys == 0)
+	{
+		//
+		// No merge string. We can stop here
+		//
+		m_do_merging = false;
+		return;
+	}
+	else if(n_gby_keys > 1)
+	{
+		throw sinsp_exception("invalid table definition: multiple groupby keys");
+	}
+
+	//
+	// Merging not supported for lists
+	//
+	if(m_type != sinsp_table::TT_TABLE)
+	{
+		throw sinsp_exception("group by not supported for list tables");
+	}
+
+	m_do_merging = true;
+
+	for(uint32_t j = 0; j < entries->size(); j++)
+	{
+		auto vit = entries->at(j);
+
 		//
-		// We are in list mode. Just append the row to the end of the sample
+		// Skip original key when grouping
 		//
-		if(m_paused)
+		if((vit.m_flags & TEF_IS_KEY) != 0)
 		{
-			return;
+			continue;
 		}
 
-		sinsp_sample_row row;
 
-		//
-		// This is a list. Create the new entry and push it back.
-		//
-		key.m_val = key.m_val;
-		key.m_cnt = 1;
-		row.m_key = key;
+		sinsp_filter_check* chk = m_premerge_extractors[j];
 
-		m_vals = (sinsp_table_field*)m_buffer->reserve(m_vals_array_sz);
+		chk->m_merge_aggregation = (sinsp_field_aggregation)vit.m_groupby_aggregation;
 
-		for(j = 1; j < m_n_fields; j++)
+		if((vit.m_flags & TEF_IS_GROUPBY_KEY) != 0)
 		{
-			uint32_t vlen = get_field_len(j);
-			m_vals[j - 1].m_val = m_fld_pointers[j].m_val;
-			m_vals[j - 1].m_len = vlen;
-			m_vals[j - 1].m_cnt = 1;
-			row.m_values.push_back(m_vals[j - 1]);
-		}
+			if(m_is_groupby_key_present)
+			{
+				throw sinsp_exception("invalid table configuration: more than one groupby key specified");
+			}
 
-		m_full_sample_data.push_back(row);
+			m_is_groupby_key_present = true;
+			m_postmerge_extractors.insert(m_postmerge_extractors.begin(), chk);
+			m_groupby_columns.insert(m_groupby_columns.begin(), j);
+		}
+		else
+		{
+			m_postmerge_extractors.push_back(chk);
+			m_groupby_columns.push_back(j);
+		}
 	}
-}
 
-void sinsp_table::process_event(sinsp_evt* evt)
-{
-	uint32_t j;
+	m_postmerge_fld_pointers = new sinsp_table_field[m_postmerge_extractors.size()];
+	m_n_postmerge_fields = (uint32_t)m_postmerge_extractors.size();
 
-	//
-	// Apply the filter
-	//
-	if(m_filter)
+	if(!m_is_groupby_key_present)
 	{
-		if(!m_filter->run(evt))
-		{
-			return;
-		}
+		throw sinsp_exception("table is missing the groupby key");
 	}
 
-	//
-	// Extract the values and create the row to add
-	//
-	for(j = 0; j < m_n_premerge_fields; j++)
+	if(m_groupby_columns.size() < 2)
 	{
-		uint32_t len;
-		uint8_t* val = m_premerge_extractors[j]->extract(evt, &len);
+		throw sinsp_exception("groupby table has no values");
+	}
 
-		sinsp_table_field* pfld = &(m_premerge_fld_pointers[j]);
+	configure_columns(&m_postmerge_extractors, &m_postmerge_columns, true);
 
-		//
-		// XXX For the moment, we only support defaults for numeric fields.
-		// At a certain point we will want to introduce the concept of zero
-		// for other fields too.
-		//
-		if(val == NULL)
-		{
-			if(m_use_defaults)
-			{
-				pfld->m_val = get_default_val(&m_premerge_legend[j]);
-				if(pfld->m_val == NULL)
-				{
-					return;
-				}
+	for(uint32_t j = 0; j < m_n_postmerge_fields; j++)
+	{
+		m_postmerge_types.push_back(m_postmerge_columns[j].m_result_type);
+		m_postmerge_legend.push_back(*m_postmerge_extractors[j]->get_field_info());
 
-				pfld->m_len = get_field_len(j);
-				pfld->m_val = m_buffer->copy(pfld->m_val, pfld->m_len);
-				pfld->m_cnt = 0;
-			}
-			else
-			{
-				return;
-			}
-		}
-		else
+		if(m_postmerge_columns[j].m_result_type != m_postmerge_legend[j].m_type)
 		{
-			pfld->m_val = val;
-			pfld->m_len = get_field_len(j);
-			pfld->m_val = m_buffer->copy(val, pfld->m_len);
-			pfld->m_cnt = 1;
+			m_postmerge_legend[j].m_type = m_postmerge_columns[j].m_result_type;
+			m_postmerge_legend[j].m_print_format = PF_DEC;
 		}
 	}
 
-	//
-	// Add the row
-	//
-	add_row(false);
-
-	return;
+	m_postmerge_vals_array_sz = (m_n_postmerge_fields - 1) * sizeof(sinsp_table_field);
 }
 
-void sinsp_table::process_proctable(sinsp_evt* evt)
+void sinsp_table::configure_columns(vector<sinsp_filter_check*>* extractors,
+	vector<sinsp_table_column>* columns, bool merging)
 {
-	sinsp_evt tevt;
-	scap_evt tscapevt;
+	columns->clear();
 
-	threadinfo_map_t* threadtable  = m_inspector->m_thread_manager->get_threads();
-	ASSERT(threadtable != NULL);
+	for(auto it = extractors->begin(); it != extractors->end(); ++it)
+	{
+		sinsp_filter_check* chk = *it;
+		sinsp_table_column col;
+		uint32_t aggr = merging? chk->m_merge_aggregation : chk->m_aggregation;
+		double input_quantile = 0;
+		sinsp_table_sketch input_sketch = TS_NONE;
 
-	uint64_t ts = evt->get_ts();
-	uint64_t ts_s = ts - (ts % ONE_SECOND_IN_NS);
-	tscapevt.ts = ts_s - 1;
+		if(it == extractors->begin())
+		{
+			// keys are never aggregated
+			aggr = A_NONE;
+		}
+		else if(merging)
+		{
+			//
+			// The values come from the rows of the premerge table, where
+			// they may be sketches already
+			//
+			input_sketch = get_sketch(chk->m_aggregation, &input_quantile);
+		}
 
-	//
-	// Note: as the event type for this fake event, we pick one of the unused
-	//       numbers, so we guarantee that filter checks will not wrongly pick it up
-	//
-	tscapevt.type = PPME_SYSDIGEVENT_X;
-	tscapevt.len = 0;
-	tscapevt.nparams = 0;
+		col.m_type = (input_sketch == TS_DISTINCT)? PT_UINT64 : chk->get_field_info()->m_type;
+		col.m_fixed_len = get_fixed_field_len(col.m_type);
+		col.m_quantile = 0;
+		col.m_sketch = get_sketch(aggr, &col.m_quantile);
+		col.m_sketch_input = (input_sketch != TS_NONE);
+		col.m_result_type = (col.m_sketch == TS_DISTINCT)? PT_UINT64 : col.m_type;
 
-	tevt.m_inspector = m_inspector;
-	tevt.m_info = &(g_infotables.m_event_info[PPME_SYSDIGEVENT_X]);
-	tevt.m_pevt = NULL;
-	tevt.m_cpuid = 0;
-	tevt.m_evtnum = 0;
-	tevt.m_pevt = &tscapevt;
-	tevt.m_fdinfo = NULL;
+		if(col.m_sketch == TS_NONE)
+		{
+			col.m_accumulate = get_accumulator(col.m_type, aggr);
+			col.m_combine = col.m_accumulate;
+		}
+		else
+		{
+			string name = chk->get_field_info()->m_name;
 
-	threadtable->loop([&] (sinsp_threadinfo& tinfo) {
-		tevt.m_tinfo = &tinfo;
-		tscapevt.tid = tevt.m_tinfo->m_tid;
+			if(m_type != sinsp_table::TT_TABLE)
+			{
+				throw sinsp_exception("invalid aggregation for " + name + ": list tables can't aggregate");
+			}
 
-		if(m_filter)
-		{
-			if(!m_filter->run(&tevt))
+			if(col.m_sketch_input && col.m_sketch != input_sketch)
 			{
-				return true;
+				throw sinsp_exception("invalid aggregation for " + name + ": distinct counts and percentiles can't be merged into each other");
+			}
+
+			col.m_accumulate = get_sketch_accumulator(col);
+			if(col.m_accumulate == NULL)
+			{
+				throw sinsp_exception("invalid aggregation for " + name + ": percentiles need a numeric field");
 			}
+
+			col.m_combine = (col.m_sketch == TS_DISTINCT)? &table_distinct_merge : &table_quantile_merge;
 		}
 
-		process_event(&tevt);
-		return true;
-	});
+		columns->push_back(col);
+	}
 }
 
-void sinsp_table::flush(sinsp_evt* evt)
-{	
-	if(!m_paused)
+void sinsp_table::add_row(bool merging)
+{
+	uint32_t j;
+
+	sinsp_table_field key(m_fld_pointers[0].m_val, 
+		m_fld_pointers[0].m_len,
+		m_fld_pointers[0].m_cnt);
+
+	if(m_type == sinsp_table::TT_TABLE)
 	{
-		if(m_next_flush_time_ns != 0)
-		{
-			//
-			// Time to emit the sample! 
-			// Add the proctable as a sample at the end of the second
-			//
-			process_proctable(evt);
+		//
+		// This is a table. Do a proper key lookup and update the entry
+		//
+		auto it = m_table->find(key);
 
+		if(it == m_table->end())
+		{
 			//
-			// If there is a merging step, switch the types to point to the merging ones.
+			// New entry. When merging, the fields already live in the
+			// table buffer, otherwise they are in the scratch buffer of
+			// the current event and need to be copied.
 			//
-			if(m_do_merging)
+			if(!merging)
 			{
-				m_types = &m_postmerge_types;
-				m_table = &m_merge_table;
-				m_n_fields = m_n_postmerge_fields;
-				m_vals_array_sz = m_postmerge_vals_array_sz;
-				m_fld_pointers = m_postmerge_fld_pointers;
-				m_extractors = &m_postmerge_extractors;
+				key.m_val = m_buffer->copy(key.m_val, key.m_len);
 			}
 
-			//
-			// Emit the sample
-			//
-			create_sample();
+			key.m_cnt = 1;
+			m_vals = (sinsp_table_field*)m_buffer->reserve(m_vals_array_sz);
 
-			if(m_type == sinsp_table::TT_TABLE)
+			for(j = 1; j < m_n_fields; j++)
 			{
-				//
-				// Switch the data storage so that the current one is still usable by the 
-				// consumers of the table.
-				//
-				switch_buffers();
+				const sinsp_table_column* col = &((*m_columns)[j]);
+				sinsp_table_field* fld = &(m_fld_pointers[j]);
 
-				//
-				// Clear the current data storage
-				//
-				m_buffer->clear();
+				if(col->m_sketch != TS_NONE && !col->m_sketch_input)
+				{
+					init_sketch(col, &(m_vals[j - 1]), fld);
+					continue;
+				}
+
+				m_vals[j - 1].m_val = merging? fld->m_val : m_buffer->copy(fld->m_val, fld->m_len);
+				m_vals[j - 1].m_len = fld->m_len;
+				m_vals[j - 1].m_cnt = fld->m_cnt;
 			}
 
+			m_table->emplace(key, m_vals);
+
+			if(m_max_rows != 0 && !merging && !m_do_merging &&
+				m_table->size() >= 2 * m_max_rows * SINSP_TABLE_TOPK_OVERSAMPLING)
+			{
+				prune_table();
+			}
+		}
+		else
+		{
 			//
-			// Reinitialize the tables
+			// Existing entry
 			//
-			m_premerge_table.clear();
-			m_merge_table.clear();
-		}
-	}
-
-	uint64_t ts = evt->get_ts();
-
-	m_prev_flush_time_ns = m_next_flush_time_ns;
-	m_next_flush_time_ns = ts - (ts % m_refresh_interval_ns) + m_refresh_interval_ns;
-
-	return;
-}
+			m_vals = it->second;
 
-void sinsp_table::print_raw(vector<sinsp_sample_row>* sample_data, uint64_t time_delta)
-{
-	vector<filtercheck_field_info>* legend = get_legend();
+			for(j = 1; j < m_n_fields; j++)
+			{
+				sinsp_table_accumulator accumulate = (*m_columns)[j].m_accumulate;
 
-	for(auto it = sample_data->begin(); it != sample_data->end(); ++it)
+				if(accumulate != NULL)
+				{
+					accumulate(&(m_vals[j - 1]), &(m_fld_pointers[j]), m_buffer);
+				}
+			}
+		}
+	}
+	else
 	{
-		for(uint32_t j = 0; j < m_n_fields - 1; j++)
+		//
+		// We are in list mode. Just append the row to the end of the sample
+		//
+		if(m_paused)
 		{
-			sinsp_filter_check* extractor = m_extractors->at(j + 1);
-			uint64_t td = 0;
+			return;
+		}
 
-			if(extractor->m_aggregation == A_TIME_AVG || 
-				extractor->m_merge_aggregation == A_TIME_AVG)
-			{
-				td = time_delta;
-			}
+		sinsp_sample_row row;
 
-			m_printer->set_val(m_types->at(j + 1), 
-				it->m_values[j].m_val,
-				it->m_values[j].m_len,
-				it->m_values[j].m_cnt,
-				legend->at(j + 1).m_print_format);
-			char* prstr = m_printer->tostring_nice(NULL, 10, td);
-			printf("%s ", prstr);
-			//printf("%s ", m_printer->tostring(NULL));
+		//
+		// This is a list. Create the new entry and push it back.
+		//
+		key.m_val = m_buffer->copy(key.m_val, key.m_len);
+		key.m_cnt = 1;
+		row.m_key = key;
+
+		m_vals = (sinsp_table_field*)m_buffer->reserve(m_vals_array_sz);
+
+		for(j = 1; j < m_n_fields; j++)
+		{
+			m_vals[j - 1].m_val = m_buffer->copy(m_fld_pointers[j].m_val, m_fld_pointers[j].m_len);
+			m_vals[j - 1].m_len = m_fld_pointers[j].m_len;
+			m_vals[j - 1].m_cnt = 1;
+			row.m_values.push_back(m_vals[j - 1]);
 		}
 
-		printf("\n");
+		m_full_sample_data.push_back(row);
 	}
-
-	printf("----------------------\n");
 }
 
-void sinsp_table::print_json(vector<sinsp_sample_row>* sample_data, uint64_t time_delta)
+void sinsp_table::init_sketch(const sinsp_table_column* col, sinsp_table_field* dst, sinsp_table_field* src)
 {
-	Json::FastWriter writer;
-	vector<filtercheck_field_info>* legend = get_legend();
-	string res;
-	uint32_t j = 0;
-	uint32_t k = 0;
-	m_json_output_lines_count = 0;
+	dst->m_val = m_buffer->reserve_aligned(get_sketch_storage_len(col->m_sketch));
+	dst->m_len = get_fixed_field_len(col->m_result_type);
+	dst->m_cnt = 1;
+	memset(dst->m_val, 0, TABLE_SKETCH_OFFSET);
 
-	if(sample_data->size() == 0)
+	if(col->m_sketch == TS_DISTINCT)
 	{
-		return;
+		get_hll(dst)->init();
 	}
-
-	if(m_json_first_row >= sample_data->size())
+	else
 	{
-		return;
+		get_tdigest(dst)->init();
 	}
 
-	if(m_json_last_row == 0 || m_json_last_row >= sample_data->size() - 1)
+	col->m_accumulate(dst, src, m_buffer);
+}
+
+void sinsp_table::update_sketch_results(unordered_map<sinsp_table_field, sinsp_table_field*, sinsp_table_field_hasher>* table,
+	vector<sinsp_table_column>* columns)
+{
+	vector<uint32_t> sketch_columns;
+
+	for(uint32_t j = 1; j < columns->size(); j++)
 	{
-		m_json_last_row = sample_data->size() - 1;
+		if((*columns)[j].m_sketch != TS_NONE)
+		{
+			sketch_columns.push_back(j);
+		}
 	}
 
-	printf("\"data\": [\n");
+	if(sketch_columns.empty())
+	{
+		return;
+	}
 
-	for(k = m_json_first_row; k <= m_json_last_row; k++)
+	for(auto it = table->begin(); it != table->end(); ++it)
 	{
-		Json::Value root;
-		Json::Value jd;
-		auto row = sample_data->at(k);
-		
-		for(uint32_t j = 0; j < m_n_fields - 1; j++)
+		for(uint32_t j : sketch_columns)
 		{
-			sinsp_filter_check* extractor = m_extractors->at(j + 1);
-			uint64_t td = 0;
+			const sinsp_table_column& col = (*columns)[j];
+			sinsp_table_field* fld = &(it->second[j - 1]);
 
-			if(extractor->m_aggregation == A_TIME_AVG || 
-				extractor->m_merge_aggregation == A_TIME_AVG)
+			if(col.m_sketch == TS_DISTINCT)
 			{
-				td = time_delta;
+				*(uint64_t*)fld->m_val = get_hll(fld)->estimate();
+			}
+			else
+			{
+				store_quantile(col.m_result_type, fld->m_val, get_tdigest(fld)->quantile(col.m_quantile));
 			}
+		}
+	}
+}
 
-			m_printer->set_val(m_types->at(j + 1), 
-				row.m_values[j].m_val,
-				row.m_values[j].m_len,
-				row.m_values[j].m_cnt,
-				legend->at(j + 1).m_print_format);
+void sinsp_table::prune_table()
+{
+	uint32_t n_keep = m_max_rows * SINSP_TABLE_TOPK_OVERSAMPLING;
+	uint32_t col = 0;
 
-			jd.append(m_printer->tojson(NULL, 10, td));
-		}
+	//
+	// Keep the rows that come first in the current sorting. Group-by
+	// tables aren't pruned: the rank of a group isn't known until all of
+	// its rows are merged.
+	//
+	ASSERT(!m_do_merging);
 
+	if(m_sorting_col != -1)
+	{
+		col = (uint32_t)m_sorting_col;
+	}
 
-		auto key = get_row_key_name_and_val(k, false);
+	if(m_premerge_columns[col + 1].m_sketch != TS_NONE)
+	{
+		update_sketch_results(&m_premerge_table, &m_premerge_columns);
+	}
 
-		root["k"] = key.second;
-		root["d"] = jd;
+	vector<pair<sinsp_table_field, sinsp_table_field*>> rows(m_premerge_table.begin(), m_premerge_table.end());
 
-		res = writer.write(root);
-		printf("%s", res.substr(0, res.size() - 1).c_str());
+	table_row_cmp cc;
+	cc.m_colid = col;
+	cc.m_ascending = m_is_sorting_ascending;
+	cc.m_type = m_premerge_types[col + 1];
 
-		m_json_output_lines_count++;
+	nth_element(rows.begin(), rows.begin() + n_keep, rows.end(), cc);
 
-		if(k >= m_json_last_row)
-		{
-			break;
-		}
+	//
+	// Move the rows we keep to a new buffer, which replaces the current
+	// one, so that the memory of the evicted rows is reused
+	//
+	m_premerge_table.clear();
+	m_compact_buffer.clear();
 
-		if(j < sample_data->size() - 1)
-		{
-			printf(",");
-		}
-		printf("\n");
+	for(uint32_t k = 0; k < n_keep; k++)
+	{
+		sinsp_table_field key = rows[k].first;
+		sinsp_table_field* vals = copy_row(&key, rows[k].second, &m_compact_buffer);
 
-		j++;
+		m_premerge_table.emplace(key, vals);
 	}
 
-	printf("],\n");
+	m_buffer->swap(m_compact_buffer);
 }
 
-void sinsp_table::filter_sample()
+sinsp_table_field* sinsp_table::copy_row(sinsp_table_field* key, sinsp_table_field* vals, sinsp_table_buffer* buffer)
 {
-	vector<filtercheck_field_info>* legend = get_legend();
+	sinsp_table_field* res = (sinsp_table_field*)buffer->reserve(m_premerge_vals_array_sz);
 
-	m_filtered_sample_data.clear();
+	key->m_val = buffer->copy(key->m_val, key->m_len);
 
-	for(auto it : m_full_sample_data)
+	for(uint32_t j = 1; j < m_n_premerge_fields; j++)
 	{
-		for(uint32_t j = 0; j < it.m_values.size(); j++)
-		{
-			ppm_param_type type;
+		sinsp_table_field* val = &(vals[j - 1]);
 
-			if(m_do_merging)
-			{
-				type = m_postmerge_types[j + 1];
-			}
-			else
-			{
-				type = m_premerge_types[j + 1];
-			}
-
-			if(type == PT_CHARBUF || type == PT_BYTEBUF || type == PT_SYSCALLID ||
-				type == PT_PORT || type == PT_L4PROTO || type == PT_SOCKFAMILY || type == PT_IPV4ADDR ||
-			        type == PT_IPV6ADDR ||
-				type == PT_UID || type == PT_GID)
-			{
-				m_printer->set_val(type, 
-					it.m_values[j].m_val, 
-					it.m_values[j].m_len,
-					it.m_values[j].m_cnt,
-					legend->at(j + 1).m_print_format);
-					
-				string strval = m_printer->tostring_nice(NULL, 0, 0);
+		res[j - 1] = *val;
 
-				if(strval.find(m_freetext_filter) != string::npos)
-				{
-					m_filtered_sample_data.push_back(it);
-					break;
-				}
-			}
+		if(m_premerge_columns[j].m_sketch != TS_NONE)
+		{
+			uint32_t len = get_sketch_storage_len(m_premerge_columns[j].m_sketch);
+			res[j - 1].m_val = buffer->reserve_aligned(len);
+			memcpy(res[j - 1].m_val, val->m_val, len);
+		}
+		else
+		{
+			res[j - 1].m_val = buffer->copy(val->m_val, val->m_len);
 		}
 	}
+
+	return res;
 }
 
-//
-// Returns the key of the first match, or NULL if no match
-//
-sinsp_table_field* sinsp_table::search_in_sample(string text)
+void sinsp_table::merge_partial(sinsp_table* shard, sinsp_evt* evt)
 {
-	vector<filtercheck_field_info>* legend = get_legend();
+	if(shard->m_type != m_type ||
+		shard->m_premerge_types != m_premerge_types ||
+		shard->m_do_merging != m_do_merging)
+	{
+		throw sinsp_exception("cannot merge tables with different configurations");
+	}
 
-	for(auto it = m_full_sample_data.begin(); it != m_full_sample_data.end(); ++it)
+	//
+	// The thread table of the shard goes in the sample too, as flush()
+	// does for the one of this table
+	//
+	if(!m_paused && m_next_flush_time_ns != 0)
 	{
-		for(uint32_t j = 0; j < it->m_values.size(); j++)
+		shard->process_proctable(evt);
+	}
+
+	if(m_type == sinsp_table::TT_TABLE)
+	{
+		for(auto it = shard->m_premerge_table.begin(); it != shard->m_premerge_table.end(); ++it)
 		{
-			ppm_param_type type;
+			auto dst = m_premerge_table.find(it->first);
 
-			if(m_do_merging)
-			{
-				ASSERT(m_types->size() == it->m_values.size() + 2);
-				type = m_types->at(j + 2);
-			}
-			else
+			if(dst == m_premerge_table.end())
 			{
-				ASSERT(m_types->size() == it->m_values.size() + 1);
-				type = m_types->at(j + 1);
+				sinsp_table_field key = it->first;
+				sinsp_table_field* vals = copy_row(&key, it->second, m_buffer);
+
+				m_premerge_table.emplace(key, vals);
+				continue;
 			}
 
-			if(type == PT_CHARBUF || type == PT_BYTEBUF || type == PT_SYSCALLID ||
-				type == PT_PORT || type == PT_L4PROTO || type == PT_SOCKFAMILY || type == PT_IPV4ADDR ||
-			        type == PT_IPV6ADDR ||
-				type == PT_UID || type == PT_GID)
+			for(uint32_t j = 1; j < m_n_premerge_fields; j++)
 			{
-				m_printer->set_val(type,
-					it->m_values[j].m_val,
-					it->m_values[j].m_len,
-					it->m_values[j].m_cnt,
-					legend->at(j + 1).m_print_format);
-
-				string strval = m_printer->tostring_nice(NULL, 0, 0);
+				sinsp_table_accumulator combine = m_premerge_columns[j].m_combine;
 
-				if(strval.find(text) != string::npos)
+				if(combine != NULL)
 				{
-					return &(it->m_key);
+					combine(&(dst->second[j - 1]), &(it->second[j - 1]), m_buffer);
 				}
 			}
 		}
-	}
 
-	return NULL;
-}
+		//
+		// Nobody reads the rows of a shard, so its buffer can be reused
+		// right away
+		//
+		shard->m_premerge_table.clear();
+		shard->m_buffer->clear();
 
-void sinsp_table::sort_sample()
-{
-	if(m_type == sinsp_table::TT_LIST)
-	{
-		if(m_sorting_col == -1 || !m_just_sorted)
+		if(m_max_rows != 0 && !m_do_merging &&
+			m_premerge_table.size() >= 2 * m_max_rows * SINSP_TABLE_TOPK_OVERSAMPLING)
 		{
-			return;
+			prune_table();
 		}
-
-		m_just_sorted = false;
 	}
-
-	if(m_sample_data->size() != 0)
+	else
 	{
-		if(m_sorting_col >= (int32_t)m_sample_data->at(0).m_values.size())
+		if(!m_paused)
 		{
-			throw sinsp_exception("invalid table sorting column");
-		}
+			for(auto it = shard->m_full_sample_data.begin(); it != shard->m_full_sample_data.end(); ++it)
+			{
+				sinsp_sample_row row;
 
-		table_row_cmp cc;
-		cc.m_colid = m_sorting_col;
-		cc.m_ascending = m_is_sorting_ascending;
-		uint32_t tyid = m_do_merging? m_sorting_col + 2 : m_sorting_col + 1;
-		cc.m_type = m_premerge_types[tyid];
+				row.m_key = it->m_key;
+				row.m_key.m_val = m_buffer->copy(it->m_key.m_val, it->m_key.m_len);
 
-		sort(m_sample_data->begin(),
-			m_sample_data->end(),
-			cc);
+				for(auto vit = it->m_values.begin(); vit != it->m_values.end(); ++vit)
+				{
+					sinsp_table_field val = *vit;
+					val.m_val = m_buffer->copy(vit->m_val, vit->m_len);
+					row.m_values.push_back(val);
+				}
+
+				m_full_sample_data.push_back(row);
+			}
+		}
+
+		shard->clear();
 	}
 }
 
-vector<sinsp_sample_row>* sinsp_table::get_sample(uint64_t time_delta)
+void sinsp_table::process_event(sinsp_evt* evt)
 {
+	uint32_t j;
+
 	//
-	// No sample generation happens when the table is paused
+	// Apply the filter
 	//
-	if(!m_paused)
+	if(m_filter)
 	{
-		//
-		// If we have a freetext filter, we start by filtering the sample
-		//
-		if(m_freetext_filter != "")
-		{
-			filter_sample();
-			m_sample_data = &m_filtered_sample_data;
-		}
-		else
+		if(!m_filter->run(evt))
 		{
-			m_sample_data = &m_full_sample_data;
+			return;
 		}
-
-		//
-		// Sort the sample
-		//
-		sort_sample();
 	}
 
 	//
-	// If required, emit the sample to stdout
+	// Extract the values and create the row to add. The values are
+	// copied, because some extractors share their storage with the
+	// event, but only into the scratch buffer: add_row() moves them to
+	// the table buffer when they start a new row.
 	//
-#ifndef _WIN32
-	if(m_output_type != sinsp_table::OT_CURSES)
+	m_scratch.clear();
+
+	for(j = 0; j < m_n_premerge_fields; j++)
 	{
-#endif
-		if(m_output_type == sinsp_table::OT_RAW)
-		{
-			print_raw(m_sample_data, time_delta);
-		}
-		else if(m_output_type == sinsp_table::OT_JSON)
+		uint32_t len;
+		uint8_t* val = m_premerge_extractors[j]->extract(evt, &len);
+
+		sinsp_table_field* pfld = &(m_premerge_fld_pointers[j]);
+
+		//
+		// XXX For the moment, we only support defaults for numeric fields.
+		// At a certain point we will want to introduce the concept of zero
+		// for other fields too.
+		//
+		if(val == NULL)
 		{
-			print_json(m_sample_data, time_delta);
+			if(m_use_defaults)
+			{
+				pfld->m_val = get_default_val(&m_premerge_legend[j]);
+				if(pfld->m_val == NULL)
+				{
+					return;
+				}
+
+				pfld->m_len = get_field_len(j);
+				pfld->m_val = m_scratch.copy(pfld->m_val, pfld->m_len);
+				pfld->m_cnt = 0;
+			}
+			else
+			{
+				return;
+			}
 		}
 		else
 		{
-			ASSERT(false);
+			// get_field_len() takes the length of byte buffers from here
+			pfld->m_val = val;
+			pfld->m_len = len;
+			pfld->m_len = get_field_len(j);
+			pfld->m_val = m_scratch.copy(val, pfld->m_len);
+			pfld->m_cnt = 1;
 		}
-#ifndef _WIN32
 	}
-#endif
 
 	//
-	// Restore the lists used for event processing
+	// Add the row
 	//
-	m_types = &m_premerge_types;
-	m_table = &m_premerge_table;
-	m_n_fields = m_n_premerge_fields;
-	m_vals_array_sz = m_premerge_vals_array_sz;
-	m_fld_pointers = m_premerge_fld_pointers;
-	m_extractors = &m_premerge_extractors;
+	add_row(false);
 
-	return m_sample_data;
+	return;
 }
 
-void sinsp_table::set_sorting_col(uint32_t col)
+void sinsp_table::process_proctable(sinsp_evt* evt)
 {
-	uint32_t n_fields;
-	vector<ppm_param_type>* types;
+	sinsp_evt tevt;
+	scap_evt tscapevt;
 
-	if(m_do_merging)
-	{
-		n_fields = m_n_postmerge_fields;
-		types = &m_postmerge_types;
-	}
-	else
-	{
-		n_fields = m_n_premerge_fields;
-		types = &m_premerge_types;
-	}
+	threadinfo_map_t* threadtable  = m_inspector->m_thread_manager->get_threads();
+	ASSERT(threadtable != NULL);
 
-	if(col == 0)
-	{
-		if(m_type == sinsp_table::TT_TABLE)
-		{
-			throw sinsp_exception("cannot sort by key");
-		}
-		else
-		{
-			m_sorting_col = -1;
-			return;
-		}
-	}
+	uint64_t ts = evt->get_ts();
+	uint64_t ts_s = ts - (ts % ONE_SECOND_IN_NS);
+	tscapevt.ts = ts_s - 1;
 
-	if(col >= n_fields)
-	{
-		throw sinsp_exception("invalid table sorting column");
-	}
+	//
+	// Note: as the event type for this fake event, we pick one of the unused
+	//       numbers, so we guarantee that filter checks will not wrongly pick it up
+	//
+	tscapevt.type = PPME_SYSDIGEVENT_X;
+	tscapevt.len = 0;
+	tscapevt.nparams = 0;
 
-	if(col == (uint32_t)(m_sorting_col + 1))
-	{
-		m_is_sorting_ascending = !m_is_sorting_ascending;
-	}
-	else
-	{
-		switch(types->at(col))
+	tevt.m_inspector = m_inspector;
+	tevt.m_info = &(g_infotables.m_event_info[PPME_SYSDIGEVENT_X]);
+	tevt.m_pevt = NULL;
+	tevt.m_cpuid = 0;
+	tevt.m_evtnum = 0;
+	tevt.m_pevt = &tscapevt;
+	tevt.m_fdinfo = NULL;
+
+	threadtable->loop([&] (sinsp_threadinfo& tinfo) {
+		tevt.m_tinfo = &tinfo;
+		tscapevt.tid = tevt.m_tinfo->m_tid;
+
+		if(m_filter)
 		{
-			case PT_INT8:
-			case PT_INT16:
-			case PT_INT32:
-			case PT_INT64:
-			case PT_UINT8:
-			case PT_UINT16:
-			case PT_UINT32:
-			case PT_UINT64:
-			case PT_RELTIME:
-			case PT_ABSTIME:
-			case PT_DOUBLE:
-			case PT_BOOL:
-				m_is_sorting_ascending = false;
-				break;
-			default:
-				m_is_sorting_ascending = true;
-				break;
+			if(!m_filter->run(&tevt))
+			{
+				return true;
+			}
 		}
-	}
-
-	m_just_sorted = true;
-	m_sorting_col = col - 1;
-}
 
-uint32_t sinsp_table::get_sorting_col()
-{
-	return (uint32_t)m_sorting_col + 1;
+		process_event(&tevt);
+		return true;
+	});
 }
 
-void sinsp_table::create_sample()
-{
-	if(m_type == sinsp_table::TT_TABLE)
+void sinsp_table::flush(sinsp_evt* evt)
+{	
+	if(!m_paused)
 	{
-		uint32_t j;
-		m_full_sample_data.clear();
-		sinsp_sample_row row;
-
-		//
-		// If merging is on, perform the merge and switch to the merged table 
-		//
-		if(m_do_merging)
+		if(m_next_flush_time_ns != 0)
 		{
-			m_table = &m_merge_table;
-			m_merge_table.clear();
+			//
+			// Time to emit the sample! 
+			// Add the proctable as a sample at the end of the second
+			//
+			process_proctable(evt);
 
-			for(auto it = m_premerge_table.begin(); it != m_premerge_table.end(); ++it)
+			//
+			// If there is a merging step, switch the types to point to the merging ones.
+			//
+			if(m_do_merging)
 			{
-				for(j = 0; j < m_n_postmerge_fields; j++)
-				{
-					sinsp_table_field* pfld = &(m_postmerge_fld_pointers[j]);
+				m_types = &m_postmerge_types;
+				m_columns = &m_postmerge_columns;
+				m_table = &m_merge_table;
+				m_n_fields = m_n_postmerge_fields;
+				m_vals_array_sz = m_postmerge_vals_array_sz;
+				m_fld_pointers = m_postmerge_fld_pointers;
+				m_extractors = &m_postmerge_extractors;
+			}
 
-					uint32_t col = m_groupby_columns[j];
-					if(col == 0)
-					{
-						pfld->m_val = it->first.m_val;
-						pfld->m_len = it->first.m_len;
-						pfld->m_cnt = it->first.m_cnt;
-					}
-					else
-					{
-						pfld->m_val = it->second[col - 1].m_val;
-						pfld->m_len = it->second[col - 1].m_len;
-						pfld->m_cnt = it->second[col - 1].m_cnt;
-					}
-				}
+			//
+			// Emit the sample
+			//
+			create_sample();
 
-				add_row(true);
+			if(m_type == sinsp_table::TT_TABLE)
+			{
+				//
+				// Switch the data storage so that the current one is still usable by the 
+				// consumers of the table.
+				//
+				switch_buffers();
+
+				//
+				// Clear the current data storage
+				//
+				m_buffer->clear();
 			}
+
+			//
+			// Reinitialize the tables
+			//
+			m_premerge_table.clear();
+			m_merge_table.clear();
 		}
-		else
-		{
-			m_table = &m_premerge_table;
-		}
+	}
 
-		//
-		// Emit the table
-		//
-		for(auto it = m_table->begin(); it != m_table->end(); ++it)
-		{
-			row.m_key = it->first;
+	uint64_t ts = evt->get_ts();
 
-			row.m_values.clear();
+	m_prev_flush_time_ns = m_next_flush_time_ns;
+	m_next_flush_time_ns = ts - (ts % m_refresh_interval_ns) + m_refresh_interval_ns;
 
-			sinsp_table_field* fields = it->second;
-			for(j = 0; j < m_n_fields - 1; j++)
+	return;
+}
+
+void sinsp_table::print_raw(vector<sinsp_sample_row>* sample_data, uint64_t time_delta)
+{
+	vector<filtercheck_field_info>* legend = get_legend();
+
+	for(auto it = sample_data->begin(); it != sample_data->end(); ++it)
+	{
+		for(uint32_t j = 0; j < m_n_fields - 1; j++)
+		{
+			sinsp_filter_check* extractor = m_extractors->at(j + 1);
+			uint64_t td = 0;
+
+			if(extractor->m_aggregation == A_TIME_AVG || 
+				extractor->m_merge_aggregation == A_TIME_AVG)
 			{
-				row.m_values.push_back(fields[j]);
+				td = time_delta;
 			}
 
-			m_full_sample_data.push_back(row);
+			m_printer->set_val(m_types->at(j + 1), 
+				it->m_values[j].m_val,
+				it->m_values[j].m_len,
+				it->m_values[j].m_cnt,
+				legend->at(j + 1).m_print_format);
+			char* prstr = m_printer->tostring_nice(NULL, 10, td);
+			printf("%s ", prstr);
+			//printf("%s ", m_printer->tostring(NULL));
 		}
+
+		printf("\n");
 	}
-	else
-	{
-		//
-		// If this is a list, there's nothing to be done, since m_full_sample_data
-		// is already prepared and doesn't need to be cleaned.
-		//
+
+	printf("----------------------\n");
+}
+
+void sinsp_table::print_json(vector<sinsp_sample_row>* sample_data, uint64_t time_delta)
+{
+	Json::FastWriter writer;
+	vector<filtercheck_field_info>* legend = get_legend();
+	string res;
+	uint32_t j = 0;
+	uint32_t k = 0;
+	m_json_output_lines_count = 0;
+
+	if(sample_data->size() == 0)
+	{
 		return;
 	}
-}
 
-void sinsp_table::add_fields_sum(ppm_param_type type, sinsp_table_field *dst, sinsp_table_field *src)
-{
-	uint8_t* operand1 = dst->m_val;
-	uint8_t* operand2 = src->m_val;
-	
-	switch(type)
+	if(m_json_first_row >= sample_data->size())
 	{
-	case PT_INT8:
-		*(int8_t*)operand1 += *(int8_t*)operand2;
-		return;
-	case PT_INT16:
-		*(int16_t*)operand1 += *(int16_t*)operand2;
-		return;
-	case PT_INT32:
-		*(int32_t*)operand1 += *(int32_t*)operand2;
-		return;
-	case PT_INT64:
-		*(int64_t*)operand1 += *(int64_t*)operand2;
-		return;
-	case PT_UINT8:
-		*(uint8_t*)operand1 += *(uint8_t*)operand2;
-		return;
-	case PT_UINT16:
-		*(uint16_t*)operand1 += *(uint16_t*)operand2;
-		return;
-	case PT_UINT32:
-	case PT_BOOL:
-		*(uint32_t*)operand1 += *(uint32_t*)operand2;
-		return;
-	case PT_UINT64:
-	case PT_RELTIME:
-	case PT_ABSTIME:
-		*(uint64_t*)operand1 += *(uint64_t*)operand2;
-		return;
-	case PT_DOUBLE:
-		*(double*)operand1 += *(double*)operand2;
-		return;
-	default:
 		return;
 	}
-}
 
-void sinsp_table::add_fields_sum_of_avg(ppm_param_type type, sinsp_table_field *dst, sinsp_table_field *src)
-{
-	uint8_t* operand1 = dst->m_val;
-	uint8_t* operand2 = src->m_val;
-	uint32_t cnt1 = dst->m_cnt;
-	uint32_t cnt2 = src->m_cnt;
-	
-	switch(type)
+	if(m_json_last_row == 0 || m_json_last_row >= sample_data->size() - 1)
 	{
-	case PT_INT8:
-		if(cnt1 > 1)
-		{
-			*(int8_t*)operand1 = *(int8_t*)operand1 / cnt1;
-		}
+		m_json_last_row = sample_data->size() - 1;
+	}
 
-		*(int8_t*)operand1 += (*(int8_t*)operand2) / cnt2;
-		break;
-	case PT_INT16:
-		if(cnt1 > 1)
-		{
-			*(int16_t*)operand1 = *(int16_t*)operand1 / cnt1;
-		}
+	printf("\"data\": [\n");
 
-		*(int16_t*)operand1 += (*(int16_t*)operand2) / cnt2;
-		break;
-	case PT_INT32:
-		if(cnt1 > 1)
+	for(k = m_json_first_row; k <= m_json_last_row; k++)
+	{
+		Json::Value root;
+		Json::Value jd;
+		auto row = sample_data->at(k);
+		
+		for(uint32_t j = 0; j < m_n_fields - 1; j++)
 		{
-			*(int32_t*)operand1 = *(int32_t*)operand1 / cnt1;
-		}
+			sinsp_filter_check* extractor = m_extractors->at(j + 1);
+			uint64_t td = 0;
 
-		*(int32_t*)operand1 += (*(int32_t*)operand2) / cnt2;
-		break;
-	case PT_INT64:
-		if(cnt1 > 1)
-		{
-			*(int64_t*)operand1 = *(int64_t*)operand1 / cnt1;
-		}
+			if(extractor->m_aggregation == A_TIME_AVG || 
+				extractor->m_merge_aggregation == A_TIME_AVG)
+			{
+				td = time_delta;
+			}
 
-		*(int64_t*)operand1 += (*(int64_t*)operand2) / cnt2;
-		break;
-	case PT_UINT8:
-		if(cnt1 > 1)
-		{
-			*(uint8_t*)operand1 = *(uint8_t*)operand1 / cnt1;
-		}
+			m_printer->set_val(m_types->at(j + 1), 
+				row.m_values[j].m_val,
+				row.m_values[j].m_len,
+				row.m_values[j].m_cnt,
+				legend->at(j + 1).m_print_format);
 
-		*(uint8_t*)operand1 += (*(uint8_t*)operand2) / cnt2;
-		break;
-	case PT_UINT16:
-		if(cnt1 > 1)
-		{
-			*(uint16_t*)operand1 = *(uint16_t*)operand1 / cnt1;
+			jd.append(m_printer->tojson(NULL, 10, td));
 		}
 
-		*(uint16_t*)operand1 += (*(uint16_t*)operand2) / cnt2;
-		break;
-	case PT_UINT32:
-	case PT_BOOL:
-		if(cnt1 > 1)
-		{
-			*(uint32_t*)operand1 = *(uint32_t*)operand1 / cnt1;
-		}
 
-		*(uint32_t*)operand1 += (*(uint32_t*)operand2) / cnt2;
-		break;
-	case PT_UINT64:
-	case PT_RELTIME:
-	case PT_ABSTIME:
-		if(cnt1 > 1)
+		auto key = get_row_key_name_and_val(k, false);
+
+		root["k"] = key.second;
+		root["d"] = jd;
+
+		res = writer.write(root);
+		printf("%s", res.substr(0, res.size() - 1).c_str());
+
+		m_json_output_lines_count++;
+
+		if(k >= m_json_last_row)
 		{
-			*(uint64_t*)operand1 = *(uint64_t*)operand1 / cnt1;
+			break;
 		}
 
-		*(uint64_t*)operand1 += (*(uint64_t*)operand2) / cnt2;
-		break;
-	case PT_DOUBLE:
-		if(cnt1 > 1)
+		if(j < sample_data->size() - 1)
 		{
-			*(double*)operand1 = *(double*)operand1 / cnt1;
+			printf(",");
 		}
+		printf("\n");
 
-		*(double*)operand1 += (*(double*)operand2) / cnt2;
-		break;
-	default:
-		break;
+		j++;
 	}
 
-	src->m_cnt = 1;
-	dst->m_cnt = 1;
+	printf("],\n");
 }
 
-void sinsp_table::add_fields_max(ppm_param_type type, sinsp_table_field *dst, sinsp_table_field *src)
+void sinsp_table::filter_sample()
 {
-	uint8_t* operand1 = dst->m_val;
-	uint8_t* operand2 = src->m_val;
+	vector<filtercheck_field_info>* legend = get_legend();
 
-	switch(type)
+	m_filtered_sample_data.clear();
+
+	for(auto it : m_full_sample_data)
 	{
-	case PT_INT8:
-		if(*(int8_t*)operand1 < *(int8_t*)operand2)
+		for(uint32_t j = 0; j < it.m_values.size(); j++)
 		{
-			*(int8_t*)operand1 = *(int8_t*)operand2;
+			ppm_param_type type;
+
+			if(m_do_merging)
+			{
+				type = m_postmerge_types[j + 1];
+			}
+			else
+			{
+				type = m_premerge_types[j + 1];
+			}
+
+			if(type == PT_CHARBUF || type == PT_BYTEBUF || type == PT_SYSCALLID ||
+				type == PT_PORT || type == PT_L4PROTO || type == PT_SOCKFAMILY || type == PT_IPV4ADDR ||
+			        type == PT_IPV6ADDR ||
+				type == PT_UID || type == PT_GID)
+			{
+				m_printer->set_val(type, 
+					it.m_values[j].m_val, 
+					it.m_values[j].m_len,
+					it.m_values[j].m_cnt,
+					legend->at(j + 1).m_print_format);
+					
+				string strval = m_printer->tostring_nice(NULL, 0, 0);
+
+				if(strval.find(m_freetext_filter) != string::npos)
+				{
+					m_filtered_sample_data.push_back(it);
+					break;
+				}
+			}
 		}
-		return;
-	case PT_INT16:
-		if(*(int16_t*)operand1 < *(int16_t*)operand2)
+	}
+}
+
+//
+// Returns the key of the first match, or NULL if no match
+//
+sinsp_table_field* sinsp_table::search_in_sample(string text)
+{
+	vector<filtercheck_field_info>* legend = get_legend();
+
+	for(auto it = m_full_sample_data.begin(); it != m_full_sample_data.end(); ++it)
+	{
+		for(uint32_t j = 0; j < it->m_values.size(); j++)
 		{
-			*(int16_t*)operand1 = *(int16_t*)operand2;
+			ppm_param_type type;
+
+			if(m_do_merging)
+			{
+				ASSERT(m_types->size() == it->m_values.size() + 2);
+				type = m_types->at(j + 2);
+			}
+			else
+			{
+				ASSERT(m_types->size() == it->m_values.size() + 1);
+				type = m_types->at(j + 1);
+			}
+
+			if(type == PT_CHARBUF || type == PT_BYTEBUF || type == PT_SYSCALLID ||
+				type == PT_PORT || type == PT_L4PROTO || type == PT_SOCKFAMILY || type == PT_IPV4ADDR ||
+			        type == PT_IPV6ADDR ||
+				type == PT_UID || type == PT_GID)
+			{
+				m_printer->set_val(type,
+					it->m_values[j].m_val,
+					it->m_values[j].m_len,
+					it->m_values[j].m_cnt,
+					legend->at(j + 1).m_print_format);
+
+				string strval = m_printer->tostring_nice(NULL, 0, 0);
+
+				if(strval.find(text) != string::npos)
+				{
+					return &(it->m_key);
+				}
+			}
 		}
-		return;
-	case PT_INT32:
-		if(*(int32_t*)operand1 < *(int32_t*)operand2)
+	}
+
+	return NULL;
+}
+
+void sinsp_table::sort_sample()
+{
+	if(m_type == sinsp_table::TT_LIST)
+	{
+		if(m_sorting_col == -1 || !m_just_sorted)
 		{
-			*(int32_t*)operand1 = *(int32_t*)operand2;
+			return;
 		}
-		return;
-	case PT_INT64:
-		if(*(int64_t*)operand1 < *(int64_t*)operand2)
+
+		m_just_sorted = false;
+	}
+
+	if(m_sample_data->size() != 0)
+	{
+		if(m_sorting_col >= (int32_t)m_sample_data->at(0).m_values.size())
 		{
-			*(int64_t*)operand1 = *(int64_t*)operand2;
+			throw sinsp_exception("invalid table sorting column");
 		}
-		return;
-	case PT_UINT8:
-		if(*(uint8_t*)operand1 < *(uint8_t*)operand2)
+
+		table_row_cmp cc;
+		cc.m_colid = m_sorting_col;
+		cc.m_ascending = m_is_sorting_ascending;
+		uint32_t tyid = m_do_merging? m_sorting_col + 2 : m_sorting_col + 1;
+		cc.m_type = m_premerge_types[tyid];
+
+		if(m_max_rows != 0 && m_sample_data->size() > m_max_rows)
 		{
-			*(uint8_t*)operand1 = *(uint8_t*)operand2;
+			partial_sort(m_sample_data->begin(),
+				m_sample_data->begin() + m_max_rows,
+				m_sample_data->end(),
+				cc);
+
+			//
+			// Only show the top rows, but keep the others: a different
+			// freetext filter or sorting column can bring them up
+			//
+			m_top_sample_data.assign(m_sample_data->begin(),
+				m_sample_data->begin() + m_max_rows);
+			m_sample_data = &m_top_sample_data;
 		}
-		return;
-	case PT_UINT16:
-		if(*(uint16_t*)operand1 < *(uint16_t*)operand2)
+		else
 		{
-			*(uint16_t*)operand1 = *(uint16_t*)operand2;
+			sort(m_sample_data->begin(),
+				m_sample_data->end(),
+				cc);
 		}
-		return;
-	case PT_UINT32:
-	case PT_BOOL:
-		if(*(uint32_t*)operand1 < *(uint32_t*)operand2)
+	}
+}
+
+vector<sinsp_sample_row>* sinsp_table::get_sample(uint64_t time_delta)
+{
+	//
+	// No sample generation happens when the table is paused
+	//
+	if(!m_paused)
+	{
+		//
+		// If we have a freetext filter, we start by filtering the sample
+		//
+		if(m_freetext_filter != "")
 		{
-			*(uint32_t*)operand1 = *(uint32_t*)operand2;
+			filter_sample();
+			m_sample_data = &m_filtered_sample_data;
 		}
-		return;
-	case PT_UINT64:
-	case PT_RELTIME:
-	case PT_ABSTIME:
-		if(*(uint64_t*)operand1 < *(uint64_t*)operand2)
+		else
 		{
-			*(uint64_t*)operand1 = *(uint64_t*)operand2;
+			m_sample_data = &m_full_sample_data;
 		}
-		return;
-	case PT_DOUBLE:
-		if(*(double*)operand1 < *(double*)operand2)
+
+		//
+		// Sort the sample
+		//
+		sort_sample();
+	}
+
+	//
+	// If required, emit the sample to stdout
+	//
+#ifndef _WIN32
+	if(m_output_type != sinsp_table::OT_CURSES)
+	{
+#endif
+		if(m_output_type == sinsp_table::OT_RAW)
 		{
-			*(double*)operand1 = *(double*)operand2;
+			print_raw(m_sample_data, time_delta);
 		}
-		return;
-	case PT_CHARBUF:
-	case PT_BYTEBUF:
-		if(dst->m_len >= src->m_len)
+		else if(m_output_type == sinsp_table::OT_JSON)
 		{
-			memcpy(dst->m_val, src->m_val, src->m_len);
+			print_json(m_sample_data, time_delta);
 		}
 		else
 		{
-			dst->m_val = m_buffer->copy(src->m_val, src->m_len);
+			ASSERT(false);
 		}
+#ifndef _WIN32
+	}
+#endif
 
-		dst->m_len = src->m_len;
-	default:
-		return;
+	//
+	// Restore the lists used for event processing
+	//
+	m_types = &m_premerge_types;
+	m_columns = &m_premerge_columns;
+	m_table = &m_premerge_table;
+	m_n_fields = m_n_premerge_fields;
+	m_vals_array_sz = m_premerge_vals_array_sz;
+	m_fld_pointers = m_premerge_fld_pointers;
+	m_extractors = &m_premerge_extractors;
+
+	return m_sample_data;
+}
+
+void sinsp_table::set_max_rows(uint32_t max_rows)
+{
+	if(max_rows != 0 && m_type != sinsp_table::TT_TABLE)
+	{
+		throw sinsp_exception("row limit not supported for list tables");
 	}
+
+	m_max_rows = max_rows;
 }
 
-void sinsp_table::add_fields_min(ppm_param_type type, sinsp_table_field *dst, sinsp_table_field *src)
+void sinsp_table::set_sorting_col(uint32_t col)
 {
-	uint8_t* operand1 = dst->m_val;
-	uint8_t* operand2 = src->m_val;
+	uint32_t n_fields;
+	vector<ppm_param_type>* types;
 
-	switch(type)
+	if(m_do_merging)
 	{
-	case PT_INT8:
-		if(*(int8_t*)operand1 > *(int8_t*)operand2)
-		{
-			*(int8_t*)operand1 = *(int8_t*)operand2;
-		}
-		return;
-	case PT_INT16:
-		if(*(int16_t*)operand1 > *(int16_t*)operand2)
-		{
-			*(int16_t*)operand1 = *(int16_t*)operand2;
-		}
-		return;
-	case PT_INT32:
-		if(*(int32_t*)operand1 > *(int32_t*)operand2)
-		{
-			*(int32_t*)operand1 = *(int32_t*)operand2;
-		}
-		return;
-	case PT_INT64:
-		if(*(int64_t*)operand1 > *(int64_t*)operand2)
-		{
-			*(int64_t*)operand1 = *(int64_t*)operand2;
-		}
-		return;
-	case PT_UINT8:
-		if(*(uint8_t*)operand1 > *(uint8_t*)operand2)
-		{
-			*(uint8_t*)operand1 = *(uint8_t*)operand2;
-		}
-		return;
-	case PT_UINT16:
-		if(*(uint16_t*)operand1 > *(uint16_t*)operand2)
-		{
-			*(uint16_t*)operand1 = *(uint16_t*)operand2;
-		}
-		return;
-	case PT_UINT32:
-	case PT_BOOL:
-		if(*(uint32_t*)operand1 > *(uint32_t*)operand2)
-		{
-			*(uint32_t*)operand1 = *(uint32_t*)operand2;
-		}
-		return;
-	case PT_UINT64:
-	case PT_RELTIME:
-	case PT_ABSTIME:
-		if(*(uint64_t*)operand1 > *(uint64_t*)operand2)
-		{
-			*(uint64_t*)operand1 = *(uint64_t*)operand2;
-		}
-		return;
-	case PT_DOUBLE:
-		if(*(double*)operand1 > *(double*)operand2)
-		{
-			*(double*)operand1 = *(double*)operand2;
-		}
-		return;
-	case PT_CHARBUF:
-	case PT_BYTEBUF:
-		ASSERT(false); // Not supposed to use this
-		if(dst->m_len >= src->m_len)
+		n_fields = m_n_postmerge_fields;
+		types = &m_postmerge_types;
+	}
+	else
+	{
+		n_fields = m_n_premerge_fields;
+		types = &m_premerge_types;
+	}
+
+	if(col == 0)
+	{
+		if(m_type == sinsp_table::TT_TABLE)
 		{
-			memcpy(dst->m_val, src->m_val, src->m_len);
+			throw sinsp_exception("cannot sort by key");
 		}
 		else
 		{
-			dst->m_val = m_buffer->copy(src->m_val, src->m_len);
+			m_sorting_col = -1;
+			return;
 		}
+	}
 
-		dst->m_len = src->m_len;
-	default:
-		return;
+	if(col >= n_fields)
+	{
+		throw sinsp_exception("invalid table sorting column");
+	}
+
+	if(col == (uint32_t)(m_sorting_col + 1))
+	{
+		m_is_sorting_ascending = !m_is_sorting_ascending;
+	}
+	else
+	{
+		switch(types->at(col))
+		{
+			case PT_INT8:
+			case PT_INT16:
+			case PT_INT32:
+			case PT_INT64:
+			case PT_UINT8:
+			case PT_UINT16:
+			case PT_UINT32:
+			case PT_UINT64:
+			case PT_RELTIME:
+			case PT_ABSTIME:
+			case PT_DOUBLE:
+			case PT_BOOL:
+				m_is_sorting_ascending = false;
+				break;
+			default:
+				m_is_sorting_ascending = true;
+				break;
+		}
 	}
+
+	m_just_sorted = true;
+	m_sorting_col = col - 1;
 }
 
-void sinsp_table::add_fields(uint32_t dst_id, sinsp_table_field* src, uint32_t aggr)
+uint32_t sinsp_table::get_sorting_col()
 {
-	ppm_param_type type = (*m_types)[dst_id];
-	sinsp_table_field* dst = &(m_vals[dst_id - 1]);
+	return (uint32_t)m_sorting_col + 1;
+}
 
-	switch(aggr)
+void sinsp_table::create_sample()
+{
+	if(m_type == sinsp_table::TT_TABLE)
 	{
-	case A_NONE:
-		return;
-	case A_SUM:
-	case A_TIME_AVG:
-		if(src->m_cnt < 2)
+		uint32_t j;
+		m_full_sample_data.clear();
+		sinsp_sample_row row;
+
+		update_sketch_results(&m_premerge_table, &m_premerge_columns);
+
+		//
+		// If merging is on, perform the merge and switch to the merged table 
+		//
+		if(m_do_merging)
 		{
-			add_fields_sum(type, dst, src);
+			m_table = &m_merge_table;
+			m_merge_table.clear();
+
+			for(auto it = m_premerge_table.begin(); it != m_premerge_table.end(); ++it)
+			{
+				for(j = 0; j < m_n_postmerge_fields; j++)
+				{
+					sinsp_table_field* pfld = &(m_postmerge_fld_pointers[j]);
+
+					uint32_t col = m_groupby_columns[j];
+					if(col == 0)
+					{
+						pfld->m_val = it->first.m_val;
+						pfld->m_len = it->first.m_len;
+						pfld->m_cnt = it->first.m_cnt;
+					}
+					else
+					{
+						pfld->m_val = it->second[col - 1].m_val;
+						pfld->m_len = it->second[col - 1].m_len;
+						pfld->m_cnt = it->second[col - 1].m_cnt;
+					}
+				}
+
+				add_row(true);
+			}
+
+			update_sketch_results(&m_merge_table, &m_postmerge_columns);
 		}
 		else
 		{
-			add_fields_sum_of_avg(type, dst, src);
+			m_table = &m_premerge_table;
 		}
 
-		return;
-	case A_AVG:
-		dst->m_cnt += src->m_cnt;
-		add_fields_sum(type, dst, src);		
-		return;
-	case A_MAX:
-		add_fields_max(type, dst, src);		
-		return;
-	case A_MIN:
-		if(src->m_cnt != 0)
+		//
+		// Emit the table
+		//
+		for(auto it = m_table->begin(); it != m_table->end(); ++it)
 		{
-			if(dst->m_cnt == 0)
-			{
-				add_fields_sum(type, dst, src);
-				dst->m_cnt++;
-			}
-			else
+			row.m_key = it->first;
+
+			row.m_values.clear();
+
+			sinsp_table_field* fields = it->second;
+			for(j = 0; j < m_n_fields - 1; j++)
 			{
-				add_fields_min(type, dst, src);
+				row.m_values.push_back(fields[j]);
 			}
+
+			m_full_sample_data.push_back(row);
 		}
-		return;
-	default:
-		ASSERT(false);
+	}
+	else
+	{
+		//
+		// If this is a list, there's nothing to be done, since m_full_sample_data
+		// is already prepared and doesn't need to be cleaned.
+		//
 		return;
 	}
 }
 
 uint32_t sinsp_table::get_field_len(uint32_t id)
 {
-	ppm_param_type type;
+	const sinsp_table_column& col = (*m_columns)[id];
 	sinsp_table_field *fld;
 
-	type = (*m_types)[id];
+	if(col.m_fixed_len != 0)
+	{
+		return col.m_fixed_len;
+	}
+
 	fld = &(m_fld_pointers[id]);
 
-	switch(type)
+	switch(col.m_type)
 	{
-	case PT_INT8:
-		return 1;
-	case PT_INT16:
-		return 2;
-	case PT_INT32:
-		return 4;
-	case PT_INT64:
-	case PT_FD:
-	case PT_PID:
-	case PT_ERRNO:
-		return 8;
-	case PT_FLAGS8:
-	case PT_UINT8:
-	case PT_SIGTYPE:
-		return 1;
-	case PT_FLAGS16:
-	case PT_UINT16:
-	case PT_PORT:
-	case PT_SYSCALLID:
-		return 2;
-	case PT_UINT32:
-	case PT_FLAGS32:
-	case PT_MODE:
-	case PT_BOOL:
-	case PT_IPV4ADDR:
-	case PT_SIGSET:
-		return 4;
-	case PT_UINT64:
-	case PT_RELTIME:
-	case PT_ABSTIME:
-		return 8;
 	case PT_CHARBUF:
 		return (uint32_t)(strlen((char*)fld->m_val) + 1);
 	case PT_BYTEBUF:
 		return fld->m_len;
-	case PT_DOUBLE:
-		return sizeof(double);
-	case PT_IPV6ADDR:
-		return sizeof(ipv6addr);
 	case PT_IPADDR:
 	case PT_IPNET:
 		if(fld->m_len == sizeof(struct in_addr))
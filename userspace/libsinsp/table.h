@@ -17,6 +17,10 @@ limitations under the License.
 
 #define SINSP_TABLE_DEFAULT_REFRESH_INTERVAL_NS 1000000000
 #define SINSP_TABLE_BUFFER_ENTRY_SIZE 16384
+//
+// With a row limit, a table keeps this many times the rows it shows
+//
+#define SINSP_TABLE_TOPK_OVERSAMPLING 4
 
 class sinsp_filter_check_reference;
 
@@ -122,28 +126,76 @@ private:
 	uint32_t m_storage_len;
 };
 
+//
+// Hashes a table key 8 bytes at a time. Most keys are fixed width
+// numbers (pids, fds, ports), which take a single multiply.
+//
 struct sinsp_table_field_hasher
 {
-  size_t operator()(const sinsp_table_field& k) const
-  {
-	  size_t h = 0;
-	  uint8_t* s = k.m_val;
-	  uint32_t len = k.m_len;
-
-	  while(--len)
-	  {
-		  h = h * 101 + (unsigned) *s++;
-	  }
-
-	  return h;  
-  }
+	static inline uint64_t mix(uint64_t h)
+	{
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	static inline uint64_t hash64(const uint8_t* s, uint32_t len)
+	{
+		uint64_t h = len * 0x9e3779b97f4a7c15ULL;
+		uint64_t w;
+
+		switch(len)
+		{
+		case 1:
+			return mix(h ^ *s);
+		case 2:
+			return mix(h ^ *(uint16_t*)s);
+		case 4:
+			return mix(h ^ *(uint32_t*)s);
+		case 8:
+			return mix(h ^ *(uint64_t*)s);
+		default:
+			break;
+		}
+
+		while(len >= 8)
+		{
+			memcpy(&w, s, 8);
+			h = mix(h ^ w);
+			s += 8;
+			len -= 8;
+		}
+
+		if(len > 0)
+		{
+			w = 0;
+			memcpy(&w, s, len);
+			h = mix(h ^ w);
+		}
+
+		return h;
+	}
+
+	size_t operator()(const sinsp_table_field& k) const
+	{
+		return (size_t)hash64(k.m_val, k.m_len);
+	}
 };
 
+//
+// Arena for the keys and values of a table. clear() keeps the chunks
+// that were allocated, so that after the first refresh intervals a
+// table runs without allocating.
+//
 class sinsp_table_buffer
 {
 public:
 	sinsp_table_buffer()
 	{
+		m_curidx = 0;
 		push_buffer();
 	}
 
@@ -157,21 +209,25 @@ public:
 
 	void push_buffer()
 	{
-		m_curbuf = new uint8_t[SINSP_TABLE_BUFFER_ENTRY_SIZE];
-		m_bufs.push_back(m_curbuf);
+		if(m_curidx + 1 < m_bufs.size())
+		{
+			m_curidx++;
+			m_curbuf = m_bufs[m_curidx];
+		}
+		else
+		{
+			m_curbuf = new uint8_t[SINSP_TABLE_BUFFER_ENTRY_SIZE];
+			m_bufs.push_back(m_curbuf);
+			m_curidx = (uint32_t)m_bufs.size() - 1;
+		}
+
 		m_pos = 0;
 	}
 
 	uint8_t* copy(uint8_t* src, uint32_t len)
 	{
-		if(m_pos + len >= SINSP_TABLE_BUFFER_ENTRY_SIZE)
-		{
-			push_buffer();
-		}
-
-		uint8_t* dest = m_curbuf + m_pos;
+		uint8_t* dest = reserve(len);
 		memcpy(dest, src, len);
-		m_pos += len;
 		return dest;
 	}
 
@@ -193,23 +249,81 @@ public:
 		return dest;
 	}
 
-	void clear()
+	//
+	// Like reserve(), but 8-byte aligned, for the sketches
+	//
+	uint8_t* reserve_aligned(uint32_t len)
 	{
-		for(auto it = m_bufs.begin(); it != m_bufs.end(); ++it)
+		uint32_t pad = (8 - (uint32_t)((uintptr_t)(m_curbuf + m_pos) & 7)) & 7;
+
+		if(m_pos + pad + len < SINSP_TABLE_BUFFER_ENTRY_SIZE)
 		{
-			delete[] *it;
+			m_pos += pad;
+		}
+		else
+		{
+			// new chunks are aligned
+			push_buffer();
 		}
 
-		m_bufs.clear();
-		push_buffer();
+		return reserve(len);
+	}
+
+	void swap(sinsp_table_buffer& other)
+	{
+		std::swap(m_bufs, other.m_bufs);
+		std::swap(m_curbuf, other.m_curbuf);
+		std::swap(m_curidx, other.m_curidx);
+		std::swap(m_pos, other.m_pos);
+	}
+
+	void clear()
+	{
+		m_curidx = 0;
+		m_curbuf = m_bufs[0];
 		m_pos = 0;
 	}
 
 	vector<uint8_t*> m_bufs;
 	uint8_t* m_curbuf;
+	uint32_t m_curidx;
 	uint32_t m_pos;
 };
 
+//
+// Combines the value of a row with the value of a new row with the same
+// key
+//
+typedef void (*sinsp_table_accumulator)(sinsp_table_field* dst, sinsp_table_field* src, sinsp_table_buffer* buffer);
+
+//
+// The columns with the DISTINCT and Pxx aggregations keep a fixed size
+// sketch for every row instead of a value
+//
+typedef enum sinsp_table_sketch
+{
+	TS_NONE = 0,
+	TS_DISTINCT,
+	TS_QUANTILE,
+}sinsp_table_sketch;
+
+//
+// What the table needs to know about a column in the per-event path,
+// resolved once in configure()
+//
+class sinsp_table_column
+{
+public:
+	ppm_param_type m_type;	// of the values added to the rows
+	uint32_t m_fixed_len;	// 0 if the length depends on the value
+	sinsp_table_accumulator m_accumulate;
+	sinsp_table_accumulator m_combine;	// Combines two rows of the table
+	sinsp_table_sketch m_sketch;
+	bool m_sketch_input;	// The values added to the rows are sketches
+	double m_quantile;
+	ppm_param_type m_result_type;	// of the sketch results
+};
+
 class sinsp_sample_row
 {
 public:
@@ -290,6 +404,40 @@ public:
 	{
 		m_is_sorting_ascending = is_sorting_ascending;
 	}
+	//
+	// Only keep the top max_rows rows of the table, by the sorting
+	// column. The table then uses bounded memory, whatever the number of
+	// keys: it evicts the bottom rows when it grows beyond
+	// SINSP_TABLE_TOPK_OVERSAMPLING times the limit, so rows close to the
+	// limit can miss values that were evicted. Group-by tables are not
+	// pruned, only the rows they show are limited. 0 removes the limit.
+	//
+	void set_max_rows(uint32_t max_rows);
+	//
+	// Adds the rows of shard, a table with the same configuration fed by
+	// another inspector, to this one, and empties shard. This lets
+	// several inspectors, for example one per capture file, fill a single
+	// view: process the events of every inspector with its own table,
+	// possibly in its own thread, and at the end of every interval merge
+	// the shards into the table that is flushed, right before calling
+	// flush() with the same evt:
+	//
+	//  for(auto shard : shards)
+	//  {
+	//      table->merge_partial(shard, evt);
+	//  }
+	//  table->flush(evt);
+	//
+	// Sums, averages, minimums, maximums and distinct counts come out the
+	// same as with a single inspector. Values without aggregation come
+	// from the first table that had the key, this one and then the shards
+	// in merge order, and the maximum of strings from the last one, so
+	// always merge the shards in the same order. Percentiles are merged
+	// sketches, within the same error bounds.
+	//
+	// The shard must not process events while it's being merged.
+	//
+	void merge_partial(sinsp_table* shard, sinsp_evt* evt);
 
 	uint64_t m_next_flush_time_ns;
 	uint64_t m_prev_flush_time_ns;
@@ -299,11 +447,12 @@ public:
 
 private:
 	inline void add_row(bool merging);
-	inline void add_fields_sum(ppm_param_type type, sinsp_table_field* dst, sinsp_table_field* src);
-	inline void add_fields_sum_of_avg(ppm_param_type type, sinsp_table_field* dst, sinsp_table_field* src);
-	inline void add_fields_max(ppm_param_type type, sinsp_table_field* dst, sinsp_table_field* src);
-	inline void add_fields_min(ppm_param_type type, sinsp_table_field* dst, sinsp_table_field* src);
-	inline void add_fields(uint32_t dst_id, sinsp_table_field* src, uint32_t aggr);
+	void configure_columns(vector<sinsp_filter_check*>* extractors, vector<sinsp_table_column>* columns, bool merging);
+	inline void init_sketch(const sinsp_table_column* col, sinsp_table_field* dst, sinsp_table_field* src);
+	void update_sketch_results(unordered_map<sinsp_table_field, sinsp_table_field*, sinsp_table_field_hasher>* table,
+		vector<sinsp_table_column>* columns);
+	void prune_table();
+	sinsp_table_field* copy_row(sinsp_table_field* key, sinsp_table_field* vals, sinsp_table_buffer* buffer);
 	void process_proctable(sinsp_evt* evt);
 	inline uint32_t get_field_len(uint32_t id);
 	inline uint8_t* get_default_val(filtercheck_field_info* fld);
@@ -323,6 +472,9 @@ private:
 	vector<sinsp_filter_check*> m_chks_to_free;
 	vector<ppm_param_type> m_premerge_types;
 	vector<ppm_param_type> m_postmerge_types;
+	vector<sinsp_table_column>* m_columns;
+	vector<sinsp_table_column> m_premerge_columns;
+	vector<sinsp_table_column> m_postmerge_columns;
 	bool m_is_key_present;
 	bool m_is_groupby_key_present;
 	vector<uint32_t> m_groupby_columns;
@@ -336,12 +488,16 @@ private:
 	sinsp_table_buffer* m_buffer;
 	sinsp_table_buffer m_buffer1;
 	sinsp_table_buffer m_buffer2;
+	sinsp_table_buffer m_scratch;	// The values of the event being processed
+	sinsp_table_buffer m_compact_buffer;	// Where prune_table() moves the rows it keeps
+	uint32_t m_max_rows;
 	uint32_t m_vals_array_sz;
 	uint32_t m_premerge_vals_array_sz;
 	uint32_t m_postmerge_vals_array_sz;
 	sinsp_filter_check_reference* m_printer;
 	vector<sinsp_sample_row> m_full_sample_data;
 	vector<sinsp_sample_row> m_filtered_sample_data;
+	vector<sinsp_sample_row> m_top_sample_data;	// The shown rows, with a row limit
 	vector<sinsp_sample_row>* m_sample_data;
 	sinsp_table_field* m_vals;
 	int32_t m_sorting_col;
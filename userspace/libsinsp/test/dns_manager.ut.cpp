@@ -0,0 +1,128 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <arpa/inet.h>
+#include <dns_manager.h>
+
+#if defined(HAS_CAPTURE)
+
+class stub_dns_lookup : public sinsp_dns_lookup
+{
+public:
+	void resolve(const std::string& name, std::set<uint32_t>& v4_addrs, std::set<ipv6addr>& v6_addrs) override
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_lookups;
+		auto it = m_hosts.find(name);
+		if(it != m_hosts.end())
+		{
+			v4_addrs.insert(it->second);
+		}
+	}
+
+	void set(const std::string& name, const char* addr)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_hosts[name] = inet_addr(addr);
+	}
+
+	std::mutex m_mutex;
+	std::map<std::string, uint32_t> m_hosts;
+	unsigned m_lookups = 0;
+};
+
+class dns_manager_test : public testing::Test
+{
+protected:
+	void SetUp()
+	{
+		m_lookup = std::make_shared<stub_dns_lookup>();
+		sinsp_dns_manager::get().set_lookup(m_lookup);
+	}
+
+	void TearDown()
+	{
+		sinsp_dns_manager& manager = sinsp_dns_manager::get();
+		manager.cleanup();
+		manager.clear();
+		manager.set_max_entries(65536);
+		manager.set_base_refresh_timeout(10 * ONE_SECOND_IN_NS);
+		manager.set_lookup(std::make_shared<sinsp_getaddrinfo_lookup>());
+	}
+
+	std::shared_ptr<stub_dns_lookup> m_lookup;
+};
+
+TEST_F(dns_manager_test, match_and_name_of)
+{
+	sinsp_dns_manager& manager = sinsp_dns_manager::get();
+	m_lookup->set("www.example.com", "10.0.0.1");
+	uint32_t addr = inet_addr("10.0.0.1");
+	uint32_t other = inet_addr("10.0.0.2");
+
+	ASSERT_EQ("", manager.name_of(AF_INET, &addr, 1));
+	ASSERT_TRUE(manager.match("www.example.com", AF_INET, &addr, 1));
+	ASSERT_FALSE(manager.match("www.example.com", AF_INET, &other, 1));
+	ASSERT_EQ(1u, m_lookup->m_lookups);
+	ASSERT_EQ(1u, manager.size());
+
+	ASSERT_EQ("www.example.com", manager.name_of(AF_INET, &addr, 2));
+	ASSERT_EQ("", manager.name_of(AF_INET, &other, 2));
+}
+
+TEST_F(dns_manager_test, bounded_size)
+{
+	sinsp_dns_manager& manager = sinsp_dns_manager::get();
+	manager.set_max_entries(32);
+	uint32_t addr = inet_addr("10.0.0.1");
+	for(int i = 0; i < 1000; ++i)
+	{
+		std::string name = "host" + std::to_string(i);
+		m_lookup->set(name, ("10.0." + std::to_string(i / 250) + '.' + std::to_string(i % 250 + 1)).c_str());
+		manager.match(name.c_str(), AF_INET, &addr, i);
+	}
+	ASSERT_LE(manager.size(), 32u);
+
+	// the most recently used name is never evicted, the evicted ones
+	// are gone from the reverse index too
+	uint32_t last = inet_addr("10.0.3.250");
+	ASSERT_EQ("host999", manager.name_of(AF_INET, &last, 1000));
+	ASSERT_EQ("", manager.name_of(AF_INET, &addr, 1000));
+}
+
+TEST_F(dns_manager_test, refresh)
+{
+	sinsp_dns_manager& manager = sinsp_dns_manager::get();
+	manager.set_base_refresh_timeout(ONE_SECOND_IN_NS / 100);
+	m_lookup->set("www.example.com", "10.0.0.1");
+	uint32_t addr = inet_addr("10.0.0.1");
+	uint32_t moved = inet_addr("10.0.0.2");
+
+	uint64_t ts = sinsp_utils::get_current_time_ns();
+	ASSERT_TRUE(manager.match("www.example.com", AF_INET, &addr, ts));
+	m_lookup->set("www.example.com", "10.0.0.2");
+
+	for(int i = 0; i < 200 && manager.name_of(AF_INET, &moved, ts).empty(); ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	ASSERT_EQ("www.example.com", manager.name_of(AF_INET, &moved, ts));
+	ASSERT_EQ("", manager.name_of(AF_INET, &addr, ts));
+}
+
+#endif // HAS_CAPTURE
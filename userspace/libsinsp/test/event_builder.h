@@ -0,0 +1,100 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include "sinsp.h"
+
+namespace test_helpers
+{
+//
+// Builds events in memory, in the format of the driver, for the tests
+// that need events with parameters but no capture
+//
+class event_builder
+{
+public:
+	event_builder(sinsp* inspector):
+		m_evt(inspector)
+	{
+	}
+
+	//
+	// The raw value of a parameter
+	//
+	template<typename T>
+	static std::string param(T val)
+	{
+		return std::string((const char*)&val, sizeof(val));
+	}
+
+	//
+	// Returns the event, which stays valid until the next call
+	//
+	sinsp_evt* build(uint64_t ts, uint64_t tid, uint16_t type, const std::vector<std::string>& params)
+	{
+		uint32_t len = (uint32_t)(sizeof(scap_evt) + params.size() * sizeof(uint16_t));
+		for(const auto& p : params)
+		{
+			len += (uint32_t)p.size();
+		}
+
+		m_buf.assign(len, 0);
+
+		scap_evt* hdr = (scap_evt*)&m_buf[0];
+		hdr->ts = ts;
+		hdr->tid = tid;
+		hdr->len = len;
+		hdr->type = type;
+		hdr->nparams = (uint32_t)params.size();
+
+		uint8_t* lens = &m_buf[sizeof(scap_evt)];
+		uint8_t* vals = lens + params.size() * sizeof(uint16_t);
+		for(const auto& p : params)
+		{
+			uint16_t plen = (uint16_t)p.size();
+			memcpy(lens, &plen, sizeof(plen));
+			lens += sizeof(plen);
+			memcpy(vals, p.data(), p.size());
+			vals += p.size();
+		}
+
+		m_evt.init(&m_buf[0], 0);
+		return &m_evt;
+	}
+
+	//
+	// A brk exit event, which has three numeric parameters besides the
+	// return value
+	//
+	sinsp_evt* brk_x(uint64_t ts, uint32_t vm_size, uint32_t vm_rss, uint32_t vm_swap)
+	{
+		return build(ts, 1, PPME_SYSCALL_BRK_4_X, {
+			param<uint64_t>(0x1000),
+			param<uint32_t>(vm_size),
+			param<uint32_t>(vm_rss),
+			param<uint32_t>(vm_swap)});
+	}
+
+private:
+	std::vector<uint8_t> m_buf;
+	sinsp_evt m_evt;
+};
+}
@@ -0,0 +1,137 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include "sinsp.h"
+#include "eventformatter.h"
+#include "event_builder.h"
+
+//
+// The vm_size and vm_rss parameters of the event are rendered in the same
+// buffer of the event
+//
+static sinsp_evt* brk_x(test_helpers::event_builder* builder)
+{
+	return builder->brk_x(1000, 12345, 678, 9);
+}
+
+//
+// The group must render every format exactly like a standalone
+// formatter would
+//
+static void expect_same_as_formatters(sinsp* inspector, sinsp_evt* evt, const std::vector<std::string>& formats)
+{
+	sinsp_evt_formatter_group group(inspector);
+	for(const auto& fmt : formats)
+	{
+		group.add_format(fmt);
+	}
+	ASSERT_EQ(formats.size(), group.get_num_formats());
+
+	std::vector<std::string> res;
+	std::vector<bool> show;
+	group.tostring(evt, &res, &show);
+	ASSERT_EQ(formats.size(), res.size());
+	ASSERT_EQ(formats.size(), show.size());
+
+	std::string buf;
+	std::vector<size_t> ends;
+	std::vector<bool> bulk_show;
+	group.tostring(std::vector<sinsp_evt*>{evt, evt}, &buf, &ends, &bulk_show);
+	ASSERT_EQ(2 * formats.size(), ends.size());
+
+	size_t start = 0;
+	for(uint32_t j = 0; j < 2 * formats.size(); j++)
+	{
+		uint32_t f = j % formats.size();
+		sinsp_evt_formatter formatter(inspector, formats[f]);
+		std::string expected;
+		bool expected_show = formatter.tostring(evt, &expected);
+
+		if(j < formats.size())
+		{
+			EXPECT_EQ(expected, res[j]) << formats[f];
+			EXPECT_EQ(expected_show, show[j]) << formats[f];
+		}
+		EXPECT_EQ(expected, buf.substr(start, ends[j] - start)) << formats[f];
+		EXPECT_EQ(expected_show, bulk_show[j]) << formats[f];
+		start = ends[j];
+	}
+}
+
+TEST(sinsp_evt_formatter_group, shared_args)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	sinsp_evt* evt = brk_x(&builder);
+
+	//
+	// Both arguments are rendered in the same buffer of the event: the
+	// value of vm_size shared with the second format must not be
+	// overwritten by the extraction of vm_rss
+	//
+	std::vector<std::string> formats = {
+		"%evt.arg.vm_size %evt.arg.vm_rss",
+		"size=%evt.arg.vm_size",
+		"%evt.arg.vm_rss/%evt.arg.vm_swap/%evt.arg.vm_size",
+	};
+	expect_same_as_formatters(&inspector, evt, formats);
+
+	std::vector<std::string> res;
+	std::vector<bool> show;
+	sinsp_evt_formatter_group group(&inspector);
+	group.add_format(formats[0]);
+	group.add_format(formats[1]);
+	group.tostring(evt, &res, &show);
+	ASSERT_EQ(2u, res.size());
+	EXPECT_EQ("12345 678", res[0]);
+	EXPECT_EQ("size=12345", res[1]);
+}
+
+TEST(sinsp_evt_formatter_group, json)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	sinsp_evt* evt = brk_x(&builder);
+
+	inspector.set_buffer_format(sinsp_evt::PF_JSON);
+
+	std::vector<std::string> formats = {
+		"*%evt.type %evt.arg.vm_size %evt.arg.vm_rss",
+		"%evt.arg.vm_rss %evt.type",
+		"%proc.name %evt.arg.vm_size",
+	};
+	expect_same_as_formatters(&inspector, evt, formats);
+}
+
+TEST(sinsp_evt_formatter_group, missing_fields)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	sinsp_evt* evt = brk_x(&builder);
+
+	//
+	// The event has no thread: without the leading '*', a missing field
+	// hides the output
+	//
+	std::vector<std::string> formats = {
+		"%evt.arg.vm_size %proc.name",
+		"*%proc.name %evt.arg.vm_size",
+		"%evt.arg.vm_size",
+	};
+	expect_same_as_formatters(&inspector, evt, formats);
+}
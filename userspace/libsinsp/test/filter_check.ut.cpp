@@ -0,0 +1,177 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include "sinsp.h"
+#include "filterchecks.h"
+
+//
+// A check that extracts a fixed raw value, to compare append_json()
+// with the serialized output of tojson()
+//
+class fixed_value_check : public sinsp_filter_check
+{
+public:
+	fixed_value_check(ppm_param_type type, ppm_print_format print_format, const void* val, uint32_t len):
+		m_value((const uint8_t*)val, (const uint8_t*)val + len)
+	{
+		m_field_info.m_type = type;
+		m_field_info.m_flags = EPF_NONE;
+		m_field_info.m_print_format = print_format;
+		m_field = &m_field_info;
+		m_info.m_fields = &m_field_info;
+		m_info.m_nfields = 1;
+	}
+
+	sinsp_filter_check* allocate_new()
+	{
+		return NULL;
+	}
+
+	uint8_t* extract(sinsp_evt *evt, OUT uint32_t* len, bool sanitize_strings = true)
+	{
+		*len = (uint32_t)m_value.size();
+		return m_value.empty() ? NULL : &m_value[0];
+	}
+
+	std::string expected()
+	{
+		Json::FastWriter writer;
+		std::string res = writer.write(tojson(NULL));
+		return res.substr(0, res.size() - 1);
+	}
+
+	std::string streamed()
+	{
+		std::string res;
+		if(!append_json(NULL, &res))
+		{
+			return "null";
+		}
+		return res;
+	}
+
+private:
+	filtercheck_field_info m_field_info;
+	std::vector<uint8_t> m_value;
+};
+
+//
+// A check that extracts a fixed JSON value, like the checks that
+// implement extract_as_js()
+//
+class fixed_json_check : public fixed_value_check
+{
+public:
+	fixed_json_check(const Json::Value& val):
+		fixed_value_check(PT_CHARBUF, PF_NA, NULL, 0),
+		m_json(val)
+	{
+	}
+
+	Json::Value extract_as_js(sinsp_evt *evt, OUT uint32_t* len)
+	{
+		return m_json;
+	}
+
+private:
+	Json::Value m_json;
+};
+
+TEST(sinsp_filter_check, append_json_numbers)
+{
+	int64_t i64 = -1234567890123LL;
+	uint64_t u64 = 18446744073709551615ULL;
+	int32_t i32 = -42;
+	uint16_t u16 = 8080;
+	uint32_t b = 1;
+
+	// m_field points into the check, so they are not copied around
+	std::vector<std::shared_ptr<fixed_value_check>> checks = {
+		std::make_shared<fixed_value_check>(PT_INT64, PF_DEC, &i64, sizeof(i64)),
+		std::make_shared<fixed_value_check>(PT_INT64, PF_HEX, &i64, sizeof(i64)),
+		std::make_shared<fixed_value_check>(PT_UINT64, PF_DEC, &u64, sizeof(u64)),
+		std::make_shared<fixed_value_check>(PT_UINT64, PF_10_PADDED_DEC, &u64, sizeof(u64)),
+		std::make_shared<fixed_value_check>(PT_INT32, PF_ID, &i32, sizeof(i32)),
+		std::make_shared<fixed_value_check>(PT_INT32, PF_OCT, &i32, sizeof(i32)),
+		std::make_shared<fixed_value_check>(PT_PORT, PF_DEC, &u16, sizeof(u16)),
+		std::make_shared<fixed_value_check>(PT_BOOL, PF_NA, &b, sizeof(b)),
+		std::make_shared<fixed_value_check>(PT_UINT64, PF_DEC, nullptr, 0),
+	};
+
+	for(auto& chk : checks)
+	{
+		ASSERT_EQ(chk->expected(), chk->streamed());
+	}
+}
+
+TEST(sinsp_filter_check, append_json_strings)
+{
+	std::vector<std::string> values = {
+		"",
+		"/usr/bin/bash",
+		"quote\" backslash\\ slash/",
+		"tab\t newline\n cr\r bs\b ff\f",
+		"ctrl\x01\x1f end",
+		"utf8 \xc3\xa9\xe2\x82\xac",
+	};
+
+	for(const auto& val : values)
+	{
+		fixed_value_check chk(PT_CHARBUF, PF_NA, val.c_str(), (uint32_t)val.size() + 1);
+		ASSERT_EQ(chk.expected(), chk.streamed()) << val;
+	}
+}
+
+TEST(sinsp_filter_check, append_json_values)
+{
+	std::string nul("nul\0 inside", 12);
+	Json::Value obj;
+	obj["key\t"] = "ctrl\x01 utf8 \xc3\xa9";
+	obj["nul"] = nul;
+	obj["list"].append("a\"b");
+	obj["list"].append(-7);
+
+	std::vector<Json::Value> values = {
+		Json::Value(nul),
+		Json::Value("utf8 \xe2\x82\xac\n"),
+		obj,
+	};
+
+	for(const auto& val : values)
+	{
+		fixed_json_check chk(val);
+		ASSERT_EQ(chk.expected(), chk.streamed());
+	}
+}
+
+//
+// The escaping of the linked jsoncpp, bundled or not
+//
+TEST(sinsp_filter_check, append_json_strings_escaping)
+{
+	std::string val = "ctrl\x01\x1f end utf8 \xc3\xa9\xe2\x82\xac";
+	fixed_value_check chk(PT_CHARBUF, PF_NA, val.c_str(), (uint32_t)val.size() + 1);
+
+#if JSONCPP_VERSION_MAJOR == 0
+	// the bundled jsoncpp
+	ASSERT_EQ("\"ctrl\\u0001\\u001F end utf8 \xc3\xa9\xe2\x82\xac\"", chk.streamed());
+#elif JSONCPP_VERSION_HEXA >= 0x01090500
+	ASSERT_EQ("\"ctrl\\u0001\\u001f end utf8 \\u00e9\\u20ac\"", chk.streamed());
+#endif
+	ASSERT_EQ(chk.expected(), chk.streamed());
+}
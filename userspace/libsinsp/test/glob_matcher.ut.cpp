@@ -0,0 +1,80 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <fnmatch.h>
+#include <random>
+#include <glob_matcher.h>
+
+static bool glob(const std::string& pattern, const std::string& str)
+{
+	glob_matcher matcher;
+	matcher.compile(pattern.c_str(), pattern.size());
+	return matcher.match(str.c_str(), str.size());
+}
+
+TEST(glob_matcher, rule_patterns)
+{
+	ASSERT_TRUE(glob("/etc/passwd", "/etc/passwd"));
+	ASSERT_FALSE(glob("/etc/passwd", "/etc/passwd-"));
+	ASSERT_TRUE(glob("/etc/*", "/etc/ssh/sshd_config"));
+	ASSERT_FALSE(glob("/etc/*", "/var/etc/x"));
+	ASSERT_TRUE(glob("*.sh", "/tmp/install.sh"));
+	ASSERT_FALSE(glob("*.sh", "/tmp/install.shx"));
+	ASSERT_TRUE(glob("/proc/*/environ", "/proc/1234/environ"));
+	ASSERT_FALSE(glob("/proc/*/environ", "/proc/1234/environment"));
+	ASSERT_TRUE(glob("*/.ssh/*", "/root/.ssh/authorized_keys"));
+	ASSERT_TRUE(glob("/dev/tty[0-9]", "/dev/tty7"));
+	ASSERT_FALSE(glob("/dev/tty[!0-9]", "/dev/tty7"));
+	ASSERT_TRUE(glob("/usr/bin/python?.?", "/usr/bin/python3.8"));
+	ASSERT_TRUE(glob("*", ""));
+	ASSERT_TRUE(glob("", ""));
+	ASSERT_FALSE(glob("?", ""));
+
+	// constructs that are not compiled still behave like fnmatch()
+	ASSERT_TRUE(glob("/dev/tty[[:digit:]]", "/dev/tty7"));
+	ASSERT_FALSE(glob("/dev/tty[[:digit:]]", "/dev/ttyS"));
+}
+
+TEST(glob_matcher, random_against_fnmatch)
+{
+	std::mt19937 rng(42);
+	const char pattern_alphabet[] = "ab/.*?[]!^-\\";
+	const char str_alphabet[] = "ab/.-[]!\\";
+	auto random_string = [&](const char* alphabet, size_t alphabet_len, size_t len)
+	{
+		std::string s;
+		for(size_t j = 0; j < len; j++)
+		{
+			s += alphabet[rng() % alphabet_len];
+		}
+		return s;
+	};
+
+	for(int i = 0; i < 50000; i++)
+	{
+		std::string pattern = random_string(pattern_alphabet, sizeof(pattern_alphabet) - 1, rng() % 10);
+		glob_matcher matcher;
+		matcher.compile(pattern.c_str(), pattern.size());
+		for(int j = 0; j < 8; j++)
+		{
+			std::string str = random_string(str_alphabet, sizeof(str_alphabet) - 1, rng() % 12);
+			ASSERT_EQ(fnmatch(pattern.c_str(), str.c_str(), 0) == 0, matcher.match(str.c_str(), str.size()))
+				<< "'" << pattern << "' / '" << str << "'";
+		}
+	}
+}
@@ -0,0 +1,236 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <arpa/inet.h>
+#include "sinsp.h"
+
+// reference implementation: linear scan, as the lookups were done before indexing
+static uint32_t scan_infer_ipv4(vector<sinsp_ipv4_ifinfo>& ifs, uint32_t addr)
+{
+	for(const auto& i : ifs) { if(i.m_addr == addr) { return i.m_addr; } }
+	for(const auto& i : ifs) { if((i.m_addr & i.m_netmask) == (addr & i.m_netmask)) { return i.m_addr; } }
+	for(const auto& i : ifs) { if(i.m_addr != ntohl(INADDR_LOOPBACK)) { return i.m_addr; } }
+	return 0;
+}
+
+static uint32_t infer_ipv4(sinsp_network_interfaces& interfaces, uint32_t dip)
+{
+	sinsp_fdinfo_t fd;
+	fd.m_type = SCAP_FD_IPV4_SOCK;
+	fd.m_sockinfo.m_ipv4info.m_fields.m_sip = 0;
+	fd.m_sockinfo.m_ipv4info.m_fields.m_dip = dip;
+	fd.m_sockinfo.m_ipv4info.m_fields.m_sport = 1;
+	fd.m_sockinfo.m_ipv4info.m_fields.m_dport = 2;
+	interfaces.update_fd(&fd);
+	return fd.m_sockinfo.m_ipv4info.m_fields.m_sip;
+}
+
+TEST(sinsp_network_interfaces, many_ipv4_interfaces)
+{
+	sinsp_network_interfaces interfaces(nullptr);
+	interfaces.import_ipv4_interface(sinsp_ipv4_ifinfo(inet_addr("127.0.0.1"), inet_addr("255.0.0.0"),
+							   inet_addr("127.255.255.255"), "lo"));
+	for(uint32_t i = 0; i < 4000; ++i)
+	{
+		// 100.64.0.0/10 is neither private nor loopback
+		std::string addr = "100." + std::to_string(64 + i / 256) + '.' + std::to_string(i % 256) + ".1";
+		const char* netmask = (i % 3) ? "255.255.255.0" : "255.255.0.0";
+		interfaces.import_ipv4_interface(sinsp_ipv4_ifinfo(inet_addr(addr.c_str()), inet_addr(netmask),
+								   0, ("veth" + std::to_string(i)).c_str()));
+	}
+
+	vector<sinsp_ipv4_ifinfo>& ifs = *interfaces.get_ipv4_list();
+	for(uint32_t i = 0; i < 5000; ++i)
+	{
+		std::string addr = "100." + std::to_string(64 + i / 256) + '.' + std::to_string(i % 256) + '.' + std::to_string(i % 7);
+		uint32_t dip = inet_addr(addr.c_str());
+		ASSERT_EQ(scan_infer_ipv4(ifs, dip), infer_ipv4(interfaces, dip)) << addr;
+	}
+	ASSERT_TRUE(interfaces.is_ipv4addr_in_subnet(inet_addr("100.64.200.9")));
+	ASSERT_TRUE(interfaces.is_ipv4addr_in_subnet(inet_addr("10.1.2.3")));
+	ASSERT_FALSE(interfaces.is_ipv4addr_in_subnet(inet_addr("8.8.8.8")));
+	ASSERT_EQ(inet_addr("100.64.0.1"), infer_ipv4(interfaces, inet_addr("8.8.8.8")));
+
+	// interfaces added through the exposed list are picked up too
+	interfaces.get_ipv4_list()->push_back(sinsp_ipv4_ifinfo(inet_addr("8.8.8.1"), inet_addr("255.255.255.0"), 0, "ext"));
+	ASSERT_TRUE(interfaces.is_ipv4addr_in_subnet(inet_addr("8.8.8.8")));
+	ASSERT_EQ(inet_addr("8.8.8.1"), infer_ipv4(interfaces, inet_addr("8.8.8.8")));
+
+	interfaces.clear();
+	ASSERT_FALSE(interfaces.is_ipv4addr_in_subnet(inet_addr("100.64.200.9")));
+	ASSERT_EQ(0u, infer_ipv4(interfaces, inet_addr("100.64.200.9")));
+}
+
+TEST(sinsp_network_interfaces, ipv6_subnets)
+{
+	sinsp_network_interfaces interfaces(nullptr);
+	sinsp_ipv6_ifinfo lo;
+	lo.m_net = interfaces.m_ipv6_loopback_addr;
+	lo.m_name = "lo";
+	interfaces.import_ipv6_interface(lo);
+	sinsp_ipv6_ifinfo eth;
+	inet_pton(AF_INET6, "2001:db8:0:1::10", eth.m_net.m_b);
+	eth.m_name = "eth0";
+	interfaces.import_ipv6_interface(eth);
+
+	sinsp_fdinfo_t fd;
+	fd.m_type = SCAP_FD_IPV6_SOCK;
+	fd.m_sockinfo.m_ipv6info.m_fields.m_sip = ipv6addr::empty_address;
+	inet_pton(AF_INET6, "2001:db8:0:1::20", fd.m_sockinfo.m_ipv6info.m_fields.m_dip.m_b);
+	fd.m_sockinfo.m_ipv6info.m_fields.m_sport = 1;
+	fd.m_sockinfo.m_ipv6info.m_fields.m_dport = 2;
+	interfaces.update_fd(&fd);
+	ASSERT_EQ(eth.m_net, fd.m_sockinfo.m_ipv6info.m_fields.m_sip);
+
+	fd.m_sockinfo.m_ipv6info.m_fields.m_sip = ipv6addr::empty_address;
+	inet_pton(AF_INET6, "2001:db8:ffff::1", fd.m_sockinfo.m_ipv6info.m_fields.m_dip.m_b);
+	interfaces.update_fd(&fd);
+	ASSERT_EQ(eth.m_net, fd.m_sockinfo.m_ipv6info.m_fields.m_sip);
+}
+
+TEST(sinsp_network_interfaces, list_changes)
+{
+	sinsp_network_interfaces interfaces(nullptr);
+	interfaces.import_ipv4_interface(sinsp_ipv4_ifinfo(inet_addr("100.64.1.1"), inet_addr("255.255.255.0"), 0, "eth0"));
+	interfaces.import_ipv4_interface(sinsp_ipv4_ifinfo(inet_addr("100.64.2.1"), inet_addr("255.255.255.0"), 0, "eth1"));
+	ASSERT_EQ(inet_addr("100.64.2.1"), infer_ipv4(interfaces, inet_addr("100.64.2.9")));
+
+	// changed in place
+	interfaces.get_ipv4_list()->at(1).m_addr = inet_addr("100.64.3.1");
+	ASSERT_EQ(inet_addr("100.64.3.1"), infer_ipv4(interfaces, inet_addr("100.64.3.9")));
+	ASSERT_EQ(inet_addr("100.64.1.1"), infer_ipv4(interfaces, inet_addr("100.64.2.9")));
+
+	// cleared and refilled with as many interfaces
+	vector<sinsp_ipv4_ifinfo>* ifs = interfaces.get_ipv4_list();
+	ifs->clear();
+	ifs->push_back(sinsp_ipv4_ifinfo(inet_addr("100.64.4.1"), inet_addr("255.255.255.0"), 0, "eth2"));
+	ifs->push_back(sinsp_ipv4_ifinfo(inet_addr("100.64.5.1"), inet_addr("255.255.255.0"), 0, "eth3"));
+	ASSERT_FALSE(interfaces.is_ipv4addr_in_subnet(inet_addr("100.64.1.9")));
+	ASSERT_TRUE(interfaces.is_ipv4addr_in_subnet(inet_addr("100.64.5.9")));
+	ASSERT_EQ(inet_addr("100.64.5.1"), infer_ipv4(interfaces, inet_addr("100.64.5.9")));
+}
+
+static scap_ifinfo_ipv4 scap_ipv4(const std::string& addr, const char* netmask, const std::string& name)
+{
+	scap_ifinfo_ipv4 res = {};
+	res.addr = inet_addr(addr.c_str());
+	res.netmask = inet_addr(netmask);
+	snprintf(res.ifname, sizeof(res.ifname), "%s", name.c_str());
+	return res;
+}
+
+static scap_ifinfo_ipv6 scap_ipv6(const char* addr, const std::string& name)
+{
+	scap_ifinfo_ipv6 res = {};
+	inet_pton(AF_INET6, addr, res.addr);
+	snprintf(res.ifname, sizeof(res.ifname), "%s", name.c_str());
+	return res;
+}
+
+static void import(sinsp_network_interfaces* interfaces, vector<scap_ifinfo_ipv4>& v4, vector<scap_ifinfo_ipv6>& v6)
+{
+	scap_addrlist list = {};
+	list.n_v4_addrs = (uint32_t)v4.size();
+	list.n_v6_addrs = (uint32_t)v6.size();
+	list.v4list = v4.data();
+	list.v6list = v6.data();
+	interfaces->import_interfaces(&list);
+}
+
+//
+// A list imported over another must give the same lookups as the same
+// list imported from scratch
+//
+static void expect_same_as_fresh_import(sinsp_network_interfaces* interfaces, vector<scap_ifinfo_ipv4>& v4, vector<scap_ifinfo_ipv6>& v6)
+{
+	import(interfaces, v4, v6);
+	sinsp_network_interfaces fresh(nullptr);
+	import(&fresh, v4, v6);
+
+	//
+	// Through the const lists, which don't invalidate the indexes
+	// updated by the import
+	//
+	const sinsp_network_interfaces* imported = interfaces;
+	ASSERT_EQ(v4.size(), imported->get_ipv4_list()->size());
+	ASSERT_EQ(v6.size(), imported->get_ipv6_list()->size());
+
+	//
+	// The addresses of the interfaces, and others in their subnets
+	//
+	for(uint32_t i = 0; i < 600; ++i)
+	{
+		uint32_t j = i % 300;
+		std::string addr = "100." + std::to_string(64 + j / 100) + '.' + std::to_string(j % 100) + (i < 300 ? ".1" : ".7");
+		uint32_t dip = inet_addr(addr.c_str());
+		ASSERT_EQ(infer_ipv4(fresh, dip), infer_ipv4(*interfaces, dip)) << addr;
+		ASSERT_EQ(fresh.is_ipv4addr_in_subnet(dip), interfaces->is_ipv4addr_in_subnet(dip)) << addr;
+	}
+
+	sinsp_fdinfo_t fd;
+	fd.m_type = SCAP_FD_IPV6_SOCK;
+	fd.m_sockinfo.m_ipv6info.m_fields.m_sport = 1;
+	fd.m_sockinfo.m_ipv6info.m_fields.m_dport = 2;
+	for(const char* addr : {"2001:db8:0:1::10", "2001:db8:0:1::20", "2001:db8:0:2::10", "2001:db8:0:2::20", "2001:db8:0:3::10", "2001:db8:0:3::20", "2001:db8:ffff::1"})
+	{
+		fd.m_sockinfo.m_ipv6info.m_fields.m_sip = ipv6addr::empty_address;
+		inet_pton(AF_INET6, addr, fd.m_sockinfo.m_ipv6info.m_fields.m_dip.m_b);
+		fresh.update_fd(&fd);
+		ipv6addr expected = fd.m_sockinfo.m_ipv6info.m_fields.m_sip;
+
+		fd.m_sockinfo.m_ipv6info.m_fields.m_sip = ipv6addr::empty_address;
+		interfaces->update_fd(&fd);
+		ASSERT_EQ(expected, fd.m_sockinfo.m_ipv6info.m_fields.m_sip) << addr;
+	}
+}
+
+TEST(sinsp_network_interfaces, import_interfaces_refresh)
+{
+	sinsp_network_interfaces interfaces(nullptr);
+	vector<scap_ifinfo_ipv4> v4;
+	vector<scap_ifinfo_ipv6> v6;
+
+	v4.push_back(scap_ipv4("127.0.0.1", "255.0.0.0", "lo"));
+	for(uint32_t i = 0; i < 100; ++i)
+	{
+		std::string addr = "100." + std::to_string(64 + i / 50) + '.' + std::to_string(i % 50) + ".1";
+		v4.push_back(scap_ipv4(addr, (i % 3) ? "255.255.255.0" : "255.255.0.0", "veth" + std::to_string(i)));
+	}
+	v6.push_back(scap_ipv6("::1", "lo"));
+	v6.push_back(scap_ipv6("2001:db8:0:1::10", "eth0"));
+	expect_same_as_fresh_import(&interfaces, v4, v6);
+
+	// appended
+	v4.push_back(scap_ipv4("100.66.1.1", "255.255.255.0", "veth100"));
+	v6.push_back(scap_ipv6("2001:db8:0:2::10", "eth1"));
+	expect_same_as_fresh_import(&interfaces, v4, v6);
+
+	// removed from the middle, and changed
+	v4.erase(v4.begin() + 10);
+	v4[20].netmask = inet_addr("255.255.0.0");
+	v6.erase(v6.begin() + 1);
+	expect_same_as_fresh_import(&interfaces, v4, v6);
+
+	// the first changed, the loopback is gone
+	v4.erase(v4.begin());
+	v6[0] = scap_ipv6("2001:db8:0:3::10", "eth2");
+	expect_same_as_fresh_import(&interfaces, v4, v6);
+
+	// unchanged
+	expect_same_as_fresh_import(&interfaces, v4, v6);
+}
@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <json_list_splitter.h>
+
+static const std::string pod_list =
+	"{\"kind\":\"PodList\",\"apiVersion\":\"v1\",\"metadata\":{\"resourceVersion\":\"42\"},"
+	"\"items\":[{\"metadata\":{\"name\":\"a\",\"labels\":{\"x\":\"}]\\\"\"}}},"
+	" {\"metadata\":{\"name\":\"b\"}}]}\n";
+
+TEST(json_list_splitter_test, split_items)
+{
+	json_list_splitter splitter;
+	json_list_splitter::json_list_t out;
+	ASSERT_EQ(2u, splitter.feed(pod_list.data(), pod_list.size(), out));
+	ASSERT_EQ("{\"kind\":\"PodList\",\"apiVersion\":\"v1\",\"metadata\":{\"resourceVersion\":\"42\"},"
+		  "\"items\":[{\"metadata\":{\"name\":\"a\",\"labels\":{\"x\":\"}]\\\"\"}}}]}", out[0]);
+	ASSERT_EQ("{\"kind\":\"PodList\",\"apiVersion\":\"v1\",\"metadata\":{\"resourceVersion\":\"42\"},"
+		  "\"items\":[{\"metadata\":{\"name\":\"b\"}}]}", out[1]);
+	ASSERT_FALSE(splitter.in_progress());
+	ASSERT_EQ(0u, splitter.buffered());
+}
+
+TEST(json_list_splitter_test, byte_by_byte)
+{
+	json_list_splitter whole;
+	json_list_splitter::json_list_t expected;
+	whole.feed(pod_list.data(), pod_list.size(), expected);
+
+	json_list_splitter splitter;
+	json_list_splitter::json_list_t out;
+	for(char c : pod_list)
+	{
+		splitter.feed(&c, 1, out);
+		ASSERT_LT(splitter.buffered(), pod_list.size() / 2);
+	}
+	ASSERT_EQ(expected, out);
+}
+
+TEST(json_list_splitter_test, passthrough)
+{
+	json_list_splitter splitter;
+	json_list_splitter::json_list_t out;
+
+	std::string empty = "{\"kind\":\"PodList\",\"items\":[]}";
+	ASSERT_EQ(1u, splitter.feed(empty.data(), empty.size(), out));
+	ASSERT_EQ(empty, out.back());
+
+	std::string status = "{\"kind\":\"Status\",\"code\":404,\"items\":null}";
+	ASSERT_EQ(1u, splitter.feed(status.data(), status.size(), out));
+	ASSERT_EQ(status, out.back());
+
+	std::string arr = "[{\"a\":1},{\"b\":2}]";
+	ASSERT_EQ(1u, splitter.feed(arr.data(), arr.size(), out));
+	ASSERT_EQ(arr, out.back());
+}
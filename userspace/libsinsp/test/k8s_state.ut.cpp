@@ -0,0 +1,89 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <k8s_state.h>
+
+static k8s_pod_t& add_pod(k8s_state_t& state, const std::string& name, const std::string& container_id)
+{
+	k8s_pod_t& pod = state.get_component<k8s_pods, k8s_pod_t>(state.get_pods(), name, name + "-uid", "default");
+	pod.set_labels({{"app", "web"}});
+	pod.set_container_ids({"docker://" + container_id});
+	state.update_cache(k8s_component::K8S_PODS, pod.get_uid());
+	return pod;
+}
+
+TEST(k8s_state_test, lookup_by_uid)
+{
+	k8s_state_t state;
+	for(int i = 0; i < 100; ++i)
+	{
+		add_pod(state, "pod" + std::to_string(i), "0123456789ab" + std::to_string(i));
+	}
+
+	ASSERT_EQ(100u, state.get_pods().size());
+	ASSERT_TRUE(state.has(state.get_pods(), "pod42-uid"));
+	ASSERT_TRUE(state.has("pod42-uid"));
+	ASSERT_FALSE(state.has(state.get_pods(), "pod100-uid"));
+	const k8s_pod_t* pod = state.get_component<k8s_pods, k8s_pod_t>(state.get_pods(), "pod42-uid");
+	ASSERT_NE(nullptr, pod);
+	ASSERT_EQ("pod42", pod->get_name());
+}
+
+TEST(k8s_state_test, stable_references_on_delete)
+{
+	k8s_state_t state;
+	k8s_pod_t& first = add_pod(state, "first", "aaaaaaaaaaaa");
+	add_pod(state, "second", "bbbbbbbbbbbb");
+	k8s_pod_t& third = add_pod(state, "third", "cccccccccccc");
+
+	ASSERT_TRUE(state.delete_component(state.get_pods(), "second-uid"));
+	ASSERT_FALSE(state.delete_component(state.get_pods(), "second-uid"));
+
+	ASSERT_EQ(2u, state.get_pods().size());
+	ASSERT_EQ(&first, state.get_pod("aaaaaaaaaaaa"));
+	ASSERT_EQ(&third, state.get_pod("cccccccccccc"));
+	ASSERT_EQ(nullptr, state.get_pod("bbbbbbbbbbbb"));
+	ASSERT_EQ("third", state.get_pods().back().get_name());
+}
+
+TEST(k8s_state_test, incremental_pod_service_cache)
+{
+	k8s_state_t state;
+	const k8s_state_t::pod_service_map& pod_services = static_cast<const k8s_state_t&>(state).get_pod_service_map();
+	k8s_service_t& svc = state.get_component<k8s_services, k8s_service_t>(state.get_services(), "web", "web-uid", "default");
+	svc.set_selectors({{"app", "web"}});
+	state.update_cache(k8s_component::K8S_SERVICES, svc.get_uid());
+	ASSERT_TRUE(pod_services.empty());
+
+	// pods added after the service are picked up without a service event
+	add_pod(state, "pod1", "111111111111");
+	add_pod(state, "pod2", "222222222222");
+	ASSERT_EQ(2u, pod_services.size());
+	ASSERT_EQ(&svc, pod_services.find("pod1-uid")->second);
+
+	// modifying the service must not duplicate entries
+	state.update_cache(k8s_component::K8S_SERVICES, svc.get_uid());
+	ASSERT_EQ(2u, pod_services.size());
+
+	ASSERT_TRUE(state.delete_component(state.get_pods(), "pod1-uid"));
+	ASSERT_EQ(1u, pod_services.size());
+	ASSERT_EQ(0u, pod_services.count("pod1-uid"));
+
+	ASSERT_TRUE(state.delete_component(state.get_services(), "web-uid"));
+	ASSERT_TRUE(pod_services.empty());
+}
@@ -0,0 +1,193 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <logger.h>
+
+//
+// The callback sink is a plain function, so it writes here
+//
+static std::mutex s_mutex;
+static std::vector<std::string> s_msgs;
+static std::atomic<bool> s_block(false);
+
+static void collect(std::string&& msg, const sinsp_logger::severity sev)
+{
+	while(s_block)
+	{
+		std::this_thread::yield();
+	}
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_msgs.push_back(msg);
+}
+
+static void reset()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_msgs.clear();
+	s_block = false;
+}
+
+TEST(logger, async_order)
+{
+	reset();
+	const uint32_t nmsgs = 1000;
+	sinsp_logger logger;
+	logger.add_callback_log(collect);
+	logger.disable_timestamps();
+	logger.enable_async();
+
+	auto run = [&](const std::string& prefix)
+	{
+		for(uint32_t j = 0; j < nmsgs; j++)
+		{
+			logger.log(prefix + std::to_string(j), sinsp_logger::SEV_INFO);
+			if(j % 100 == 0)
+			{
+				logger.flush();
+			}
+		}
+		logger.flush();
+	};
+	std::thread t1(run, "a");
+	std::thread t2(run, "b");
+	t1.join();
+	t2.join();
+
+	ASSERT_EQ(0u, logger.get_dropped());
+	logger.disable_async();
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	ASSERT_EQ(2 * nmsgs, s_msgs.size());
+	uint32_t next_a = 0;
+	uint32_t next_b = 0;
+	for(auto& m : s_msgs)
+	{
+		uint32_t& next = m[0] == 'a' ? next_a : next_b;
+		ASSERT_EQ(std::to_string(next), m.substr(1));
+		next++;
+	}
+}
+
+TEST(logger, async_thread_exit)
+{
+	reset();
+	const uint32_t nthreads = 200;
+	sinsp_logger logger;
+	logger.add_callback_log(collect);
+	logger.disable_timestamps();
+	logger.enable_async();
+
+	//
+	// Every thread exits right after its message, without flushing: the
+	// writer forgets the ring of the thread, but not before writing it
+	//
+	std::vector<std::thread> threads;
+	for(uint32_t j = 0; j < nthreads; j++)
+	{
+		threads.emplace_back([&logger, j]()
+		{
+			logger.log("t" + std::to_string(j), sinsp_logger::SEV_INFO);
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+	logger.disable_async();
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	ASSERT_EQ(nthreads, s_msgs.size());
+}
+
+TEST(logger, async_drops)
+{
+	reset();
+	sinsp_logger logger;
+	logger.add_callback_log(collect);
+	logger.disable_timestamps();
+	logger.enable_async(4);
+
+	//
+	// The writer is stuck in the sink, so the ring fills up: the caller
+	// doesn't wait, the other messages are counted
+	//
+	s_block = true;
+	for(uint32_t j = 0; j < 100; j++)
+	{
+		logger.log("msg", sinsp_logger::SEV_INFO);
+	}
+	ASSERT_GE(logger.get_dropped(), (uint64_t)(100 - 2 * 4));
+	s_block = false;
+
+	//
+	// Critical messages skip the ring
+	//
+	logger.log("critical", sinsp_logger::SEV_CRITICAL);
+	logger.flush();
+	uint64_t dropped = logger.get_dropped();
+	logger.disable_async();
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	ASSERT_NE(s_msgs.end(), std::find(s_msgs.begin(), s_msgs.end(), "critical"));
+	ASSERT_NE(s_msgs.end(), std::find_if(s_msgs.begin(), s_msgs.end(), [](const std::string& m)
+	{
+		return m.find(" log messages dropped") != std::string::npos;
+	}));
+	ASSERT_EQ(100 - dropped + 2, s_msgs.size());
+}
+
+TEST(logger, log_lazy)
+{
+	reset();
+	sinsp_logger logger;
+	logger.add_callback_log(collect);
+	logger.set_severity(sinsp_logger::SEV_INFO);
+
+	uint32_t nbuilt = 0;
+	auto build = [&]()
+	{
+		nbuilt++;
+		return std::string("built");
+	};
+	logger.log_lazy(sinsp_logger::SEV_DEBUG, build);
+	ASSERT_EQ(0u, nbuilt);
+	logger.log_lazy(sinsp_logger::SEV_INFO, build);
+	ASSERT_EQ(1u, nbuilt);
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	ASSERT_EQ(1u, s_msgs.size());
+}
+
+TEST(logger, rate_limiter)
+{
+	sinsp_log_rate_limiter limiter(1, 5);
+
+	uint32_t nclaimed = 0;
+	for(uint32_t j = 0; j < 100; j++)
+	{
+		nclaimed += limiter.claim() ? 1 : 0;
+	}
+	ASSERT_EQ(5u, nclaimed);
+}
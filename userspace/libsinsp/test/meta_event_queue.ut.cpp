@@ -0,0 +1,148 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sinsp.h>
+#include <meta_event_queue.h>
+
+static std::vector<std::shared_ptr<sinsp_evt>> new_evts(size_t n)
+{
+	std::vector<std::shared_ptr<sinsp_evt>> res;
+	for(size_t j = 0; j < n; j++)
+	{
+		res.push_back(std::make_shared<sinsp_evt>());
+	}
+	return res;
+}
+
+TEST(meta_event_queue, order)
+{
+	std::vector<std::shared_ptr<sinsp_evt>> evts = new_evts(3);
+	sinsp_meta_event_queue queue;
+	ASSERT_FALSE(queue.pending());
+
+	queue.push(evts[0]);
+	std::vector<std::shared_ptr<sinsp_evt>> batch = {evts[1], evts[2]};
+	queue.push(batch);
+	ASSERT_TRUE(batch.empty());
+	ASSERT_TRUE(queue.pending());
+
+	//
+	// The local event comes first
+	//
+	sinsp_evt local;
+	queue.set_local(&local);
+	ASSERT_EQ(&local, queue.pop_local());
+	ASSERT_EQ(nullptr, queue.pop_local());
+
+	for(auto& evt : evts)
+	{
+		ASSERT_TRUE(queue.pending());
+		ASSERT_EQ(evt.get(), queue.pop());
+	}
+
+	ASSERT_EQ(nullptr, queue.pop());
+	ASSERT_FALSE(queue.pending());
+}
+
+TEST(meta_event_queue, push_while_draining)
+{
+	std::vector<std::shared_ptr<sinsp_evt>> evts = new_evts(3);
+	sinsp_meta_event_queue queue;
+	queue.push(evts[0]);
+	queue.push(evts[1]);
+
+	ASSERT_EQ(evts[0].get(), queue.pop());
+	queue.push(evts[2]);
+	ASSERT_EQ(evts[1].get(), queue.pop());
+	ASSERT_TRUE(queue.pending());
+	ASSERT_EQ(evts[2].get(), queue.pop());
+	ASSERT_EQ(nullptr, queue.pop());
+	ASSERT_FALSE(queue.pending());
+
+	//
+	// A local event set while the shared ones are exhausted keeps the
+	// flag up
+	//
+	sinsp_evt local;
+	queue.set_local(&local);
+	ASSERT_EQ(nullptr, queue.pop());
+	ASSERT_TRUE(queue.pending());
+	ASSERT_EQ(&local, queue.pop_local());
+}
+
+TEST(meta_event_queue, threads)
+{
+	const size_t nthreads = 4;
+	const size_t nevts = 10000;
+	sinsp_meta_event_queue queue;
+
+	std::vector<std::vector<std::shared_ptr<sinsp_evt>>> evts;
+	std::unordered_map<sinsp_evt*, std::pair<size_t, size_t>> index;
+	for(size_t t = 0; t < nthreads; t++)
+	{
+		evts.push_back(new_evts(nevts));
+		for(size_t j = 0; j < nevts; j++)
+		{
+			index[evts[t][j].get()] = std::make_pair(t, j);
+		}
+	}
+
+	std::vector<std::thread> threads;
+	for(size_t t = 0; t < nthreads; t++)
+	{
+		threads.emplace_back([&queue, &evts, t]()
+		{
+			for(auto& evt : evts[t])
+			{
+				queue.push(evt);
+			}
+		});
+	}
+
+	//
+	// The events of every thread come out in order, none is lost
+	//
+	std::vector<size_t> next(nthreads, 0);
+	size_t npopped = 0;
+	while(npopped < nthreads * nevts)
+	{
+		sinsp_evt* evt = queue.pending() ? queue.pop() : NULL;
+		if(evt == NULL)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		auto it = index.find(evt);
+		ASSERT_NE(index.end(), it);
+		ASSERT_EQ(next[it->second.first], it->second.second);
+		next[it->second.first]++;
+		npopped++;
+	}
+
+	for(auto& th : threads)
+	{
+		th.join();
+	}
+	ASSERT_EQ(nullptr, queue.pop());
+	ASSERT_FALSE(queue.pending());
+}
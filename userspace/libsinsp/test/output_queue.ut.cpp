@@ -0,0 +1,403 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sinsp.h>
+#include <eventformatter.h>
+#include <output_queue.h>
+#include "event_builder.h"
+
+static const uint64_t MS = 1000000;
+
+//
+// A sink that can be held, like an output that stopped reading
+//
+class test_sink
+{
+public:
+	test_sink():
+		m_hold(false)
+	{
+	}
+
+	void write(const sinsp_output_queue::message& msg)
+	{
+		while(m_hold)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_msgs.push_back(msg);
+	}
+
+	sinsp_output_queue::sink_t get()
+	{
+		return [this](const sinsp_output_queue::message& msg) { write(msg); };
+	}
+
+	std::atomic<bool> m_hold;
+	std::mutex m_mutex;
+	std::vector<sinsp_output_queue::message> m_msgs;
+};
+
+static void check_accounting(const sinsp_output_queue& queue, uint32_t npriorities)
+{
+	for(uint32_t p = 0; p < npriorities; p++)
+	{
+		sinsp_output_queue::stats st = queue.get_stats(p);
+		ASSERT_EQ(st.m_pushed, st.m_delivered + st.m_coalesced + st.m_dropped_rate + st.m_dropped_full);
+	}
+}
+
+TEST(output_queue, rate_limits)
+{
+	test_sink sink;
+	sinsp_output_queue::params params;
+	params.m_priorities[0].m_rate = 10;
+	params.m_priorities[0].m_max_burst = 5;
+	params.m_coalesce_window_ns = 0;
+	sinsp_output_queue queue(params, sink.get());
+
+	//
+	// The burst goes through, then 10 per second
+	//
+	uint64_t ts = 1000 * MS;
+	uint32_t naccepted = 0;
+	for(uint32_t j = 0; j < 100; j++)
+	{
+		naccepted += queue.push(ts, 0, "", "msg " + std::to_string(j)) ? 1 : 0;
+	}
+	ASSERT_EQ(5u, naccepted);
+
+	for(uint32_t j = 0; j < 100; j++)
+	{
+		naccepted += queue.push(ts + 1000 * MS, 0, "", "msg " + std::to_string(j)) ? 1 : 0;
+	}
+	ASSERT_EQ(10u, naccepted);
+
+	queue.flush();
+	ASSERT_EQ(10u, sink.m_msgs.size());
+	ASSERT_EQ(190u, queue.get_stats(0).m_dropped_rate);
+	check_accounting(queue, 1);
+}
+
+TEST(output_queue, per_key_limits)
+{
+	test_sink sink;
+	sinsp_output_queue::params params;
+	params.m_per_key.m_rate = 1;
+	params.m_per_key.m_max_burst = 2;
+	params.m_max_keys = 2;
+	params.m_coalesce_window_ns = 0;
+	sinsp_output_queue queue(params, sink.get());
+
+	uint64_t ts = 1000 * MS;
+	for(uint32_t j = 0; j < 10; j++)
+	{
+		queue.push(ts, 0, "rule_a", "a");
+		queue.push(ts + 1, 0, "rule_b", "b");
+	}
+
+	//
+	// A third key makes the queue forget the one seen the longest ago,
+	// which then starts with a full bucket again
+	//
+	queue.push(ts + 2, 0, "rule_c", "c");
+	queue.push(ts + 3, 0, "rule_a", "a");
+
+	queue.flush();
+	ASSERT_EQ(2u + 2 + 1 + 1, sink.m_msgs.size());
+	check_accounting(queue, 1);
+}
+
+TEST(output_queue, coalescing)
+{
+	test_sink sink;
+	sink.m_hold = true;
+	sinsp_output_queue::params params;
+	params.m_coalesce_window_ns = 100 * MS;
+	sinsp_output_queue queue(params, sink.get());
+
+	uint64_t ts = 1000 * MS;
+	queue.push(ts, 0, "rule", "first");
+	for(uint32_t j = 0; j < 10; j++)
+	{
+		queue.push(ts + j * MS, 0, "rule", "same");
+		queue.push(ts + j * MS, 0, "other_rule", "same");
+	}
+
+	//
+	// Out of the window: a new message
+	//
+	queue.push(ts + 200 * MS, 0, "rule", "same");
+
+	sink.m_hold = false;
+	queue.flush();
+
+	std::lock_guard<std::mutex> lock(sink.m_mutex);
+	std::vector<std::pair<std::string, uint32_t>> got;
+	for(auto& msg : sink.m_msgs)
+	{
+		got.push_back(std::make_pair(msg.m_key + ":" + msg.m_text, msg.m_count));
+	}
+
+	//
+	// The output thread waits in the sink with the first message, the
+	// others stay queued and get coalesced
+	//
+	std::vector<std::pair<std::string, uint32_t>> expected = {
+		{"rule:first", 1}, {"rule:same", 10}, {"other_rule:same", 10}, {"rule:same", 1}};
+	ASSERT_EQ(expected, got);
+	ASSERT_EQ(9 * MS, sink.m_msgs[1].m_last_ts - sink.m_msgs[1].m_ts);
+	ASSERT_EQ(18u, queue.get_stats(0).m_coalesced);
+	check_accounting(queue, 1);
+}
+
+TEST(output_queue, coalescing_priorities)
+{
+	test_sink sink;
+	sink.m_hold = true;
+	sinsp_output_queue::params params;
+	params.m_priorities.resize(3);
+	params.m_coalesce_window_ns = 100 * MS;
+	sinsp_output_queue queue(params, sink.get());
+
+	//
+	// A message of a higher priority isn't coalesced into a queued one
+	// of a lower priority: it would be delivered late
+	//
+	uint64_t ts = 1000 * MS;
+	queue.push(ts, 0, "rule", "first");
+	queue.push(ts + MS, 2, "rule", "same");
+	queue.push(ts + 2 * MS, 0, "rule", "same");
+	queue.push(ts + 3 * MS, 2, "rule", "same");
+
+	sink.m_hold = false;
+	queue.flush();
+
+	std::lock_guard<std::mutex> lock(sink.m_mutex);
+	std::vector<std::pair<std::string, uint32_t>> got;
+	for(auto& msg : sink.m_msgs)
+	{
+		got.push_back(std::make_pair(std::to_string(msg.m_priority) + ":" + msg.m_text, msg.m_count));
+	}
+
+	std::vector<std::pair<std::string, uint32_t>> expected = {
+		{"0:first", 1}, {"0:same", 1}, {"2:same", 2}};
+	ASSERT_EQ(expected, got);
+	ASSERT_EQ(0u, queue.get_stats(0).m_coalesced);
+	ASSERT_EQ(1u, queue.get_stats(2).m_coalesced);
+	check_accounting(queue, 3);
+}
+
+TEST(output_queue, priorities)
+{
+	test_sink sink;
+	sinsp_output_queue::params params;
+	params.m_priorities.resize(3);
+	params.m_max_messages = 10;
+	params.m_coalesce_window_ns = 0;
+	sinsp_output_queue queue(params, sink.get());
+
+	//
+	// With the sink held and the queue full of low priority messages,
+	// the new low priority ones are dropped, and the higher priority
+	// ones take the place of the oldest
+	//
+	sink.m_hold = true;
+	uint64_t ts = 1000 * MS;
+	for(uint32_t j = 0; j < 20; j++)
+	{
+		queue.push(ts + j, 2, "", "low " + std::to_string(j));
+	}
+	for(uint32_t j = 0; j < 5; j++)
+	{
+		ASSERT_TRUE(queue.push(ts + 100 + j, 0, "", "high " + std::to_string(j)));
+	}
+	ASSERT_LE(queue.get_queued(), 10u);
+
+	sink.m_hold = false;
+	queue.flush();
+
+	//
+	// One low message may have been taken before the sink was held;
+	// after that the high ones come first
+	//
+	std::lock_guard<std::mutex> lock(sink.m_mutex);
+	uint32_t first_high = 0;
+	while(sink.m_msgs[first_high].m_priority != 0)
+	{
+		first_high++;
+	}
+	ASSERT_LE(first_high, 1u);
+	for(uint32_t j = 0; j < 5; j++)
+	{
+		ASSERT_EQ("high " + std::to_string(j), sink.m_msgs[first_high + j].m_text);
+	}
+	ASSERT_EQ(first_high + 5 + 5, sink.m_msgs.size());
+	for(uint32_t j = 0; j < 5; j++)
+	{
+		ASSERT_EQ("low " + std::to_string(first_high + 5 + j), sink.m_msgs[first_high + 5 + j].m_text);
+	}
+	ASSERT_EQ(10 + 5 - first_high, queue.get_stats(2).m_dropped_full);
+	check_accounting(queue, 3);
+}
+
+//
+// Bursts of synthetic matches with an output that stops reading for a
+// while: the capture loop must go on without waiting for it, within the
+// memory bounds, and all the messages must be accounted for
+//
+TEST(output_queue, bursts)
+{
+	const uint32_t nbursts = 50;
+	const uint32_t burst_len = 20000;
+	const uint32_t nrules = 50;
+
+	test_sink sink;
+	sinsp_output_queue::params params;
+	params.m_priorities.resize(3);
+	params.m_priorities[1].m_rate = 1000;
+	params.m_priorities[1].m_max_burst = 1000;
+	params.m_priorities[2].m_rate = 100;
+	params.m_priorities[2].m_max_burst = 500;
+	params.m_per_key.m_rate = 50;
+	params.m_per_key.m_max_burst = 200;
+	params.m_max_keys = nrules / 2;
+	params.m_max_messages = 1000;
+	params.m_max_bytes = 64 * 1024;
+	params.m_coalesce_window_ns = 10 * MS;
+	sinsp_output_queue queue(params, sink.get());
+
+	sink.m_hold = true;
+	auto capture_loop = std::async(std::launch::async, [&]()
+	{
+		uint64_t ts = 1000 * MS;
+		uint32_t max_queued = 0;
+		uint64_t max_queued_bytes = 0;
+		for(uint32_t b = 0; b < nbursts; b++)
+		{
+			for(uint32_t j = 0; j < burst_len; j++)
+			{
+				uint32_t rule = (j * 7 + b) % nrules;
+				queue.push(ts, rule % 3, "rule_" + std::to_string(rule),
+					   "proc=p" + std::to_string(j % 64) + " fd=" + std::to_string(j % 5));
+				ts += 1000;
+			}
+
+			max_queued = std::max(max_queued, queue.get_queued());
+			max_queued_bytes = std::max(max_queued_bytes, queue.get_queued_bytes());
+
+			//
+			// Let the output go after half of the bursts
+			//
+			if(b == nbursts / 2)
+			{
+				sink.m_hold = false;
+			}
+			ts += 100 * MS;
+		}
+		return std::make_pair(max_queued, max_queued_bytes);
+	});
+
+	ASSERT_EQ(std::future_status::ready, capture_loop.wait_for(std::chrono::seconds(30)));
+	std::pair<uint32_t, uint64_t> max = capture_loop.get();
+	ASSERT_LE(max.first, params.m_max_messages);
+	ASSERT_LE(max.second, params.m_max_bytes);
+
+	sink.m_hold = false;
+	queue.flush();
+	check_accounting(queue, 3);
+
+	uint64_t npushed = 0;
+	uint64_t ndelivered = 0;
+	for(uint32_t p = 0; p < 3; p++)
+	{
+		sinsp_output_queue::stats st = queue.get_stats(p);
+		npushed += st.m_pushed;
+		ndelivered += st.m_delivered;
+	}
+	ASSERT_EQ((uint64_t)nbursts * burst_len, npushed);
+	ASSERT_EQ(ndelivered, sink.m_msgs.size());
+	ASSERT_GT(queue.get_stats(0).m_delivered, 0u);
+}
+
+TEST(output_queue, formatter)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	sinsp_evt* evt = builder.brk_x(1000 * MS, 12345, 678, 9);
+
+	test_sink sink;
+	sinsp_output_queue::params params;
+	params.m_priorities[0].m_rate = 1;
+	params.m_priorities[0].m_max_burst = 2;
+	sinsp_output_queue queue(params, sink.get());
+
+	//
+	// The events over the rate are dropped, the timestamp of the event
+	// is used
+	//
+	sinsp_evt_formatter formatter(&inspector, "size=%evt.arg.vm_size rss=%evt.arg.vm_rss");
+	ASSERT_TRUE(queue.push(evt, formatter, 0, "rule"));
+	ASSERT_TRUE(queue.push(evt, formatter, 0, "rule"));
+	ASSERT_FALSE(queue.push(evt, formatter, 0, "rule"));
+	ASSERT_EQ(1u, queue.get_stats(0).m_dropped_rate);
+
+	queue.flush();
+	std::lock_guard<std::mutex> lock(sink.m_mutex);
+	ASSERT_EQ(1u, sink.m_msgs.size());
+	ASSERT_EQ("size=12345 rss=678", sink.m_msgs[0].m_text);
+	ASSERT_EQ("rule", sink.m_msgs[0].m_key);
+	ASSERT_EQ(1000 * MS, sink.m_msgs[0].m_ts);
+	ASSERT_EQ(2u, sink.m_msgs[0].m_count);
+	check_accounting(queue, 1);
+}
+
+TEST(output_queue, formatter_hidden)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	sinsp_evt* evt = builder.brk_x(1000 * MS, 12345, 678, 9);
+
+	test_sink sink;
+	sinsp_output_queue queue(sinsp_output_queue::params(), sink.get());
+
+	//
+	// The event has no thread, so this formatter doesn't show it: the
+	// event is not counted
+	//
+	sinsp_evt_formatter hidden(&inspector, "%proc.name");
+	ASSERT_FALSE(queue.push(evt, hidden, 0, "rule"));
+	sinsp_evt_formatter shown(&inspector, "*%proc.name");
+	ASSERT_TRUE(queue.push(evt, shown, 0, "rule"));
+
+	queue.flush();
+	ASSERT_EQ(1u, queue.get_stats(0).m_pushed);
+	std::lock_guard<std::mutex> lock(sink.m_mutex);
+	ASSERT_EQ(1u, sink.m_msgs.size());
+	ASSERT_EQ("<NA>", sink.m_msgs[0].m_text);
+	check_accounting(queue, 1);
+}
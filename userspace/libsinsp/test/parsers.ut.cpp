@@ -0,0 +1,127 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include "sinsp.h"
+#include "parsers.h"
+#include "event_builder.h"
+
+using test_helpers::event_builder;
+
+static const int64_t TID = 1;
+
+class test_helper
+{
+public:
+	//
+	// The parser of the inspector, which owns part of its state
+	//
+	static sinsp_parser* get_parser(sinsp* inspector)
+	{
+		return inspector->m_parser;
+	}
+
+	//
+	// Without a capture, only live events can be parsed
+	//
+	static void set_live(sinsp* inspector)
+	{
+		inspector->set_mode(SCAP_MODE_LIVE);
+	}
+};
+
+static sinsp_threadinfo* add_thread(sinsp* inspector)
+{
+	sinsp_threadinfo* tinfo = inspector->build_threadinfo();
+	tinfo->m_tid = TID;
+	tinfo->m_pid = TID;
+	tinfo->m_comm = "init";
+	inspector->m_thread_manager->add_thread(tinfo, false);
+	return &*inspector->get_thread_ref(TID, false, true);
+}
+
+//
+// Parses the event the way sinsp::next() does
+//
+static void process(sinsp_parser* parser, sinsp_evt* evt)
+{
+	parser->process_event(evt);
+	parser->event_cleanup(evt);
+}
+
+static sinsp_evt* openat_e(event_builder* builder, uint64_t ts, const char* name)
+{
+	return builder->build(ts, TID, PPME_SYSCALL_OPENAT_E, {
+		event_builder::param<int64_t>(PPM_AT_FDCWD),
+		std::string(name, strlen(name) + 1),
+		event_builder::param<uint32_t>(PPM_O_RDONLY),
+		event_builder::param<uint32_t>(0)});
+}
+
+static sinsp_evt* fd_evt(event_builder* builder, uint64_t ts, uint16_t type, int64_t fd)
+{
+	return builder->build(ts, TID, type, {event_builder::param<int64_t>(fd)});
+}
+
+TEST(sinsp_parser, event_parser_flags)
+{
+	sinsp inspector;
+	sinsp_parser& parser = *test_helper::get_parser(&inspector);
+
+	EXPECT_EQ(sinsp_parser::PARSER_STORE_ENTER, parser.get_event_parser_flags(PPME_SYSCALL_OPENAT_E));
+	EXPECT_EQ(sinsp_parser::PARSER_STORE_ENTER, parser.get_event_parser_flags(PPME_SOCKET_SENDTO_E));
+	EXPECT_EQ(sinsp_parser::PARSER_TRACER_WRITE, parser.get_event_parser_flags(PPME_SYSCALL_WRITE_E));
+	EXPECT_EQ(sinsp_parser::PARSER_NONE, parser.get_event_parser_flags(PPME_SYSCALL_OPENAT_X));
+	EXPECT_EQ(sinsp_parser::PARSER_NONE, parser.get_event_parser_flags(PPME_SYSCALL_BRK_4_X));
+	EXPECT_EQ(sinsp_parser::PARSER_NONE, parser.get_event_parser_flags(PPM_EVENT_MAX));
+}
+
+TEST(sinsp_parser, dispatch)
+{
+	sinsp inspector;
+	sinsp_parser& parser = *test_helper::get_parser(&inspector);
+	event_builder builder(&inspector);
+	test_helper::set_live(&inspector);
+	sinsp_threadinfo* tinfo = add_thread(&inspector);
+
+	//
+	// An exit event that carries everything its parser needs
+	//
+	process(&parser, builder.build(998, TID, PPME_SYSCALL_CHDIR_E, {}));
+	process(&parser, builder.build(999, TID, PPME_SYSCALL_CHDIR_X, {
+		event_builder::param<int64_t>(0),
+		std::string("/etc", 5)}));
+	EXPECT_EQ("/etc/", tinfo->get_cwd());
+
+	//
+	// The stored enter event gives the exit parser the file name
+	//
+	process(&parser, openat_e(&builder, 1000, "passwd"));
+	process(&parser, fd_evt(&builder, 1001, PPME_SYSCALL_OPENAT_X, 3));
+	sinsp_fdinfo_t* fdinfo = tinfo->get_fd(3);
+	ASSERT_NE(nullptr, fdinfo);
+	EXPECT_EQ("/etc/passwd", fdinfo->m_name);
+
+	//
+	// An exit without its enter event is not parsed
+	//
+	process(&parser, builder.brk_x(1002, 1024, 512, 0));
+	EXPECT_EQ(1024u, tinfo->m_vmsize_kb);
+	EXPECT_EQ(512u, tinfo->m_vmrss_kb);
+	process(&parser, fd_evt(&builder, 1003, PPME_SYSCALL_OPENAT_X, 4));
+	EXPECT_EQ(nullptr, tinfo->get_fd(4));
+}
@@ -0,0 +1,242 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <string>
+#include <sinsp.h>
+#include <protodecoder.h>
+
+static bool decode(sinsp_decoder_http* dec, sinsp_http_stream* stream, const std::string& data, bool truncated = false)
+{
+	dec->on_reset(NULL);
+	return dec->decode(stream, data.data(), (uint32_t)data.size(), truncated);
+}
+
+TEST(protodecoder, http_request)
+{
+	sinsp inspector;
+	sinsp_decoder_http* dec = (sinsp_decoder_http*)inspector.require_protodecoder("http");
+	sinsp_http_stream stream;
+
+	ASSERT_TRUE(decode(dec, &stream, "GET /index.html?a=b HTTP/1.1\r\nUser-Agent: curl\r\nHost:  example.com \r\n\r\n"));
+	ASSERT_TRUE(dec->is_data_valid());
+	ASSERT_TRUE(dec->m_is_request);
+	ASSERT_FALSE(dec->m_is_response);
+	ASSERT_EQ("GET", dec->m_method);
+	ASSERT_EQ("/index.html?a=b", dec->m_url);
+	ASSERT_EQ("example.com", dec->m_host);
+	ASSERT_EQ(sinsp_http_stream::ST_START_LINE, stream.m_state);
+
+	// the body is not decoded
+	ASSERT_FALSE(decode(dec, &stream, "{\"GET\": 1}"));
+	ASSERT_FALSE(dec->is_data_valid());
+
+	ASSERT_TRUE(decode(dec, &stream, "HTTP/1.1 404 Not Found\r\n"));
+	ASSERT_TRUE(dec->m_is_response);
+	ASSERT_EQ(404u, dec->m_status);
+	ASSERT_EQ(sinsp_http_stream::ST_HEADERS, stream.m_state);
+}
+
+TEST(protodecoder, http_split)
+{
+	sinsp inspector;
+	sinsp_decoder_http* dec = (sinsp_decoder_http*)inspector.require_protodecoder("http");
+	sinsp_http_stream stream;
+
+	// the request line is split across three writes
+	ASSERT_TRUE(decode(dec, &stream, "PO"));
+	ASSERT_FALSE(dec->is_data_valid());
+	ASSERT_TRUE(decode(dec, &stream, "ST /api/v1/ite"));
+	ASSERT_FALSE(dec->is_data_valid());
+	ASSERT_TRUE(decode(dec, &stream, "ms HTTP/1.1\r\nHo"));
+	ASSERT_TRUE(dec->m_is_request);
+	ASSERT_EQ("POST", dec->m_method);
+	ASSERT_EQ("/api/v1/items", dec->m_url);
+	ASSERT_TRUE(dec->m_host.empty());
+	ASSERT_TRUE(decode(dec, &stream, "st: api\r\n\r\nbody"));
+	ASSERT_FALSE(dec->m_is_request);
+	ASSERT_EQ("api", dec->m_host);
+
+	// truncated by the snaplen: the next data starts a new message
+	ASSERT_TRUE(decode(dec, &stream, "GET /a HTTP/1.1\r\nAccept: te", true));
+	ASSERT_EQ("/a", dec->m_url);
+	ASSERT_TRUE(decode(dec, &stream, "GET /b HTTP/1.1\r\n"));
+	ASSERT_EQ("/b", dec->m_url);
+
+	// a new message while in the headers of the previous one
+	ASSERT_TRUE(decode(dec, &stream, "DELETE /c HTTP/1.1\r\n"));
+	ASSERT_EQ("DELETE", dec->m_method);
+	ASSERT_EQ("/c", dec->m_url);
+}
+
+TEST(protodecoder, http_not_http)
+{
+	sinsp inspector;
+	sinsp_decoder_http* dec = (sinsp_decoder_http*)inspector.require_protodecoder("http");
+	sinsp_http_stream stream;
+
+	// a TLS client hello
+	ASSERT_FALSE(decode(dec, &stream, std::string("\x16\x03\x01\x02\x00\x01\x00\x01\xfc\x03\x03", 11)));
+	ASSERT_FALSE(decode(dec, &stream, "GETS / HTTP/1.1\r\n"));
+	ASSERT_FALSE(dec->is_data_valid());
+
+	// starts like a request, but the start line is invalid
+	ASSERT_FALSE(decode(dec, &stream, "GET /index.html\r\nHost: example.com\r\n"));
+	ASSERT_FALSE(decode(dec, &stream, "HTTP/1.1 OK\r\n"));
+	ASSERT_FALSE(dec->is_data_valid());
+	ASSERT_EQ(sinsp_http_stream::ST_START_LINE, stream.m_state);
+}
+
+static std::string dns_query(const std::string& name, uint16_t type, uint16_t flags)
+{
+	std::string res("\x12\x34", 2);
+	res += (char)(flags >> 8);
+	res += (char)(flags & 0xff);
+	res += std::string("\x00\x01\x00\x00\x00\x00\x00\x00", 8);
+
+	size_t start = 0;
+	while(start < name.size())
+	{
+		size_t end = name.find('.', start);
+		if(end == std::string::npos)
+		{
+			end = name.size();
+		}
+		res += (char)(end - start);
+		res += name.substr(start, end - start);
+		start = end + 1;
+	}
+	res += '\0';
+	res += (char)(type >> 8);
+	res += (char)(type & 0xff);
+	res += std::string("\x00\x01", 2);
+	return res;
+}
+
+TEST(protodecoder, dns_message)
+{
+	sinsp inspector;
+	sinsp_decoder_dns* dec = (sinsp_decoder_dns*)inspector.require_protodecoder("dns");
+
+	std::string msg = dns_query("www.example.com", 28, 0x0100);
+	ASSERT_TRUE(dec->decode_message((const uint8_t*)msg.data(), (uint32_t)msg.size()));
+	ASSERT_TRUE(dec->is_data_valid());
+	ASSERT_EQ("www.example.com", dec->m_qname);
+	ASSERT_STREQ("AAAA", dec->get_type_str());
+	ASSERT_FALSE(dec->m_is_response);
+
+	dec->on_reset(NULL);
+	msg = dns_query("example.org", 1, 0x8183);
+	ASSERT_TRUE(dec->decode_message((const uint8_t*)msg.data(), (uint32_t)msg.size()));
+	ASSERT_TRUE(dec->m_is_response);
+	ASSERT_EQ(3u, dec->m_rcode);
+
+	// cut in the middle of the name
+	dec->on_reset(NULL);
+	ASSERT_FALSE(dec->decode_message((const uint8_t*)msg.data(), 16));
+	ASSERT_FALSE(dec->is_data_valid());
+}
+
+static std::string dns_tcp_message(const std::string& msg)
+{
+	std::string res;
+	res += (char)(msg.size() >> 8);
+	res += (char)(msg.size() & 0xff);
+	return res + msg;
+}
+
+static bool decode_tcp(sinsp_decoder_dns* dec, sinsp_dns_stream* stream, const std::string& data)
+{
+	return dec->decode_tcp(stream, data.data(), (uint32_t)data.size(), (uint32_t)data.size());
+}
+
+TEST(protodecoder, dns_tcp)
+{
+	sinsp inspector;
+	sinsp_decoder_dns* dec = (sinsp_decoder_dns*)inspector.require_protodecoder("dns");
+	sinsp_dns_stream stream;
+
+	std::string msg = dns_query("api.example.com", 1, 0x0100);
+	std::string all = dns_tcp_message(msg);
+
+	// the length prefix and the message are written separately
+	ASSERT_FALSE(decode_tcp(dec, &stream, all.substr(0, 2)));
+	ASSERT_FALSE(decode_tcp(dec, &stream, msg.substr(0, 20)));
+	ASSERT_TRUE(decode_tcp(dec, &stream, msg.substr(20)));
+	ASSERT_EQ("api.example.com", dec->m_qname);
+	ASSERT_TRUE(stream.m_partial.empty());
+	ASSERT_EQ(0u, stream.m_skip);
+
+	// two messages in one write
+	dec->on_reset(NULL);
+	std::string next = dns_tcp_message(dns_query("next.example.com", 1, 0x0100));
+	ASSERT_TRUE(decode_tcp(dec, &stream, all + next));
+	ASSERT_EQ("next.example.com", dec->m_qname);
+	ASSERT_TRUE(stream.m_partial.empty());
+	ASSERT_EQ(0u, stream.m_skip);
+}
+
+TEST(protodecoder, dns_tcp_long_message)
+{
+	sinsp inspector;
+	sinsp_decoder_dns* dec = (sinsp_decoder_dns*)inspector.require_protodecoder("dns");
+	sinsp_dns_stream stream;
+
+	//
+	// A 3000 bytes response, whose answers happen to contain what looks
+	// like another message where the second read starts
+	//
+	std::string msg = dns_query("big.example.com", 1, 0x8180);
+	msg.append(1000 - 2 - msg.size(), 'a');
+	msg += dns_tcp_message(dns_query("fake.example.com", 1, 0x0100));
+	msg.append(3000 - msg.size(), 'b');
+	std::string all = dns_tcp_message(msg);
+	std::string next = dns_tcp_message(dns_query("next.example.com", 1, 0x0100));
+
+	ASSERT_TRUE(decode_tcp(dec, &stream, all.substr(0, 1000)));
+	ASSERT_EQ("big.example.com", dec->m_qname);
+	ASSERT_TRUE(dec->m_is_response);
+	ASSERT_EQ(2002u, stream.m_skip);
+
+	dec->on_reset(NULL);
+	ASSERT_FALSE(decode_tcp(dec, &stream, all.substr(1000, 1000)));
+	ASSERT_FALSE(dec->is_data_valid());
+	ASSERT_EQ(1002u, stream.m_skip);
+
+	// the end of the response and the next message in the same read
+	ASSERT_TRUE(decode_tcp(dec, &stream, all.substr(2000) + next));
+	ASSERT_EQ("next.example.com", dec->m_qname);
+	ASSERT_EQ(0u, stream.m_skip);
+
+	// only the beginning of the read was captured: what wasn't is
+	// skipped as well
+	dec->on_reset(NULL);
+	ASSERT_TRUE(dec->decode_tcp(&stream, all.data(), 200, 2000));
+	ASSERT_EQ("big.example.com", dec->m_qname);
+	ASSERT_EQ(1002u, stream.m_skip);
+	ASSERT_TRUE(decode_tcp(dec, &stream, all.substr(2000) + next));
+	ASSERT_EQ("next.example.com", dec->m_qname);
+
+	// the data that wasn't captured goes beyond the current message:
+	// the next read is taken as the beginning of a message
+	dec->on_reset(NULL);
+	ASSERT_FALSE(dec->decode_tcp(&stream, next.data(), 10, (uint32_t)next.size() + 100));
+	ASSERT_TRUE(stream.m_partial.empty());
+	ASSERT_EQ(0u, stream.m_skip);
+	ASSERT_TRUE(decode_tcp(dec, &stream, next));
+	ASSERT_EQ("next.example.com", dec->m_qname);
+}
@@ -0,0 +1,119 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <sketches.h>
+
+static uint64_t mix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+TEST(sketches, hyperloglog_estimate)
+{
+	hyperloglog hll;
+	hll.init();
+	ASSERT_EQ(0u, hll.estimate());
+
+	//
+	// Small cardinalities are counted almost exactly
+	//
+	for(uint64_t j = 0; j < 100; j++)
+	{
+		hll.add(mix(j));
+		hll.add(mix(j));
+	}
+	ASSERT_NEAR(100, (double)hll.estimate(), 3);
+
+	for(uint64_t j = 100; j < 100000; j++)
+	{
+		hll.add(mix(j));
+	}
+	ASSERT_NEAR(100000, (double)hll.estimate(), 100000 * 0.1);
+}
+
+TEST(sketches, hyperloglog_merge)
+{
+	hyperloglog a;
+	hyperloglog b;
+	a.init();
+	b.init();
+
+	//
+	// Two overlapping sets of 20000 values, 30000 in total
+	//
+	for(uint64_t j = 0; j < 20000; j++)
+	{
+		a.add(mix(j));
+		b.add(mix(j + 10000));
+	}
+
+	a.merge(b);
+	ASSERT_NEAR(30000, (double)a.estimate(), 30000 * 0.1);
+}
+
+TEST(sketches, tdigest_quantiles)
+{
+	tdigest td;
+	td.init();
+	ASSERT_EQ(0, td.quantile(0.5));
+
+	td.add(42);
+	ASSERT_EQ(42, td.quantile(0.5));
+
+	td.init();
+	for(uint32_t j = 1; j <= 100000; j++)
+	{
+		// a permutation of 1..100000
+		td.add((double)((j * 7919) % 100000 + 1));
+	}
+
+	ASSERT_EQ(100000, td.get_count());
+	ASSERT_EQ(1, td.quantile(0));
+	ASSERT_EQ(100000, td.quantile(1));
+	ASSERT_NEAR(50000, td.quantile(0.5), 1000);
+	ASSERT_NEAR(90000, td.quantile(0.9), 1000);
+	ASSERT_NEAR(99000, td.quantile(0.99), 200);
+	ASSERT_NEAR(99900, td.quantile(0.999), 50);
+	ASSERT_LE(td.m_n_centroids, tdigest::MAX_CENTROIDS);
+}
+
+TEST(sketches, tdigest_merge)
+{
+	tdigest a;
+	tdigest b;
+	a.init();
+	b.init();
+
+	for(uint32_t j = 1; j <= 50000; j++)
+	{
+		a.add(j);
+		b.add(j + 50000);
+	}
+
+	a.merge(b);
+	ASSERT_EQ(100000, a.get_count());
+	ASSERT_EQ(1, a.quantile(0));
+	ASSERT_EQ(100000, a.quantile(1));
+	ASSERT_NEAR(50000, a.quantile(0.5), 1000);
+	ASSERT_NEAR(99000, a.quantile(0.99), 300);
+}
@@ -0,0 +1,139 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <thread>
+#include <stage_timers.h>
+
+using namespace internal_metrics;
+
+static const histogram& stage_histogram(registry& r, const std::string& stage)
+{
+	for(auto& it : r.get_metrics())
+	{
+		if(it.first.get_name() == "stage." + stage)
+		{
+			return *std::static_pointer_cast<histogram>(it.second);
+		}
+	}
+	throw std::runtime_error("missing stage " + stage);
+}
+
+static std::string folded()
+{
+	FILE* f = tmpfile();
+	stage_timers::write_folded(f);
+	std::string res;
+	rewind(f);
+	char buf[256];
+	while(fgets(buf, sizeof(buf), f) != NULL)
+	{
+		res += buf;
+	}
+	fclose(f);
+	return res;
+}
+
+TEST(stage_timers, histogram_buckets)
+{
+	ASSERT_EQ(0u, histogram::bucket(0));
+	ASSERT_EQ(1u, histogram::bucket(1));
+	ASSERT_EQ(2u, histogram::bucket(2));
+	ASSERT_EQ(2u, histogram::bucket(3));
+	ASSERT_EQ(11u, histogram::bucket(1024));
+	ASSERT_EQ(64u, histogram::bucket(UINT64_MAX));
+
+	histogram h;
+	for(uint64_t v = 1; v <= 100; v++)
+	{
+		h.add(v);
+	}
+	ASSERT_EQ(100u, h.get_count());
+	ASSERT_EQ(5050u, h.get_sum());
+	ASSERT_EQ(63u, h.get_quantile(0.5));
+	ASSERT_EQ(127u, h.get_quantile(0.99));
+}
+
+TEST(stage_timers, disabled)
+{
+	stage_timers::enable(false);
+	stage_timers::reset();
+	{
+		scoped_stage_timer timer(STAGE_PARSE);
+	}
+
+	registry r;
+	stage_timers::export_metrics(r);
+	ASSERT_EQ(0u, stage_histogram(r, "parse").get_count());
+}
+
+TEST(stage_timers, nested_stages)
+{
+	stage_timers::enable(true);
+	stage_timers::reset();
+	for(int j = 0; j < 10; j++)
+	{
+		scoped_stage_timer next(STAGE_NEXT);
+		{
+			scoped_stage_timer parse(STAGE_PARSE);
+			scoped_stage_timer filter(STAGE_FILTER);
+		}
+		scoped_stage_timer dump(STAGE_DUMP);
+	}
+	stage_timers::enable(false);
+
+	registry r;
+	stage_timers::export_metrics(r);
+	ASSERT_EQ(10u, stage_histogram(r, "next").get_count());
+	ASSERT_EQ(10u, stage_histogram(r, "parse").get_count());
+	ASSERT_EQ(10u, stage_histogram(r, "filter").get_count());
+	ASSERT_EQ(10u, stage_histogram(r, "dump").get_count());
+	ASSERT_EQ(0u, stage_histogram(r, "format").get_count());
+	ASSERT_GE(stage_histogram(r, "next").get_sum(), stage_histogram(r, "parse").get_sum());
+	ASSERT_GE(stage_histogram(r, "parse").get_sum(), stage_histogram(r, "filter").get_sum());
+
+	std::string out = folded();
+	ASSERT_NE(std::string::npos, out.find("next;parse;filter ")) << out;
+	ASSERT_NE(std::string::npos, out.find("next;dump ")) << out;
+}
+
+TEST(stage_timers, threads)
+{
+	stage_timers::enable(true);
+	stage_timers::reset();
+
+	std::vector<std::thread> threads;
+	for(int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([]()
+		{
+			for(int j = 0; j < 1000; j++)
+			{
+				scoped_stage_timer timer(STAGE_FORMAT);
+			}
+		});
+	}
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+	stage_timers::enable(false);
+
+	registry r;
+	stage_timers::export_metrics(r);
+	ASSERT_EQ(4000u, stage_histogram(r, "format").get_count());
+}
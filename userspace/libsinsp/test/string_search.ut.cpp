@@ -0,0 +1,90 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <random>
+#include <string_search.h>
+
+static string_search make_search(const std::string& needle)
+{
+	string_search search;
+	search.set(needle.c_str(), needle.size());
+	return search;
+}
+
+TEST(string_search, find)
+{
+	std::string path = "/var/lib/docker/overlay2/0123456789abcdef/merged/etc/passwd";
+	ASSERT_EQ(strstr(path.c_str(), "passwd"), make_search("passwd").find(path.c_str(), path.size()));
+	ASSERT_EQ(strstr(path.c_str(), "/etc/"), make_search("/etc/").find(path.c_str(), path.size()));
+	ASSERT_EQ(path.c_str(), make_search("").find(path.c_str(), path.size()));
+	ASSERT_EQ(nullptr, make_search("shadow").find(path.c_str(), path.size()));
+	ASSERT_EQ(nullptr, make_search("passwd!").find(path.c_str(), path.size()));
+
+	ASSERT_TRUE(make_search("/var/").is_prefix_of(path.c_str()));
+	ASSERT_FALSE(make_search("/etc/").is_prefix_of(path.c_str()));
+	ASSERT_TRUE(make_search("/passwd").is_suffix_of(path.c_str(), path.size()));
+	ASSERT_FALSE(make_search("/shadow").is_suffix_of(path.c_str(), path.size()));
+}
+
+TEST(string_search, find_nocase)
+{
+	std::string cmdline = "CURL -sSL HTTPS://Example.COM/install.SH | bash";
+	ASSERT_EQ(strcasestr(cmdline.c_str(), "example.com"), make_search("example.com").find_nocase(cmdline.c_str(), cmdline.size()));
+	ASSERT_EQ(strcasestr(cmdline.c_str(), "Install.sh"), make_search("Install.sh").find_nocase(cmdline.c_str(), cmdline.size()));
+	ASSERT_EQ(strcasestr(cmdline.c_str(), "c"), make_search("c").find_nocase(cmdline.c_str(), cmdline.size()));
+	ASSERT_EQ(nullptr, make_search("wget").find_nocase(cmdline.c_str(), cmdline.size()));
+
+	// characters next to the letters in the ASCII table are not folded
+	std::string brackets = "@[`{";
+	ASSERT_EQ(nullptr, make_search("`{").find_nocase(brackets.c_str(), 2));
+	ASSERT_EQ(nullptr, make_search("@[").find_nocase("`{", 2));
+}
+
+TEST(string_search, random_against_libc)
+{
+	std::mt19937 rng(42);
+	const char alphabet[] = "aAbB/.@[`{\xe9";
+	auto random_string = [&](size_t len)
+	{
+		std::string s;
+		for(size_t j = 0; j < len; j++)
+		{
+			s += alphabet[rng() % (sizeof(alphabet) - 1)];
+		}
+		return s;
+	};
+
+	for(int i = 0; i < 20000; i++)
+	{
+		std::string haystack = random_string(rng() % 80);
+		std::string needle = random_string(1 + rng() % 6);
+		string_search search = make_search(needle);
+		ASSERT_EQ(strstr(haystack.c_str(), needle.c_str()), search.find(haystack.c_str(), haystack.size()))
+			<< haystack << " / " << needle;
+
+		// reference case-insensitive search, ASCII folding only
+		std::string lower_haystack = haystack;
+		std::string lower_needle = needle;
+		for(char& c : lower_haystack) { if(c >= 'A' && c <= 'Z') { c |= 0x20; } }
+		for(char& c : lower_needle) { if(c >= 'A' && c <= 'Z') { c |= 0x20; } }
+		const char* expected = strstr(lower_haystack.c_str(), lower_needle.c_str());
+		const char* found = search.find_nocase(haystack.c_str(), haystack.size());
+		ASSERT_EQ(expected ? expected - lower_haystack.c_str() : -1, found ? found - haystack.c_str() : -1)
+			<< haystack << " / " << needle;
+	}
+}
@@ -0,0 +1,329 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <functional>
+#include <map>
+#include "sinsp.h"
+#include "table.h"
+#include "event_builder.h"
+
+//
+// The tables are fed brk exit events, whose vm_size, vm_rss and vm_swap
+// parameters are the keys and the values
+//
+static const uint64_t START_TS = 1000000000;
+
+static sinsp_view_column_info column(const char* field, uint32_t flags,
+	sinsp_field_aggregation aggregation, sinsp_field_aggregation groupby_aggregation = A_NONE)
+{
+	return sinsp_view_column_info(field, field, "", 10, flags,
+		aggregation, groupby_aggregation, vector<string>(), "");
+}
+
+static sinsp_table* new_table(sinsp* inspector, vector<sinsp_view_column_info> columns, test_helpers::event_builder* builder)
+{
+	sinsp_table* res = new sinsp_table(inspector, sinsp_table::TT_TABLE, ONE_SECOND_IN_NS,
+		sinsp_table::OT_CURSES, 0, 0);
+	res->configure(&columns, "", false, 0);
+	res->set_sorting_col(1);
+
+	// starts the first interval
+	res->flush(builder->brk_x(START_TS, 0, 0, 0));
+	return res;
+}
+
+//
+// Ends the interval and returns the rows of the table
+//
+static vector<sinsp_sample_row>* get_sample(sinsp_table* table, test_helpers::event_builder* builder)
+{
+	table->flush(builder->brk_x(START_TS + ONE_SECOND_IN_NS, 0, 0, 0));
+	return table->get_sample(ONE_SECOND_IN_NS);
+}
+
+static uint64_t get_uint(const sinsp_table_field& fld)
+{
+	switch(fld.m_len)
+	{
+	case 4:
+		return *(uint32_t*)fld.m_val;
+	case 8:
+		return *(uint64_t*)fld.m_val;
+	default:
+		ADD_FAILURE() << "unexpected field length " << fld.m_len;
+		return 0;
+	}
+}
+
+//
+// The rows of a sample by key, as numbers
+//
+static std::map<uint64_t, vector<uint64_t>> get_values(vector<sinsp_sample_row>* sample)
+{
+	std::map<uint64_t, vector<uint64_t>> res;
+
+	for(const auto& row : *sample)
+	{
+		vector<uint64_t>& vals = res[get_uint(row.m_key)];
+		for(const auto& fld : row.m_values)
+		{
+			vals.push_back(get_uint(fld));
+		}
+	}
+
+	return res;
+}
+
+static vector<uint64_t> get_keys(vector<sinsp_sample_row>* sample)
+{
+	vector<uint64_t> res;
+
+	for(const auto& row : *sample)
+	{
+		res.push_back(get_uint(row.m_key));
+	}
+
+	return res;
+}
+
+TEST(sinsp_table, distinct)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	unique_ptr<sinsp_table> table(new_table(&inspector, {
+		column("evt.rawarg.vm_swap", TEF_IS_KEY, A_NONE),
+		column("evt.rawarg.vm_rss", TEF_NONE, A_DISTINCT),
+		column("evt.rawarg.vm_size", TEF_NONE, A_SUM)}, &builder));
+
+	//
+	// Every value is seen twice
+	//
+	for(uint32_t j = 0; j < 2 * 300; j++)
+	{
+		table->process_event(builder.brk_x(START_TS + j, 1, j % 300, 1));
+		table->process_event(builder.brk_x(START_TS + j, 1, j % 20, 2));
+	}
+
+	auto rows = get_values(get_sample(table.get(), &builder));
+	ASSERT_EQ(2u, rows.size());
+	EXPECT_NEAR(300, (double)rows[1][0], 300 * 0.05);
+	EXPECT_EQ(600u, rows[1][1]);
+	EXPECT_NEAR(20, (double)rows[2][0], 1);
+	EXPECT_EQ(600u, rows[2][1]);
+}
+
+TEST(sinsp_table, percentiles)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	unique_ptr<sinsp_table> table(new_table(&inspector, {
+		column("evt.rawarg.vm_swap", TEF_IS_KEY, A_NONE),
+		column("evt.rawarg.vm_rss", TEF_NONE, A_P50),
+		column("evt.rawarg.vm_rss", TEF_NONE, A_P99)}, &builder));
+
+	//
+	// 1 to 1000, out of order
+	//
+	for(uint32_t j = 0; j < 1000; j++)
+	{
+		table->process_event(builder.brk_x(START_TS + j, 1, (j * 7919) % 1000 + 1, 1));
+	}
+
+	auto rows = get_values(get_sample(table.get(), &builder));
+	ASSERT_EQ(1u, rows.size());
+	EXPECT_NEAR(500, (double)rows[1][0], 10);
+	EXPECT_NEAR(990, (double)rows[1][1], 10);
+}
+
+TEST(sinsp_table, max_rows)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	unique_ptr<sinsp_table> table(new_table(&inspector, {
+		column("evt.rawarg.vm_swap", TEF_IS_KEY, A_NONE),
+		column("evt.rawarg.vm_size", TEF_NONE, A_SUM)}, &builder));
+	table->set_max_rows(5);
+
+	//
+	// Many more keys than the table keeps, so that it prunes itself
+	//
+	for(uint32_t j = 0; j < 1000; j++)
+	{
+		table->process_event(builder.brk_x(START_TS + j, j, 0, j));
+	}
+
+	vector<sinsp_sample_row>* sample = get_sample(table.get(), &builder);
+	ASSERT_EQ(vector<uint64_t>({999, 998, 997, 996, 995}), get_keys(sample));
+	EXPECT_EQ(999u, get_uint(sample->at(0).m_values[0]));
+}
+
+TEST(sinsp_table, max_rows_resort)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	unique_ptr<sinsp_table> table(new_table(&inspector, {
+		column("evt.rawarg.vm_swap", TEF_IS_KEY, A_NONE),
+		column("evt.rawarg.vm_size", TEF_NONE, A_SUM)}, &builder));
+	table->set_max_rows(3);
+
+	//
+	// Few enough keys that nothing is pruned
+	//
+	for(uint32_t j = 0; j < 10; j++)
+	{
+		table->process_event(builder.brk_x(START_TS + j, j + 1, 0, j));
+	}
+
+	vector<sinsp_sample_row>* sample = get_sample(table.get(), &builder);
+	ASSERT_EQ(vector<uint64_t>({9, 8, 7}), get_keys(sample));
+
+	//
+	// The rows below the limit are still there when the sorting changes
+	//
+	table->set_sorting_col(1);
+	ASSERT_TRUE(table->is_sorting_ascending());
+	sample = table->get_sample(ONE_SECOND_IN_NS);
+	ASSERT_EQ(vector<uint64_t>({0, 1, 2}), get_keys(sample));
+}
+
+TEST(sinsp_table, max_rows_groupby)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	unique_ptr<sinsp_table> table(new_table(&inspector, {
+		column("evt.rawarg.vm_size", TEF_IS_KEY, A_NONE),
+		column("evt.rawarg.vm_swap", TEF_IS_GROUPBY_KEY, A_NONE),
+		column("evt.rawarg.vm_rss", TEF_NONE, A_SUM, A_SUM)}, &builder));
+	table->set_max_rows(2);
+
+	//
+	// Groups 8 and 9 have many rows worth little, the others a single row
+	// worth more: pruning the rows before grouping would drop the top
+	// groups
+	//
+	uint32_t key = 0;
+	for(uint32_t group = 0; group < 8; group++)
+	{
+		table->process_event(builder.brk_x(START_TS + key, key, 100, group));
+		key++;
+	}
+
+	for(uint32_t j = 0; j < 110; j++)
+	{
+		table->process_event(builder.brk_x(START_TS + key, key, 10, (j < 60)? 9 : 8));
+		key++;
+	}
+
+	vector<sinsp_sample_row>* sample = get_sample(table.get(), &builder);
+	ASSERT_EQ(vector<uint64_t>({9, 8}), get_keys(sample));
+	EXPECT_EQ(600u, get_uint(sample->at(0).m_values[0]));
+	EXPECT_EQ(500u, get_uint(sample->at(1).m_values[0]));
+}
+
+//
+// The raw rows of a sample by key, with the count of every value
+//
+typedef std::map<std::string, vector<pair<std::string, uint32_t>>> raw_rows;
+
+static raw_rows get_raw_rows(vector<sinsp_sample_row>* sample)
+{
+	raw_rows res;
+
+	for(const auto& row : *sample)
+	{
+		auto& vals = res[std::string((const char*)row.m_key.m_val, row.m_key.m_len)];
+		for(const auto& fld : row.m_values)
+		{
+			vals.emplace_back(std::string((const char*)fld.m_val, fld.m_len), fld.m_cnt);
+		}
+	}
+
+	return res;
+}
+
+//
+// Feeds the same events to a table, and in turn to three shards that are
+// then merged: both must end up with the same rows
+//
+static void expect_same_merged(vector<sinsp_view_column_info> columns,
+	std::function<sinsp_evt*(test_helpers::event_builder*, uint32_t)> next_evt)
+{
+	sinsp inspector;
+	test_helpers::event_builder builder(&inspector);
+	unique_ptr<sinsp_table> table(new_table(&inspector, columns, &builder));
+	vector<unique_ptr<sinsp_table>> shards;
+
+	for(uint32_t j = 0; j < 3; j++)
+	{
+		shards.emplace_back(new_table(&inspector, columns, &builder));
+	}
+
+	for(uint32_t j = 0; j < 2000; j++)
+	{
+		table->process_event(next_evt(&builder, j));
+		shards[j % 3]->process_event(next_evt(&builder, j));
+	}
+
+	sinsp_evt* evt = builder.brk_x(START_TS + ONE_SECOND_IN_NS, 0, 0, 0);
+	shards[0]->merge_partial(shards[1].get(), evt);
+	shards[0]->merge_partial(shards[2].get(), evt);
+
+	raw_rows expected = get_raw_rows(get_sample(table.get(), &builder));
+	ASSERT_FALSE(expected.empty());
+	EXPECT_EQ(expected, get_raw_rows(get_sample(shards[0].get(), &builder)));
+
+	// the merged shards are emptied
+	EXPECT_TRUE(get_sample(shards[1].get(), &builder)->empty());
+	EXPECT_TRUE(get_sample(shards[2].get(), &builder)->empty());
+}
+
+TEST(sinsp_table, merge_partial)
+{
+	expect_same_merged({
+			column("evt.rawarg.vm_swap", TEF_IS_KEY, A_NONE),
+			column("evt.rawarg.vm_size", TEF_NONE, A_SUM),
+			column("evt.rawarg.vm_rss", TEF_NONE, A_AVG),
+			column("evt.rawarg.vm_size", TEF_NONE, A_MIN),
+			column("evt.rawarg.vm_size", TEF_NONE, A_MAX),
+			column("evt.rawarg.vm_rss", TEF_NONE, A_DISTINCT)},
+		[](test_helpers::event_builder* builder, uint32_t j)
+		{
+			return builder->brk_x(START_TS + j, (j * 31) % 1009, (j * 7) % 53, j % 17);
+		});
+}
+
+TEST(sinsp_table, merge_partial_groupby)
+{
+	//
+	// The group of a row only depends on its key, so that it doesn't
+	// depend on which shard saw the key first
+	//
+	expect_same_merged({
+			column("evt.rawarg.vm_size", TEF_IS_KEY, A_NONE),
+			column("evt.rawarg.vm_swap", TEF_IS_GROUPBY_KEY, A_NONE),
+			column("evt.rawarg.vm_rss", TEF_NONE, A_SUM, A_SUM),
+			column("evt.rawarg.vm_rss", TEF_NONE, A_AVG, A_AVG),
+			column("evt.rawarg.vm_rss", TEF_NONE, A_MIN, A_MIN),
+			column("evt.rawarg.vm_rss", TEF_NONE, A_MAX, A_MAX),
+			column("evt.rawarg.vm_rss", TEF_NONE, A_DISTINCT, A_DISTINCT)},
+		[](test_helpers::event_builder* builder, uint32_t j)
+		{
+			uint32_t key = (j * 31) % 101;
+			return builder->brk_x(START_TS + j, key, (j * 7) % 53, key % 7);
+		});
+}
@@ -0,0 +1,80 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "sinsp.h"
+#include <gtest.h>
+
+static sinsp_threadinfo* add_process(sinsp& inspector, int64_t pid, int64_t ppid)
+{
+	sinsp_threadinfo* tinfo = inspector.build_threadinfo();
+	tinfo->m_tid = pid;
+	tinfo->m_pid = pid;
+	tinfo->m_ptid = ppid;
+	tinfo->m_comm = "proc" + std::to_string(pid);
+	inspector.m_thread_manager->add_thread(tinfo, false);
+	return &*inspector.get_thread_ref(pid, false, true);
+}
+
+static std::vector<int64_t> ancestors(sinsp_threadinfo* tinfo)
+{
+	std::vector<int64_t> res;
+	sinsp_threadinfo::visitor_func_t visitor = [&res] (sinsp_threadinfo *pt)
+	{
+		res.push_back(pt->m_pid);
+		return true;
+	};
+	tinfo->traverse_parent_state(visitor);
+	return res;
+}
+
+TEST(sinsp_threadinfo, parent_thread_cache)
+{
+	sinsp inspector;
+	for(int64_t pid = 1; pid <= 10; pid++)
+	{
+		add_process(inspector, pid, pid - 1);
+	}
+	sinsp_threadinfo* leaf = &*inspector.get_thread_ref(10, false, true);
+	ASSERT_NE(nullptr, leaf);
+
+	// repeated walks return the same chain
+	for(int j = 0; j < 3; j++)
+	{
+		ASSERT_EQ(std::vector<int64_t>({9, 8, 7, 6, 5, 4, 3, 2, 1}), ancestors(leaf));
+	}
+
+	// removing an ancestor cuts the chain
+	inspector.m_thread_manager->remove_thread(5, true);
+	ASSERT_EQ(std::vector<int64_t>({9, 8, 7, 6}), ancestors(leaf));
+
+	// changing the parent is picked up
+	sinsp_threadinfo* t6 = &*inspector.get_thread_ref(6, false, true);
+	t6->m_ptid = 3;
+	ASSERT_EQ(std::vector<int64_t>({9, 8, 7, 6, 3, 2, 1}), ancestors(leaf));
+
+	// a parent that was missing is found once it is added
+	sinsp_threadinfo* orphan = add_process(inspector, 20, 21);
+	ASSERT_EQ(nullptr, orphan->get_parent_thread());
+	add_process(inspector, 21, 1);
+	ASSERT_EQ(21, orphan->get_parent_thread()->m_pid);
+	ASSERT_EQ(std::vector<int64_t>({21, 1}), ancestors(orphan));
+
+	// a thread replaced in the table is not returned from the cache
+	sinsp_threadinfo* replaced = add_process(inspector, 21, 2);
+	ASSERT_EQ(replaced, orphan->get_parent_thread());
+	ASSERT_EQ(std::vector<int64_t>({21, 2, 1}), ancestors(orphan));
+}
@@ -0,0 +1,252 @@
+/*
+Copyright (C) 2021 The Falco Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include <gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sinsp.h>
+#include <tracers.h>
+
+//
+// Without an inspector, the parser only tokenizes
+//
+static sinsp_tracerparser::parse_result parse(sinsp_tracerparser& parser, const std::string& msg)
+{
+	std::vector<char> buf(msg.begin(), msg.end());
+	buf.push_back(0);
+	return parser.process_event_data(buf.data(), (uint32_t)msg.size(), 0);
+}
+
+static std::vector<std::string> tokens(const std::vector<char*>& strs, const std::vector<uint32_t>& lens)
+{
+	std::vector<std::string> res;
+	for(uint32_t j = 0; j < strs.size(); j++)
+	{
+		res.push_back(std::string(strs[j], lens[j]));
+	}
+	return res;
+}
+
+TEST(tracers, parse_json)
+{
+	sinsp_tracerparser parser(NULL);
+
+	ASSERT_EQ(sinsp_tracerparser::RES_OK, parse(parser,
+		"[\">\", 12345, [\"mysql\", \"query\", \"in\\\"it\"], [{\"arg1\":\"val1\"}, {\"arg2\":\"val2\"}]]"));
+	ASSERT_EQ('>', parser.m_type_str[0]);
+	ASSERT_EQ(12345, parser.m_id);
+	ASSERT_EQ(std::vector<std::string>({"mysql", "query", "in\\\"it"}), tokens(parser.m_tags, parser.m_taglens));
+	ASSERT_EQ(std::vector<std::string>({"arg1", "arg2"}), tokens(parser.m_argnames, parser.m_argnamelens));
+	ASSERT_EQ(std::vector<std::string>({"val1", "val2"}), tokens(parser.m_argvals, parser.m_argvallens));
+
+	ASSERT_EQ(sinsp_tracerparser::RES_FAILED, parse(parser, "[\">\", 12345x, [\"mysql\"], []]"));
+}
+
+TEST(tracers, parse_simple)
+{
+	sinsp_tracerparser parser(NULL);
+
+	ASSERT_EQ(sinsp_tracerparser::RES_OK, parse(parser, "<:123:my\\.sql.query:a\\=b=c\\,d,e=f:"));
+	ASSERT_EQ('<', parser.m_type_str[0]);
+	ASSERT_EQ(123, parser.m_id);
+	ASSERT_EQ(std::vector<std::string>({"my.sql", "query"}), tokens(parser.m_tags, parser.m_taglens));
+	ASSERT_EQ(std::vector<std::string>({"a=b", "e"}), tokens(parser.m_argnames, parser.m_argnamelens));
+	ASSERT_EQ(std::vector<std::string>({"c,d", "f"}), tokens(parser.m_argvals, parser.m_argvallens));
+
+	ASSERT_EQ(sinsp_tracerparser::RES_FAILED, parse(parser, ">:123:my<sql::"));
+}
+
+TEST(tracers, fragments)
+{
+	sinsp_tracerparser parser(NULL);
+
+	ASSERT_EQ(sinsp_tracerparser::RES_TRUNCATED, parse(parser, ">:123:mysql.qu"));
+	ASSERT_EQ(sinsp_tracerparser::RES_TRUNCATED, parse(parser, "ery:arg"));
+	ASSERT_EQ(sinsp_tracerparser::RES_OK, parse(parser, "=val:"));
+	ASSERT_EQ(std::vector<std::string>({"mysql", "query"}), tokens(parser.m_tags, parser.m_taglens));
+	ASSERT_EQ(std::vector<std::string>({"arg"}), tokens(parser.m_argnames, parser.m_argnamelens));
+	ASSERT_EQ(std::vector<std::string>({"val"}), tokens(parser.m_argvals, parser.m_argvallens));
+}
+
+//
+// A parser that tracks the open spans of an inspector
+//
+class tracking_parser
+{
+public:
+	tracking_parser():
+		m_tinfo(m_inspector.build_threadinfo()),
+		m_parser(&m_inspector)
+	{
+		m_tinfo->m_tid = 1;
+		m_parser.m_tinfo = m_tinfo.get();
+		m_inspector.request_tracer_state_tracking();
+	}
+
+	~tracking_parser()
+	{
+		sinsp_tracerparser::clear_partial_tracers(&m_inspector);
+	}
+
+	//
+	// The span opened or closed by msg, NULL if the exit had no enter
+	//
+	sinsp_partial_tracer* process(const std::string& msg)
+	{
+		if(parse(m_parser, msg) != sinsp_tracerparser::RES_OK)
+		{
+			return NULL;
+		}
+		return m_parser.m_enter_pae;
+	}
+
+	sinsp m_inspector;
+	std::unique_ptr<sinsp_threadinfo> m_tinfo;
+	sinsp_tracerparser m_parser;
+};
+
+TEST(tracers, match_exit)
+{
+	tracking_parser t;
+	sinsp& inspector = t.m_inspector;
+
+	sinsp_partial_tracer* a = t.process(">:1:mysql.query::");
+	sinsp_partial_tracer* b = t.process(">:1:mysql.insert::");
+	sinsp_partial_tracer* c = t.process(">:2:mysql.query::");
+	sinsp_partial_tracer* d = t.process(">:1:mysql.query::");
+	ASSERT_EQ(4u, inspector.m_partial_tracers_list.size());
+	ASSERT_EQ(3u, inspector.m_partial_tracers_index.size());
+
+	//
+	// By id and tags, the most recent first
+	//
+	ASSERT_EQ(b, t.process("<:1:mysql.insert::"));
+	ASSERT_EQ(d, t.process("<:1:mysql.query::"));
+	ASSERT_EQ(a, t.process("<:1:mysql.query::"));
+	ASSERT_EQ(nullptr, t.process("<:1:mysql.query::"));
+	ASSERT_EQ(nullptr, t.process("<:2:mysql::"));
+	ASSERT_EQ(nullptr, t.process("<:2:mysql.query.x::"));
+	ASSERT_EQ(1u, inspector.m_partial_tracers_list.size());
+	ASSERT_EQ(1u, inspector.m_partial_tracers_index.size());
+	ASSERT_EQ(c, t.process("<:2:mysql.query::"));
+
+	ASSERT_TRUE(inspector.m_partial_tracers_list.empty());
+	ASSERT_TRUE(inspector.m_partial_tracers_index.empty());
+}
+
+TEST(tracers, hash_collisions)
+{
+	tracking_parser t;
+	sinsp& inspector = t.m_inspector;
+
+	sinsp_partial_tracer* a = t.process(">:1:a::");
+	sinsp_partial_tracer* b = t.process(">:1:b::");
+	sinsp_partial_tracer* c = t.process(">:1:c::");
+	ASSERT_EQ(3u, inspector.m_partial_tracers_index.size());
+
+	//
+	// Chain b and c in front of a, like spans with the hash of a but
+	// other tags would be
+	//
+	sinsp_tracerparser::remove_partial_tracer(&inspector, b);
+	sinsp_tracerparser::remove_partial_tracer(&inspector, c);
+	ASSERT_EQ(1u, inspector.m_partial_tracers_index.size());
+	for(sinsp_partial_tracer* pae : {b, c})
+	{
+		inspector.m_partial_tracers_list.push_front(pae);
+		pae->m_list_it = inspector.m_partial_tracers_list.begin();
+		pae->m_index_hash = a->m_index_hash;
+		pae->m_index_next = inspector.m_partial_tracers_index[a->m_index_hash];
+		inspector.m_partial_tracers_index[a->m_index_hash] = pae;
+	}
+
+	//
+	// The exit of a skips the spans in front of it, and is unlinked
+	// from the end of the chain
+	//
+	ASSERT_EQ(a, t.process("<:1:a::"));
+	ASSERT_EQ(2u, inspector.m_partial_tracers_list.size());
+	ASSERT_EQ(c, inspector.m_partial_tracers_index[b->m_index_hash]);
+	ASSERT_EQ(b, c->m_index_next);
+	ASSERT_EQ(nullptr, b->m_index_next);
+
+	//
+	// From the middle and the front of the chain
+	//
+	sinsp_partial_tracer* a2 = t.process(">:1:a::");
+	ASSERT_EQ(a2, inspector.m_partial_tracers_index[a->m_index_hash]);
+	sinsp_tracerparser::remove_partial_tracer(&inspector, c);
+	ASSERT_EQ(b, a2->m_index_next);
+	ASSERT_EQ(a2, t.process("<:1:a::"));
+	ASSERT_EQ(b, inspector.m_partial_tracers_index[a->m_index_hash]);
+	sinsp_tracerparser::remove_partial_tracer(&inspector, b);
+	ASSERT_TRUE(inspector.m_partial_tracers_list.empty());
+	ASSERT_TRUE(inspector.m_partial_tracers_index.empty());
+	inspector.m_partial_tracers_pool->push(b);
+	inspector.m_partial_tracers_pool->push(c);
+}
+
+TEST(tracers, find_parent)
+{
+	tracking_parser t;
+
+	sinsp_partial_tracer* parent = t.process(">:7:mysql::");
+	ASSERT_NE(nullptr, parent);
+	t.process(">:8:mysql::");
+	t.process(">:7:mysql.query::");
+	ASSERT_EQ(parent, t.m_parser.find_parent_enter_pae());
+
+	t.process(">:9:mysql.query::");
+	ASSERT_EQ(nullptr, t.m_parser.find_parent_enter_pae());
+
+	//
+	// Once the parent is closed
+	//
+	ASSERT_EQ(parent, t.process("<:7:mysql::"));
+	t.process(">:7:mysql.insert::");
+	ASSERT_EQ(nullptr, t.m_parser.find_parent_enter_pae());
+}
+
+TEST(tracers, pool_exhausted)
+{
+	tracking_parser t;
+	sinsp& inspector = t.m_inspector;
+
+	//
+	// When every span of the pool is open, they are all dropped
+	//
+	uint32_t nopen = 0;
+	while(inspector.m_partial_tracers_list.size() == nopen)
+	{
+		nopen++;
+		t.process(">:" + std::to_string(nopen) + ":span::");
+	}
+	ASSERT_GT(nopen, 1u);
+	ASSERT_TRUE(inspector.m_partial_tracers_list.empty());
+	ASSERT_TRUE(inspector.m_partial_tracers_index.empty());
+
+	//
+	// The index is rebuilt with the new spans
+	//
+	sinsp_partial_tracer* pae = t.process(">:1:span::");
+	ASSERT_NE(nullptr, pae);
+	ASSERT_EQ(1u, inspector.m_partial_tracers_index.size());
+	ASSERT_EQ(nullptr, t.process("<:2:span::"));
+	ASSERT_EQ(pae, t.process("<:1:span::"));
+	ASSERT_TRUE(inspector.m_partial_tracers_index.empty());
+}
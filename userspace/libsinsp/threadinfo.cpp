@@ -76,6 +76,9 @@ void sinsp_threadinfo::init()
 	m_vtid = -1;
 	m_vpid = -1;
 	m_main_thread.reset();
+	m_parent_thread = NULL;
+	m_parent_thread_ptid = -1;
+	m_parent_thread_generation = 0;
 	m_lastevent_fd = 0;
 #ifdef HAS_FILTERING
 	m_last_latency_entertime = 0;
@@ -356,13 +359,15 @@ void sinsp_threadinfo::add_fd_from_scap(scap_fdinfo *fdi, OUT sinsp_fdinfo_t *re
 	}
 
 	//
-	// Call the protocol decoder callbacks associated to notify them about this FD
+	// Notify all the protocol decoders about this FD: the socket decoders
+	// don't follow the open() calls, but they do want the sockets that
+	// were open before the capture started
 	//
 	ASSERT(m_inspector != NULL);
 	vector<sinsp_protodecoder*>::iterator it;
 
-	for(it = m_inspector->m_parser->m_open_callbacks.begin();
-		it != m_inspector->m_parser->m_open_callbacks.end(); ++it)
+	for(it = m_inspector->m_parser->m_protodecoders.begin();
+		it != m_inspector->m_parser->m_protodecoders.end(); ++it)
 	{
 		(*it)->on_fd_from_proc(newfdi);
 	}
@@ -666,7 +671,23 @@ void sinsp_threadinfo::set_cgroups(const char* cgroups, size_t len)
 
 sinsp_threadinfo* sinsp_threadinfo::get_parent_thread()
 {
-	return &*m_inspector->get_thread_ref(m_ptid, false, true);
+	uint64_t generation = m_inspector->m_thread_manager->get_generation();
+
+	if(m_parent_thread != NULL &&
+	   m_parent_thread_ptid == m_ptid &&
+	   m_parent_thread_generation == generation)
+	{
+		return m_parent_thread;
+	}
+
+	//
+	// A missing parent is not cached, since it can be added to the
+	// table at any time without changing the generation
+	//
+	m_parent_thread = &*m_inspector->get_thread_ref(m_ptid, false, true);
+	m_parent_thread_ptid = m_ptid;
+	m_parent_thread_generation = generation;
+	return m_parent_thread;
 }
 
 sinsp_fdinfo_t* sinsp_threadinfo::add_fd(int64_t fd, sinsp_fdinfo_t *fdinfo)
@@ -1211,7 +1232,8 @@ void sinsp_threadinfo::fd_to_scap(scap_fdinfo *dst, sinsp_fdinfo_t* src)
 // sinsp_thread_manager implementation
 ///////////////////////////////////////////////////////////////////////////////
 sinsp_thread_manager::sinsp_thread_manager(sinsp* inspector)
-	: m_max_thread_table_size(m_thread_table_absolute_max_size)
+	: m_generation(0),
+	  m_max_thread_table_size(m_thread_table_absolute_max_size)
 {
 	m_inspector = inspector;
 	clear();
@@ -1220,6 +1242,7 @@ sinsp_thread_manager::sinsp_thread_manager(sinsp* inspector)
 void sinsp_thread_manager::clear()
 {
 	m_threadtable.clear();
+	m_generation++;
 	m_last_tid = 0;
 	m_last_tinfo.reset();
 	m_last_flush_time_ns = 0;
@@ -1287,6 +1310,11 @@ bool sinsp_thread_manager::add_thread(sinsp_threadinfo *threadinfo, bool from_sc
 
 	threadinfo->compute_program_hash();
 	threadinfo->allocate_private_state();
+	if(m_threadtable.get(threadinfo->m_tid) != nullptr)
+	{
+		// the threadinfo being replaced is freed
+		m_generation++;
+	}
 	m_threadtable.put(threadinfo);
 
 	return true;
@@ -1376,6 +1404,7 @@ void sinsp_thread_manager::remove_thread(int64_t tid, bool force)
 #endif
 
 		m_threadtable.erase(tid);
+		m_generation++;
 
 		//
 		// If the thread has a nonzero refcount, it means that we are forcing the removal
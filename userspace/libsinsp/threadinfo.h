@@ -152,6 +152,10 @@ public:
 
 	/*!
 	  \brief Get the process that launched this thread's process.
+
+	  \note the result is cached until m_ptid changes or a thread is
+	  removed from the thread table, so walking the ancestors of a
+	  process repeatedly does not cost a table lookup per hop.
 	*/
 	sinsp_threadinfo* get_parent_thread();
 
@@ -432,6 +436,11 @@ VISIBILITY_PRIVATE
 	sinsp_fdtable m_fdtable; // The fd table of this thread
 	std::string m_cwd; // current working directory
 	mutable std::weak_ptr<sinsp_threadinfo> m_main_thread;
+	// get_parent_thread() cache, valid for the m_ptid and thread table
+	// generation it was looked up with
+	sinsp_threadinfo* m_parent_thread;
+	int64_t m_parent_thread_ptid;
+	uint64_t m_parent_thread_generation;
 	uint8_t* m_lastevent_data; // Used by some event parsers to store the last enter event
 	std::vector<void*> m_private_state;
 
@@ -630,6 +639,13 @@ public:
 	uint64_t get_m_n_proc_lookups_duration_ns() const { return m_n_proc_lookups_duration_ns; }
 	void reset_thread_counters() { m_n_proc_lookups = 0; m_n_main_thread_lookups = 0; m_n_proc_lookups_duration_ns = 0; }
 
+	//
+	// Changes every time a threadinfo is removed from the table or
+	// replaced, i.e. whenever raw pointers to threadinfos kept outside
+	// of the table may have become dangling
+	//
+	uint64_t get_generation() const { return m_generation; }
+
 	void set_m_max_n_proc_lookups(int32_t val) { m_max_n_proc_lookups = val; }
 	void set_m_max_n_proc_socket_lookups(int32_t val) { m_max_n_proc_socket_lookups = val; }
 private:
@@ -644,6 +660,7 @@ private:
 	std::weak_ptr<sinsp_threadinfo> m_last_tinfo;
 	uint64_t m_last_flush_time_ns;
 	uint32_t m_n_drops;
+	uint64_t m_generation;
 	const uint32_t m_thread_table_absolute_max_size = 131072;
 	uint32_t m_max_thread_table_size;
 	int32_t m_n_proc_lookups = 0;
@@ -16,10 +16,120 @@ limitations under the License.
 */
 
 #include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "sinsp.h"
 #include "sinsp_int.h"
 #include "tracers.h"
 
+///////////////////////////////////////////////////////////////////////////////
+// Tokenizer helpers
+///////////////////////////////////////////////////////////////////////////////
+
+//
+// A set of characters that end a token. The zero terminator must be part
+// of every set, so that find() stops at the end of the data.
+//
+class tracer_charset
+{
+public:
+	tracer_charset(const char* chars, uint32_t nchars)
+	{
+		ASSERT(nchars <= MAX_CHARS);
+		memset(m_table, 0, sizeof(m_table));
+
+		m_nchars = nchars;
+		for(uint32_t j = 0; j < nchars; j++)
+		{
+			m_table[(uint8_t)chars[j]] = true;
+#ifdef __SSE2__
+			m_chars[j] = _mm_set1_epi8(chars[j]);
+#endif
+		}
+	}
+
+	//
+	// Returns the first character of p that is in the set. The storage
+	// must extend TRACER_STORAGE_PADDING bytes past the terminator.
+	//
+	inline char* find(char* p) const
+	{
+#ifdef __SSE2__
+		while(true)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)p);
+			__m128i m = _mm_cmpeq_epi8(v, m_chars[0]);
+			for(uint32_t j = 1; j < m_nchars; j++)
+			{
+				m = _mm_or_si128(m, _mm_cmpeq_epi8(v, m_chars[j]));
+			}
+
+			int mask = _mm_movemask_epi8(m);
+			if(mask != 0)
+			{
+				return p + __builtin_ctz(mask);
+			}
+
+			p += 16;
+		}
+#else
+		while(!m_table[(uint8_t)*p])
+		{
+			p++;
+		}
+
+		return p;
+#endif
+	}
+
+	static const uint32_t MAX_CHARS = 8;
+
+private:
+#ifdef __SSE2__
+	__m128i m_chars[MAX_CHARS];
+#endif
+	bool m_table[256];
+	uint32_t m_nchars;
+};
+
+static const char s_str_chars[] = {0, '"'};
+static const char s_simple_tag_chars[] = {0, '\\', '.', ':', '>', '<', '=', '\n'};
+static const char s_simple_argname_chars[] = {0, '\\', '=', '>', '<', '\n'};
+static const char s_simple_argval_chars[] = {0, '\\', ',', ':', '='};
+
+static const tracer_charset s_str_delims(s_str_chars, sizeof(s_str_chars));
+static const tracer_charset s_simple_tag_delims(s_simple_tag_chars, sizeof(s_simple_tag_chars));
+static const tracer_charset s_simple_argname_delims(s_simple_argname_chars, sizeof(s_simple_argname_chars));
+static const tracer_charset s_simple_argval_delims(s_simple_argval_chars, sizeof(s_simple_argval_chars));
+
+//
+// Grows a partial tracer storage geometrically, so that spans of
+// increasing size don't reallocate every time
+//
+static inline void reserve_tracer_storage(char** storage, uint32_t* size, uint32_t len)
+{
+	if(*size >= len)
+	{
+		return;
+	}
+
+	uint32_t newsize = *size * 2;
+	if(newsize < len)
+	{
+		newsize = len;
+	}
+
+	char* newstorage = (char*)realloc(*storage, newsize);
+	if(newstorage == NULL)
+	{
+		throw sinsp_exception("memory allocation error in sinsp_tracerparser::init_partial_tracer.");
+	}
+
+	*storage = newstorage;
+	*size = newsize;
+}
+
 sinsp_tracerparser::sinsp_tracerparser(sinsp *inspector)
 {
 	m_inspector = inspector;
@@ -40,7 +150,7 @@ sinsp_tracerparser::~sinsp_tracerparser()
 
 void sinsp_tracerparser::set_storage_size(uint32_t newsize)
 {
-	m_storage = (char*)realloc(m_storage, newsize);
+	m_storage = (char*)realloc(m_storage, newsize + TRACER_STORAGE_PADDING);
 	if(m_storage == NULL)
 	{
 		throw sinsp_exception("memory allocation error in sinsp_tracerparser::process_event_data.");
@@ -184,52 +294,39 @@ sinsp_tracerparser::parse_result sinsp_tracerparser::process_event_data(char *da
 			// the entries will be stuck there forever. Better clean the list, miss the 128
 			// events it contains, and start fresh.
 			//
-			list<sinsp_partial_tracer*>* partial_tracers_list = &m_inspector->m_partial_tracers_list;
-			list<sinsp_partial_tracer*>::iterator it;
-
-			for(it = partial_tracers_list->begin(); it != partial_tracers_list->end(); ++it)
-			{
-				m_inspector->m_partial_tracers_pool->push(*it);
-			}
-
-			partial_tracers_list->clear();
+			clear_partial_tracers(m_inspector);
 
 			return sinsp_tracerparser::RES_OK;
 		}
 
 		init_partial_tracer(pae);
 		pae->m_time = ts;
-		m_inspector->m_partial_tracers_list.push_front(pae);
+		add_partial_tracer(m_inspector, pae);
 		m_enter_pae = pae;
 	}
 	else
 	{
-		list<sinsp_partial_tracer*>* partial_tracers_list = &m_inspector->m_partial_tracers_list;
-		list<sinsp_partial_tracer*>::iterator it;
-
 		init_partial_tracer(&m_exit_pae);
 
-		for(it = partial_tracers_list->begin(); it != partial_tracers_list->end(); ++it)
+		sinsp_partial_tracer* pae = find_partial_tracer(&m_exit_pae, m_exit_pae.m_tags_len - 1);
+		if(pae != NULL)
 		{
-			if(m_exit_pae.compare(*it) == true)
-			{
-				m_exit_pae.m_time = ts;
-
-				//
-				// This is a bit tricky and deserves some explanation:
-				// despite removing the pae and returning it to the available pool,
-				// we link to it so that the filters will use it. We do that as an
-				// optimization (it avoids making a copy or implementing logic for 
-				// delayed list removal), and we base it on the assumption that,
-				// since the processing is strictly sequential and single thread,
-				// nobody will modify the pae until the event is fully processed.
-				//
-				m_enter_pae = *it;
-
-				m_inspector->m_partial_tracers_pool->push(*it);
-				partial_tracers_list->erase(it);
-				return sinsp_tracerparser::RES_OK;
-			}
+			m_exit_pae.m_time = ts;
+
+			//
+			// This is a bit tricky and deserves some explanation:
+			// despite removing the pae and returning it to the available pool,
+			// we link to it so that the filters will use it. We do that as an
+			// optimization (it avoids making a copy or implementing logic for 
+			// delayed list removal), and we base it on the assumption that,
+			// since the processing is strictly sequential and single thread,
+			// nobody will modify the pae until the event is fully processed.
+			//
+			m_enter_pae = pae;
+
+			remove_partial_tracer(m_inspector, pae);
+			m_inspector->m_partial_tracers_pool->push(pae);
+			return sinsp_tracerparser::RES_OK;
 		}
 
 		m_enter_pae = NULL;
@@ -240,9 +337,6 @@ sinsp_tracerparser::parse_result sinsp_tracerparser::process_event_data(char *da
 
 sinsp_partial_tracer* sinsp_tracerparser::find_parent_enter_pae()
 {
-	list<sinsp_partial_tracer*>* partial_tracers_list = &m_inspector->m_partial_tracers_list;
-	list<sinsp_partial_tracer*>::iterator it;
-
 	char* tse = m_enter_pae->m_tags_storage + m_tot_taglens;
 	if(*tse == 0 && tse > m_enter_pae->m_tags_storage)
 	{
@@ -261,17 +355,97 @@ sinsp_partial_tracer* sinsp_tracerparser::find_parent_enter_pae()
 		--tse;
 	}
 
-	for(it = partial_tracers_list->begin(); it != partial_tracers_list->end(); ++it)
+	return find_partial_tracer(m_enter_pae, len);
+}
+
+inline uint64_t sinsp_tracerparser::hash_tags(uint64_t id, const char* tags, uint32_t len)
+{
+	const uint64_t k = 0x9e3779b97f4a7c15ULL;
+	uint64_t h = (id ^ len) * k;
+	uint64_t w;
+
+	for(; len >= sizeof(w); tags += sizeof(w), len -= sizeof(w))
+	{
+		memcpy(&w, tags, sizeof(w));
+		h = (h ^ w) * k;
+		h ^= h >> 29;
+	}
+
+	w = 0;
+	memcpy(&w, tags, len);
+	h = (h ^ w) * k;
+	return h ^ (h >> 32);
+}
+
+//
+// Returns the most recent open span with the id of pae and the first len
+// bytes of its tags as tags, like a scan of the list from the front
+//
+sinsp_partial_tracer* sinsp_tracerparser::find_partial_tracer(sinsp_partial_tracer* pae, uint32_t len)
+{
+	unordered_map<uint64_t, sinsp_partial_tracer*>::iterator it =
+		m_inspector->m_partial_tracers_index.find(hash_tags(pae->m_id, pae->m_tags_storage, len));
+
+	if(it == m_inspector->m_partial_tracers_index.end())
+	{
+		return NULL;
+	}
+
+	for(sinsp_partial_tracer* cur = it->second; cur != NULL; cur = cur->m_index_next)
 	{
-		if(m_enter_pae->compare(*it, len) == true)
+		if(pae->compare(cur, len) == true)
 		{
-			return *it;
+			return cur;
 		}
 	}
 
 	return NULL;
 }
 
+void sinsp_tracerparser::add_partial_tracer(sinsp* inspector, sinsp_partial_tracer* pae)
+{
+	inspector->m_partial_tracers_list.push_front(pae);
+	pae->m_list_it = inspector->m_partial_tracers_list.begin();
+
+	pae->m_index_hash = hash_tags(pae->m_id, pae->m_tags_storage, pae->m_tags_len - 1);
+	sinsp_partial_tracer*& head = inspector->m_partial_tracers_index[pae->m_index_hash];
+	pae->m_index_next = head;
+	head = pae;
+}
+
+void sinsp_tracerparser::remove_partial_tracer(sinsp* inspector, sinsp_partial_tracer* pae)
+{
+	inspector->m_partial_tracers_list.erase(pae->m_list_it);
+
+	unordered_map<uint64_t, sinsp_partial_tracer*>::iterator it =
+		inspector->m_partial_tracers_index.find(pae->m_index_hash);
+	ASSERT(it != inspector->m_partial_tracers_index.end());
+
+	sinsp_partial_tracer** link = &it->second;
+	while(*link != pae)
+	{
+		ASSERT(*link != NULL);
+		link = &(*link)->m_index_next;
+	}
+
+	*link = pae->m_index_next;
+	if(it->second == NULL)
+	{
+		inspector->m_partial_tracers_index.erase(it);
+	}
+}
+
+void sinsp_tracerparser::clear_partial_tracers(sinsp* inspector)
+{
+	for(auto it = inspector->m_partial_tracers_list.begin(); it != inspector->m_partial_tracers_list.end(); ++it)
+	{
+		inspector->m_partial_tracers_pool->push(*it);
+	}
+
+	inspector->m_partial_tracers_list.clear();
+	inspector->m_partial_tracers_index.clear();
+}
+
 inline void sinsp_tracerparser::parse_json(char* evtstr)
 {
 	char* p = m_storage;
@@ -539,11 +713,8 @@ inline void sinsp_tracerparser::parse_json(char* evtstr)
 
 inline void sinsp_tracerparser::delete_char(char* p)
 {
-	while(*p != 0)
-	{
-		*p = *(p + 1);
-		p++;
-	}
+	// Moves the rest of the string, terminator included, back by one
+	memmove(p, p + 1, strlen(p));
 }
 
 inline void sinsp_tracerparser::parse_simple(char* evtstr)
@@ -630,43 +801,37 @@ inline void sinsp_tracerparser::parse_simple(char* evtstr)
 
 	if(*p != ':')
 	{
-		bool dont_interpret_next_char = false;
-
 		while(true)
 		{
 			char* start = p;
 
 			m_tags.push_back(p);
 
-			while(*p != 0)
+			while(true)
 			{
-				if(dont_interpret_next_char)
-				{
-					dont_interpret_next_char = false;
-					++p;
-					continue;
-				}
+				p = s_simple_tag_delims.find(p);
 
 				if(*p == '\\')
 				{
-					ASSERT(dont_interpret_next_char == false);
-					dont_interpret_next_char = true;
+					//
+					// Drop the backslash and keep the next character,
+					// whatever it is
+					//
 					delete_char(p);
+					if(*p != 0)
+					{
+						++p;
+					}
 					continue;
 				}
 
-				if(*p == '.' || *p == ':')
-				{
-					break;
-				}
-
 				if(*p == '>' || *p == '<' || *p == '=' || *p == '\n')
 				{
 					m_res = sinsp_tracerparser::RES_FAILED;
 					return;
 				}
 
-				++p;
+				break;
 			}
 
 			m_taglens.push_back((uint32_t)(p - start));
@@ -703,8 +868,6 @@ inline void sinsp_tracerparser::parse_simple(char* evtstr)
 
 	if(*p != ':')
 	{
-		bool dont_interpret_next_char = false;
-
 		while(true)
 		{
 			char* start = p;
@@ -714,35 +877,27 @@ inline void sinsp_tracerparser::parse_simple(char* evtstr)
 			//
 			m_argnames.push_back(p);
 
-			while(*p != 0)
+			while(true)
 			{
-				if(dont_interpret_next_char)
-				{
-					dont_interpret_next_char = false;
-					++p;
-					continue;
-				}
+				p = s_simple_argname_delims.find(p);
 
 				if(*p == '\\')
 				{
-					ASSERT(dont_interpret_next_char == false);
-					dont_interpret_next_char = true;
 					delete_char(p);
+					if(*p != 0)
+					{
+						++p;
+					}
 					continue;
 				}
 
-				if(*p == '=')
-				{
-					break;
-				}
-
 				if(*p == '>' || *p == '<' || *p == '\n')
 				{
 					m_res = sinsp_tracerparser::RES_FAILED;
 					return;
 				}
 
-				++p;
+				break;
 			}
 
 			m_argnamelens.push_back((uint32_t)(p - start));
@@ -776,31 +931,21 @@ inline void sinsp_tracerparser::parse_simple(char* evtstr)
 			start = p;
 			m_argvals.push_back(p);
 
-			dont_interpret_next_char = false;
-
-			while(*p != 0)
+			while(true)
 			{
-				if(dont_interpret_next_char)
-				{
-					dont_interpret_next_char = false;
-					++p;
-					continue;
-				}
+				p = s_simple_argval_delims.find(p);
 
 				if(*p == '\\')
 				{
-					ASSERT(dont_interpret_next_char == false);
-					dont_interpret_next_char = true;
 					delete_char(p);
+					if(*p != 0)
+					{
+						++p;
+					}
 					continue;
 				}
 
-				if(*p == ',' || *p == ':' || *p == '=')
-				{
-					break;
-				}
-
-				++p;
+				break;
 			}
 
 			m_argvallens.push_back((uint32_t)(p - start));
@@ -1069,16 +1214,23 @@ inline sinsp_tracerparser::parse_result sinsp_tracerparser::parsestr(char* p, ch
 	p++;
 
 	//
-	// Navigate to the end of the string
+	// Navigate to the end of the string, skipping the escaped quotes
 	//
-	while(!(*p == '\"' && *(p - 1) != '\\'))
+	while(true)
 	{
+		p = s_str_delims.find(p);
+
 		if(*p == 0)
 		{
 			*delta = (uint32_t)(p - initial + 1);
 			return sinsp_tracerparser::RES_TRUNCATED;
 		}
 
+		if(*(p - 1) != '\\')
+		{
+			break;
+		}
+
 		p++;
 	}
 
@@ -1227,11 +1379,7 @@ inline void sinsp_tracerparser::init_partial_tracer(sinsp_partial_tracer* pae)
 	pae->m_ntags = (uint32_t)m_tags.size();
 	uint32_t encoded_tags_len = m_tot_taglens + pae->m_ntags + 1;
 
-	if(pae->m_tags_storage_size < encoded_tags_len)
-	{
-		pae->m_tags_storage = (char*)realloc(pae->m_tags_storage, encoded_tags_len);
-		pae->m_tags_storage_size = encoded_tags_len;
-	}
+	reserve_tracer_storage(&pae->m_tags_storage, &pae->m_tags_storage_size, encoded_tags_len);
 
 	char* p = pae->m_tags_storage;
 	for(it = m_tags.begin(), sit = m_taglens.begin(); 
@@ -1254,11 +1402,7 @@ inline void sinsp_tracerparser::init_partial_tracer(sinsp_partial_tracer* pae)
 	pae->m_nargs = (uint32_t)m_argnames.size();
 	uint32_t encoded_argnames_len = m_tot_argnamelens + pae->m_nargs + 1;
 
-	if(pae->m_argnames_storage_size < encoded_argnames_len)
-	{
-		pae->m_argnames_storage = (char*)realloc(pae->m_argnames_storage, encoded_argnames_len);
-		pae->m_argnames_storage_size = encoded_argnames_len;
-	}
+	reserve_tracer_storage(&pae->m_argnames_storage, &pae->m_argnames_storage_size, encoded_argnames_len);
 
 	p = pae->m_argnames_storage;
 	for(it = m_argnames.begin(), sit = m_argnamelens.begin(); 
@@ -1280,11 +1424,7 @@ inline void sinsp_tracerparser::init_partial_tracer(sinsp_partial_tracer* pae)
 	pae->m_argvallens.clear();
 	uint32_t encoded_argvals_len = m_tot_argvallens + pae->m_nargs + 1;
 
-	if(pae->m_argvals_storage_size < encoded_argvals_len)
-	{
-		pae->m_argvals_storage = (char*)realloc(pae->m_argvals_storage, encoded_argvals_len);
-		pae->m_argvals_storage_size = encoded_argvals_len;
-	}
+	reserve_tracer_storage(&pae->m_argvals_storage, &pae->m_argvals_storage_size, encoded_argvals_len);
 
 	p = pae->m_argvals_storage;
 	for(it = m_argvals.begin(), sit = m_argvallens.begin(); 
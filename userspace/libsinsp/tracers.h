@@ -15,8 +15,16 @@ limitations under the License.
 
 */
 
+#pragma once
+
 #define UESTORAGE_INITIAL_BUFSIZE 256
 
+//
+// Slack at the end of the parser storage, so that the tokenizer can load
+// 16 bytes at a time past the terminating zero
+//
+#define TRACER_STORAGE_PADDING 16
+
 ///////////////////////////////////////////////////////////////////////////////
 // A partial tracer
 ///////////////////////////////////////////////////////////////////////////////
@@ -116,6 +124,14 @@ public:
 
 	uint64_t m_time;
 	uint64_t m_tid;
+
+	//
+	// Position in sinsp::m_partial_tracers_list and in the chain of
+	// sinsp::m_partial_tracers_index with the same id and tags
+	//
+	list<sinsp_partial_tracer*>::iterator m_list_it;
+	uint64_t m_index_hash;
+	sinsp_partial_tracer* m_index_next;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -145,6 +161,14 @@ public:
 	sinsp_partial_tracer* find_parent_enter_pae();
 	void test();
 
+	//
+	// The list of open spans is indexed by id and tags, so that exits
+	// don't have to walk it
+	//
+	static void add_partial_tracer(sinsp* inspector, sinsp_partial_tracer* pae);
+	static void remove_partial_tracer(sinsp* inspector, sinsp_partial_tracer* pae);
+	static void clear_partial_tracers(sinsp* inspector);
+
 	char* m_type_str;
 	int64_t m_id;
 	vector<char*> m_tags;
@@ -174,6 +198,8 @@ VISIBILITY_PRIVATE
 	inline parse_result parsenumber_colend(char* p, int64_t* res, uint32_t* delta);
 	inline void init_partial_tracer(sinsp_partial_tracer* pae);
 	inline void delete_char(char* p);
+	static inline uint64_t hash_tags(uint64_t id, const char* tags, uint32_t len);
+	sinsp_partial_tracer* find_partial_tracer(sinsp_partial_tracer* pae, uint32_t len);
 
 	string m_fullfragment_storage_str;
 	sinsp *m_inspector;
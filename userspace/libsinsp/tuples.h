@@ -18,6 +18,7 @@ limitations under the License.
 #pragma once
 
 #include <stdint.h>
+#include <functional>
 
 /** @defgroup state State management
  *  @{
@@ -111,3 +112,18 @@ typedef union _unix_tuple
 } unix_tuple;
 
 /*@}*/
+
+namespace std {
+/**
+ * \brief Specialization of std::hash for ipv6addr
+ *
+ * It allows `ipv6addr` instances to be used as `unordered_map` keys
+ */
+template<> struct hash<ipv6addr> {
+	std::size_t operator()(const ipv6addr& addr) const {
+		uint64_t h = ((uint64_t)addr.m_b[0] << 32 | addr.m_b[1]) * 0x9e3779b97f4a7c15ULL;
+		h ^= ((uint64_t)addr.m_b[2] << 32 | addr.m_b[3]) + (h >> 29);
+		return ::std::hash<uint64_t>{}(h);
+	}
+};
+}